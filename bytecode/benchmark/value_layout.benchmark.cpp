@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bytecode/boxed_value.hpp"
+#include "bytecode/value.hpp"
+
+namespace fc = fluir::code;
+
+namespace {
+  // Matches the capacity the VM reserves for its stack
+  constexpr int STACK_DEPTH = 256;
+
+  /* Builds and reads the values of a layout, along with whatever storage the owner of its stack has to keep */
+  template <typename V>
+  struct Layout {
+    template <typename Concrete>
+    V make(Concrete value) {
+      return V{value};
+    }
+    fc::U64 asU64(const V& value) const { return value.asU64(); }
+  };
+
+  template <>
+  struct Layout<fc::BoxedValue> {
+    fc::WideTable wide;
+
+    template <typename Concrete>
+    fc::BoxedValue make(Concrete value) {
+      if constexpr (std::is_same_v<Concrete, fc::I64> || std::is_same_v<Concrete, fc::U64>) {
+        return fc::BoxedValue{value, wide};
+      } else {
+        return fc::BoxedValue{value};
+      }
+    }
+    fc::U64 asU64(const fc::BoxedValue& value) const { return value.asU64(wide); }
+  };
+
+  /* Pushes STACK_DEPTH copies of `value` onto a VM-style stack and pops them all off again */
+  template <typename V, typename Concrete>
+  void pushPop(benchmark::State& state, Concrete concrete) {
+    Layout<V> layout;
+    const V value = layout.make(concrete);
+    std::vector<V> stack;
+    stack.reserve(STACK_DEPTH);
+    for (auto _ : state) {
+      for (int i = 0; i != STACK_DEPTH; ++i) {
+        stack.push_back(value);
+      }
+      while (!stack.empty()) {
+        benchmark::DoNotOptimize(stack.back());
+        stack.pop_back();
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * STACK_DEPTH);
+    state.SetLabel(std::to_string(sizeof(V)) + " bytes");
+  }
+
+  /* Runs the pop, pop, push sequence of a VM binary operator STACK_DEPTH times */
+  template <typename V, typename Concrete, typename Op, typename As>
+  void binaryOps(benchmark::State& state, Concrete initial, Concrete operand, Op op, As as) {
+    Layout<V> layout;
+    std::vector<V> stack;
+    stack.reserve(STACK_DEPTH);
+    for (auto _ : state) {
+      stack.push_back(layout.make(initial));
+      for (int i = 0; i != STACK_DEPTH; ++i) {
+        stack.push_back(layout.make(operand));
+        auto rhs = as(layout, stack.back());
+        stack.pop_back();
+        auto lhs = as(layout, stack.back());
+        stack.pop_back();
+        stack.push_back(layout.make(static_cast<Concrete>(op(lhs, rhs))));
+      }
+      benchmark::DoNotOptimize(stack.back());
+      stack.pop_back();
+    }
+    state.SetItemsProcessed(state.iterations() * STACK_DEPTH);
+  }
+
+  constexpr auto add = [](auto lhs, auto rhs) { return lhs + rhs; };
+  constexpr auto bitXor = [](auto lhs, auto rhs) { return lhs ^ rhs; };
+}  // namespace
+
+template <typename V>
+static void BM_PushPopF64(benchmark::State& state) {
+  pushPop<V>(state, 1.5);
+}
+BENCHMARK(BM_PushPopF64<fc::Value>);
+BENCHMARK(BM_PushPopF64<fc::BoxedValue>);
+
+template <typename V>
+static void BM_PushPopI32(benchmark::State& state) {
+  pushPop<V>(state, std::int32_t{-7});
+}
+BENCHMARK(BM_PushPopI32<fc::Value>);
+BENCHMARK(BM_PushPopI32<fc::BoxedValue>);
+
+template <typename V>
+static void BM_PushPopWideU64(benchmark::State& state) {
+  pushPop<V>(state, std::numeric_limits<std::uint64_t>::max());
+}
+BENCHMARK(BM_PushPopWideU64<fc::Value>);
+BENCHMARK(BM_PushPopWideU64<fc::BoxedValue>);
+
+template <typename V>
+static void BM_ArithmeticF64(benchmark::State& state) {
+  binaryOps<V, fc::F64>(state, 0.0, 0.5, add, [](const Layout<V>&, const V& v) { return v.asF64(); });
+}
+BENCHMARK(BM_ArithmeticF64<fc::Value>);
+BENCHMARK(BM_ArithmeticF64<fc::BoxedValue>);
+
+template <typename V>
+static void BM_ArithmeticI32(benchmark::State& state) {
+  binaryOps<V, fc::I32>(state, 0, 3, add, [](const Layout<V>&, const V& v) { return v.asI32(); });
+}
+BENCHMARK(BM_ArithmeticI32<fc::Value>);
+BENCHMARK(BM_ArithmeticI32<fc::BoxedValue>);
+
+template <typename V>
+static void BM_ArithmeticWideU64(benchmark::State& state) {
+  binaryOps<V, fc::U64>(state, std::numeric_limits<std::uint64_t>::max(), 1, bitXor,
+                        [](const Layout<V>& layout, const V& v) { return layout.asU64(v); });
+}
+BENCHMARK(BM_ArithmeticWideU64<fc::Value>);
+BENCHMARK(BM_ArithmeticWideU64<fc::BoxedValue>);
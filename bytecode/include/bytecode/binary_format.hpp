@@ -0,0 +1,182 @@
+#ifndef FLUIR_BYTECODE_BINARY_FORMAT_HPP
+#define FLUIR_BYTECODE_BINARY_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "byte_code.hpp"
+
+/** The binary container format (Header::filetype 'B').
+ *
+ * Everything is little endian. A file is a fixed size header, a table describing each section, then the sections
+ * themselves, each starting at a multiple of ALIGNMENT so their contents can be read in place.
+ *
+ *   Header (HEADER_SIZE bytes)
+ *     0   'B'
+ *     1   major, minor and patch, one byte each
+ *     4   the instruction set: 'I' for stack code or 'R' for register code
+ *     5   3 reserved bytes, always zero
+ *     8   u64 entry offset, the index of the chunk execution starts in
+ *     16  u32 number of sections
+ *     20  4 reserved bytes, always zero
+ *   Section table, one SECTION_ENTRY_SIZE entry per section
+ *     0   u32 SectionKind
+ *     4   u32 the index of the chunk the section belongs to, zero for module sections
+ *     8   u64 the offset of the section from the start of the file
+ *     16  u64 the size of the section in bytes
+ *
+ * Every chunk has a NAME section, which starts the chunk, and then any of its other sections. Constants are stored as
+ * typed arrays: a u64 count, one PrimitiveType byte per constant padded to ALIGNMENT, then the bits of each constant
+ * zero extended to a u64. Decoders skip sections of kinds they do not know.
+ *
+ * The first section is the DIRECTORY, followed by the other module sections and then the chunks in order. It lets a
+ * decoder find any one chunk without reading the others: a u64 count, then one DIRECTORY_ENTRY_SIZE entry per chunk
+ *     0   u64 the offset of the chunk's first section from the start of the file
+ *     8   u64 the number of bytes from there to the end of the chunk's last section
+ *     16  u32 the index of the chunk's first section, its NAME, in the section table
+ *     20  u32 the number of sections the chunk has
+ */
+namespace fluir::code::binary {
+  enum class SectionKind : std::uint32_t {
+    /** The chunk's name, as raw characters */
+    NAME = 1,
+    /** The chunk's code, as raw bytes */
+    CODE = 2,
+    /** The chunk's constant table */
+    CONSTANTS = 3,
+    /** A u64 count, then for each subgraph its chunk, its number of dependencies and the dependencies, all u64 */
+    SUBGRAPHS = 4,
+    /** A u64 count, then for each entry its u64 offset and node, the five i32 coordinates and 4 bytes of padding */
+    DEBUG = 5,
+    /** ByteCode::constants, shared by every chunk, in the same layout as CONSTANTS */
+    SHARED_CONSTANTS = 6,
+    /** Where each chunk's sections are, so chunks can be decoded one at a time */
+    DIRECTORY = 7,
+  };
+
+  constexpr std::size_t HEADER_SIZE = 24;
+  constexpr std::size_t SECTION_ENTRY_SIZE = 24;
+  constexpr std::size_t DEBUG_ENTRY_SIZE = 40;
+  constexpr std::size_t DIRECTORY_ENTRY_SIZE = 24;
+  constexpr std::size_t ALIGNMENT = 8;
+
+  struct Section {
+    SectionKind kind;
+    std::uint32_t chunk;
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  struct DirectoryEntry {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t firstSection;
+    std::uint32_t sections;
+  };
+
+  constexpr std::size_t aligned(std::size_t size) { return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+  /** Writes a constant table in the typed array layout */
+  inline void encodeConstants(const std::vector<Value>& constants, Bytes& out) {
+    writeOperand(static_cast<std::uint64_t>(constants.size()), std::back_inserter(out));
+    for (const auto& constant : constants) {
+      out.push_back(static_cast<std::uint8_t>(constant.type()));
+    }
+    out.resize(aligned(out.size()));
+    for (const auto& constant : constants) {
+      writeOperand(valueBits(constant), std::back_inserter(out));
+    }
+  }
+
+  /** Encodes code in the binary format */
+  inline Bytes encode(const ByteCode& code) {
+    std::vector<Section> sections;
+    // The sections' contents, with offsets relative to the end of the section table until it is written
+    Bytes data;
+    const auto add = [&](SectionKind kind, std::size_t chunk, auto&& write) {
+      const auto start = data.size();
+      write(data);
+      sections.push_back(Section{.kind = kind,
+                                 .chunk = static_cast<std::uint32_t>(chunk),
+                                 .offset = start,
+                                 .size = data.size() - start});
+      data.resize(aligned(data.size()));
+    };
+    const auto u64 = [](Bytes& out, std::uint64_t value) { writeOperand(value, std::back_inserter(out)); };
+
+    // The directory's entries are filled in once every section has been laid out
+    add(SectionKind::DIRECTORY, 0, [&](Bytes& out) {
+      out.resize(out.size() + sizeof(std::uint64_t) + code.chunks.size() * DIRECTORY_ENTRY_SIZE);
+    });
+    if (!code.constants.empty()) {
+      add(SectionKind::SHARED_CONSTANTS, 0, [&](Bytes& out) { encodeConstants(code.constants, out); });
+    }
+    std::vector<std::size_t> firstSections;
+    for (std::size_t i = 0; i != code.chunks.size(); ++i) {
+      const auto& chunk = code.chunks[i];
+      firstSections.push_back(sections.size());
+      add(SectionKind::NAME, i, [&](Bytes& out) { out.insert(out.end(), chunk.name.begin(), chunk.name.end()); });
+      add(SectionKind::CONSTANTS, i, [&](Bytes& out) { encodeConstants(chunk.constants, out); });
+      add(SectionKind::CODE, i, [&](Bytes& out) { out.insert(out.end(), chunk.code.begin(), chunk.code.end()); });
+      if (!chunk.subgraphs.empty()) {
+        add(SectionKind::SUBGRAPHS, i, [&](Bytes& out) {
+          u64(out, chunk.subgraphs.size());
+          for (const auto& subgraph : chunk.subgraphs) {
+            u64(out, subgraph.chunk);
+            u64(out, subgraph.dependencies.size());
+            for (auto dependency : subgraph.dependencies) {
+              u64(out, dependency);
+            }
+          }
+        });
+      }
+      if (!chunk.debug.empty()) {
+        add(SectionKind::DEBUG, i, [&](Bytes& out) {
+          u64(out, chunk.debug.size());
+          for (const auto& entry : chunk.debug) {
+            u64(out, entry.offset);
+            u64(out, entry.node);
+            for (auto coordinate : {entry.x, entry.y, entry.z, entry.width, entry.height}) {
+              writeOperand(coordinate, std::back_inserter(out));
+            }
+            writeOperand(std::uint32_t{0}, std::back_inserter(out));
+          }
+        });
+      }
+    }
+
+    const auto dataStart = HEADER_SIZE + sections.size() * SECTION_ENTRY_SIZE;
+    firstSections.push_back(sections.size());
+    auto* directory = writeOperand(static_cast<std::uint64_t>(code.chunks.size()), data.data());
+    for (std::size_t i = 0; i != code.chunks.size(); ++i) {
+      const auto& first = sections[firstSections[i]];
+      const auto& last = sections[firstSections[i + 1] - 1];
+      directory = writeOperand(static_cast<std::uint64_t>(dataStart + first.offset), directory);
+      directory = writeOperand(static_cast<std::uint64_t>(last.offset + last.size - first.offset), directory);
+      directory = writeOperand(static_cast<std::uint32_t>(firstSections[i]), directory);
+      directory = writeOperand(static_cast<std::uint32_t>(firstSections[i + 1] - firstSections[i]), directory);
+    }
+    Bytes file(dataStart);
+    file[0] = static_cast<std::uint8_t>(FILETYPE_BINARY);
+    file[1] = code.header.major;
+    file[2] = code.header.minor;
+    file[3] = code.header.patch;
+    file[4] = static_cast<std::uint8_t>(usesRegisters(code.header) ? FILETYPE_REGISTERS : FILETYPE_INSPECT);
+    writeOperand(code.header.entryOffset, file.data() + 8);
+    writeOperand(static_cast<std::uint32_t>(sections.size()), file.data() + 16);
+
+    auto* entry = file.data() + HEADER_SIZE;
+    for (const auto& section : sections) {
+      entry = writeOperand(static_cast<std::uint32_t>(section.kind), entry);
+      entry = writeOperand(section.chunk, entry);
+      entry = writeOperand(static_cast<std::uint64_t>(dataStart + section.offset), entry);
+      entry = writeOperand(section.size, entry);
+    }
+    file.insert(file.end(), data.begin(), data.end());
+    return file;
+  }
+}  // namespace fluir::code::binary
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef FLUIR_BYTECODE_BOXED_VALUE_HPP
+#define FLUIR_BYTECODE_BOXED_VALUE_HPP
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "primitives.hpp"
+#include "value.hpp"
+
+namespace fluir::code {
+
+  /** The side table holding the full-width I64 and U64 values of BoxedValues which do not fit in the payload.
+   *
+   * Whoever owns a collection of BoxedValues, such as a stack or constant pool, owns the table their wide values index
+   * into. Equal values share a slot, so a value stored again costs no extra memory. Slots are only released all at
+   * once by clear(), after which the wide values which referred to them must no longer be read.
+   */
+  class WideTable {
+   public:
+    /** The slot holding bits, adding one if the table does not hold them yet */
+    std::uint32_t intern(std::uint64_t bits) {
+      auto [found, added] = slots_.try_emplace(bits, static_cast<std::uint32_t>(values_.size()));
+      if (added) {
+        values_.push_back(bits);
+      }
+      return found->second;
+    }
+
+    [[nodiscard]] std::uint64_t at(std::uint32_t slot) const { return values_[slot]; }
+    [[nodiscard]] std::size_t size() const { return values_.size(); }
+
+    void clear() {
+      values_.clear();
+      slots_.clear();
+    }
+
+   private:
+    std::vector<std::uint64_t> values_;
+    std::unordered_map<std::uint64_t, std::uint32_t> slots_;
+  };
+
+  /** A generic Fluir value NaN-boxed into 8 bytes.
+   *
+   * F64 values are stored as themselves. Every other type lives in the payload of a negative quiet NaN, with a 4 bit
+   * tag selecting the type:
+   *
+   *   63       51 50  47 46                                            0
+   *   1111111111111 tag  payload (47 bits)
+   *
+   * I64 and U64 values which do not fit in the payload use a wide form: the payload holds the slot of the full-width
+   * value in a WideTable, so they are constructed and read through that table. Copying a BoxedValue never allocates.
+   * Incoming NaNs are canonicalized so they never collide with a boxed value, which
+   * means the sign and payload of a NaN are not preserved.
+   */
+  class BoxedValue {
+    friend bool operator==(const BoxedValue&, const BoxedValue&);
+
+   public:
+    explicit BoxedValue(F64 d) : bits_(boxDouble(d)) { }
+    explicit BoxedValue(I8 i) : bits_(box(TAG_I8, static_cast<std::uint8_t>(i))) { }
+    explicit BoxedValue(I16 i) : bits_(box(TAG_I16, static_cast<std::uint16_t>(i))) { }
+    explicit BoxedValue(I32 i) : bits_(box(TAG_I32, static_cast<std::uint32_t>(i))) { }
+    /** Throws if i needs the wide form, which has to be stored in a WideTable */
+    explicit BoxedValue(I64 i) : bits_(box(TAG_I64, narrow(i))) { }
+    BoxedValue(I64 i, WideTable& wide) :
+      bits_(fitsPayload(i) ? box(TAG_I64, static_cast<std::uint64_t>(i) & PAYLOAD_MASK)
+                           : box(TAG_WIDE_I64, wide.intern(static_cast<std::uint64_t>(i)))) { }
+    explicit BoxedValue(U8 u) : bits_(box(TAG_U8, u)) { }
+    explicit BoxedValue(U16 u) : bits_(box(TAG_U16, u)) { }
+    explicit BoxedValue(U32 u) : bits_(box(TAG_U32, u)) { }
+    /** Throws if u needs the wide form, which has to be stored in a WideTable */
+    explicit BoxedValue(U64 u) : bits_(box(TAG_U64, narrow(u))) { }
+    BoxedValue(U64 u, WideTable& wide) :
+      bits_(u <= PAYLOAD_MASK ? box(TAG_U64, u) : box(TAG_WIDE_U64, wide.intern(u))) { }
+
+    explicit BoxedValue(const Value& value) : BoxedValue(fromValue(value, nullptr)) { }
+    BoxedValue(const Value& value, WideTable& wide) : BoxedValue(fromValue(value, &wide)) { }
+
+    [[nodiscard]] PrimitiveType type() const {
+      if (!isBoxed()) {
+        return PrimitiveType::F64;
+      }
+      switch (tag()) {
+        case TAG_I8:
+          return PrimitiveType::I8;
+        case TAG_I16:
+          return PrimitiveType::I16;
+        case TAG_I32:
+          return PrimitiveType::I32;
+        case TAG_I64:
+        case TAG_WIDE_I64:
+          return PrimitiveType::I64;
+        case TAG_U8:
+          return PrimitiveType::U8;
+        case TAG_U16:
+          return PrimitiveType::U16;
+        case TAG_U32:
+          return PrimitiveType::U32;
+        default:
+          return PrimitiveType::U64;
+      }
+    }
+
+    /** Whether the value is stored in a WideTable */
+    [[nodiscard]] bool isWide() const { return isBoxed() && tag() >= TAG_WIDE_I64; }
+
+    [[nodiscard]] F64 uncheckedAsF64() const { return std::bit_cast<F64>(bits_); }
+    [[nodiscard]] I8 uncheckedAsI8() const { return static_cast<I8>(payload()); }
+    [[nodiscard]] I16 uncheckedAsI16() const { return static_cast<I16>(payload()); }
+    [[nodiscard]] I32 uncheckedAsI32() const { return static_cast<I32>(payload()); }
+    /** Only for values which are not wide */
+    [[nodiscard]] I64 uncheckedAsI64() const {
+      // Sign-extend the 47 bit payload
+      return static_cast<I64>(payload() << (64 - TAG_SHIFT)) >> (64 - TAG_SHIFT);
+    }
+    [[nodiscard]] I64 uncheckedAsI64(const WideTable& wide) const {
+      return isWide() ? static_cast<I64>(wide.at(slot())) : uncheckedAsI64();
+    }
+    [[nodiscard]] U8 uncheckedAsU8() const { return static_cast<U8>(payload()); }
+    [[nodiscard]] U16 uncheckedAsU16() const { return static_cast<U16>(payload()); }
+    [[nodiscard]] U32 uncheckedAsU32() const { return static_cast<U32>(payload()); }
+    /** Only for values which are not wide */
+    [[nodiscard]] U64 uncheckedAsU64() const { return payload(); }
+    [[nodiscard]] U64 uncheckedAsU64(const WideTable& wide) const { return isWide() ? wide.at(slot()) : payload(); }
+
+#define TEMP_CONCAT(a, b) a##b
+#define FLUIR_BOXED_VALUE_ACCESSOR(Type, Concrete) \
+  [[nodiscard]] Concrete TEMP_CONCAT(as, Type)() const { \
+    assertType(PrimitiveType::Type);                     \
+    return TEMP_CONCAT(uncheckedAs, Type)();             \
+  }
+
+    FLUIR_BOXED_VALUE_ACCESSOR(F64, double)
+    FLUIR_CODE_SIZED_INT_TYPES(FLUIR_BOXED_VALUE_ACCESSOR)
+    FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_BOXED_VALUE_ACCESSOR)
+
+#undef FLUIR_BOXED_VALUE_ACCESSOR
+
+    /** Throws if the value is wide */
+    [[nodiscard]] I64 asI64() const {
+      assertType(PrimitiveType::I64);
+      assertNarrow();
+      return uncheckedAsI64();
+    }
+    [[nodiscard]] I64 asI64(const WideTable& wide) const {
+      assertType(PrimitiveType::I64);
+      return uncheckedAsI64(wide);
+    }
+    /** Throws if the value is wide */
+    [[nodiscard]] U64 asU64() const {
+      assertType(PrimitiveType::U64);
+      assertNarrow();
+      return uncheckedAsU64();
+    }
+    [[nodiscard]] U64 asU64(const WideTable& wide) const {
+      assertType(PrimitiveType::U64);
+      return uncheckedAsU64(wide);
+    }
+
+    /** Throws if the value is wide */
+    [[nodiscard]] Value toValue() const {
+      assertNarrow();
+      switch (type()) {
+#define FLUIR_BOXED_TO_VALUE(Type, Concrete) \
+  case PrimitiveType::Type:                  \
+    return Value{TEMP_CONCAT(uncheckedAs, Type)()};
+
+        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_BOXED_TO_VALUE)
+#undef FLUIR_BOXED_TO_VALUE
+      }
+      return Value{uncheckedAsF64()};
+    }
+    [[nodiscard]] Value toValue(const WideTable& wide) const {
+      if (!isWide()) {
+        return toValue();
+      }
+      return tag() == TAG_WIDE_I64 ? Value{uncheckedAsI64(wide)} : Value{uncheckedAsU64(wide)};
+    }
+
+   private:
+    enum Tag : std::uint64_t {
+      // Tag 0 is never used so that no boxed value looks like the canonical NaN
+      TAG_I8 = 1,
+      TAG_I16,
+      TAG_I32,
+      TAG_I64,
+      TAG_U8,
+      TAG_U16,
+      TAG_U32,
+      TAG_U64,
+      TAG_WIDE_I64,
+      TAG_WIDE_U64,
+    };
+
+    static constexpr std::uint64_t BOX_MASK = 0xFFF8'0000'0000'0000;
+    static constexpr std::uint64_t CANONICAL_NAN = 0x7FF8'0000'0000'0000;
+    static constexpr int TAG_SHIFT = 47;
+    static constexpr std::uint64_t TAG_MASK = 0xF;
+    static constexpr std::uint64_t PAYLOAD_MASK = (std::uint64_t{1} << TAG_SHIFT) - 1;
+
+    std::uint64_t bits_;
+
+    [[nodiscard]] bool isBoxed() const { return (bits_ & BOX_MASK) == BOX_MASK; }
+    [[nodiscard]] Tag tag() const { return static_cast<Tag>((bits_ >> TAG_SHIFT) & TAG_MASK); }
+    [[nodiscard]] std::uint64_t payload() const { return bits_ & PAYLOAD_MASK; }
+    [[nodiscard]] std::uint32_t slot() const { return static_cast<std::uint32_t>(payload()); }
+
+    static std::uint64_t box(Tag tag, std::uint64_t payload) { return BOX_MASK | (tag << TAG_SHIFT) | payload; }
+
+    static std::uint64_t boxDouble(F64 d) {
+      auto bits = std::bit_cast<std::uint64_t>(d);
+      return (bits & BOX_MASK) == BOX_MASK ? CANONICAL_NAN : bits;
+    }
+
+    static bool fitsPayload(I64 i) {
+      constexpr I64 limit = I64{1} << (TAG_SHIFT - 1);
+      return -limit <= i && i < limit;
+    }
+
+    static std::uint64_t narrow(I64 i) {
+      if (!fitsPayload(i)) {
+        throw std::runtime_error("A full-width I64 has to be stored in a WideTable");
+      }
+      return static_cast<std::uint64_t>(i) & PAYLOAD_MASK;
+    }
+
+    static std::uint64_t narrow(U64 u) {
+      if (u > PAYLOAD_MASK) {
+        throw std::runtime_error("A full-width U64 has to be stored in a WideTable");
+      }
+      return u;
+    }
+
+    static BoxedValue fromValue(const Value& value, WideTable* wide) {
+      switch (value.type()) {
+        case PrimitiveType::I64:
+          return wide ? BoxedValue{value.uncheckedAsI64(), *wide} : BoxedValue{value.uncheckedAsI64()};
+        case PrimitiveType::U64:
+          return wide ? BoxedValue{value.uncheckedAsU64(), *wide} : BoxedValue{value.uncheckedAsU64()};
+#define FLUIR_VALUE_TO_BOXED(Type, Concrete) \
+  case PrimitiveType::Type:                  \
+    return BoxedValue{value.TEMP_CONCAT(uncheckedAs, Type)()};
+
+          FLUIR_CODE_SIZED_INT_TYPES(FLUIR_VALUE_TO_BOXED)
+          FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_VALUE_TO_BOXED)
+#undef FLUIR_VALUE_TO_BOXED
+        case PrimitiveType::F64:
+          break;
+      }
+      return BoxedValue{value.uncheckedAsF64()};
+    }
+
+    static constexpr std::uint64_t tagOf(PrimitiveType type) {
+      switch (type) {
+        case PrimitiveType::I8:
+          return TAG_I8;
+        case PrimitiveType::I16:
+          return TAG_I16;
+        case PrimitiveType::I32:
+          return TAG_I32;
+        case PrimitiveType::I64:
+          return TAG_I64;
+        case PrimitiveType::U8:
+          return TAG_U8;
+        case PrimitiveType::U16:
+          return TAG_U16;
+        case PrimitiveType::U32:
+          return TAG_U32;
+        default:
+          return TAG_U64;
+      }
+    }
+
+    /** Compares the box prefix and tag in one go rather than decoding the full type */
+    [[nodiscard]] bool holds(PrimitiveType type) const {
+      if (type == PrimitiveType::F64) {
+        return !isBoxed();
+      }
+      constexpr std::uint64_t prefix = BOX_MASK >> TAG_SHIFT;
+      auto high = bits_ >> TAG_SHIFT;
+      return high == (prefix | tagOf(type)) || (type == PrimitiveType::I64 && high == (prefix | TAG_WIDE_I64)) ||
+             (type == PrimitiveType::U64 && high == (prefix | TAG_WIDE_U64));
+    }
+
+    void assertType(PrimitiveType type) const {
+      if (!holds(type)) {
+        throw std::runtime_error("Actual value type does not match");
+      }
+    }
+
+    void assertNarrow() const {
+      if (isWide()) {
+        throw std::runtime_error("A wide value can only be read through its WideTable");
+      }
+    }
+  };
+
+  static_assert(sizeof(BoxedValue) == 8);
+  static_assert(std::is_trivially_copyable_v<BoxedValue>);
+
+  namespace boxed_value_literals {
+    inline BoxedValue operator""_f64(long double d) { return BoxedValue{static_cast<double>(d)}; }
+    inline BoxedValue operator""_i64(unsigned long long i) { return BoxedValue{static_cast<std::int64_t>(i)}; }
+    inline BoxedValue operator""_i32(unsigned long long i) { return BoxedValue{static_cast<std::int32_t>(i)}; }
+    inline BoxedValue operator""_i16(unsigned long long i) { return BoxedValue{static_cast<std::int16_t>(i)}; }
+    inline BoxedValue operator""_i8(unsigned long long i) { return BoxedValue{static_cast<std::int8_t>(i)}; }
+    inline BoxedValue operator""_u64(unsigned long long int u) { return BoxedValue{static_cast<std::uint64_t>(u)}; }
+    inline BoxedValue operator""_u32(unsigned long long int u) { return BoxedValue{static_cast<std::uint32_t>(u)}; }
+    inline BoxedValue operator""_u16(unsigned long long int u) { return BoxedValue{static_cast<std::uint16_t>(u)}; }
+    inline BoxedValue operator""_u8(unsigned long long int u) { return BoxedValue{static_cast<std::uint8_t>(u)}; }
+  }  // namespace boxed_value_literals
+
+  /** Wide values are only compared within one WideTable, where equal values share a slot */
+  inline bool operator==(const BoxedValue& lhs, const BoxedValue& rhs) {
+    if (lhs.isWide() || rhs.isWide()) {
+      return lhs.bits_ == rhs.bits_;
+    }
+    if (lhs.type() != rhs.type()) {
+      return false;
+    }
+
+    switch (lhs.type()) {
+#define FLUIR_BOXED_VALUE_COMPARE(Type, Concrete) \
+  case PrimitiveType::Type:                       \
+    return TEMP_CONCAT(lhs.uncheckedAs, Type)() == TEMP_CONCAT(rhs.uncheckedAs, Type)();
+
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_BOXED_VALUE_COMPARE)
+
+#undef FLUIR_BOXED_VALUE_COMPARE
+#undef TEMP_CONCAT
+    }
+    return false;
+  }
+}  // namespace fluir::code
+
+#endif  // FLUIR_BYTECODE_BOXED_VALUE_HPP
@@ -2,12 +2,21 @@
 #define FLUIR_BYTECODE_BYTE_CODE_HPP
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "code_chunk.hpp"
 #include "instruction.hpp"
 
 namespace fluir::code {
+  /** Header::filetype of code written in the inspect format using the stack instruction set */
+  constexpr char FILETYPE_INSPECT = 'I';
+  /** Header::filetype of code written in the inspect format using the register instruction set */
+  constexpr char FILETYPE_REGISTERS = 'R';
+  /** The first byte of code written in the binary format, which records the instruction set separately. Decoding it
+   * gives a Header with filetype FILETYPE_INSPECT or FILETYPE_REGISTERS. */
+  constexpr char FILETYPE_BINARY = 'B';
+
   struct Header {
     char filetype{0};
 
@@ -15,13 +24,36 @@ namespace fluir::code {
     std::uint8_t minor{0};
     std::uint8_t patch{0};
 
+    /** The index of the chunk execution starts in, unless it is told to start elsewhere */
     std::uint64_t entryOffset{0};
   };
 
   struct ByteCode {
     Header header{};
     std::vector<Chunk> chunks{};
+    /** The constant table shared by every chunk of the module, so each constant is stored once however many chunks use
+     * it. Chunks using it leave their own table empty. The VM only reads chunk tables, so the shared table must be
+     * expanded with expandSharedConstants before the code runs. */
+    std::vector<Value> constants{};
+    /** Owns the memory the views of chunks loaded in place point into, such as a mapped file */
+    std::shared_ptr<const void> storage{};
   };
+
+  /** Gives every chunk without constants of its own a copy of the shared constant table, then empties it */
+  inline void expandSharedConstants(ByteCode& code) {
+    if (code.constants.empty()) {
+      return;
+    }
+    for (auto& chunk : code.chunks) {
+      if (chunk.constants.empty()) {
+        chunk.constants = code.constants;
+      }
+    }
+    code.constants.clear();
+  }
+
+  /** Whether the chunks hold register instructions rather than stack instructions */
+  constexpr bool usesRegisters(const Header& header) { return header.filetype == FILETYPE_REGISTERS; }
 }  // namespace fluir::code
 
 #endif
@@ -1,6 +1,9 @@
 #ifndef FLUIR_BYTECODE_CODE_CHUNK_HPP
 #define FLUIR_BYTECODE_CODE_CHUNK_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -10,10 +13,93 @@
 namespace fluir::code {
   using Bytes = std::vector<uint8_t>;
 
+  /** One sink of a chunk along with everything it depends on, compiled into a chunk of its own so that it can run
+   * concurrently with the chunk's other sinks */
+  struct Subgraph {
+    /** The index of the subgraph's chunk in the ByteCode */
+    std::size_t chunk{0};
+    /** The subgraphs of the same chunk which must finish before this one starts. They always come earlier in the
+     * table, so the table is already in a valid order to run sequentially. */
+    std::vector<std::size_t> dependencies{};
+  };
+
+  /** Marks where the code generated for one flow graph node starts, so that time spent in the VM can be attributed
+   * back to the node. The node owns every byte up to the next entry. */
+  struct DebugEntry {
+    std::size_t offset{0};
+    /** The ID of the node in the flow graph */
+    std::uint64_t node{0};
+    /** Where the node is drawn in the flow graph */
+    std::int32_t x{0};
+    std::int32_t y{0};
+    std::int32_t z{0};
+    std::int32_t width{0};
+    std::int32_t height{0};
+
+    friend bool operator==(const DebugEntry&, const DebugEntry&) = default;
+  };
+
+  /** A constant table which lives in memory owned by someone else, laid out as in the binary format: one PrimitiveType
+   * byte per constant, and the bits of each constant as a little endian u64. The bits start at a multiple of 8 bytes.
+   */
+  class ConstantView {
+   public:
+    ConstantView() = default;
+    /** types must only hold PrimitiveTypes, and bits must be 8 bytes for each of them */
+    ConstantView(std::span<const std::uint8_t> types, std::span<const std::uint8_t> bits) :
+        types_(types), bits_(bits) { }
+
+    [[nodiscard]] std::size_t size() const { return types_.size(); }
+    [[nodiscard]] bool empty() const { return types_.empty(); }
+    [[nodiscard]] PrimitiveType type(std::size_t index) const { return static_cast<PrimitiveType>(types_[index]); }
+    [[nodiscard]] Value operator[](std::size_t index) const { return *valueFromBits(types_[index], bits(index)); }
+    /** The constant at index, which must be an F64 */
+    [[nodiscard]] F64 f64(std::size_t index) const { return fromBits<F64>(bits(index)); }
+
+   private:
+    std::span<const std::uint8_t> types_;
+    std::span<const std::uint8_t> bits_;
+
+    [[nodiscard]] std::uint64_t bits(std::size_t index) const {
+      return readOperand<std::uint64_t>(bits_.data() + index * sizeof(std::uint64_t));
+    }
+  };
+
   struct Chunk {
     std::string name = "";
     Bytes code{};
     std::vector<Value> constants{};
+    /** The chunk split into independent subgraphs, in the order its sinks appear in code. Running every subgraph
+     * produces the same output as running code. Empty if the chunk only runs as a whole. */
+    std::vector<Subgraph> subgraphs{};
+    /** The node each part of code was generated for, in increasing order of offset. Empty if the chunk was compiled
+     * without debug info. */
+    std::vector<DebugEntry> debug{};
+    /** The code and constants of a chunk loaded in place from a mapped file. They point into the mapping instead of
+     * being copied into code and constants, which stay empty. The ByteCode's storage keeps the mapping alive. */
+    std::span<const std::uint8_t> codeView{};
+    ConstantView constantView{};
+
+    /** The chunk's code, wherever it lives */
+    [[nodiscard]] std::span<const std::uint8_t> instructions() const {
+      return codeView.data() != nullptr ? codeView : std::span<const std::uint8_t>{code};
+    }
+
+    // The constant accessors are forced inline because the VM checks them for every PUSH, and its dispatch loop is too
+    // large for the compiler to inline them on its own
+    [[nodiscard, gnu::always_inline]] std::size_t constantCount() const {
+      return constantView.empty() ? constants.size() : constantView.size();
+    }
+    [[nodiscard, gnu::always_inline]] PrimitiveType constantType(std::size_t index) const {
+      return constantView.empty() ? constants[index].type() : constantView.type(index);
+    }
+    [[nodiscard]] Value constant(std::size_t index) const {
+      return constantView.empty() ? constants[index] : constantView[index];
+    }
+    /** The constant at index, which must be an F64 */
+    [[nodiscard, gnu::always_inline]] F64 f64Constant(std::size_t index) const {
+      return constantView.empty() ? constants[index].uncheckedAsF64() : constantView.f64(index);
+    }
   };
 }  // namespace fluir::code
 
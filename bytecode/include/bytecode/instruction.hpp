@@ -1,38 +1,87 @@
 #ifndef FLUIR_BYTECODE_INSTRUCTION_HPP
 #define FLUIR_BYTECODE_INSTRUCTION_HPP
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "primitives.hpp"
 
 namespace fluir::code {
+  // Instructions from PUSH2 to F64_MUL_ADD are superinstructions. The compiler never emits them, the VM's fuser
+  // rewrites common sequences into them when code is loaded.
+  //
+  // The instructions after them are the I64_ and U64_ arithmetic instructions specialized to a single operand type from
+  // FLUIR_CODE_SIZED_INT_TYPES and FLUIR_CODE_SIZED_UINT_TYPES, e.g. I8_ADD adds two I8s. Each family follows the order
+  // of the I64_ or U64_ instructions it specializes.
+  //
+  // The last instructions push a value without the indirection through the constant table: PUSH_F64_IMM and
+  // PUSH_I64_IMM carry a whole F64 or I64 as 8 little endian operand bytes, and PUSH_SMALL_INT a signed byte which it
+  // pushes as an I64. PUSH_WIDE names a constant with a little endian 16 bit index, for chunks with more constants
+  // than PUSH can name.
   // clang-format off
-  #define FLUIR_CODE_INSTRUCTIONS(code)  \
-  code(EXIT)                             \
-  code(PUSH)                             \
-  code(POP)                              \
-  code(F64_ADD)                          \
-  code(F64_SUB)                          \
-  code(F64_MUL)                          \
-  code(F64_DIV)                          \
-  code(F64_NEG)                          \
-  code(F64_AFF)                          \
-  code(I64_ADD)                          \
-  code(I64_SUB)                          \
-  code(I64_MUL)                          \
-  code(I64_DIV)                          \
-  code(I64_NEG)                          \
-  code(I64_AFF)                          \
-  code(U64_ADD)                          \
-  code(U64_SUB)                          \
-  code(U64_MUL)                          \
-  code(U64_DIV)                          \
-  code(U64_AFF)                          \
-  code(CAST_IU)                          \
-  code(CAST_UI)                          \
-  code(CAST_IF)                          \
-  code(CAST_UF)                          \
-  code(CAST_FI)                          \
-  code(CAST_FU)                          \
-  code(CAST_WIDTH)
+  #define FLUIR_CODE_SIZED_INT_INSTRUCTIONS(code, Type) \
+  code(Type##_ADD)                                      \
+  code(Type##_SUB)                                      \
+  code(Type##_MUL)                                      \
+  code(Type##_DIV)                                      \
+  code(Type##_NEG)
+
+  #define FLUIR_CODE_SIZED_UINT_INSTRUCTIONS(code, Type) \
+  code(Type##_ADD)                                       \
+  code(Type##_SUB)                                       \
+  code(Type##_MUL)                                       \
+  code(Type##_DIV)
+
+  #define FLUIR_CODE_INSTRUCTIONS(code)         \
+  code(EXIT)                                    \
+  code(PUSH)                                    \
+  code(POP)                                     \
+  code(F64_ADD)                                 \
+  code(F64_SUB)                                 \
+  code(F64_MUL)                                 \
+  code(F64_DIV)                                 \
+  code(F64_NEG)                                 \
+  code(F64_AFF)                                 \
+  code(I64_ADD)                                 \
+  code(I64_SUB)                                 \
+  code(I64_MUL)                                 \
+  code(I64_DIV)                                 \
+  code(I64_NEG)                                 \
+  code(I64_AFF)                                 \
+  code(U64_ADD)                                 \
+  code(U64_SUB)                                 \
+  code(U64_MUL)                                 \
+  code(U64_DIV)                                 \
+  code(U64_AFF)                                 \
+  code(CAST_IU)                                 \
+  code(CAST_UI)                                 \
+  code(CAST_IF)                                 \
+  code(CAST_UF)                                 \
+  code(CAST_FI)                                 \
+  code(CAST_FU)                                 \
+  code(CAST_WIDTH)                              \
+  code(PUSH2)                                   \
+  code(PUSH_PUSH_F64_ADD)                       \
+  code(PUSH_PUSH_F64_SUB)                       \
+  code(PUSH_PUSH_F64_MUL)                       \
+  code(PUSH_PUSH_F64_DIV)                       \
+  code(PUSH_POP)                                \
+  code(F64_MUL_ADD)                             \
+  FLUIR_CODE_SIZED_INT_INSTRUCTIONS(code, I8)   \
+  FLUIR_CODE_SIZED_INT_INSTRUCTIONS(code, I16)  \
+  FLUIR_CODE_SIZED_INT_INSTRUCTIONS(code, I32)  \
+  FLUIR_CODE_SIZED_UINT_INSTRUCTIONS(code, U8)  \
+  FLUIR_CODE_SIZED_UINT_INSTRUCTIONS(code, U16) \
+  FLUIR_CODE_SIZED_UINT_INSTRUCTIONS(code, U32) \
+  code(PUSH_F64_IMM)                            \
+  code(PUSH_I64_IMM)                            \
+  code(PUSH_SMALL_INT)                          \
+  code(PUSH_WIDE)
 
   // clang-format
 
@@ -42,6 +91,152 @@ namespace fluir::code {
 #undef enumerate
   };
 
+  /** The number of instructions. No byte from it upwards is an instruction. */
+  constexpr std::size_t INSTRUCTION_COUNT = 0
+#define FLUIR_COUNT_INSTRUCTION(inst) +1
+    FLUIR_CODE_INSTRUCTIONS(FLUIR_COUNT_INSTRUCTION)
+#undef FLUIR_COUNT_INSTRUCTION
+    ;
+
+  /** The name of an instruction, such as "F64_ADD", or "<UNKNOWN>" for a byte which is not an instruction */
+  constexpr std::string_view instructionName(std::uint8_t instruction) {
+    constexpr std::string_view names[] = {
+#define FLUIR_INSTRUCTION_TO_STR(inst) #inst,
+      FLUIR_CODE_INSTRUCTIONS(FLUIR_INSTRUCTION_TO_STR)
+#undef FLUIR_INSTRUCTION_TO_STR
+    };
+    return instruction < std::size(names) ? names[instruction] : "<UNKNOWN>";
+  }
+
+  /** The number of operand bytes which follow an instruction in a Chunk's code */
+  constexpr int operandBytes(Instruction instruction) {
+    switch (instruction) {
+      case PUSH:
+      case PUSH_POP:
+      case CAST_IU:
+      case CAST_UI:
+      case CAST_FI:
+      case CAST_FU:
+      case CAST_WIDTH:
+      case PUSH_SMALL_INT:
+        return 1;
+      case PUSH_WIDE:
+      case PUSH2:
+      case PUSH_PUSH_F64_ADD:
+      case PUSH_PUSH_F64_SUB:
+      case PUSH_PUSH_F64_MUL:
+      case PUSH_PUSH_F64_DIV:
+        return 2;
+      case PUSH_F64_IMM:
+      case PUSH_I64_IMM:
+        return 8;
+      default:
+        return 0;
+    }
+  }
+
+  /** The number of constants PUSH_WIDE can name */
+  constexpr std::size_t WIDE_CONSTANTS = 1 << 16;
+
+  /** Reads a multi-byte operand, which is always stored little endian, starting at operand */
+  template <typename T>
+  T readOperand(const std::uint8_t* operand) {
+    std::array<std::uint8_t, sizeof(T)> bytes;
+    std::copy_n(operand, sizeof(T), bytes.begin());
+    if constexpr (std::endian::native == std::endian::big) {
+      std::ranges::reverse(bytes);
+    }
+    return std::bit_cast<T>(bytes);
+  }
+
+  /** Writes value as a little endian multi-byte operand to out */
+  template <typename T, typename Out>
+  Out writeOperand(T value, Out out) {
+    auto bytes = std::bit_cast<std::array<std::uint8_t, sizeof(T)>>(value);
+    if constexpr (std::endian::native == std::endian::big) {
+      std::ranges::reverse(bytes);
+    }
+    return std::ranges::copy(bytes, out).out;
+  }
+
+  /** The number of register operand bytes which follow an instruction in register code, or -1 if the instruction is
+   * not part of the register instruction set.
+   *
+   * Register instructions reuse the stack opcodes with explicit operands, destination first: `F64_ADD dst, lhs, rhs`,
+   * `F64_NEG dst, src`, `CAST_FI dst, src, width` and `POP src`. Registers 0 to N - 1 are preloaded with a chunk's N
+   * constants, so there is no PUSH.
+   */
+  constexpr int registerOperandBytes(Instruction instruction) {
+    switch (instruction) {
+      case EXIT:
+        return 0;
+      case POP:
+        return 1;
+      case F64_NEG:
+      case F64_AFF:
+      case I64_NEG:
+      case I64_AFF:
+      case U64_AFF:
+      case CAST_IF:
+      case CAST_UF:
+#define FLUIR_SIZED_UNARY(Type, Concrete) case Type##_NEG:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_UNARY)
+#undef FLUIR_SIZED_UNARY
+        return 2;
+      case F64_ADD:
+      case F64_SUB:
+      case F64_MUL:
+      case F64_DIV:
+      case I64_ADD:
+      case I64_SUB:
+      case I64_MUL:
+      case I64_DIV:
+      case U64_ADD:
+      case U64_SUB:
+      case U64_MUL:
+      case U64_DIV:
+      case CAST_IU:
+      case CAST_UI:
+      case CAST_FI:
+      case CAST_FU:
+#define FLUIR_SIZED_BINARY(Type, Concrete) \
+  case Type##_ADD:                         \
+  case Type##_SUB:                         \
+  case Type##_MUL:                         \
+  case Type##_DIV:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_BINARY)
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_BINARY)
+#undef FLUIR_SIZED_BINARY
+        return 3;
+      default:
+        return -1;
+    }
+  }
+
+  /** The width specialized version of an I64_ or U64_ arithmetic instruction for operands of the given type, such as
+   * I8_ADD for I64_ADD and I8. Any other instruction, or a type without specialized instructions, returns generic. */
+  constexpr Instruction sized(Instruction generic, PrimitiveType type) {
+    const bool isInt = generic >= I64_ADD && generic <= I64_NEG;
+    const bool isUint = generic >= U64_ADD && generic <= U64_DIV;
+    const auto family = [generic](Instruction first, Instruction genericFirst) {
+      return static_cast<Instruction>(first + (generic - genericFirst));
+    };
+    switch (type) {
+#define FLUIR_SIZED_INT(Type, Concrete) \
+  case PrimitiveType::Type:             \
+    return isInt ? family(Type##_ADD, I64_ADD) : generic;
+      FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_INT)
+#undef FLUIR_SIZED_INT
+#define FLUIR_SIZED_UINT(Type, Concrete) \
+  case PrimitiveType::Type:              \
+    return isUint ? family(Type##_ADD, U64_ADD) : generic;
+      FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_UINT)
+#undef FLUIR_SIZED_UINT
+      default:
+        return generic;
+    }
+  }
+
 }  // namespace fluir::code
 
 #endif
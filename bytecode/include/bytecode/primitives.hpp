@@ -5,15 +5,22 @@
 
 namespace fluir::code {
   // clang-format off
-#define FLUIR_CODE_PRIMITIVE_TYPES(code)  \
-code(F64, double)                   \
+// The int types narrower than 64 bits. Each has its own width specialized arithmetic instructions.
+#define FLUIR_CODE_SIZED_INT_TYPES(code)  \
 code(I8, std::int8_t)               \
 code(I16, std::int16_t)             \
-code(I32, std::int32_t)             \
-code(I64, std::int64_t)             \
+code(I32, std::int32_t)
+
+#define FLUIR_CODE_SIZED_UINT_TYPES(code) \
 code(U8, std::uint8_t)              \
 code(U16, std::uint16_t)            \
-code(U32, std::uint32_t)            \
+code(U32, std::uint32_t)
+
+#define FLUIR_CODE_PRIMITIVE_TYPES(code)  \
+code(F64, double)                   \
+FLUIR_CODE_SIZED_INT_TYPES(code)    \
+code(I64, std::int64_t)             \
+FLUIR_CODE_SIZED_UINT_TYPES(code)   \
 code(U64, std::uint64_t)
   // clang-format on
 
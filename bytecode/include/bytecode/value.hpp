@@ -1,7 +1,11 @@
 #ifndef FLUIR_VALUE_H
 #define FLUIR_VALUE_H
 
+#include <bit>
+#include <cstdint>
+#include <optional>
 #include <stdexcept>
+#include <type_traits>
 
 #include "primitives.hpp"
 
@@ -36,6 +40,16 @@ namespace fluir::code {
 
 #undef FLUIR_VALUE_ACCESSOR
 
+    // Accessors which skip the type check. Only use these when the type has
+    // already been proven, e.g. by the VM's verifier
+#define FLUIR_VALUE_UNCHECKED_ACCESSOR(Type, Concrete)                                                \
+  [[nodiscard]] Concrete& TEMP_CONCAT(uncheckedAs, Type)() { return data_.Type; }                     \
+  [[nodiscard]] const Concrete& TEMP_CONCAT(uncheckedAs, Type)() const { return data_.Type; }
+
+    FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_VALUE_UNCHECKED_ACCESSOR)
+
+#undef FLUIR_VALUE_UNCHECKED_ACCESSOR
+
    private:
     PrimitiveType type_;
 
@@ -84,6 +98,54 @@ namespace fluir::code {
     }
     return false;
   }
+
+  /** The bits of one of the concrete types in FLUIR_CODE_PRIMITIVE_TYPES, zero extended to a u64 */
+  template <typename T>
+  std::uint64_t toBits(T value) {
+    if constexpr (std::is_integral_v<T>) {
+      return static_cast<std::uint64_t>(static_cast<std::make_unsigned_t<T>>(value));
+    } else {
+      return std::bit_cast<std::uint64_t>(value);
+    }
+  }
+
+  /** The inverse of toBits */
+  template <typename T>
+  T fromBits(std::uint64_t bits) {
+    if constexpr (std::is_integral_v<T>) {
+      return static_cast<T>(static_cast<std::make_unsigned_t<T>>(bits));
+    } else {
+      return std::bit_cast<T>(bits);
+    }
+  }
+
+  /** The bits of a value, zero extended to a u64 */
+  inline std::uint64_t valueBits(const Value& value) {
+    switch (value.type()) {
+#define FLUIR_VALUE_BITS(Type, Concrete) \
+  case PrimitiveType::Type:              \
+    return toBits(value.as##Type());
+
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_VALUE_BITS)
+
+#undef FLUIR_VALUE_BITS
+    }
+    return 0;
+  }
+
+  /** The value of type with the given bits, or nullopt if type is not a PrimitiveType */
+  inline std::optional<Value> valueFromBits(std::uint8_t type, std::uint64_t bits) {
+    switch (static_cast<PrimitiveType>(type)) {
+#define FLUIR_VALUE_FROM_BITS(Type, Concrete) \
+  case PrimitiveType::Type:                   \
+    return Value{fromBits<Concrete>(bits)};
+
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_VALUE_FROM_BITS)
+
+#undef FLUIR_VALUE_FROM_BITS
+    }
+    return std::nullopt;
+  }
 }  // namespace fluir::code
 
 #endif  // FLUIR_VALUE_H
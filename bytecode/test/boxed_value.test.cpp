@@ -0,0 +1,229 @@
+#include "bytecode/boxed_value.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+using fluir::code::BoxedValue;
+using fluir::code::PrimitiveType;
+using fluir::code::Value;
+using fluir::code::WideTable;
+
+using namespace fluir::code::boxed_value_literals;
+
+TEST(TestBoxedValue, IsEightBytes) { EXPECT_EQ(8, sizeof(BoxedValue)); }
+
+TEST(TestBoxedValue, InitializeFloat64) {
+  double expected = 4.5;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::F64, value.type());
+  EXPECT_DOUBLE_EQ(expected, value.asF64());
+}
+
+TEST(TestBoxedValue, InitializeInt64) {
+  std::int64_t expected = -31;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::I64, value.type());
+  EXPECT_FALSE(value.isWide());
+  EXPECT_EQ(expected, value.asI64());
+}
+
+TEST(TestBoxedValue, InitializeInt32) {
+  std::int32_t expected = std::numeric_limits<std::int32_t>::min();
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::I32, value.type());
+  EXPECT_EQ(expected, value.asI32());
+}
+
+TEST(TestBoxedValue, InitializeInt16) {
+  std::int16_t expected = -13;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::I16, value.type());
+  EXPECT_EQ(expected, value.asI16());
+}
+
+TEST(TestBoxedValue, InitializeInt8) {
+  std::int8_t expected = -4;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::I8, value.type());
+  EXPECT_EQ(expected, value.asI8());
+}
+
+TEST(TestBoxedValue, InitializeUint64) {
+  std::uint64_t expected = 12345;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::U64, value.type());
+  EXPECT_FALSE(value.isWide());
+  EXPECT_EQ(expected, value.asU64());
+}
+
+TEST(TestBoxedValue, InitializeUint32) {
+  std::uint32_t expected = std::numeric_limits<std::uint32_t>::max();
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::U32, value.type());
+  EXPECT_EQ(expected, value.asU32());
+}
+
+TEST(TestBoxedValue, InitializeUint16) {
+  std::uint16_t expected = 12;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::U16, value.type());
+  EXPECT_EQ(expected, value.asU16());
+}
+
+TEST(TestBoxedValue, InitializeUint8) {
+  std::uint8_t expected = 255;
+
+  BoxedValue value{expected};
+
+  ASSERT_EQ(PrimitiveType::U8, value.type());
+  EXPECT_EQ(expected, value.asU8());
+}
+
+TEST(TestBoxedValue, PayloadBoundariesStayInline) {
+  constexpr std::int64_t limit = std::int64_t{1} << 46;
+  WideTable wide;
+
+  EXPECT_FALSE(BoxedValue(limit - 1, wide).isWide());
+  EXPECT_FALSE(BoxedValue(-limit, wide).isWide());
+  EXPECT_TRUE(BoxedValue(limit, wide).isWide());
+  EXPECT_TRUE(BoxedValue(-limit - 1, wide).isWide());
+  EXPECT_EQ(-limit, BoxedValue{-limit}.asI64());
+  EXPECT_EQ(limit - 1, BoxedValue{limit - 1}.asI64());
+  EXPECT_EQ(2, wide.size());
+}
+
+TEST(TestBoxedValue, WideInt64IsLossless) {
+  WideTable wide;
+  for (std::int64_t expected : {std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(),
+                                std::int64_t{0x1234'5678'9ABC'DEF0}}) {
+    BoxedValue value{expected, wide};
+
+    ASSERT_EQ(PrimitiveType::I64, value.type());
+    EXPECT_TRUE(value.isWide());
+    EXPECT_EQ(expected, value.asI64(wide));
+  }
+}
+
+TEST(TestBoxedValue, WideUint64IsLossless) {
+  std::uint64_t expected = std::numeric_limits<std::uint64_t>::max();
+  WideTable wide;
+
+  BoxedValue value{expected, wide};
+
+  ASSERT_EQ(PrimitiveType::U64, value.type());
+  EXPECT_TRUE(value.isWide());
+  EXPECT_EQ(expected, value.asU64(wide));
+}
+
+TEST(TestBoxedValue, WideValuesNeedTheirTable) {
+  WideTable wide;
+  BoxedValue value{std::numeric_limits<std::uint64_t>::max(), wide};
+
+  EXPECT_THROW(BoxedValue{std::numeric_limits<std::uint64_t>::max()}, std::runtime_error);
+  EXPECT_THROW(BoxedValue{std::numeric_limits<std::int64_t>::min()}, std::runtime_error);
+  EXPECT_THROW(auto _ = value.asU64(), std::runtime_error);
+  EXPECT_THROW(auto _ = value.toValue(), std::runtime_error);
+}
+
+TEST(TestBoxedValue, WideValuesCopyWithoutNewSlots) {
+  WideTable wide;
+  BoxedValue original{std::numeric_limits<std::uint64_t>::max(), wide};
+
+  BoxedValue copy = original;
+  BoxedValue moved = std::move(original);
+  copy = BoxedValue{std::numeric_limits<std::int64_t>::min(), wide};
+
+  EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(), moved.asU64(wide));
+  EXPECT_EQ(std::numeric_limits<std::int64_t>::min(), copy.asI64(wide));
+  EXPECT_EQ(2, wide.size());
+}
+
+TEST(TestBoxedValue, EqualWideValuesShareASlot) {
+  WideTable wide;
+
+  BoxedValue first{std::numeric_limits<std::uint64_t>::max(), wide};
+  BoxedValue second{std::numeric_limits<std::uint64_t>::max(), wide};
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1, wide.size());
+}
+
+TEST(TestBoxedValue, NaNIsCanonicalized) {
+  BoxedValue positive{std::numeric_limits<double>::quiet_NaN()};
+  BoxedValue negative{-std::numeric_limits<double>::quiet_NaN()};
+
+  ASSERT_EQ(PrimitiveType::F64, positive.type());
+  ASSERT_EQ(PrimitiveType::F64, negative.type());
+  EXPECT_TRUE(std::isnan(positive.asF64()));
+  EXPECT_TRUE(std::isnan(negative.asF64()));
+}
+
+TEST(TestBoxedValue, InfinityIsNotBoxed) {
+  BoxedValue value{-std::numeric_limits<double>::infinity()};
+
+  ASSERT_EQ(PrimitiveType::F64, value.type());
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), value.asF64());
+}
+
+TEST(TestBoxedValue, RoundTripsThroughValue) {
+  for (const Value& expected : {Value{1.5},
+                                Value{std::int8_t{-3}},
+                                Value{std::int64_t{-1} << 60},
+                                Value{std::uint16_t{7}},
+                                Value{std::numeric_limits<std::uint64_t>::max()}}) {
+    WideTable wide;
+    BoxedValue boxed{expected, wide};
+
+    EXPECT_EQ(expected.type(), boxed.type());
+    EXPECT_EQ(expected, boxed.toValue(wide));
+  }
+}
+
+TEST(TestBoxedValue, EqualityComparesTypeAndValue) {
+  EXPECT_EQ(12_i64, 12_i64);
+  EXPECT_NE(12_i64, 12_u64);
+  EXPECT_NE(12_i32, 13_i32);
+  WideTable wide;
+  EXPECT_EQ(BoxedValue(std::numeric_limits<std::int64_t>::max(), wide),
+            BoxedValue(std::numeric_limits<std::int64_t>::max(), wide));
+  EXPECT_NE(BoxedValue(std::numeric_limits<std::int64_t>::max(), wide),
+            BoxedValue(std::numeric_limits<std::int64_t>::min(), wide));
+}
+
+TEST(TestBoxedValue, I64AccessChecksForFloat) {
+  BoxedValue value = 4.5_f64;
+
+  EXPECT_THROW(auto _ = value.asI64(), std::runtime_error);
+}
+
+TEST(TestBoxedValue, F64AccessChecksForFloat) {
+  BoxedValue value = 12_u64;
+
+  EXPECT_THROW(auto _ = value.asF64(), std::runtime_error);
+}
+
+TEST(TestBoxedValue, U64AccessChecksForFloat) {
+  BoxedValue value = 12_i64;
+
+  EXPECT_THROW(auto _ = value.asU64(), std::runtime_error);
+}
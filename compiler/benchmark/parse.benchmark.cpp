@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include "compiler/frontend/parser.hpp"
+
+namespace {
+  std::atomic<std::size_t> heapBytes{0};
+  std::atomic<std::size_t> peakHeapBytes{0};
+
+  /* Each allocation starts with its size, padded so what follows keeps the alignment malloc gives */
+  constexpr std::size_t SIZE_HEADER = alignof(std::max_align_t);
+}  // namespace
+
+/* Every allocation is counted, so a benchmark can find the most the heap held while it ran */
+void* operator new(std::size_t size) {
+  auto* memory = static_cast<std::byte*>(std::malloc(SIZE_HEADER + size));
+  if (memory == nullptr) {
+    throw std::bad_alloc{};
+  }
+  *reinterpret_cast<std::size_t*>(memory) = size;
+  const auto now = heapBytes += size;
+  auto peak = peakHeapBytes.load();
+  while (now > peak && !peakHeapBytes.compare_exchange_weak(peak, now)) { }
+  return memory + SIZE_HEADER;
+}
+
+void operator delete(void* memory) noexcept {
+  if (memory != nullptr) {
+    auto* allocation = static_cast<std::byte*>(memory) - SIZE_HEADER;
+    heapBytes -= *reinterpret_cast<std::size_t*>(allocation);
+    std::free(allocation);
+  }
+}
+
+void operator delete(void* memory, std::size_t) noexcept { operator delete(memory); }
+
+namespace {
+  constexpr std::size_t NODES_PER_FUNCTION = 1'000;
+
+  /* A .fl source of the given number of functions, each of which adds up NODES_PER_FUNCTION constants */
+  std::string source(std::size_t functions) {
+    std::string text = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<fluir>\n";
+    for (std::size_t function = 0; function != functions; ++function) {
+      fmt::format_to(std::back_inserter(text),
+                     "  <function name=\"f{}\" id=\"{}\" x=\"0\" y=\"0\" z=\"0\" w=\"100\" h=\"100\">\n    <body>\n",
+                     function,
+                     function + 1);
+      for (std::size_t node = 0; node != NODES_PER_FUNCTION; node += 2) {
+        // A constant, then a sum of it and the sum before it, joined by conduits
+        fmt::format_to(std::back_inserter(text),
+                       "      <constant id=\"{0}\" x=\"{1}\" y=\"0\" z=\"0\" w=\"5\" h=\"5\">\n"
+                       "        <float>{2}.5</float>\n"
+                       "      </constant>\n"
+                       "      <binary id=\"{3}\" x=\"{1}\" y=\"10\" z=\"0\" w=\"5\" h=\"5\" operator=\"+\" />\n"
+                       "      <conduit id=\"{4}\" input=\"{0}\">\n"
+                       "        <output target=\"{3}\" index=\"1\" />\n"
+                       "      </conduit>\n",
+                       3 * node + 1,
+                       node,
+                       node / 2,
+                       3 * node + 2,
+                       3 * node + 3);
+      }
+      text += "    </body>\n  </function>\n";
+    }
+    text += "</fluir>\n";
+    return text;
+  }
+
+  /* Writes the source to a temporary .fl file, returning its path */
+  std::filesystem::path sourceFile(std::size_t functions) {
+    const auto path = std::filesystem::temp_directory_path() / fmt::format("fluir_parse_{}.fl", functions);
+    std::ofstream fout{path, std::ios::binary};
+    fout << source(functions);
+    return path;
+  }
+}  // namespace
+
+/* Parses generated .fl files of several megabytes from disk, reporting the throughput, the most the heap held while
+ * parsing and how much of that is the parse tree which is left at the end */
+static void BM_ParseFile(benchmark::State& state) {
+  const auto path = sourceFile(static_cast<std::size_t>(state.range(0)));
+  const auto size = std::filesystem::file_size(path);
+  std::size_t peak = 0;
+  std::size_t tree = 0;
+  for (auto _ : state) {
+    const auto before = heapBytes.load();
+    peakHeapBytes = before;
+    fluir::Context ctx;
+    auto results = fluir::parseFile(ctx, path);
+    benchmark::DoNotOptimize(results);
+    peak = std::max(peak, peakHeapBytes.load() - before);
+    tree = heapBytes.load() - before;
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+  state.counters["file_bytes"] = static_cast<double>(size);
+  state.counters["peak_heap_kb"] = static_cast<double>(peak) / 1024;
+  state.counters["peak_heap_per_byte"] = static_cast<double>(peak) / static_cast<double>(size);
+  state.counters["tree_kb"] = static_cast<double>(tree) / 1024;
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_ParseFile)->Arg(1)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+
+/* Parses the same sources from memory, without reading a file */
+static void BM_ParseString(benchmark::State& state) {
+  const auto text = source(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    fluir::Context ctx;
+    auto results = fluir::parseString(ctx, text);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_ParseString)->Arg(1)->Arg(16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,23 @@
+#ifndef FLUIR_COMPILER_BACKEND_BINARY_WRITER_HPP
+#define FLUIR_COMPILER_BACKEND_BINARY_WRITER_HPP
+
+#include "compiler/backend/code_writer.hpp"
+
+namespace fluir {
+  /** Writes code in the binary format (filetype 'B') described in bytecode/binary_format.hpp.
+   *
+   * The section table at the front of the file needs the size of every section, so the code is collected as it is
+   * written and only encoded once the last chunk is known.
+   */
+  class BinaryWriter : public CodeWriter {
+   private:
+    code::ByteCode code_;
+
+    void writeHeader(const code::Header&, std::ostream&) override;
+    void writeSharedConstants(const std::vector<code::Value>&, std::ostream&) override;
+    void writeChunk(const code::Chunk&, std::ostream&) override;
+    void finish(std::ostream&) override;
+  };
+}  // namespace fluir
+
+#endif
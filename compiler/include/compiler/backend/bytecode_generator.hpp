@@ -1,18 +1,40 @@
 #ifndef FLUIR_COMPILER_BACKEND_BYTECODE_GENERATOR_HPP
 #define FLUIR_COMPILER_BACKEND_BYTECODE_GENERATOR_HPP
 
+#include <optional>
+
 #include "bytecode/byte_code.hpp"
 #include "compiler/backend/code_writer.hpp"
+#include "compiler/backend/constant_pool.hpp"
 #include "compiler/models/asg.hpp"
+#include "compiler/models/operator.hpp"
 #include "compiler/utility/context.hpp"
 
 namespace fluir {
   Results<code::ByteCode> generateCode(Context& ctx, const asg::ASG& graph);
+  /** Generates code with a single constant table shared by every chunk, which stores constants repeated across
+   * functions once */
+  Results<code::ByteCode> generateCodeSharingConstants(Context& ctx, const asg::ASG& graph);
   void writeCode(const code::ByteCode& code, CodeWriter& writer, std::ostream& destination);
 
+  /** The instruction applying a binary op to operands of type, or nullopt if op is not a binary operator. Ints narrower
+   * than 64 bits get the instruction specialized to their width, which skips widening them at runtime. */
+  std::optional<code::Instruction> binaryInstruction(Operator op, code::PrimitiveType type);
+  /** The instruction applying a unary op to an operand of type, or nullopt if there is none, such as for negating a
+   * uint */
+  std::optional<code::Instruction> unaryInstruction(Operator op, code::PrimitiveType type);
+
+  struct GeneratorOptions {
+    /** Put every constant in ByteCode::constants instead of the table of the chunk using it */
+    bool shareConstants{false};
+    /** Also give each sink of a function with several a chunk of its own, named {function}_sink{n}, which the VM can
+     * run concurrently. Nodes shared between sinks are generated again in each of their chunks. */
+    bool subgraphs{false};
+  };
+
   class BytecodeGenerator {
    public:
-    static Results<code::ByteCode> generate(Context& ctx, const asg::ASG& graph);
+    static Results<code::ByteCode> generate(Context& ctx, const asg::ASG& graph, GeneratorOptions options = {});
 
     void operator()(const asg::FunctionDecl& func);
 
@@ -23,14 +45,22 @@ namespace fluir {
    private:
     Context& ctx_;
     const asg::ASG& graph_;
+    GeneratorOptions options_;
     code::ByteCode code_;
     code::Chunk current_;
+    /** The constants of the current chunk, or of the whole module when they are shared */
+    ConstantPool constants_{code::WIDE_CONSTANTS};
 
-    explicit BytecodeGenerator(Context& ctx, const asg::ASG& graph);
+    explicit BytecodeGenerator(Context& ctx, const asg::ASG& graph, GeneratorOptions options);
 
     void emitByte(std::uint8_t byte);
     void emitBytes(std::uint8_t byte1, std::uint8_t byte2);
-    size_t addConstant(code::Value value);
+    /** The index of value in the constant table, adding it if it is new, or nullopt if the table is full */
+    std::optional<size_t> addConstant(code::Value value);
+    /** Moves the constants added since the last call into the current chunk, unless they are shared */
+    void finishChunk();
+    /** Attributes the code emitted from here on to node, until another node is marked */
+    void mark(const asg::Node& node);
 
     Results<code::ByteCode> run();
     void recursivelyGenerate(const asg::Node& node);
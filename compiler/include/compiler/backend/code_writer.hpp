@@ -14,7 +14,11 @@ namespace fluir {
 
    private:
     virtual void writeHeader(const code::Header&, std::ostream&) = 0;
+    /** Only called for modules with a shared constant table, between the header and the first chunk */
+    virtual void writeSharedConstants(const std::vector<code::Value>&, std::ostream&) = 0;
     virtual void writeChunk(const code::Chunk&, std::ostream&) = 0;
+    /** Called after the last chunk, for formats which can only be written once every chunk is known */
+    virtual void finish(std::ostream&) { }
   };
 }  // namespace fluir
 
@@ -0,0 +1,52 @@
+#ifndef FLUIR_COMPILER_BACKEND_CONSTANT_POOL_HPP
+#define FLUIR_COMPILER_BACKEND_CONSTANT_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "bytecode/value.hpp"
+
+namespace fluir {
+  /** Builds a constant table which holds each distinct value once.
+   *
+   * Values are found through a hash index rather than by searching the table, so interning stays constant time however
+   * many constants a chunk has. Values are compared bit for bit instead of with operator==: -0.0 and 0.0 get entries of
+   * their own, and every copy of the same NaN shares one entry.
+   */
+  class ConstantPool {
+   public:
+    explicit ConstantPool(std::size_t capacity = std::numeric_limits<std::size_t>::max());
+
+    /** The index of value in the table, adding it if it is new, or nullopt if the table is full */
+    std::optional<std::size_t> intern(const code::Value& value);
+
+    [[nodiscard]] const std::vector<code::Value>& values() const { return values_; }
+    [[nodiscard]] std::size_t size() const { return values_.size(); }
+    /** Hands over the table, leaving the pool empty */
+    std::vector<code::Value> take();
+
+   private:
+    /** A value's type and its bits, zero extended to 64 bits */
+    struct Key {
+      code::PrimitiveType type;
+      std::uint64_t bits;
+
+      friend bool operator==(const Key&, const Key&) = default;
+    };
+    struct KeyHash {
+      std::size_t operator()(const Key& key) const;
+    };
+
+    std::size_t capacity_;
+    std::vector<code::Value> values_;
+    std::unordered_map<Key, std::size_t, KeyHash> indices_;
+
+    static Key keyOf(const code::Value& value);
+  };
+}  // namespace fluir
+
+#endif
@@ -9,12 +9,17 @@
 namespace fluir {
   class InspectWriter : public CodeWriter, private IndentFormatter<> {
    private:
+    bool registers_{false};
+
     void writeHeader(const code::Header&, std::ostream&) override;
+    void writeSharedConstants(const std::vector<code::Value>&, std::ostream&) override;
     void writeChunk(const code::Chunk&, std::ostream&) override;
 
     void writeConstants(const std::vector<code::Value>&, std::ostream&);
     void writeConstant(const code::Value&, std::ostream&);
     void writeCode(const code::Bytes&, std::ostream&);
+    void writeSubgraphs(const std::vector<code::Subgraph>&, std::ostream&);
+    void writeDebug(const std::vector<code::DebugEntry>&, std::ostream&);
   };
 }  // namespace fluir
 
@@ -0,0 +1,54 @@
+#ifndef FLUIR_COMPILER_BACKEND_REGISTER_GENERATOR_HPP
+#define FLUIR_COMPILER_BACKEND_REGISTER_GENERATOR_HPP
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "bytecode/byte_code.hpp"
+#include "compiler/backend/constant_pool.hpp"
+#include "compiler/models/asg.hpp"
+#include "compiler/utility/context.hpp"
+
+namespace fluir {
+  /** Generates code for the register instruction set (filetype 'R') */
+  Results<code::ByteCode> generateRegisterCode(Context& ctx, const asg::ASG& graph);
+
+  /** Lowers each node of a data flow graph into a single register, SSA style.
+   *
+   * A chunk's constants are preloaded into its first registers, so constants never need an instruction. Every other
+   * node writes its value to a fresh register exactly once, and nodes shared by several consumers are only computed a
+   * single time.
+   */
+  class RegisterGenerator {
+   public:
+    static Results<code::ByteCode> generate(Context& ctx, const asg::ASG& graph);
+
+    void operator()(const asg::FunctionDecl& func);
+
+    std::uint8_t generate(const asg::BinaryOp& binary);
+    std::uint8_t generate(const asg::UnaryOp& unary);
+    std::uint8_t generate(const asg::ConstantFP& constant);
+
+   private:
+    Context& ctx_;
+    const asg::ASG& graph_;
+    code::ByteCode code_;
+    code::Chunk current_;
+    ConstantPool constants_;
+    /** The register holding the value of each node which has already been generated */
+    std::unordered_map<asg::Node const*, std::uint8_t> registers_;
+    std::size_t nextRegister_{0};
+
+    explicit RegisterGenerator(Context& ctx, const asg::ASG& graph);
+
+    void emitBytes(std::initializer_list<std::uint8_t> bytes);
+    std::size_t addConstant(code::Value value);
+    std::uint8_t allocateRegister();
+
+    Results<code::ByteCode> run();
+    void collectConstants(const asg::Node& node);
+    std::uint8_t recursivelyGenerate(const asg::Node& node);
+  };
+}  // namespace fluir
+
+#endif
@@ -2,12 +2,12 @@
 #define FLUIR_COMPILER_FRONTEND_PARSER_HPP
 
 #include <filesystem>
+#include <istream>
 #include <string>
 #include <utility>
 
-#include <tinyxml2.h>
-
 #include "compiler/frontend/parse_tree/parse_tree.hpp"
+#include "compiler/frontend/xml_reader.hpp"
 #include "compiler/utility/results.hpp"
 #include "compiler/utility/context.hpp"
 
@@ -15,51 +15,58 @@ namespace fluir {
   Results<pt::ParseTree> parseString(Context& ctx, const std::string_view source);
   Results<pt::ParseTree> parseFile(Context& ctx, const std::filesystem::path& source);
 
+  /** Parses .fl sources into a ParseTree as they are read.
+   *
+   * Elements are pulled out of the source one tag at a time with an XmlReader and turned straight into the tree, so
+   * the parser never holds more of the source than the reader's window. An error in an element is reported at the
+   * line the element starts on, and the rest of the element is skipped before parsing goes on with its next sibling.
+   */
   class Parser {
    public:
     explicit Parser(Context& ctx);
 
     Results<pt::ParseTree> parseString(const std::string_view source);
     Results<pt::ParseTree> parseFile(const std::filesystem::path& file);
+    /** Parses the source read from in, naming it filename in diagnostics */
+    Results<pt::ParseTree> parseStream(std::istream& in, std::string filename);
 
    private:
     Context& ctx_;
     std::string filename_;
-    tinyxml2::XMLDocument doc_;
+    /** The reader of the source being parsed, whose last START is the element being parsed */
+    XmlReader* reader_{nullptr};
     pt::ParseTree tree_;
 
-    using Element = tinyxml2::XMLElement;
+    Results<pt::ParseTree> parse(XmlReader& reader);
 
     void flowGraph();
-    void declaration(Element* element);
-    void functionDecl(Element* element);
-
-    pt::Block block(Element* element);
-    std::pair<ID, pt::Node> node(Element* element);
-    std::pair<ID, pt::Node> constant(Element* element);
-    std::pair<ID, pt::Node> binary(Element* element);
-    std::pair<ID, pt::Node> unary(Element* element);
-
-    std::pair<ID, pt::Conduit> conduit(Element* element);
-    pt::Conduit::Output conduitOutput(Element* element);
-
-    pt::Literal literal(Element* element);
-    pt::Float fl_float(Element* element);
-
-    std::string_view getAttribute(Element* element, std::string_view type, std::string_view attribute);
-    std::string_view getOptionalAttribute(Element* element,
-                                          std::string_view attribute,
-                                          std::string_view defaultValue = "");
-    ID parseId(Element* element, std::string_view type);
-    ID parseIdReference(Element* element, std::string_view attribute, std::string_view type);
-    ID parseOptionalIdReference(Element* element, std::string_view attribute, std::string_view type);
-    FlowGraphLocation parseLocation(Element* element, std::string_view type);
-    Operator parseOperator(Element* element, std::string_view attribute, std::string_view type);
+    void declaration();
+    void functionDecl();
+
+    pt::Block block();
+    std::pair<ID, pt::Node> node();
+    std::pair<ID, pt::Node> constant();
+    std::pair<ID, pt::Node> binary();
+    std::pair<ID, pt::Node> unary();
+
+    std::pair<ID, pt::Conduit> conduit();
+    pt::Conduit::Output conduitOutput();
+
+    pt::Literal literal();
+    pt::Float fl_float();
+
+    std::string_view getAttribute(std::string_view type, std::string_view attribute);
+    std::string_view getOptionalAttribute(std::string_view attribute, std::string_view defaultValue = "");
+    ID parseId(std::string_view type);
+    ID parseIdReference(std::string_view attribute, std::string_view type);
+    ID parseOptionalIdReference(std::string_view attribute, std::string_view type);
+    FlowGraphLocation parseLocation(std::string_view type);
+    Operator parseOperator(std::string_view attribute, std::string_view type);
 
     template <typename... FmtArgs>
-    void panicIf(bool condition, Element* element, std::string_view format, FmtArgs... args);
+    void panicIf(bool condition, int line, std::string_view format, FmtArgs... args);
     template <typename... FmtArgs>
-    [[noreturn]] void panicAt(Element* element, std::string_view format, FmtArgs... args);
+    [[noreturn]] void panicAt(int line, std::string_view format, FmtArgs... args);
     /** Indicates the parser is in a panic */
     class PanicMode { };
 
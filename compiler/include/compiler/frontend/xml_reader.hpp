@@ -0,0 +1,112 @@
+#ifndef FLUIR_COMPILER_FRONTEND_XML_READER_HPP
+#define FLUIR_COMPILER_FRONTEND_XML_READER_HPP
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fluir {
+  /** Pulls the tags of an XML document out of a stream one at a time.
+   *
+   * Only a fixed window of the stream is held, along with the tag being read and the names of the elements it is
+   * nested in, so documents far larger than memory can be read. Text, comments, processing instructions and the
+   * DOCTYPE between tags are skipped, unless an element's text is asked for. Entities in attribute values and text are
+   * replaced. Throws a SyntaxError if the document is not well formed.
+   */
+  class XmlReader {
+   public:
+    enum class Event {
+      START,
+      END,
+      END_OF_DOCUMENT
+    };
+
+    struct SyntaxError {
+      int line;            /**< The line the error was found on */
+      std::string message; /**< What is wrong with the document */
+    };
+
+    static constexpr std::size_t DEFAULT_WINDOW = 64 * 1024;
+
+    /** Reads from in, which must outlive the reader, window bytes at a time */
+    explicit XmlReader(std::istream& in, std::size_t window = DEFAULT_WINDOW);
+    /** Reads the document in source, which must outlive the reader, without copying it */
+    explicit XmlReader(std::string_view source);
+
+    /** Reads up to and including the next start or end tag. A self-closing tag is read as a START, then an END. */
+    Event next();
+    /** Skips to the END of the element which leaves depth elements open. Does nothing if there already are. */
+    void skipTo(std::size_t depth);
+    /** Skips the rest of the element of the last START, up to and including its END */
+    void skipElement() { skipTo(depth() - 1); }
+
+    /** The name of the element of the last START or END */
+    [[nodiscard]] std::string_view name() const { return name_; }
+    /** The line the last tag started on, counting from 1 */
+    [[nodiscard]] int line() const { return tagLine_; }
+    /** The number of elements which have started but not ended, counting a self-closing element until its END */
+    [[nodiscard]] std::size_t depth() const { return open_.size() + (pendingEnd_ ? 1 : 0); }
+    /** The value of the attribute of the last START with the given name, if it has one. The value is null terminated
+     * and stays valid until the next call to next. */
+    [[nodiscard]] std::optional<std::string_view> attribute(std::string_view name) const;
+    /** The text at the start of the element of the last START, before any child element, if there is any besides
+     * whitespace. It stays valid until the next call to next. */
+    std::optional<std::string_view> text();
+
+   private:
+    std::istream* in_{nullptr};
+    std::unique_ptr<char[]> window_;
+    std::size_t windowSize_{0};
+    const char* pos_{nullptr};
+    const char* end_{nullptr};
+
+    int line_{1};
+    int tagLine_{1};
+    std::string name_;
+    /** Every attribute of the last START. Only the first attributeCount_ are used, so their storage is reused. */
+    std::vector<std::pair<std::string, std::string>> attributes_;
+    std::size_t attributeCount_{0};
+    std::string text_;
+    /** The names of the elements which have started but not ended, outermost first */
+    std::vector<std::string> open_;
+    /** Whether the last START was self-closing, so its END is read next */
+    bool pendingEnd_{false};
+    /** Whether text has already read the '<' of the next tag */
+    bool atTag_{false};
+
+    /** Whether there is anything left to read, refilling the window if it is used up */
+    bool more();
+    bool refill();
+    [[nodiscard]] char peek() const { return *pos_; }
+    /** Consumes the next character, which must be c */
+    void expect(char c, std::string_view context);
+    /** Consumes characters while they satisfy keep, counting lines */
+    template <typename Predicate>
+    void skipWhile(Predicate keep);
+    /** Appends characters to out while they satisfy keep, counting lines */
+    template <typename Predicate>
+    void appendWhile(Predicate keep, std::string& out);
+    void skipWhitespace();
+    /** Skips past the first occurrence of terminator */
+    void skipPast(std::string_view terminator, std::string_view context);
+    /** Skips a declaration such as <!DOCTYPE ...>, whose "<!" has been read */
+    void skipDeclaration();
+
+    void readName(std::string& out, std::string_view context);
+    void readAttributes();
+    void readValue(char quote, std::string& out);
+    /** Appends the character an entity stands for, whose '&' is next, or the entity itself if it is not known */
+    void readEntity(std::string& out);
+    /** Appends the contents of a CDATA section, whose "<!" has been read */
+    void readCData(std::string& out);
+
+    [[noreturn]] void fail(std::string message) const;
+  };
+}  // namespace fluir
+
+#endif
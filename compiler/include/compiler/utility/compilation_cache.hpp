@@ -0,0 +1,49 @@
+#ifndef FLUIR_COMPILER_UTILITY_COMPILATION_CACHE_HPP
+#define FLUIR_COMPILER_UTILITY_COMPILATION_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fluir {
+  /** A directory of compiled code, addressed by the hash of everything that decides what the compiler writes: the
+   * source, the compiler's version, the sources it was built from and its options.
+   *
+   * Each entry is one file named after its key. Entries are written to a temporary file and renamed into place, so
+   * compilers sharing the directory never read half of an entry. Finding an entry marks it as used, and storing one
+   * evicts the least recently used entries until the directory fits its size limit. The cache is only an
+   * optimization: if the directory cannot be read or written, lookups miss and stores are dropped.
+   */
+  class CompilationCache {
+   public:
+    static constexpr std::uintmax_t DEFAULT_LIMIT = 256 * 1024 * 1024;
+
+    explicit CompilationCache(std::filesystem::path directory, std::uintmax_t limit = DEFAULT_LIMIT);
+
+    /** The directory named by FLUIR_CACHE_DIR, or else fluir in the user's cache directory, if either is set */
+    static std::optional<std::filesystem::path> defaultDirectory();
+    /** The key of source compiled by this compiler, where options names every option which changes its output */
+    static std::string key(std::string_view source, std::string_view options);
+    /** The SHA-256 of bytes as 64 lowercase hex digits */
+    static std::string digest(std::string_view bytes);
+
+    /** The output stored under key, if there is any */
+    [[nodiscard]] std::optional<std::string> find(const std::string& key) const;
+    /** Stores output under key, then evicts entries until the cache fits its limit */
+    void store(const std::string& key, std::string_view output) const;
+
+    [[nodiscard]] const std::filesystem::path& directory() const { return directory_; }
+    [[nodiscard]] std::uintmax_t limit() const { return limit_; }
+
+   private:
+    std::filesystem::path directory_;
+    std::uintmax_t limit_;
+
+    [[nodiscard]] std::filesystem::path entry(const std::string& key) const;
+    void evict() const;
+  };
+}  // namespace fluir
+
+#endif
@@ -0,0 +1,22 @@
+#include "compiler/backend/binary_writer.hpp"
+
+#include <utility>
+
+#include "bytecode/binary_format.hpp"
+
+namespace fluir {
+  void BinaryWriter::writeHeader(const code::Header& header, std::ostream&) {
+    code_ = code::ByteCode{.header = header};
+  }
+
+  void BinaryWriter::writeSharedConstants(const std::vector<code::Value>& constants, std::ostream&) {
+    code_.constants = constants;
+  }
+
+  void BinaryWriter::writeChunk(const code::Chunk& chunk, std::ostream&) { code_.chunks.push_back(chunk); }
+
+  void BinaryWriter::finish(std::ostream& os) {
+    const auto bytes = code::binary::encode(std::exchange(code_, {}));
+    os.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  }
+}  // namespace fluir
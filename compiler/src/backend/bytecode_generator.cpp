@@ -1,22 +1,88 @@
 #include "compiler/backend/bytecode_generator.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
 
 #include <fmt/format.h>
 
 using fluir::code::Instruction;
 
 namespace fluir {
+  namespace {
+    /** The type of value a node leaves on the stack. Arithmetic keeps the type of its operands.
+     *
+     * Constants are the only leaves, and the ASG only has F64 constants so far, so every node is an F64 until the ASG
+     * carries types. Until then, the int paths of binaryInstruction and unaryInstruction are only reached by calling
+     * them directly. */
+    code::PrimitiveType typeOf(const asg::Node& node) {
+      switch (node.kind()) {
+        case asg::NodeKind::BinaryOperator:
+          return typeOf(*node.as<asg::BinaryOp>()->lhs());
+        case asg::NodeKind::UnaryOperator:
+          return typeOf(*node.as<asg::UnaryOp>()->operand());
+        case asg::NodeKind::Constant:
+          return code::PrimitiveType::F64;
+      }
+      return code::PrimitiveType::F64;
+    }
+
+    /** Picks between the F64, I64 and U64 forms of an arithmetic instruction by the type of its operands. Ints
+     * narrower than 64 bits get the instruction specialized to their width, which skips widening them at runtime. */
+    Instruction arithmetic(code::PrimitiveType type, Instruction f64, Instruction i64, Instruction u64) {
+      if (type == code::PrimitiveType::F64) {
+        return f64;
+      }
+      return code::sized((static_cast<std::uint8_t>(type) & code::SIGNED) != 0 ? i64 : u64, type);
+    }
+  }  // namespace
+
+  std::optional<code::Instruction> binaryInstruction(Operator op, code::PrimitiveType type) {
+    switch (op) {
+      case Operator::PLUS:
+        return arithmetic(type, Instruction::F64_ADD, Instruction::I64_ADD, Instruction::U64_ADD);
+      case Operator::MINUS:
+        return arithmetic(type, Instruction::F64_SUB, Instruction::I64_SUB, Instruction::U64_SUB);
+      case Operator::STAR:
+        return arithmetic(type, Instruction::F64_MUL, Instruction::I64_MUL, Instruction::U64_MUL);
+      case Operator::SLASH:
+        return arithmetic(type, Instruction::F64_DIV, Instruction::I64_DIV, Instruction::U64_DIV);
+      case Operator::UNKNOWN:
+        break;
+    }
+    return std::nullopt;
+  }
+
+  std::optional<code::Instruction> unaryInstruction(Operator op, code::PrimitiveType type) {
+    switch (op) {
+      case Operator::PLUS:
+        return arithmetic(type, Instruction::F64_AFF, Instruction::I64_AFF, Instruction::U64_AFF);
+      case Operator::MINUS:
+        // There is no instruction to negate a uint
+        if (type != code::PrimitiveType::F64 && (static_cast<std::uint8_t>(type) & code::SIGNED) == 0) {
+          return std::nullopt;
+        }
+        return arithmetic(type, Instruction::F64_NEG, Instruction::I64_NEG, Instruction::I64_NEG);
+      default:
+        break;
+    }
+    return std::nullopt;
+  }
+
   Results<code::ByteCode> generateCode(Context& ctx, const asg::ASG& graph) {
     return BytecodeGenerator::generate(ctx, graph);
   }
 
+  Results<code::ByteCode> generateCodeSharingConstants(Context& ctx, const asg::ASG& graph) {
+    return BytecodeGenerator::generate(ctx, graph, {.shareConstants = true});
+  }
+
   void writeCode(const code::ByteCode& code, CodeWriter& writer, std::ostream& destination) {
     return writer.write(code, destination);
   }
 
-  Results<code::ByteCode> BytecodeGenerator::generate(Context& ctx, const asg::ASG& graph) {
-    BytecodeGenerator generator{ctx, graph};
+  Results<code::ByteCode> BytecodeGenerator::generate(Context& ctx, const asg::ASG& graph, GeneratorOptions options) {
+    BytecodeGenerator generator{ctx, graph, options};
     return generator.run();
   }
 
@@ -27,79 +93,122 @@ namespace fluir {
     for (const auto& node : func.statements) {
       recursivelyGenerate(*node);
       // Each top level node will leave a value on the stack, so pop it off
+      mark(*node);
       emitByte(Instruction::POP);
     }
 
     // (FOR NOW) end all functions with the EXIT instruction
     emitByte(Instruction::EXIT);
-    code_.chunks.push_back(std::move(current_));
+    finishChunk();
+    auto function = std::move(current_);
+    // Any errors would be reported again while generating the sinks
+    if (!options_.subgraphs || func.statements.size() < 2 || ctx_.diagnostics.containsErrors()) {
+      code_.chunks.push_back(std::move(function));
+      return;
+    }
+
+    // Each sink also gets a chunk of its own, placed right after the function's, so the VM can run them concurrently.
+    // Every sink only reads constants today, and nodes shared between sinks are generated again for each one, so no
+    // sink depends on another yet.
+    std::vector<code::Chunk> sinks;
+    for (const auto& node : func.statements) {
+      current_ = code::Chunk{};
+      // Chunk names are words in the inspect format, so the name of a sink could also be the name of a function
+      current_.name = fmt::format("{}_sink{}", func.name, sinks.size());
+      if (std::ranges::any_of(graph_.declarations,
+                              [&](const asg::FunctionDecl& other) { return other.name == current_.name; })) {
+        ctx_.diagnostics.emitError(fmt::format(
+          "Function {} has the name of the chunk for sink {} of {}.", current_.name, sinks.size(), func.name));
+        code_.chunks.push_back(std::move(function));
+        return;
+      }
+      recursivelyGenerate(*node);
+      mark(*node);
+      emitByte(Instruction::POP);
+      emitByte(Instruction::EXIT);
+      finishChunk();
+      function.subgraphs.push_back(code::Subgraph{.chunk = code_.chunks.size() + 1 + sinks.size(), .dependencies = {}});
+      sinks.push_back(std::move(current_));
+    }
+    code_.chunks.push_back(std::move(function));
+    std::ranges::move(sinks, std::back_inserter(code_.chunks));
   }
 
   void BytecodeGenerator::generate(const asg::BinaryOp& node) {
     recursivelyGenerate(*node.lhs());
     recursivelyGenerate(*node.rhs());
+    mark(node);
 
-    // TODO: Handle other types here
-    switch (node.op()) {
-      case Operator::PLUS:
-        emitByte(Instruction::F64_ADD);
-        break;
-      case Operator::MINUS:
-        emitByte(Instruction::F64_SUB);
-        break;
-      case Operator::STAR:
-        emitByte(Instruction::F64_MUL);
-        break;
-      case Operator::SLASH:
-        emitByte(Instruction::F64_DIV);
-        break;
-      case Operator::UNKNOWN:
-        // TODO: Handle this better
-        ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -, *, /");
-        break;
+    if (auto instruction = binaryInstruction(node.op(), typeOf(*node.lhs()))) {
+      emitByte(*instruction);
+    } else {
+      // TODO: Handle this better
+      ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -, *, /");
     }
   }
 
   void BytecodeGenerator::generate(const asg::UnaryOp& node) {
     recursivelyGenerate(*node.operand());
-    // TODO: Handle other types here
-    switch (node.op()) {
-      case Operator::PLUS:
-        emitByte(Instruction::F64_AFF);
-        break;
-      case Operator::MINUS:
-        emitByte(Instruction::F64_NEG);
-        break;
-      default:
-        // TODO: Handle this better
-        ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -");
-        break;
+    mark(node);
+    if (auto instruction = unaryInstruction(node.op(), typeOf(*node.operand()))) {
+      emitByte(*instruction);
+    } else if (node.op() == Operator::MINUS) {
+      ctx_.diagnostics.emitError(fmt::format("Node {} negates an unsigned integer, which has no negative.", node.id()));
+    } else {
+      // TODO: Handle this better
+      ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -");
     }
   }
 
   void BytecodeGenerator::generate(const asg::ConstantFP& node) {
     const auto constant = addConstant(code::Value(node.value()));
 
-    // TODO: Handle more constants with special instruction
-    emitBytes(Instruction::PUSH, static_cast<std::uint8_t>(constant));
+    mark(node);
+    if (!constant) {
+      // The constant table is full, so carry the value in the code instead
+      emitByte(Instruction::PUSH_F64_IMM);
+      code::writeOperand(node.value(), std::back_inserter(current_.code));
+    } else if (*constant > UINT8_MAX) {
+      emitByte(Instruction::PUSH_WIDE);
+      code::writeOperand(static_cast<std::uint16_t>(*constant), std::back_inserter(current_.code));
+    } else {
+      emitBytes(Instruction::PUSH, static_cast<std::uint8_t>(*constant));
+    }
   }
 
-  BytecodeGenerator::BytecodeGenerator(Context& ctx, const asg::ASG& graph) : ctx_(ctx), graph_(graph), code_{} { }
+  BytecodeGenerator::BytecodeGenerator(Context& ctx, const asg::ASG& graph, GeneratorOptions options) :
+    ctx_(ctx), graph_(graph), options_(options), code_{} { }
 
   void BytecodeGenerator::emitByte(std::uint8_t byte) { current_.code.push_back(byte); }
   void BytecodeGenerator::emitBytes(std::uint8_t byte1, std::uint8_t byte2) {
     emitByte(byte1);
     emitByte(byte2);
   }
-  size_t BytecodeGenerator::addConstant(code::Value value) {
-    if (auto found = std::ranges::find(current_.constants, value); found != current_.constants.end()) {
-      return found - current_.constants.begin();
+  std::optional<size_t> BytecodeGenerator::addConstant(code::Value value) { return constants_.intern(value); }
+
+  void BytecodeGenerator::finishChunk() {
+    if (!options_.shareConstants) {
+      current_.constants = constants_.take();
+    }
+  }
+
+  void BytecodeGenerator::mark(const asg::Node& node) {
+    auto& debug = current_.debug;
+    // A node marked without emitting any code owns nothing, so the new node replaces it
+    if (!debug.empty() && debug.back().offset == current_.code.size()) {
+      debug.pop_back();
     }
-    current_.constants.emplace_back(std::move(value));
-    if (current_.constants.size() > UINT8_MAX) {
-      ctx_.diagnostics.emitError(fmt::format("Too many constants. Only {} constants allowed.", UINT8_MAX));
+    if (!debug.empty() && debug.back().node == node.id()) {
+      return;
     }
-    return current_.constants.size() - 1;
+    const auto location = node.location();
+    debug.push_back(code::DebugEntry{.offset = current_.code.size(),
+                                     .node = node.id(),
+                                     .x = location.x,
+                                     .y = location.y,
+                                     .z = location.z,
+                                     .width = location.width,
+                                     .height = location.height});
   }
 
   Results<code::ByteCode> BytecodeGenerator::run() {
@@ -110,6 +219,9 @@ namespace fluir {
     // For now, zero out header
     // TODO: Put the language version in the header here
     code_.header = code::Header{};
+    if (options_.shareConstants) {
+      code_.constants = constants_.take();
+    }
 
     return std::move(code_);
   }
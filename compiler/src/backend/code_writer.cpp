@@ -3,8 +3,12 @@
 namespace fluir {
   void CodeWriter::write(const code::ByteCode& code, std::ostream& destination) {
     writeHeader(code.header, destination);
+    if (!code.constants.empty()) {
+      writeSharedConstants(code.constants, destination);
+    }
     for (const auto& chunk : code.chunks) {
       writeChunk(chunk, destination);
     }
+    finish(destination);
   }
 }  // namespace fluir
@@ -0,0 +1,55 @@
+#include "compiler/backend/constant_pool.hpp"
+
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace fluir {
+  namespace {
+    template <typename T>
+    std::uint64_t bitsOf(T value) {
+      static_assert(sizeof(T) <= sizeof(std::uint64_t));
+      std::uint64_t bits = 0;
+      std::memcpy(&bits, &value, sizeof(T));
+      return bits;
+    }
+  }  // namespace
+
+  ConstantPool::ConstantPool(std::size_t capacity) : capacity_(capacity) { }
+
+  std::optional<std::size_t> ConstantPool::intern(const code::Value& value) {
+    const auto key = keyOf(value);
+    if (auto found = indices_.find(key); found != indices_.end()) {
+      return found->second;
+    }
+    if (values_.size() == capacity_) {
+      return std::nullopt;
+    }
+    indices_.emplace(key, values_.size());
+    values_.push_back(value);
+    return values_.size() - 1;
+  }
+
+  std::vector<code::Value> ConstantPool::take() {
+    indices_.clear();
+    return std::exchange(values_, {});
+  }
+
+  std::size_t ConstantPool::KeyHash::operator()(const Key& key) const {
+    // Mix the type into the bits, since small ints of different types often have the same bits
+    return std::hash<std::uint64_t>{}(key.bits ^ (static_cast<std::uint64_t>(key.type) << 56));
+  }
+
+  ConstantPool::Key ConstantPool::keyOf(const code::Value& value) {
+    switch (value.type()) {
+#define FLUIR_CONSTANT_KEY(Type, Concrete) \
+  case code::PrimitiveType::Type:          \
+    return Key{code::PrimitiveType::Type, bitsOf(value.uncheckedAs##Type())};
+
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_CONSTANT_KEY)
+
+#undef FLUIR_CONSTANT_KEY
+    }
+    return Key{value.type(), 0};
+  }
+}  // namespace fluir
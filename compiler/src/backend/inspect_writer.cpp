@@ -1,5 +1,6 @@
 #include "compiler/backend/inspect_writer.hpp"
 
+#include <cstdint>
 #include <format>
 #include <string>
 
@@ -15,8 +16,20 @@ namespace fluir {
   }  // namespace
 
   void InspectWriter::writeHeader(const code::Header& header, std::ostream& os) {
-    os << fmt::format("I{:0>2X}{:0>2X}{:0>2X}{:0>16X}\n", header.major, header.minor, header.patch, header.entryOffset);
+    registers_ = code::usesRegisters(header);
+    os << fmt::format("{}{:0>2X}{:0>2X}{:0>2X}{:0>16X}\n",
+                      registers_ ? code::FILETYPE_REGISTERS : code::FILETYPE_INSPECT,
+                      header.major,
+                      header.minor,
+                      header.patch,
+                      header.entryOffset);
   }
+  void InspectWriter::writeSharedConstants(const std::vector<code::Value>& constants, std::ostream& os) {
+    // The same section as a chunk's constants, but at the top level of the file
+    os << formatIndented("CONSTANTS x{:X}\n", constants.size());
+    writeConstants(constants, os);
+  }
+
   void InspectWriter::writeChunk(const code::Chunk& chunk, std::ostream& os) {
     os << fmt::format("CHUNK {}\n", chunk.name);
     [[maybe_unused]] auto _ = indent();
@@ -26,6 +39,16 @@ namespace fluir {
     os << formatIndented("CODE x{:X}\n", chunk.code.size());
 
     writeCode(chunk.code, os);
+
+    if (!chunk.subgraphs.empty()) {
+      os << formatIndented("SUBGRAPHS x{:X}\n", chunk.subgraphs.size());
+      writeSubgraphs(chunk.subgraphs, os);
+    }
+
+    if (!chunk.debug.empty()) {
+      os << formatIndented("DEBUG x{:X}\n", chunk.debug.size());
+      writeDebug(chunk.debug, os);
+    }
   }
 
   void InspectWriter::writeConstants(const std::vector<code::Value>& constants, std::ostream& os) {
@@ -68,17 +91,46 @@ namespace fluir {
     }
   }
 
+  void InspectWriter::writeSubgraphs(const std::vector<code::Subgraph>& subgraphs, std::ostream& os) {
+    [[maybe_unused]] auto _ = indent();
+    for (const auto& subgraph : subgraphs) {
+      // The subgraph's chunk, then the number of dependencies followed by each of them
+      std::string line = fmt::format("x{:X} x{:X}", subgraph.chunk, subgraph.dependencies.size());
+      for (auto dependency : subgraph.dependencies) {
+        line += fmt::format(" x{:X}", dependency);
+      }
+      os << formatIndented("{}\n", line);
+    }
+  }
+
+  void InspectWriter::writeDebug(const std::vector<code::DebugEntry>& debug, std::ostream& os) {
+    [[maybe_unused]] auto _ = indent();
+    for (const auto& entry : debug) {
+      // The offset and node, then the location with each coordinate as its 32 bit two's complement
+      os << formatIndented("x{:X} x{:X} x{:X} x{:X} x{:X} x{:X} x{:X}\n",
+                           entry.offset,
+                           entry.node,
+                           static_cast<std::uint32_t>(entry.x),
+                           static_cast<std::uint32_t>(entry.y),
+                           static_cast<std::uint32_t>(entry.z),
+                           static_cast<std::uint32_t>(entry.width),
+                           static_cast<std::uint32_t>(entry.height));
+    }
+  }
+
   void InspectWriter::writeCode(const code::Bytes& bytes, std::ostream& os) {
     [[maybe_unused]] auto _ = indent();
     for (auto i = bytes.begin(); i != bytes.end(); ++i) {
-      switch (*i) {
-        case code::Instruction::PUSH:
-          os << formatIndented("{} x{:X}\n", instructionNames[*i], *(i + 1));
-          ++i;
-          break;
-        default:
-          os << formatIndented("{}\n", instructionNames[*i]);
+      std::string line = instructionNames[*i];
+      // Operands are written on the same line as their instruction
+      const auto instruction = static_cast<code::Instruction>(*i);
+      for (auto operands = registers_ ? code::registerOperandBytes(instruction) : code::operandBytes(instruction);
+           operands > 0 && i + 1 != bytes.end();
+           --operands) {
+        ++i;
+        line += fmt::format(" x{:X}", *i);
       }
+      os << formatIndented("{}\n", line);
     }
   }
 }  // namespace fluir
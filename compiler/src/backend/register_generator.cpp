@@ -0,0 +1,160 @@
+#include "compiler/backend/register_generator.hpp"
+
+#include <fmt/format.h>
+
+using fluir::code::Instruction;
+
+namespace fluir {
+  namespace {
+    constexpr std::size_t REGISTER_COUNT = UINT8_MAX + 1;
+  }  // namespace
+
+  Results<code::ByteCode> generateRegisterCode(Context& ctx, const asg::ASG& graph) {
+    return RegisterGenerator::generate(ctx, graph);
+  }
+
+  Results<code::ByteCode> RegisterGenerator::generate(Context& ctx, const asg::ASG& graph) {
+    RegisterGenerator generator{ctx, graph};
+    return generator.run();
+  }
+
+  void RegisterGenerator::operator()(const asg::FunctionDecl& func) {
+    current_ = code::Chunk{};
+    current_.name = func.name;
+    registers_.clear();
+
+    // Constants live in the first registers, so find all of them before handing out any other register
+    for (const auto& node : func.statements) {
+      collectConstants(*node);
+    }
+    nextRegister_ = constants_.size();
+
+    for (const auto& node : func.statements) {
+      auto result = recursivelyGenerate(*node);
+      // Each top level node is an output, so print its value
+      emitBytes({Instruction::POP, result});
+    }
+
+    // (FOR NOW) end all functions with the EXIT instruction
+    emitBytes({Instruction::EXIT});
+    current_.constants = constants_.take();
+    code_.chunks.push_back(std::move(current_));
+  }
+
+  std::uint8_t RegisterGenerator::generate(const asg::BinaryOp& node) {
+    auto lhs = recursivelyGenerate(*node.lhs());
+    auto rhs = recursivelyGenerate(*node.rhs());
+    auto result = allocateRegister();
+
+    // Every constant is an F64 so far, so every operation is on F64s
+    switch (node.op()) {
+      case Operator::PLUS:
+        emitBytes({Instruction::F64_ADD, result, lhs, rhs});
+        break;
+      case Operator::MINUS:
+        emitBytes({Instruction::F64_SUB, result, lhs, rhs});
+        break;
+      case Operator::STAR:
+        emitBytes({Instruction::F64_MUL, result, lhs, rhs});
+        break;
+      case Operator::SLASH:
+        emitBytes({Instruction::F64_DIV, result, lhs, rhs});
+        break;
+      case Operator::UNKNOWN:
+        ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -, *, /");
+        break;
+    }
+    return result;
+  }
+
+  std::uint8_t RegisterGenerator::generate(const asg::UnaryOp& node) {
+    auto operand = recursivelyGenerate(*node.operand());
+    switch (node.op()) {
+      case Operator::PLUS:
+        // Affirming a value does not change it, so just reuse the operand's register
+        return operand;
+      case Operator::MINUS:
+        {
+          auto result = allocateRegister();
+          emitBytes({Instruction::F64_NEG, result, operand});
+          return result;
+        }
+      default:
+        ctx_.diagnostics.emitError("Unknown operator encountered. Expected one of +, -");
+        return operand;
+    }
+  }
+
+  std::uint8_t RegisterGenerator::generate(const asg::ConstantFP& node) {
+    return static_cast<std::uint8_t>(addConstant(code::Value(node.value())));
+  }
+
+  RegisterGenerator::RegisterGenerator(Context& ctx, const asg::ASG& graph) : ctx_(ctx), graph_(graph), code_{} { }
+
+  void RegisterGenerator::emitBytes(std::initializer_list<std::uint8_t> bytes) {
+    current_.code.insert(current_.code.end(), bytes);
+  }
+
+  std::size_t RegisterGenerator::addConstant(code::Value value) {
+    const auto before = constants_.size();
+    const auto index = *constants_.intern(value);
+    if (constants_.size() != before && constants_.size() == REGISTER_COUNT + 1) {
+      ctx_.diagnostics.emitError(fmt::format("Too many constants. Only {} constants allowed.", REGISTER_COUNT));
+    }
+    return index;
+  }
+
+  std::uint8_t RegisterGenerator::allocateRegister() {
+    if (nextRegister_ == REGISTER_COUNT) {
+      ctx_.diagnostics.emitError(fmt::format("Too many registers. Only {} registers allowed.", REGISTER_COUNT));
+    }
+    return static_cast<std::uint8_t>(nextRegister_++);
+  }
+
+  Results<code::ByteCode> RegisterGenerator::run() {
+    for (const auto& declaration : graph_.declarations) {
+      (*this)(declaration);
+    }
+
+    // The version is left zero, as in the header of stack code
+    code_.header = code::Header{.filetype = code::FILETYPE_REGISTERS};
+
+    return std::move(code_);
+  }
+
+  void RegisterGenerator::collectConstants(const asg::Node& node) {
+    switch (node.kind()) {
+      case asg::NodeKind::BinaryOperator:
+        collectConstants(*node.as<asg::BinaryOp>()->lhs());
+        collectConstants(*node.as<asg::BinaryOp>()->rhs());
+        break;
+      case asg::NodeKind::UnaryOperator:
+        collectConstants(*node.as<asg::UnaryOp>()->operand());
+        break;
+      case asg::NodeKind::Constant:
+        addConstant(code::Value(node.as<asg::ConstantFP>()->value()));
+        break;
+    }
+  }
+
+  std::uint8_t RegisterGenerator::recursivelyGenerate(const asg::Node& node) {
+    if (auto found = registers_.find(&node); found != registers_.end()) {
+      return found->second;
+    }
+
+    std::uint8_t result = 0;
+    switch (node.kind()) {
+      case asg::NodeKind::BinaryOperator:
+        result = generate(*node.as<asg::BinaryOp>());
+        break;
+      case asg::NodeKind::UnaryOperator:
+        result = generate(*node.as<asg::UnaryOp>());
+        break;
+      case asg::NodeKind::Constant:
+        result = generate(*node.as<asg::ConstantFP>());
+        break;
+    }
+    registers_.emplace(&node, result);
+    return result;
+  }
+}  // namespace fluir
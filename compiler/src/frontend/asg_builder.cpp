@@ -1,24 +1,31 @@
 #include "compiler/frontend/asg_builder.hpp"
 
 #include <algorithm>
+#include <iterator>
 #include <ranges>
 #include <unordered_set>
 #include <variant>
+#include <vector>
 
 #include "compiler/scope_guard.hpp"
 
 namespace {
-  /** Returns the set of Nodes that are not dependencies of other Nodes */
-  std::unordered_set<fluir::ID> getSinkNodes(const fluir::pt::Block& block) {
-    std::unordered_set<fluir::ID> sinkNodes;
-
-    // Start with all Nodes in the block
-    std::ranges::transform(
-      block.nodes, std::inserter(sinkNodes, sinkNodes.begin()), [](const auto& pair) { return pair.first; });
-
-    // Remove all Nodes that are dependencies of other Nodes
-    std::ranges::for_each(block.conduits | std::views::values,
-                          [&sinkNodes](const auto& conduit) { sinkNodes.erase(conduit.input); });
+  /** Returns the Nodes that are not dependencies of other Nodes, in order of their IDs so the code generated for them
+   * does not depend on the order of the parse tree's hash maps */
+  std::vector<fluir::ID> getSinkNodes(const fluir::pt::Block& block) {
+    std::unordered_set<fluir::ID> dependencies;
+    std::ranges::transform(block.conduits | std::views::values,
+                           std::inserter(dependencies, dependencies.begin()),
+                           [](const auto& conduit) { return conduit.input; });
+
+    // Keep all Nodes in the block that are not dependencies of other Nodes
+    std::vector<fluir::ID> sinkNodes;
+    for (const auto id : block.nodes | std::views::keys) {
+      if (!dependencies.contains(id)) {
+        sinkNodes.push_back(id);
+      }
+    }
+    std::ranges::sort(sinkNodes);
 
     return sinkNodes;
   }
@@ -47,8 +54,13 @@ namespace fluir {
   }
 
   Results<asg::ASG> ASGBuilder::run() {
-    for (const auto& declaration : tree_.declarations | std::views::values) {
-      graph_.declarations.emplace_back(std::visit(*this, declaration));
+    // Build declarations in order of their IDs, so the same source always produces the same chunks
+    std::vector<ID> ids;
+    ids.reserve(tree_.declarations.size());
+    std::ranges::copy(tree_.declarations | std::views::keys, std::back_inserter(ids));
+    std::ranges::sort(ids);
+    for (const auto id : ids) {
+      graph_.declarations.emplace_back(std::visit(*this, tree_.declarations.at(id)));
     }
     if (ctx_.diagnostics.containsErrors()) {
       return NoResult;
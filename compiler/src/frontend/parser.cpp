@@ -1,24 +1,44 @@
 #include "compiler/frontend/parser.hpp"
 
+#include <cstdlib>
 #include <fstream>
 #include <optional>
-#include <sstream>
 
 #include <fmt/format.h>
 
 using namespace std::string_literals;
 
+namespace {
+  /** Reads an unsigned 64 bit integer the way tinyxml2 did: decimal, or hex with a leading "0x" */
+  std::optional<fluir::ID> toId(std::string_view text) {
+    // The reader's values are null terminated, and strtoull skips leading whitespace itself
+    const char* start = text.data();
+    while (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r') {
+      ++start;
+    }
+    const bool hex = start[0] == '0' && (start[1] == 'x' || start[1] == 'X');
+    char* end = nullptr;
+    const auto value = std::strtoull(start, &end, hex ? 16 : 10);
+    if (end == start) {
+      return std::nullopt;
+    }
+    return value;
+  }
+}  // namespace
+
 namespace fluir {
+  using Event = XmlReader::Event;
+
   template <typename... FmtArgs>
-  void Parser::panicIf(bool condition, Element* element, std::string_view format, FmtArgs... args) {
+  void Parser::panicIf(bool condition, int line, std::string_view format, FmtArgs... args) {
     if (condition) {
-      panicAt(element, format, args...);
+      panicAt(line, format, args...);
     }
   }
   template <typename... FmtArgs>
-  [[noreturn]] void Parser::panicAt(Element* element, std::string_view format, FmtArgs... args) {
+  [[noreturn]] void Parser::panicAt(int line, std::string_view format, FmtArgs... args) {
     ctx_.diagnostics.emitError(fmt::vformat(format, fmt::make_format_args(args...)),
-                               std::make_shared<SourceLocation>(element->GetLineNum(), filename_));
+                               std::make_shared<SourceLocation>(line, filename_));
     throw PanicMode{};
   }
 
@@ -35,29 +55,36 @@ namespace fluir {
   Parser::Parser(Context& ctx) : ctx_(ctx) { }
 
   Results<pt::ParseTree> Parser::parseFile(const std::filesystem::path& file) {
-    filename_ = file.filename().string();
-    doc_.Clear();
-    std::ifstream fin(file);
-    std::stringstream ss;
-    ss << fin.rdbuf();
-
-    doc_.Parse(ss.str().c_str());
-
-    flowGraph();
-
-    if (ctx_.diagnostics.containsErrors()) {
+    std::ifstream fin(file, std::ios::binary);
+    if (!fin) {
+      ctx_.diagnostics.emitError(fmt::format("Cannot open '{}'.", file.string()));
       return NoResult;
-    } else {
-      return std::move(tree_);
     }
+    return parseStream(fin, file.filename().string());
   }
 
   Results<pt::ParseTree> Parser::parseString(const std::string_view source) {
     filename_ = "<FROM STRING>";
-    doc_.Clear();
-    doc_.Parse(source.data());
+    XmlReader reader{source};
+    return parse(reader);
+  }
 
-    flowGraph();
+  Results<pt::ParseTree> Parser::parseStream(std::istream& in, std::string filename) {
+    filename_ = std::move(filename);
+    XmlReader reader{in};
+    return parse(reader);
+  }
+
+  Results<pt::ParseTree> Parser::parse(XmlReader& reader) {
+    reader_ = &reader;
+    tree_ = pt::ParseTree{};
+    try {
+      flowGraph();
+    } catch (const XmlReader::SyntaxError& error) {
+      // The rest of a malformed document cannot be read
+      ctx_.diagnostics.emitError(error.message, std::make_shared<SourceLocation>(error.line, filename_));
+    }
+    reader_ = nullptr;
 
     if (ctx_.diagnostics.containsErrors()) {
       return NoResult;
@@ -69,17 +96,19 @@ namespace fluir {
   void Parser::flowGraph() {
     std::string_view expectedRoot = "fluir";
     try {
-      auto root = doc_.RootElement();
-
-      panicIf(root->Name() != expectedRoot,
-              root,
+      panicIf(reader_->next() != Event::START,
+              reader_->line(),
+              "Expected root element to be '{}', found none.",
+              expectedRoot);
+      panicIf(reader_->name() != expectedRoot,
+              reader_->line(),
               "Expected root element to be '{}', found '{}'.",
               expectedRoot,
-              root->Name());
+              reader_->name());
       // TODO: Check metadata
 
-      for (auto child = root->FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
-        declaration(child);
+      while (reader_->next() == Event::START) {
+        declaration();
       }
     } catch (const PanicMode&) {
       // If something goes wrong at this level, there isn't really anything to
@@ -88,210 +117,227 @@ namespace fluir {
     }
   }
 
-  void Parser::declaration(Element* element) {
-    std::string_view name = element->Name();
+  void Parser::declaration() {
+    const auto depth = reader_->depth();
     try {
       // TODO: This could use a trie
-      if (name == "function") {
-        functionDecl(element);
+      if (reader_->name() == "function") {
+        functionDecl();
       } else {
-        panicAt(element, "Unexpected element '{}'. Expected declaration.", name);
+        panicAt(reader_->line(), "Unexpected element '{}'. Expected declaration.", reader_->name());
       }
     } catch (const PanicMode&) {
-      // Synchronize here
+      // Synchronize at the end of the declaration
+      reader_->skipTo(depth - 1);
     }
   }
 
-  void Parser::functionDecl(Element* element) {
+  void Parser::functionDecl() {
     constexpr std::string_view type = "function";
-    std::string_view name = getAttribute(element, type, "name");
-    ID id = parseId(element, type);
-    auto location = parseLocation(element, type);
-
-    auto bodyElement = element->FirstChildElement("body");
-    panicIf(!bodyElement, element, "Function '{}' has no body. Expected a '<body>' element.", name);
-
-    pt::Block body = block(bodyElement->FirstChildElement());
+    const auto line = reader_->line();
+    std::string name{getAttribute(type, "name")};
+    ID id = parseId(type);
+    auto location = parseLocation(type);
+
+    // Only the first body is parsed, any other children are skipped
+    std::optional<pt::Block> body;
+    while (reader_->next() == Event::START) {
+      if (!body && reader_->name() == "body") {
+        body = block();
+      } else {
+        reader_->skipElement();
+      }
+    }
+    panicIf(!body, line, "Function '{}' has no body. Expected a '<body>' element.", name);
 
     panicIf(tree_.declarations.contains(id),
-            element,
+            line,
             "Duplicate declaration IDs. Function '{}' has id {}, but that ID is already in use.",
             name,
             id);
-    tree_.declarations.emplace(id, pt::FunctionDecl{id, location, std::string(name), body});
+    tree_.declarations.emplace(id, pt::FunctionDecl{id, location, std::move(name), std::move(*body)});
   }
 
-  pt::Block Parser::block(Element* element) {
+  pt::Block Parser::block() {
     auto block = pt::EMPTY_BLOCK;
-    for (; element != nullptr; element = element->NextSiblingElement()) {
+    while (reader_->next() == Event::START) {
+      // Errors are reported where the element starts, even once all of it has been read
+      const auto line = reader_->line();
+      const auto depth = reader_->depth();
       try {
-        if (element->Name() == "conduit"s) {
+        if (reader_->name() == "conduit"s) {
           // Parse a conduit
-          auto result = conduit(element);
+          auto result = conduit();
           auto& [id, resultConduit] = result;
           panicIf(block.nodes.contains(id) || block.conduits.contains(id),
-                  element,
+                  line,
                   "Duplicate IDs. Conduit has ID {}, but that ID is already in use.",
                   id);
           block.conduits.emplace(std::move(result));
 
         } else {
           // Parse any other node
-          auto result = node(element);
+          const std::string type{reader_->name()};
+          auto result = node();
           auto& [id, resultNode] = result;
           panicIf(block.nodes.contains(id) || block.conduits.contains(id),
-                  element,
+                  line,
                   "Duplicate IDs. Node <{}> has ID {}, but that ID is already in use.",
-                  element->Name(),
+                  type,
                   id);
           block.nodes.emplace(std::move(result));
         }
       } catch (const PanicMode&) {
-        // Synchronize here
+        // Synchronize at the end of the element
+        reader_->skipTo(depth - 1);
         continue;
       }
     }
     return block;
   }
 
-  std::pair<ID, pt::Node> Parser::node(Element* element) {
+  std::pair<ID, pt::Node> Parser::node() {
     // TODO: This could use a trie
-    std::string_view type = element->Name();
+    std::string_view type = reader_->name();
     if (type == "constant") {
-      return constant(element);
+      return constant();
     } else if (type == "binary") {
-      return binary(element);
+      return binary();
     } else if (type == "unary") {
-      return unary(element);
+      return unary();
     } else {
-      panicAt(element, "Unexpected element '{}'. Expected a node.", type);
+      panicAt(reader_->line(), "Unexpected element '{}'. Expected a node.", type);
     }
   }
 
-  std::pair<ID, pt::Conduit> Parser::conduit(Element* element) {
+  std::pair<ID, pt::Conduit> Parser::conduit() {
     constexpr std::string_view type = "conduit";
-    auto id = parseId(element, type);
-    auto input = parseIdReference(element, "input", type);
-    auto indexStr = getOptionalAttribute(element, "index", "0");
+    auto id = parseId(type);
+    auto input = parseIdReference("input", type);
+    auto indexStr = getOptionalAttribute("index", "0");
     auto index = std::stoi(indexStr.data());
     std::vector<pt::Conduit::Output> children;
-    for (auto child = element->FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
-      children.push_back(conduitOutput(child));
+    while (reader_->next() == Event::START) {
+      children.push_back(conduitOutput());
     }
 
     return {id, pt::Conduit{.id = id, .input = input, .index = index, .children = children}};
   }
 
-  pt::Conduit::Output Parser::conduitOutput(Element* element) {
+  pt::Conduit::Output Parser::conduitOutput() {
     constexpr std::string_view type = "output";
-    auto target = parseIdReference(element, "target", type);
-    auto indexStr = getOptionalAttribute(element, "index", "0");
+    auto target = parseIdReference("target", type);
+    auto indexStr = getOptionalAttribute("index", "0");
     auto index = std::stoi(indexStr.data());
+    reader_->skipElement();
 
     return pt::Conduit::Output{.target = target, .index = index};
   }
 
-  std::pair<ID, pt::Node> Parser::constant(Element* element) {
+  std::pair<ID, pt::Node> Parser::constant() {
     std::string_view type = "constant";
-    auto id = parseId(element, type);
-    auto location = parseLocation(element, type);
-    auto value = literal(element->FirstChildElement());
+    const auto depth = reader_->depth();
+    auto id = parseId(type);
+    auto location = parseLocation(type);
+    auto value = literal();
+    // Skip the rest of the value and anything after it
+    reader_->skipTo(depth - 1);
 
     return {id, pt::Constant{id, location, value}};
   }
 
-  std::pair<ID, pt::Node> Parser::binary(Element* element) {
+  std::pair<ID, pt::Node> Parser::binary() {
     std::string_view type = "binary";
-    auto id = parseId(element, type);
-    auto location = parseLocation(element, type);
+    auto id = parseId(type);
+    auto location = parseLocation(type);
     // TODO: Remove this
-    auto lhs = parseOptionalIdReference(element, "lhs", type);
-    auto rhs = parseOptionalIdReference(element, "rhs", type);
-    auto op = parseOperator(element, "operator", type);
+    auto lhs = parseOptionalIdReference("lhs", type);
+    auto rhs = parseOptionalIdReference("rhs", type);
+    auto op = parseOperator("operator", type);
+    reader_->skipElement();
 
     return {id, pt::Binary{id, location, lhs, rhs, op}};
   }
 
-  std::pair<ID, pt::Node> Parser::unary(Element* element) {
+  std::pair<ID, pt::Node> Parser::unary() {
     std::string_view type = "unary";
-    auto id = parseId(element, type);
-    auto location = parseLocation(element, type);
+    auto id = parseId(type);
+    auto location = parseLocation(type);
     // TODO: Remove this
-    auto lhs = parseOptionalIdReference(element, "lhs", type);
-    auto op = parseOperator(element, "operator", type);
+    auto lhs = parseOptionalIdReference("lhs", type);
+    auto op = parseOperator("operator", type);
+    reader_->skipElement();
 
     return {id, pt::Unary{id, location, lhs, op}};
   }
 
-  pt::Literal Parser::literal(Element* element) {
+  pt::Literal Parser::literal() {
+    // The value is the first child of the constant
+    const auto line = reader_->line();
+    panicIf(reader_->next() != Event::START, line, "Constant has no value. Expected a '<float>' element.");
     // TODO: This could use a trie to be faster
     // TODO: Support other literal types
-    std::string_view name = element->Name();
+    std::string_view name = reader_->name();
     if (name == "float") {
-      return fl_float(element);
+      return fl_float();
     } else {
       // TODO: Error
       throw PanicMode{};
     }
   }
-  pt::Float Parser::fl_float(Element* element) {
-    double value = 0.0;
-    auto error = element->QueryDoubleText(&value);
-    panicIf(error != tinyxml2::XML_SUCCESS,
-            element,
+  pt::Float Parser::fl_float() {
+    const auto line = reader_->line();
+    const auto text = reader_->text();
+    // Like sscanf, which tinyxml2 used, leading whitespace is skipped and anything after the number is ignored
+    char* end = nullptr;
+    const double value = text ? std::strtod(text->data(), &end) : 0.0;
+    panicIf(!text || end == text->data(),
+            line,
             "Expected a numeric value in element '<{}>'. '{}' cannot be parsed as a number.",
             "float",
-            element->GetText());
+            text.value_or(""));
     return value;
   }
 
-  std::string_view Parser::getAttribute(Element* element, std::string_view type, std::string_view attribute) {
-    auto value = element->Attribute(attribute.data());
-    panicIf(value == nullptr, element, "{} element is missing attribute '{}'.", type, attribute);
+  std::string_view Parser::getAttribute(std::string_view type, std::string_view attribute) {
+    auto value = reader_->attribute(attribute);
+    panicIf(!value, reader_->line(), "{} element is missing attribute '{}'.", type, attribute);
 
-    return value;
+    return *value;
   }
 
-  std::string_view Parser::getOptionalAttribute(Element* element,
-                                                std::string_view attribute,
-                                                std::string_view defaultValue) {
-    auto value = element->Attribute(attribute.data());
-    if (value == nullptr) {
-      return defaultValue;
-    } else {
-      return value;
-    }
+  std::string_view Parser::getOptionalAttribute(std::string_view attribute, std::string_view defaultValue) {
+    return reader_->attribute(attribute).value_or(defaultValue);
   }
 
-  ID Parser::parseId(Element* element, std::string_view type) { return parseIdReference(element, "id", type); }
+  ID Parser::parseId(std::string_view type) { return parseIdReference("id", type); }
 
-  ID Parser::parseIdReference(Element* element, std::string_view attribute, std::string_view type) {
-    ID reference = INVALID_ID;
-    auto error = element->QueryUnsigned64Attribute(attribute.data(), &reference);
-    panicIf(error != tinyxml2::XML_SUCCESS, element, "{} element is missing attribute '{}'.", type, attribute);
+  ID Parser::parseIdReference(std::string_view attribute, std::string_view type) {
+    const auto value = reader_->attribute(attribute);
+    const auto reference = value ? toId(*value) : std::nullopt;
+    panicIf(!reference, reader_->line(), "{} element is missing attribute '{}'.", type, attribute);
 
-    return reference;
+    return *reference;
   }
 
-  ID Parser::parseOptionalIdReference(Element* element, std::string_view attribute, std::string_view) {
-    ID reference = INVALID_ID;
-    element->QueryUnsigned64Attribute(attribute.data(), &reference);
+  ID Parser::parseOptionalIdReference(std::string_view attribute, std::string_view) {
+    const auto value = reader_->attribute(attribute);
 
-    return reference;
+    return value ? toId(*value).value_or(INVALID_ID) : INVALID_ID;
   }
 
-  FlowGraphLocation Parser::parseLocation(Element* element, std::string_view type) {
+  FlowGraphLocation Parser::parseLocation(std::string_view type) {
     return {
-      .x = std::atoi(getAttribute(element, type, "x").data()),
-      .y = std::atoi(getAttribute(element, type, "y").data()),
-      .z = std::atoi(getAttribute(element, type, "z").data()),
-      .width = std::atoi(getAttribute(element, type, "w").data()),
-      .height = std::atoi(getAttribute(element, type, "h").data()),
+      .x = std::atoi(getAttribute(type, "x").data()),
+      .y = std::atoi(getAttribute(type, "y").data()),
+      .z = std::atoi(getAttribute(type, "z").data()),
+      .width = std::atoi(getAttribute(type, "w").data()),
+      .height = std::atoi(getAttribute(type, "h").data()),
     };
   }
 
-  Operator Parser::parseOperator(Element* element, std::string_view attribute, std::string_view type) {
-    std::string_view opText = element->Attribute(attribute.data());
+  Operator Parser::parseOperator(std::string_view attribute, std::string_view type) {
+    std::string_view opText = getOptionalAttribute(attribute);
     // TODO: This could be made faster...
     if (opText == "+") {
       return Operator::PLUS;
@@ -302,7 +348,7 @@ namespace fluir {
     } else if (opText == "/") {
       return Operator::SLASH;
     } else {
-      panicAt(element, "Unrecognized operator '{}' in element '<{}>'.", opText, type);
+      panicAt(reader_->line(), "Unrecognized operator '{}' in element '<{}>'.", opText, type);
     }
   }
 
@@ -0,0 +1,384 @@
+#include "compiler/frontend/xml_reader.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+#include <fmt/format.h>
+
+namespace {
+  bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+  /** Whether c may start a name. Bytes of multibyte UTF-8 characters are all allowed, as tinyxml2 allowed them. */
+  bool isNameStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' ||
+           static_cast<unsigned char>(c) >= 0x80;
+  }
+
+  bool isNameChar(char c) { return isNameStart(c) || (c >= '0' && c <= '9') || c == '.' || c == '-'; }
+
+  void appendUtf8(char32_t codePoint, std::string& out) {
+    if (codePoint < 0x80) {
+      out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+      out += static_cast<char>(0xC0 | (codePoint >> 6));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+      out += static_cast<char>(0xE0 | (codePoint >> 12));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (codePoint >> 18));
+      out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+
+  /** The character entity stands for, without its '&' and ';', if it is a predefined or numeric entity */
+  std::optional<char32_t> entityValue(std::string_view entity) {
+    if (entity == "amp") {
+      return U'&';
+    } else if (entity == "lt") {
+      return U'<';
+    } else if (entity == "gt") {
+      return U'>';
+    } else if (entity == "quot") {
+      return U'"';
+    } else if (entity == "apos") {
+      return U'\'';
+    } else if (entity.starts_with('#')) {
+      const bool hex = entity.starts_with("#x");
+      const auto digits = entity.substr(hex ? 2 : 1);
+      std::uint32_t codePoint = 0;
+      const auto [end, error] =
+        std::from_chars(digits.data(), digits.data() + digits.size(), codePoint, hex ? 16 : 10);
+      if (error == std::errc{} && end == digits.data() + digits.size() && !digits.empty() && codePoint <= 0x10FFFF) {
+        return static_cast<char32_t>(codePoint);
+      }
+    }
+    return std::nullopt;
+  }
+}  // namespace
+
+namespace fluir {
+  XmlReader::XmlReader(std::istream& in, std::size_t window) :
+    in_(&in), window_(std::make_unique<char[]>(std::max<std::size_t>(window, 1))),
+    windowSize_(std::max<std::size_t>(window, 1)) { }
+
+  XmlReader::XmlReader(std::string_view source) : pos_(source.data()), end_(source.data() + source.size()) { }
+
+  XmlReader::Event XmlReader::next() {
+    if (pendingEnd_) {
+      pendingEnd_ = false;
+      return Event::END;
+    }
+    for (;;) {
+      if (!atTag_) {
+        // Text between tags is not needed, only the tags
+        skipWhile([](char c) { return c != '<'; });
+        if (!more()) {
+          if (!open_.empty()) {
+            fail(fmt::format("The document ended before element '<{}>' was closed.", open_.back()));
+          }
+          return Event::END_OF_DOCUMENT;
+        }
+        tagLine_ = line_;
+        ++pos_;
+      }
+      atTag_ = false;
+      if (!more()) {
+        fail("The document ended inside a tag.");
+      }
+
+      switch (peek()) {
+        case '?':
+          skipPast("?>", "processing instruction");
+          continue;
+        case '!':
+          ++pos_;
+          skipDeclaration();
+          continue;
+        case '/':
+          ++pos_;
+          readName(name_, "end tag");
+          skipWhitespace();
+          expect('>', "end tag");
+          if (open_.empty() || open_.back() != name_) {
+            fail(open_.empty() ? fmt::format("Unexpected end tag '</{}>'.", name_)
+                               : fmt::format("Expected '</{}>', found '</{}>'.", open_.back(), name_));
+          }
+          open_.pop_back();
+          return Event::END;
+        default:
+          readName(name_, "tag");
+          readAttributes();
+          if (peek() == '/') {
+            ++pos_;
+            expect('>', "tag");
+            pendingEnd_ = true;
+          } else {
+            expect('>', "tag");
+            open_.push_back(name_);
+          }
+          return Event::START;
+      }
+    }
+  }
+
+  void XmlReader::skipTo(std::size_t depth) {
+    while (this->depth() > depth) {
+      next();
+    }
+  }
+
+  std::optional<std::string_view> XmlReader::attribute(std::string_view name) const {
+    for (std::size_t i = 0; i != attributeCount_; ++i) {
+      if (attributes_[i].first == name) {
+        return attributes_[i].second;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::optional<std::string_view> XmlReader::text() {
+    if (pendingEnd_ || atTag_) {
+      return std::nullopt;
+    }
+    text_.clear();
+    for (;;) {
+      appendWhile([](char c) { return c != '<' && c != '&' && c != '\r'; }, text_);
+      if (!more()) {
+        // The next call to next reports the element which was not closed
+        break;
+      }
+      if (peek() == '&') {
+        readEntity(text_);
+        continue;
+      }
+      if (peek() == '\r') {
+        // Line ends are normalized to '\n'
+        ++pos_;
+        continue;
+      }
+
+      tagLine_ = line_;
+      ++pos_;
+      if (!more() || peek() != '!') {
+        // The start of the next tag, which next goes on from
+        atTag_ = true;
+        break;
+      }
+      ++pos_;
+      if (more() && peek() == '[') {
+        readCData(text_);
+      } else {
+        skipDeclaration();
+      }
+    }
+    if (std::ranges::all_of(text_, isWhitespace)) {
+      return std::nullopt;
+    }
+    return text_;
+  }
+
+  bool XmlReader::more() { return pos_ != end_ || refill(); }
+
+  bool XmlReader::refill() {
+    if (in_ == nullptr || !*in_) {
+      return false;
+    }
+    in_->read(window_.get(), static_cast<std::streamsize>(windowSize_));
+    pos_ = window_.get();
+    end_ = pos_ + in_->gcount();
+    return pos_ != end_;
+  }
+
+  void XmlReader::expect(char c, std::string_view context) {
+    if (!more()) {
+      fail(fmt::format("The document ended inside a {}. Expected '{}'.", context, c));
+    }
+    if (peek() != c) {
+      fail(fmt::format("Expected '{}' in {}, found '{}'.", c, context, peek()));
+    }
+    ++pos_;
+  }
+
+  template <typename Predicate>
+  void XmlReader::skipWhile(Predicate keep) {
+    while (more()) {
+      const auto* stop = std::find_if_not(pos_, end_, keep);
+      line_ += static_cast<int>(std::count(pos_, stop, '\n'));
+      pos_ = stop;
+      if (stop != end_) {
+        return;
+      }
+    }
+  }
+
+  template <typename Predicate>
+  void XmlReader::appendWhile(Predicate keep, std::string& out) {
+    while (more()) {
+      const auto* stop = std::find_if_not(pos_, end_, keep);
+      line_ += static_cast<int>(std::count(pos_, stop, '\n'));
+      out.append(pos_, stop);
+      pos_ = stop;
+      if (stop != end_) {
+        return;
+      }
+    }
+  }
+
+  void XmlReader::skipWhitespace() { skipWhile(isWhitespace); }
+
+  void XmlReader::skipPast(std::string_view terminator, std::string_view context) {
+    // The last characters read, which match the terminator once it has been read
+    std::string last;
+    while (more()) {
+      const char c = *pos_++;
+      if (c == '\n') {
+        ++line_;
+      }
+      last += c;
+      if (last.size() > terminator.size()) {
+        last.erase(last.begin());
+      }
+      if (last == terminator) {
+        return;
+      }
+    }
+    fail(fmt::format("The document ended inside a {}. Expected '{}'.", context, terminator));
+  }
+
+  void XmlReader::skipDeclaration() {
+    if (!more()) {
+      fail("The document ended inside a tag.");
+    }
+    if (peek() == '-') {
+      ++pos_;
+      expect('-', "comment");
+      skipPast("-->", "comment");
+      return;
+    }
+    if (peek() == '[') {
+      // CDATA outside of an element's text is skipped like any other text
+      text_.clear();
+      readCData(text_);
+      return;
+    }
+    // A DOCTYPE or other declaration, whose internal subset may hold '>' between brackets
+    int brackets = 0;
+    while (more()) {
+      const char c = *pos_++;
+      if (c == '\n') {
+        ++line_;
+      } else if (c == '[') {
+        ++brackets;
+      } else if (c == ']') {
+        --brackets;
+      } else if (c == '>' && brackets <= 0) {
+        return;
+      }
+    }
+    fail("The document ended inside a declaration. Expected '>'.");
+  }
+
+  void XmlReader::readName(std::string& out, std::string_view context) {
+    out.clear();
+    if (!more() || !isNameStart(peek())) {
+      fail(more() ? fmt::format("Expected a name in {}, found '{}'.", context, peek())
+                  : fmt::format("The document ended inside a {}. Expected a name.", context));
+    }
+    appendWhile(isNameChar, out);
+  }
+
+  void XmlReader::readAttributes() {
+    attributeCount_ = 0;
+    for (;;) {
+      skipWhitespace();
+      if (!more()) {
+        fail(fmt::format("The document ended inside the tag '<{}'.", name_));
+      }
+      if (peek() == '>' || peek() == '/') {
+        return;
+      }
+
+      if (attributeCount_ == attributes_.size()) {
+        attributes_.emplace_back();
+      }
+      auto& [attribute, value] = attributes_[attributeCount_];
+      readName(attribute, "attribute");
+      skipWhitespace();
+      expect('=', "attribute");
+      skipWhitespace();
+      if (!more() || (peek() != '"' && peek() != '\'')) {
+        fail(fmt::format("Expected a quoted value for attribute '{}'.", attribute));
+      }
+      const char quote = *pos_++;
+      readValue(quote, value);
+      if (this->attribute(attribute)) {
+        fail(fmt::format("Element '<{}>' has attribute '{}' more than once.", name_, attribute));
+      }
+      ++attributeCount_;
+    }
+  }
+
+  void XmlReader::readValue(char quote, std::string& out) {
+    out.clear();
+    for (;;) {
+      appendWhile([quote](char c) { return c != quote && c != '&' && c != '<'; }, out);
+      if (!more()) {
+        fail("The document ended inside an attribute value.");
+      }
+      if (peek() == quote) {
+        ++pos_;
+        return;
+      }
+      if (peek() == '<') {
+        fail("Attribute values cannot contain '<'.");
+      }
+      readEntity(out);
+    }
+  }
+
+  void XmlReader::readEntity(std::string& out) {
+    // Entities are short, so anything longer than the longest is left as it is
+    constexpr std::size_t LONGEST = 10;
+    ++pos_;
+    std::string entity;
+    while (more() && entity.size() != LONGEST && peek() != ';' && (isNameChar(peek()) || peek() == '#')) {
+      entity += *pos_++;
+    }
+    if (more() && peek() == ';') {
+      if (auto value = entityValue(entity)) {
+        ++pos_;
+        appendUtf8(*value, out);
+        return;
+      }
+    }
+    out += '&';
+    out += entity;
+  }
+
+  void XmlReader::readCData(std::string& out) {
+    for (const char c : std::string_view{"[CDATA["}) {
+      expect(c, "CDATA section");
+    }
+    // The contents are taken as they are, up to the first "]]>"
+    std::size_t start = out.size();
+    while (more()) {
+      const char c = *pos_++;
+      if (c == '\n') {
+        ++line_;
+      }
+      out += c;
+      if (out.size() - start >= 3 && std::string_view{out}.ends_with("]]>")) {
+        out.resize(out.size() - 3);
+        return;
+      }
+    }
+    fail("The document ended inside a CDATA section. Expected ']]>'.");
+  }
+
+  void XmlReader::fail(std::string message) const { throw SyntaxError{.line = line_, .message = std::move(message)}; }
+}  // namespace fluir
@@ -1,11 +1,20 @@
+#include <charconv>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
 
+#include "compiler/backend/binary_writer.hpp"
 #include "compiler/backend/bytecode_generator.hpp"
 #include "compiler/backend/inspect_writer.hpp"
+#include "compiler/backend/register_generator.hpp"
 #include "compiler/frontend/asg_builder.hpp"
 #include "compiler/frontend/parser.hpp"
+#include "compiler/utility/compilation_cache.hpp"
 #include "compiler/utility/context.hpp"
 #include "compiler/utility/pass.hpp"
 
@@ -19,29 +28,97 @@ static void printDiagnostics(const fluir::Diagnostics& diagnostics) {
 
 int main(int argc, char** argv) {
   // TODO: Read real inputs from the command line
-  if (argc != 2) {
-    std::cerr << "Usage: fluir.compiler file.fl\n";
+  bool registers = false;
+  bool shareConstants = false;
+  bool subgraphs = false;
+  bool binary = false;
+  bool useCache = true;
+  std::optional<fs::path> cacheDirectory = fluir::CompilationCache::defaultDirectory();
+  std::uintmax_t cacheLimit = fluir::CompilationCache::DEFAULT_LIMIT;
+  for (int i = 1; i < argc - 1; ++i) {
+    const std::string_view flag{argv[i]};
+    if (flag == "--registers") {
+      registers = true;
+    } else if (flag == "--share-constants") {
+      shareConstants = true;
+    } else if (flag == "--subgraphs") {
+      subgraphs = true;
+    } else if (flag == "--binary") {
+      binary = true;
+    } else if (flag == "--no-cache") {
+      useCache = false;
+    } else if (flag == "--cache-dir" && i + 1 < argc - 1) {
+      cacheDirectory = fs::path{argv[++i]};
+    } else if (flag == "--cache-limit" && i + 1 < argc - 1) {
+      // The limit is given in MiB
+      const std::string_view limit{argv[++i]};
+      std::uintmax_t mebibytes = 0;
+      if (std::from_chars(limit.data(), limit.data() + limit.size(), mebibytes).ptr != limit.data() + limit.size()) {
+        argc = 0;
+        break;
+      }
+      cacheLimit = mebibytes * 1024 * 1024;
+    } else {
+      argc = 0;
+      break;
+    }
+  }
+  // Register code has no subgraphs
+  if (argc < 2 || (registers && (shareConstants || subgraphs))) {
+    std::cerr << "Usage: fluir.compiler [--registers | [--share-constants] [--subgraphs]] [--binary]\n"
+                 "                      [--no-cache | [--cache-dir dir] [--cache-limit MiB]] file.fl\n";
     return 1;
   }
 
-  fs::path source = fs::canonical(fs::path{argv[1]});
+  fs::path source = fs::canonical(fs::path{argv[argc - 1]});
+  fs::path destination{"./out.flc"};
+
+  // Compiling the same source with the same options always writes the same code, so it can be copied from the cache
+  std::optional<fluir::CompilationCache> cache;
+  std::string key;
+  if (useCache && cacheDirectory) {
+    cache.emplace(*cacheDirectory, cacheLimit);
+    std::ifstream fin{source, std::ios::binary};
+    const std::string text{std::istreambuf_iterator<char>{fin}, std::istreambuf_iterator<char>{}};
+    const auto options = std::string{registers ? "registers" : shareConstants ? "share-constants" : "stack"} +
+                         (subgraphs ? " subgraphs" : "") + (binary ? " binary" : " inspect");
+    key = fluir::CompilationCache::key(text, options);
+    if (auto cached = cache->find(key)) {
+      std::ofstream fout{destination, std::ios::binary};
+      fout << *cached;
+      return 0;
+    }
+  }
+
   auto frontendResults = fluir::addContext(fluir::Context{}, source) | fluir::parseFile | fluir::buildGraph;
   printDiagnostics(frontendResults.ctx.diagnostics);
   if (frontendResults.ctx.diagnostics.containsErrors()) {
     return 1;
   }
 
-  auto backendResults = std::move(frontendResults) | fluir::generateCode;
+  auto generate = [&](fluir::Context& ctx, const fluir::asg::ASG& graph) {
+    if (registers) {
+      return fluir::generateRegisterCode(ctx, graph);
+    }
+    return fluir::BytecodeGenerator::generate(ctx, graph, {.shareConstants = shareConstants, .subgraphs = subgraphs});
+  };
+  auto backendResults = std::move(frontendResults) | generate;
   printDiagnostics(backendResults.ctx.diagnostics);
   if (backendResults.ctx.diagnostics.containsErrors()) {
     return 1;
   }
 
+  std::ostringstream out;
+  fluir::InspectWriter inspect{};
+  fluir::BinaryWriter bytes{};
+  fluir::writeCode(backendResults.data.value(), binary ? static_cast<fluir::CodeWriter&>(bytes) : inspect, out);
   {
-    fs::path destination{"./out.flc"};
-    std::ofstream fout{destination};
-    fluir::InspectWriter writer{};
-    fluir::writeCode(backendResults.data.value(), writer, fout);
+    std::ofstream fout{destination, std::ios::binary};
+    fout << out.view();
+  }
+  // A hit skips the diagnostics, so only code which compiled without any is cached
+  if (cache && backendResults.ctx.diagnostics.empty()) {
+    cache->store(key, out.view());
   }
 
   return 0;
@@ -0,0 +1,214 @@
+#include "compiler/utility/compilation_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#ifndef FLUIR_COMPILER_VERSION
+#error "FLUIR_COMPILER_VERSION must name the version of the compiler, which is part of every cache key"
+#endif
+#ifndef FLUIR_COMPILER_BUILD
+#error "FLUIR_COMPILER_BUILD must identify the sources the compiler was built from, which are part of every cache key"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+  constexpr std::array<std::uint32_t, 64> ROUND_CONSTANTS{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+  };
+
+  /** Mixes one 64 byte block into the state of a SHA-256 */
+  void compress(std::array<std::uint32_t, 8>& state, const unsigned char* block) {
+    std::array<std::uint32_t, 64> schedule;
+    for (std::size_t i = 0; i != 16; ++i) {
+      const auto* word = block + 4 * i;
+      schedule[i] = static_cast<std::uint32_t>(word[0]) << 24 | static_cast<std::uint32_t>(word[1]) << 16 |
+                    static_cast<std::uint32_t>(word[2]) << 8 | static_cast<std::uint32_t>(word[3]);
+    }
+    for (std::size_t i = 16; i != 64; ++i) {
+      const auto s0 = std::rotr(schedule[i - 15], 7) ^ std::rotr(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+      const auto s1 = std::rotr(schedule[i - 2], 17) ^ std::rotr(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+      schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = state;
+    for (std::size_t i = 0; i != 64; ++i) {
+      const auto s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+      const auto choice = (e & f) ^ (~e & g);
+      const auto t1 = h + s1 + choice + ROUND_CONSTANTS[i] + schedule[i];
+      const auto s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+      const auto majority = (a & b) ^ (a & c) ^ (b & c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + s0 + majority;
+    }
+    const std::array<std::uint32_t, 8> mixed{a, b, c, d, e, f, g, h};
+    for (std::size_t i = 0; i != 8; ++i) {
+      state[i] += mixed[i];
+    }
+  }
+
+  /** Whether name is a key, rather than a temporary file or anything else in the cache's directory */
+  bool isKey(const std::string& name) {
+    return name.size() == 64 &&
+           std::ranges::all_of(name, [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+  }
+}  // namespace
+
+namespace fluir {
+  CompilationCache::CompilationCache(fs::path directory, std::uintmax_t limit) :
+    directory_(std::move(directory)), limit_(limit) { }
+
+  std::optional<fs::path> CompilationCache::defaultDirectory() {
+    if (const char* directory = std::getenv("FLUIR_CACHE_DIR"); directory != nullptr && *directory != '\0') {
+      return fs::path{directory};
+    }
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache != nullptr && *cache != '\0') {
+      return fs::path{cache} / "fluir";
+    }
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+      return fs::path{home} / ".cache" / "fluir";
+    }
+    return std::nullopt;
+  }
+
+  std::string CompilationCache::key(std::string_view source, std::string_view options) {
+    // Every part but the source is length prefixed, so no two different inputs run together into the same bytes
+    return digest(fmt::format("fluir.compiler {} {}\n{} {}\n{}",
+                              FLUIR_COMPILER_VERSION,
+                              FLUIR_COMPILER_BUILD,
+                              options.size(),
+                              options,
+                              source));
+  }
+
+  std::string CompilationCache::digest(std::string_view bytes) {
+    std::array<std::uint32_t, 8> state{
+      0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+    const auto* data = reinterpret_cast<const unsigned char*>(bytes.data());
+    std::size_t at = 0;
+    for (; bytes.size() - at >= 64; at += 64) {
+      compress(state, data + at);
+    }
+
+    // The rest of the bytes, a single 1 bit, zeros and the length in bits fill one or two final blocks
+    std::array<unsigned char, 128> tail{};
+    const auto rest = bytes.size() - at;
+    std::copy_n(data + at, rest, tail.begin());
+    tail[rest] = 0x80;
+    const std::size_t tailSize = rest < 56 ? 64 : 128;
+    const std::uint64_t bits = static_cast<std::uint64_t>(bytes.size()) * 8;
+    for (std::size_t i = 0; i != 8; ++i) {
+      tail[tailSize - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    for (std::size_t block = 0; block != tailSize; block += 64) {
+      compress(state, tail.data() + block);
+    }
+
+    std::string hex;
+    hex.reserve(64);
+    for (const auto word : state) {
+      fmt::format_to(std::back_inserter(hex), "{:08x}", word);
+    }
+    return hex;
+  }
+
+  std::optional<std::string> CompilationCache::find(const std::string& key) const {
+    const auto path = entry(key);
+    std::ifstream fin{path, std::ios::binary};
+    if (!fin) {
+      return std::nullopt;
+    }
+    std::string output{std::istreambuf_iterator<char>{fin}, std::istreambuf_iterator<char>{}};
+    if (fin.bad()) {
+      return std::nullopt;
+    }
+    // Mark the entry as recently used, so eviction keeps it over entries which have not been hit
+    std::error_code ignored;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+    return output;
+  }
+
+  void CompilationCache::store(const std::string& key, std::string_view output) const {
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    if (error) {
+      return;
+    }
+
+    const auto temporary = directory_ / fmt::format("{}.{:08x}.tmp", key, std::random_device{}());
+    {
+      std::ofstream fout{temporary, std::ios::binary};
+      fout.write(output.data(), static_cast<std::streamsize>(output.size()));
+      if (!fout.flush()) {
+        fout.close();
+        fs::remove(temporary, error);
+        return;
+      }
+    }
+    fs::rename(temporary, entry(key), error);
+    if (error) {
+      fs::remove(temporary, error);
+      return;
+    }
+    evict();
+  }
+
+  fs::path CompilationCache::entry(const std::string& key) const { return directory_ / key; }
+
+  void CompilationCache::evict() const {
+    struct Entry {
+      fs::path path;
+      std::uintmax_t size;
+      fs::file_time_type used;
+    };
+    std::vector<Entry> entries;
+    std::uintmax_t total = 0;
+    std::error_code error;
+    for (fs::directory_iterator it{directory_, error}, end; !error && it != end; it.increment(error)) {
+      if (!isKey(it->path().filename().string())) {
+        continue;
+      }
+      std::error_code sizeError;
+      std::error_code timeError;
+      const auto size = it->file_size(sizeError);
+      const auto used = it->last_write_time(timeError);
+      if (!sizeError && !timeError) {
+        entries.push_back(Entry{.path = it->path(), .size = size, .used = used});
+        total += size;
+      }
+    }
+
+    std::ranges::sort(entries, {}, &Entry::used);
+    for (const auto& oldest : entries) {
+      if (total <= limit_) {
+        break;
+      }
+      // Another compiler may have evicted it already, in which case it no longer counts either
+      fs::remove(oldest.path, error);
+      total -= oldest.size;
+    }
+  }
+}  // namespace fluir
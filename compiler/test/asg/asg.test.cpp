@@ -1,4 +1,6 @@
+#include <string>
 #include <variant>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -29,6 +31,26 @@ TEST(TestAstBuilder, SingleEmptyFunction) {
   EXPECT_TRUE(actual.declarations.front().statements.empty());
 }
 
+TEST(TestAstBuilder, BuildsDeclarationsInOrderOfTheirIds) {
+  fluir::Context ctx;
+  fluir::pt::ParseTree pt;
+  for (fluir::ID id : {40, 3, 17, 8, 25, 1, 12}) {
+    const fluir::pt::FunctionDecl decl{
+      .id = id, .location = {}, .name = std::to_string(id), .body = fluir::pt::EMPTY_BLOCK};
+    pt.declarations.emplace(id, decl);
+  }
+
+  auto results = fluir::buildGraph(ctx, pt);
+  auto& actual = results.value();
+
+  ASSERT_FALSE(ctx.diagnostics.containsErrors());
+  std::vector<fluir::ID> ids;
+  for (const auto& declaration : actual.declarations) {
+    ids.push_back(declaration.id);
+  }
+  EXPECT_EQ((std::vector<fluir::ID>{1, 3, 8, 12, 17, 25, 40}), ids);
+}
+
 TEST(TestBuildFlowGraph, SingleBinaryExprWithoutSharing) {
   fluir::Context ctx;
   fluir::pt::Block block = {
@@ -163,3 +185,22 @@ TEST(TestBuildFlowGraph, MultipleExprWithSharing) {
   EXPECT_EQ(fluir::Operator::MINUS, unary2->op());
   EXPECT_EQ(binary->rhs(), unary2->operand());
 }
+
+TEST(TestBuildFlowGraph, BuildsSinksInOrderOfTheirIds) {
+  fluir::Context ctx;
+  fluir::pt::Block block;
+  for (fluir::ID id : {9, 2, 14, 5, 11}) {
+    const fluir::pt::Constant constant{.id = id, .location = {}, .value = fluir::pt::Float{static_cast<double>(id)}};
+    block.nodes.emplace(id, constant);
+  }
+
+  auto results = fluir::buildDataFlowGraph(ctx, block);
+  auto& actual = results.value();
+
+  ASSERT_FALSE(ctx.diagnostics.containsErrors());
+  std::vector<fluir::ID> ids;
+  for (const auto& statement : actual) {
+    ids.push_back(statement->id());
+  }
+  EXPECT_EQ((std::vector<fluir::ID>{2, 5, 9, 11, 14}), ids);
+}
@@ -0,0 +1,54 @@
+#include "compiler/backend/binary_writer.hpp"
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "bytecode/binary_format.hpp"
+#include "compiler/backend/bytecode_generator.hpp"
+
+namespace fc = fluir::code;
+using namespace fc::value_literals;
+
+TEST(TestBinaryWriter, WritesTheEncodedCode) {
+  fc::ByteCode code{.header = {.filetype = '\0', .major = 1, .minor = 12, .patch = 17, .entryOffset = 255},
+                    .chunks = {fc::Chunk{.name = "main",
+                                         .code = {fc::PUSH, 0x00, fc::POP, fc::EXIT},
+                                         .constants = {1.5_f64}}}};
+
+  std::stringstream ss;
+  fluir::BinaryWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  const auto expected = fc::binary::encode(code);
+  EXPECT_EQ((std::string{expected.begin(), expected.end()}), ss.str());
+}
+
+TEST(TestBinaryWriter, WritesTheHeaderAndSectionTable) {
+  fc::ByteCode code{
+    .header = {.filetype = fc::FILETYPE_REGISTERS, .major = 1, .minor = 12, .patch = 17, .entryOffset = 255},
+    .chunks = {fc::Chunk{.name = "main", .code = {fc::EXIT}, .constants = {}}},
+    .constants = {1.5_f64}};
+
+  std::stringstream ss;
+  fluir::BinaryWriter uut{};
+  fluir::writeCode(code, uut, ss);
+  const auto actual = ss.str();
+
+  // 'B', the version, the instruction set and padding, then the entry offset and the number of sections
+  ASSERT_LE(fc::binary::HEADER_SIZE, actual.size());
+  EXPECT_EQ((std::string{'B', 1, 12, 17, 'R', 0, 0, 0, '\xFF', 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0}),
+            actual.substr(0, fc::binary::HEADER_SIZE));
+  // The directory and the shared constants come first, then the name, constants and code of the chunk
+  const auto kind = [&](std::size_t section) {
+    return static_cast<std::uint8_t>(actual.at(fc::binary::HEADER_SIZE + section * fc::binary::SECTION_ENTRY_SIZE));
+  };
+  EXPECT_EQ(static_cast<std::uint8_t>(fc::binary::SectionKind::DIRECTORY), kind(0));
+  EXPECT_EQ(static_cast<std::uint8_t>(fc::binary::SectionKind::SHARED_CONSTANTS), kind(1));
+  EXPECT_EQ(static_cast<std::uint8_t>(fc::binary::SectionKind::NAME), kind(2));
+  EXPECT_EQ(static_cast<std::uint8_t>(fc::binary::SectionKind::CONSTANTS), kind(3));
+  EXPECT_EQ(static_cast<std::uint8_t>(fc::binary::SectionKind::CODE), kind(4));
+  // Every section is aligned
+  EXPECT_EQ(0, actual.size() % fc::binary::ALIGNMENT);
+}
@@ -1,5 +1,8 @@
 #include "compiler/backend/bytecode_generator.hpp"
 
+#include <cmath>
+#include <iterator>
+
 #include <gtest/gtest.h>
 
 #include "bytecode_assertions.hpp"
@@ -10,6 +13,10 @@ namespace fa = fluir::asg;
 namespace fc = fluir::code;
 using namespace fc::value_literals;
 
+static fluir::Results<fc::ByteCode> generateWithSubgraphs(fluir::Context& ctx, const fa::ASG& graph) {
+  return fluir::BytecodeGenerator::generate(ctx, graph, {.subgraphs = true});
+}
+
 TEST(TestBytecodeGenerator, GeneratesEmptyFunction) {
   fa::ASG input;
   input.declarations.emplace_back(fa::FunctionDecl{.id = 3, .name = "main", .statements = {}});
@@ -165,13 +172,250 @@ TEST(TestBytecodeGenerator, GeneratesExpressionWithSharedNodes) {
                                                  fc::POP,
                                                  fc::Instruction::EXIT,
                                                },
-                                             .constants = {100.0_f64, 3.5_f64, 4.4_f64}}}};
+                                             .constants = {100.0_f64, 3.5_f64, 4.4_f64}},
+                                   // Each sink also gets a chunk of its own
+                                   fc::Chunk{.name = "bar_sink0",
+                                             .code = {fc::PUSH,
+                                                      0x00,
+                                                      fc::PUSH,
+                                                      0x01,
+                                                      fc::F64_NEG,
+                                                      fc::PUSH,
+                                                      0x02,
+                                                      fc::F64_DIV,
+                                                      fc::F64_ADD,
+                                                      fc::POP,
+                                                      fc::Instruction::EXIT},
+                                             .constants = {100.0_f64, 3.5_f64, 4.4_f64}},
+                                   fc::Chunk{.name = "bar_sink1",
+                                             .code = {fc::PUSH,
+                                                      0x00,
+                                                      fc::F64_NEG,
+                                                      fc::PUSH,
+                                                      0x01,
+                                                      fc::F64_DIV,
+                                                      fc::F64_NEG,
+                                                      fc::POP,
+                                                      fc::Instruction::EXIT},
+                                             .constants = {3.5_f64, 4.4_f64}}}};
 
-  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCode;
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | generateWithSubgraphs;
 
   EXPECT_FALSE(ctx.diagnostics.containsErrors());
 
   EXPECT_BC_HEADER_EQ(expected.header, actual.value().header);
-  EXPECT_EQ(expected.chunks.size(), actual.value().chunks.size());
-  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.value().chunks.at(0));
+  ASSERT_EQ(expected.chunks.size(), actual.value().chunks.size());
+  for (int i = 0; i != expected.chunks.size(); ++i) {
+    EXPECT_CHUNK_EQ(expected.chunks.at(i), actual.value().chunks.at(i));
+  }
+  // The sinks share nodes, but each one computes them again, so neither depends on the other
+  const auto& subgraphs = actual.value().chunks.at(0).subgraphs;
+  ASSERT_EQ(2, subgraphs.size());
+  EXPECT_EQ(1, subgraphs[0].chunk);
+  EXPECT_TRUE(subgraphs[0].dependencies.empty());
+  EXPECT_EQ(2, subgraphs[1].chunk);
+  EXPECT_TRUE(subgraphs[1].dependencies.empty());
+}
+
+TEST(TestBytecodeGenerator, MapsCodeBackToNodes) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 3, .name = "foo", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::move(std::make_unique<fa::UnaryOp>(
+        fluir::Operator::MINUS,
+        std::make_shared<fa::BinaryOp>(
+          fluir::Operator::STAR,
+          std::make_shared<fa::ConstantFP>(1.5, 4, fluir::FlowGraphLocation{1, 2, 0, 3, 4}),
+          std::make_shared<fa::ConstantFP>(2.5, 5, fluir::FlowGraphLocation{-5, 6, 0, 7, 8}),
+          6,
+          fluir::FlowGraphLocation{10, 20, 1, 30, 40}),
+        7,
+        fluir::FlowGraphLocation{50, 60, 0, 70, 80})));
+      return graph;
+    }()});
+
+  // PUSH x00, PUSH x01, F64_MUL, F64_NEG, POP, EXIT. The top node also owns the POP and EXIT it leads to.
+  const std::vector<fc::DebugEntry> expected{
+    {.offset = 0, .node = 4, .x = 1, .y = 2, .z = 0, .width = 3, .height = 4},
+    {.offset = 2, .node = 5, .x = -5, .y = 6, .z = 0, .width = 7, .height = 8},
+    {.offset = 4, .node = 6, .x = 10, .y = 20, .z = 1, .width = 30, .height = 40},
+    {.offset = 5, .node = 7, .x = 50, .y = 60, .z = 0, .width = 70, .height = 80},
+  };
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  ASSERT_EQ(1, actual.value().chunks.size());
+  EXPECT_EQ(expected, actual.value().chunks.at(0).debug);
+}
+
+TEST(TestBytecodeGenerator, NamesConstantsPastTheFirst256WithPushWide) {
+  constexpr int COUNT = 300;
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      for (int i = 0; i != COUNT; ++i) {
+        graph.push_back(std::make_unique<fa::ConstantFP>(static_cast<double>(i), i + 2, fluir::FlowGraphLocation{}));
+      }
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  const auto& main = actual.value().chunks.at(0);
+  ASSERT_EQ(COUNT, main.constants.size());
+  // PUSH i, POP for the first 256 constants, then PUSH_WIDE i, POP
+  EXPECT_EQ((fc::Bytes{fc::PUSH, 0xFF, fc::POP}),
+            (fc::Bytes{main.code.begin() + 255 * 3, main.code.begin() + 256 * 3}));
+  EXPECT_EQ((fc::Bytes{fc::PUSH_WIDE, 0x00, 0x01, fc::POP}),
+            (fc::Bytes{main.code.begin() + 256 * 3, main.code.begin() + 256 * 3 + 4}));
+  EXPECT_EQ((fc::Bytes{fc::PUSH_WIDE, 0x2B, 0x01, fc::POP, fc::EXIT}),
+            (fc::Bytes{main.code.end() - 5, main.code.end()}));
+}
+
+TEST(TestBytecodeGenerator, WritesConstantsInlineOnceTheTableIsFull) {
+  constexpr auto COUNT = fc::WIDE_CONSTANTS + 1;
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      for (std::size_t i = 0; i != COUNT; ++i) {
+        graph.push_back(std::make_unique<fa::ConstantFP>(static_cast<double>(i), i + 2, fluir::FlowGraphLocation{}));
+      }
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  const auto& main = actual.value().chunks.at(0);
+  EXPECT_EQ(fc::WIDE_CONSTANTS, main.constants.size());
+  fc::Bytes expected{fc::PUSH_F64_IMM};
+  fc::writeOperand(static_cast<double>(fc::WIDE_CONSTANTS), std::back_inserter(expected));
+  expected.insert(expected.end(), {fc::POP, fc::EXIT});
+  EXPECT_EQ(expected, (fc::Bytes{main.code.end() - 11, main.code.end()}));
+}
+
+TEST(TestBytecodeGenerator, KeepsNegativeZeroApartFromZero) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::make_unique<fa::ConstantFP>(0.0, 2, fluir::FlowGraphLocation{}));
+      graph.push_back(std::make_unique<fa::ConstantFP>(-0.0, 3, fluir::FlowGraphLocation{}));
+      graph.push_back(std::make_unique<fa::ConstantFP>(0.0, 4, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  const auto& main = actual.value().chunks.at(0);
+  ASSERT_EQ(2, main.constants.size());
+  EXPECT_FALSE(std::signbit(main.constants[0].asF64()));
+  EXPECT_TRUE(std::signbit(main.constants[1].asF64()));
+  EXPECT_EQ((fc::Bytes{fc::PUSH, 0, fc::POP, fc::PUSH, 1, fc::POP, fc::PUSH, 0, fc::POP, fc::EXIT}), main.code);
+}
+
+TEST(TestBytecodeGenerator, SharesConstantsAcrossFunctions) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::make_unique<fa::ConstantFP>(1.5, 2, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 3, .name = "foo", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::make_unique<fa::ConstantFP>(2.5, 4, fluir::FlowGraphLocation{}));
+      graph.push_back(std::make_unique<fa::ConstantFP>(1.5, 5, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateCodeSharingConstants;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  const auto& code = actual.value();
+  EXPECT_EQ((std::vector{1.5_f64, 2.5_f64}), code.constants);
+  ASSERT_EQ(2, code.chunks.size());
+  for (const auto& chunk : code.chunks) {
+    EXPECT_TRUE(chunk.constants.empty()) << chunk.name;
+  }
+  EXPECT_EQ((fc::Bytes{fc::PUSH, 0, fc::POP, fc::EXIT}), code.chunks[0].code);
+  EXPECT_EQ((fc::Bytes{fc::PUSH, 1, fc::POP, fc::PUSH, 0, fc::POP, fc::EXIT}), code.chunks[1].code);
+}
+
+TEST(TestBytecodeGenerator, GivesSinksChunksOnlyWithSubgraphs) {
+  const auto twoSinks = []() {
+    fa::ASG input;
+    input.declarations.emplace_back(fa::FunctionDecl{
+      .id = 1, .name = "main", .statements = []() {
+        fa::DataFlowGraph graph;
+        graph.push_back(std::make_unique<fa::ConstantFP>(1.5, 2, fluir::FlowGraphLocation{}));
+        graph.push_back(std::make_unique<fa::ConstantFP>(2.5, 3, fluir::FlowGraphLocation{}));
+        return graph;
+      }()});
+    return input;
+  };
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, twoSinks()) | fluir::generateCode;
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  ASSERT_EQ(1, actual.value().chunks.size());
+  EXPECT_TRUE(actual.value().chunks[0].subgraphs.empty());
+
+  auto [subgraphCtx, subgraphs] = fluir::addContext(fluir::Context{}, twoSinks()) | generateWithSubgraphs;
+  EXPECT_FALSE(subgraphCtx.diagnostics.containsErrors());
+  ASSERT_EQ(3, subgraphs.value().chunks.size());
+  EXPECT_EQ("main_sink0", subgraphs.value().chunks[1].name);
+  EXPECT_EQ("main_sink1", subgraphs.value().chunks[2].name);
+}
+
+TEST(TestBytecodeGenerator, ReportsFunctionsNamedLikeASink) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::make_unique<fa::ConstantFP>(1.5, 2, fluir::FlowGraphLocation{}));
+      graph.push_back(std::make_unique<fa::ConstantFP>(2.5, 3, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 4, .name = "main_sink1", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(std::make_unique<fa::ConstantFP>(3.5, 5, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | generateWithSubgraphs;
+
+  EXPECT_TRUE(ctx.diagnostics.containsErrors());
+}
+
+TEST(TestBytecodeGenerator, SelectsWidthSpecializedArithmetic) {
+  using enum fc::Instruction;
+  using fluir::Operator;
+
+  EXPECT_EQ(F64_ADD, fluir::binaryInstruction(Operator::PLUS, fc::PrimitiveType::F64));
+  EXPECT_EQ(I8_ADD, fluir::binaryInstruction(Operator::PLUS, fc::PrimitiveType::I8));
+  EXPECT_EQ(I16_SUB, fluir::binaryInstruction(Operator::MINUS, fc::PrimitiveType::I16));
+  EXPECT_EQ(I32_MUL, fluir::binaryInstruction(Operator::STAR, fc::PrimitiveType::I32));
+  EXPECT_EQ(I64_DIV, fluir::binaryInstruction(Operator::SLASH, fc::PrimitiveType::I64));
+  EXPECT_EQ(U8_DIV, fluir::binaryInstruction(Operator::SLASH, fc::PrimitiveType::U8));
+  EXPECT_EQ(U32_ADD, fluir::binaryInstruction(Operator::PLUS, fc::PrimitiveType::U32));
+  EXPECT_EQ(U64_MUL, fluir::binaryInstruction(Operator::STAR, fc::PrimitiveType::U64));
+  EXPECT_EQ(std::nullopt, fluir::binaryInstruction(Operator::UNKNOWN, fc::PrimitiveType::I8));
+
+  EXPECT_EQ(F64_NEG, fluir::unaryInstruction(Operator::MINUS, fc::PrimitiveType::F64));
+  EXPECT_EQ(I16_NEG, fluir::unaryInstruction(Operator::MINUS, fc::PrimitiveType::I16));
+  EXPECT_EQ(I64_NEG, fluir::unaryInstruction(Operator::MINUS, fc::PrimitiveType::I64));
+  // Affirming has no specialized instructions
+  EXPECT_EQ(I64_AFF, fluir::unaryInstruction(Operator::PLUS, fc::PrimitiveType::I8));
+  EXPECT_EQ(U64_AFF, fluir::unaryInstruction(Operator::PLUS, fc::PrimitiveType::U16));
+  EXPECT_EQ(std::nullopt, fluir::unaryInstruction(Operator::MINUS, fc::PrimitiveType::U8));
+  EXPECT_EQ(std::nullopt, fluir::unaryInstruction(Operator::MINUS, fc::PrimitiveType::U64));
+  EXPECT_EQ(std::nullopt, fluir::unaryInstruction(Operator::STAR, fc::PrimitiveType::F64));
 }
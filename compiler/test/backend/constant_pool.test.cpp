@@ -0,0 +1,61 @@
+#include "compiler/backend/constant_pool.hpp"
+
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+namespace fc = fluir::code;
+using namespace fc::value_literals;
+
+TEST(TestConstantPool, InternsEachValueOnce) {
+  fluir::ConstantPool uut;
+
+  EXPECT_EQ(0, uut.intern(1.5_f64));
+  EXPECT_EQ(1, uut.intern(2.5_f64));
+  EXPECT_EQ(0, uut.intern(1.5_f64));
+  EXPECT_EQ((std::vector{1.5_f64, 2.5_f64}), uut.values());
+}
+
+TEST(TestConstantPool, ComparesValuesBitForBit) {
+  fluir::ConstantPool uut;
+  const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+  EXPECT_EQ(0, uut.intern(fc::Value{0.0}));
+  EXPECT_EQ(1, uut.intern(fc::Value{-0.0}));
+  EXPECT_EQ(2, uut.intern(fc::Value{nan}));
+  EXPECT_EQ(2, uut.intern(fc::Value{nan}));
+  EXPECT_EQ(3, uut.intern(fc::Value{-nan}));
+  ASSERT_EQ(4, uut.size());
+  EXPECT_TRUE(std::signbit(uut.values()[1].asF64()));
+}
+
+TEST(TestConstantPool, KeepsTypesApart) {
+  fluir::ConstantPool uut;
+
+  EXPECT_EQ(0, uut.intern(1_i8));
+  EXPECT_EQ(1, uut.intern(1_u8));
+  EXPECT_EQ(2, uut.intern(1_i64));
+  EXPECT_EQ(3, uut.intern(fc::Value{std::bit_cast<double>(std::uint64_t{1})}));
+  EXPECT_EQ(0, uut.intern(1_i8));
+}
+
+TEST(TestConstantPool, ReportsAFullTable) {
+  fluir::ConstantPool uut{2};
+
+  EXPECT_EQ(0, uut.intern(1.0_f64));
+  EXPECT_EQ(1, uut.intern(2.0_f64));
+  EXPECT_EQ(std::nullopt, uut.intern(3.0_f64));
+  // Values already in the table are still found
+  EXPECT_EQ(1, uut.intern(2.0_f64));
+}
+
+TEST(TestConstantPool, TakeEmptiesThePool) {
+  fluir::ConstantPool uut;
+  uut.intern(1.0_f64);
+
+  EXPECT_EQ((std::vector{1.0_f64}), uut.take());
+  EXPECT_EQ(0, uut.size());
+  EXPECT_EQ(0, uut.intern(2.0_f64));
+}
@@ -268,3 +268,177 @@ CHUNK main
 
   EXPECT_EQ(expected, actual);
 }
+
+TEST(TestInspectWriter, WriteInstructionOperands) {
+  std::string expected = R"(I0120030000000000000000
+CHUNK main
+  CONSTANTS x2
+    VF64 1.500000000000
+    VF64 2.000000000000
+  CODE xA
+    IPUSH2 x0 x1
+    IF64_MUL_ADD
+    ICAST_FI x4
+    IPUSH_PUSH_F64_SUB x1 x0
+    IEXIT
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{
+      .name = "main",
+      .code = {fc::PUSH2, 0x00, 0x01, fc::F64_MUL_ADD, fc::CAST_FI, fc::WIDTH_32, fc::PUSH_PUSH_F64_SUB, 0x01, 0x00,
+               fc::EXIT},
+      .constants = {1.5_f64, 2.0_f64}}}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TestInspectWriter, WriteRegisterProgram) {
+  std::string expected = R"(R0120030000000000000000
+CHUNK main
+  CONSTANTS x2
+    VF64 1.500000000000
+    VF64 2.000000000000
+  CODE xB
+    IF64_MUL x2 x0 x1
+    ICAST_FI x3 x2 x4
+    IPOP x3
+    IEXIT
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'R', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{
+      .name = "main",
+      .code = {fc::F64_MUL, 0x02, 0x00, 0x01, fc::CAST_FI, 0x03, 0x02, fc::WIDTH_32, fc::POP, 0x03, fc::EXIT},
+      .constants = {1.5_f64, 2.0_f64}}}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TestInspectWriter, WriteSubgraphs) {
+  std::string expected = R"(I0120030000000000000000
+CHUNK main
+  CONSTANTS x0
+  CODE x1
+    IEXIT
+  SUBGRAPHS x3
+    x1 x0
+    x2 x0
+    x3 x2 x0 x1
+CHUNK main_sink0
+  CONSTANTS x0
+  CODE x1
+    IEXIT
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{.name = "main",
+                                  .code = {fc::EXIT},
+                                  .constants = {},
+                                  .subgraphs = {{.chunk = 1, .dependencies = {}},
+                                                {.chunk = 2, .dependencies = {}},
+                                                {.chunk = 3, .dependencies = {0, 1}}}},
+               fluir::code::Chunk{.name = "main_sink0", .code = {fc::EXIT}, .constants = {}}}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TestInspectWriter, WriteDebugEntries) {
+  std::string expected = R"(I0120030000000000000000
+CHUNK main
+  CONSTANTS x1
+    VF64 1.500000000000
+  CODE x4
+    IPUSH x0
+    IPOP
+    IEXIT
+  DEBUG x2
+    x0 x4 x1 x2 x0 x3 x4
+    x2 x1A xFFFFFFFB x6 x0 x7 x8
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{
+      .name = "main",
+      .code = {fc::PUSH, 0x00, fc::POP, fc::EXIT},
+      .constants = {1.5_f64},
+      .debug = {{.offset = 0, .node = 4, .x = 1, .y = 2, .z = 0, .width = 3, .height = 4},
+                {.offset = 2, .node = 26, .x = -5, .y = 6, .z = 0, .width = 7, .height = 8}}}}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TestInspectWriter, WriteImmediateAndWidePushes) {
+  std::string expected = R"(I0120030000000000000000
+CHUNK main
+  CONSTANTS x0
+  CODE xF
+    IPUSH_F64_IMM x0 x0 x0 x0 x0 x0 xF8 x3F
+    IPUSH_SMALL_INT xF9
+    IPUSH_WIDE x1 x1
+    IEXIT
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{.name = "main",
+                                  .code = {fc::PUSH_F64_IMM, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x3F,
+                                           fc::PUSH_SMALL_INT, 0xF9, fc::PUSH_WIDE, 0x01, 0x01, fc::EXIT},
+                                  .constants = {}}}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TestInspectWriter, WriteSharedConstants) {
+  std::string expected = R"(I0120030000000000000000
+CONSTANTS x1
+  VF64 1.500000000000
+CHUNK main
+  CONSTANTS x0
+  CODE x4
+    IPUSH x0
+    IPOP
+    IEXIT
+)";
+  fluir::code::ByteCode code{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{.name = "main", .code = {fc::PUSH, 0x00, fc::POP, fc::EXIT}, .constants = {}}},
+    .constants = {1.5_f64}};
+
+  std::stringstream ss;
+  fluir::InspectWriter uut{};
+  fluir::writeCode(code, uut, ss);
+
+  auto actual = ss.str();
+
+  EXPECT_EQ(expected, actual);
+}
@@ -0,0 +1,179 @@
+#include "compiler/backend/register_generator.hpp"
+
+#include <gtest/gtest.h>
+
+#include "bytecode_assertions.hpp"
+#include "compiler/utility/pass.hpp"
+
+namespace fa = fluir::asg;
+namespace fc = fluir::code;
+using namespace fc::value_literals;
+
+TEST(TestRegisterGenerator, GeneratesEmptyFunction) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{.id = 3, .name = "main", .statements = {}});
+
+  fc::ByteCode expected{.header = {.filetype = 'R', .major = 0, .minor = 0, .patch = 0, .entryOffset = 0},
+                        .chunks = {fc::Chunk{.name = "main", .code = {fc::Instruction::EXIT}, .constants = {}}}};
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateRegisterCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.value().header);
+  EXPECT_EQ(expected.chunks.size(), actual.value().chunks.size());
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.value().chunks.at(0));
+}
+
+TEST(TestRegisterGenerator, GeneratesSimpleBinaryExpression) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 3, .name = "foo", .statements = []() {
+      fa::DataFlowGraph graph;
+      graph.push_back(
+        std::move(std::make_unique<fa::BinaryOp>(fluir::Operator::STAR,
+                                                 std::make_shared<fa::ConstantFP>(1.5, 3, fluir::FlowGraphLocation{}),
+                                                 std::make_shared<fa::ConstantFP>(2.5, 2, fluir::FlowGraphLocation{}),
+                                                 1,
+                                                 fluir::FlowGraphLocation{})));
+      return graph;
+    }()});
+
+  // Registers 0 and 1 hold the constants, so the product goes in register 2
+  fc::ByteCode expected{.header = {.filetype = 'R', .major = 0, .minor = 0, .patch = 0, .entryOffset = 0},
+                        .chunks = {fc::Chunk{.name = "foo",
+                                             .code =
+                                               {
+                                                 fc::Instruction::F64_MUL,
+                                                 0x02,
+                                                 0x00,
+                                                 0x01,
+                                                 fc::Instruction::POP,
+                                                 0x02,
+                                                 fc::Instruction::EXIT,
+                                               },
+                                             .constants = {1.5_f64, 2.5_f64}}}};
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateRegisterCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.value().header);
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.value().chunks.at(0));
+}
+
+TEST(TestRegisterGenerator, GeneratesUnaryExpressions) {
+  fa::ASG input;
+  input.declarations.emplace_back(
+    fa::FunctionDecl{.id = 3, .name = "bar", .statements = []() {
+                       fa::DataFlowGraph graph;
+                       graph.push_back(std::make_unique<fa::UnaryOp>(
+                         fluir::Operator::MINUS,
+                         std::make_shared<fa::ConstantFP>(3.456, 3, fluir::FlowGraphLocation{}),
+                         1,
+                         fluir::FlowGraphLocation{}));
+                       graph.push_back(std::make_unique<fa::UnaryOp>(
+                         fluir::Operator::PLUS,
+                         std::make_shared<fa::ConstantFP>(3.456, 4, fluir::FlowGraphLocation{}),
+                         2,
+                         fluir::FlowGraphLocation{}));
+                       return graph;
+                     }()});
+
+  // Affirming a value needs no instruction at all
+  fc::ByteCode expected{.header = {.filetype = 'R', .major = 0, .minor = 0, .patch = 0, .entryOffset = 0},
+                        .chunks = {fc::Chunk{.name = "bar",
+                                             .code =
+                                               {
+                                                 fc::Instruction::F64_NEG,
+                                                 0x01,
+                                                 0x00,
+                                                 fc::Instruction::POP,
+                                                 0x01,
+                                                 fc::Instruction::POP,
+                                                 0x00,
+                                                 fc::Instruction::EXIT,
+                                               },
+                                             .constants = {3.456_f64}}}};
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateRegisterCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.value().chunks.at(0));
+}
+
+TEST(TestRegisterGenerator, ComputesSharedNodesOnce) {
+  auto shared = std::make_shared<fa::BinaryOp>(
+    fluir::Operator::SLASH,
+    std::make_shared<fa::UnaryOp>(fluir::Operator::MINUS,
+                                  std::make_shared<fa::ConstantFP>(3.5, 5, fluir::FlowGraphLocation{}),
+                                  2,
+                                  fluir::FlowGraphLocation{}),
+    std::make_shared<fa::ConstantFP>(4.4, 6, fluir::FlowGraphLocation{}),
+    4,
+    fluir::FlowGraphLocation{});
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 3, .name = "bar", .statements = [&]() {
+      fa::DataFlowGraph graph;
+      graph.push_back(
+        std::make_unique<fa::BinaryOp>(fluir::Operator::PLUS,
+                                       std::make_shared<fa::ConstantFP>(100.0, 3, fluir::FlowGraphLocation{}),
+                                       shared,
+                                       1,
+                                       fluir::FlowGraphLocation{}));
+      graph.push_back(std::make_unique<fa::UnaryOp>(fluir::Operator::MINUS, shared, 7, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+
+  fc::ByteCode expected{.header = {.filetype = 'R', .major = 0, .minor = 0, .patch = 0, .entryOffset = 0},
+                        .chunks = {fc::Chunk{.name = "bar",
+                                             .code =
+                                               {
+                                                 fc::Instruction::F64_NEG,
+                                                 0x03,
+                                                 0x01,
+                                                 fc::Instruction::F64_DIV,
+                                                 0x04,
+                                                 0x03,
+                                                 0x02,
+                                                 fc::Instruction::F64_ADD,
+                                                 0x05,
+                                                 0x00,
+                                                 0x04,
+                                                 fc::Instruction::POP,
+                                                 0x05,
+                                                 fc::Instruction::F64_NEG,
+                                                 0x06,
+                                                 0x04,
+                                                 fc::Instruction::POP,
+                                                 0x06,
+                                                 fc::Instruction::EXIT,
+                                               },
+                                             .constants = {100.0_f64, 3.5_f64, 4.4_f64}}}};
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateRegisterCode;
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.value().chunks.at(0));
+}
+
+TEST(TestRegisterGenerator, ReportsRunningOutOfRegisters) {
+  fa::ASG input;
+  input.declarations.emplace_back(fa::FunctionDecl{
+    .id = 1, .name = "main", .statements = []() {
+      fa::DataFlowGraph graph;
+      fa::SharedDependency value = std::make_shared<fa::ConstantFP>(1.0, 2, fluir::FlowGraphLocation{});
+      for (fluir::ID id = 3; id != 300; ++id) {
+        value = std::make_shared<fa::UnaryOp>(fluir::Operator::MINUS, value, id, fluir::FlowGraphLocation{});
+      }
+      graph.push_back(std::make_unique<fa::UnaryOp>(fluir::Operator::PLUS, value, 300, fluir::FlowGraphLocation{}));
+      return graph;
+    }()});
+
+  auto [ctx, actual] = fluir::addContext(fluir::Context{}, std::move(input)) | fluir::generateRegisterCode;
+
+  EXPECT_TRUE(ctx.diagnostics.containsErrors());
+}
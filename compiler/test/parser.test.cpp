@@ -1,6 +1,7 @@
 #include "compiler/frontend/parser.hpp"
 #include "compiler/frontend/parse_tree/parse_tree.hpp"
 
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <variant>
@@ -22,6 +23,17 @@ TEST_P(TestParser, Test) {
   EXPECT_EQ(expected, actual.value());
 }
 
+TEST_P(TestParser, ParsesStreams) {
+  fluir::Context ctx;
+  const auto& [source, expected, name] = GetParam();
+  std::istringstream in{source};
+
+  auto actual = fluir::Parser{ctx}.parseStream(in, name + ".fl");
+
+  EXPECT_FALSE(ctx.diagnostics.containsErrors());
+  EXPECT_EQ(expected, actual.value());
+}
+
 namespace {
   TestParserData CanParseEmptyMain{
     R"(<?xml version="1.0" encoding="UTF-8"?>
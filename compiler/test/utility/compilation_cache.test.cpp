@@ -0,0 +1,98 @@
+#include "compiler/utility/compilation_cache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+  class TestCompilationCache : public ::testing::Test {
+   protected:
+    fs::path directory = fs::temp_directory_path() / "fluir_compilation_cache_test";
+
+    void SetUp() override { fs::remove_all(directory); }
+    void TearDown() override { fs::remove_all(directory); }
+
+    /** Makes the entry for key look as if it was last used seconds ago */
+    void age(const std::string& key, int seconds) {
+      fs::last_write_time(directory / key, fs::file_time_type::clock::now() - std::chrono::seconds{seconds});
+    }
+  };
+}  // namespace
+
+TEST(TestCompilationCacheKeys, HashesWithSha256) {
+  EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", fluir::CompilationCache::digest(""));
+  EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", fluir::CompilationCache::digest("abc"));
+  // Two blocks of padding, then a message of several blocks
+  EXPECT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+            fluir::CompilationCache::digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+  EXPECT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+            fluir::CompilationCache::digest(std::string(1'000'000, 'a')));
+}
+
+TEST(TestCompilationCacheKeys, DependOnTheSourceAndOptions) {
+  const auto key = fluir::CompilationCache::key("<program/>", "stack inspect");
+
+  EXPECT_EQ(64, key.size());
+  EXPECT_EQ(key, fluir::CompilationCache::key("<program/>", "stack inspect"));
+  EXPECT_NE(key, fluir::CompilationCache::key("<program />", "stack inspect"));
+  EXPECT_NE(key, fluir::CompilationCache::key("<program/>", "stack binary"));
+  // Moving bytes between the options and the source changes the key too
+  EXPECT_NE(fluir::CompilationCache::key("b", "a"), fluir::CompilationCache::key("", "a\nb"));
+}
+
+TEST_F(TestCompilationCache, FindsWhatWasStored) {
+  const fluir::CompilationCache cache{directory};
+  const auto key = fluir::CompilationCache::key("source", "options");
+
+  EXPECT_FALSE(cache.find(key).has_value());
+  cache.store(key, std::string{"I00\0\x01\xFF", 6});
+
+  EXPECT_EQ((std::string{"I00\0\x01\xFF", 6}), cache.find(key));
+  // Only the entry is left behind, not the temporary file it was written to
+  EXPECT_EQ(1, std::distance(fs::directory_iterator{directory}, fs::directory_iterator{}));
+}
+
+TEST_F(TestCompilationCache, EvictsTheLeastRecentlyUsedEntries) {
+  const fluir::CompilationCache cache{directory, 250};
+  const auto first = fluir::CompilationCache::key("first", "");
+  const auto second = fluir::CompilationCache::key("second", "");
+  const auto third = fluir::CompilationCache::key("third", "");
+  cache.store(first, std::string(100, 'a'));
+  age(first, 30);
+  cache.store(second, std::string(100, 'b'));
+  age(second, 20);
+  // Using the first entry makes the second the least recently used
+  ASSERT_TRUE(cache.find(first).has_value());
+
+  cache.store(third, std::string(100, 'c'));
+
+  EXPECT_TRUE(cache.find(first).has_value());
+  EXPECT_FALSE(cache.find(second).has_value());
+  EXPECT_TRUE(cache.find(third).has_value());
+}
+
+TEST_F(TestCompilationCache, LeavesOtherFilesAlone) {
+  const fluir::CompilationCache cache{directory, 0};
+  fs::create_directories(directory);
+  { std::ofstream{directory / "notes.txt"} << "not an entry"; }
+
+  cache.store(fluir::CompilationCache::key("source", ""), "code");
+
+  EXPECT_TRUE(fs::exists(directory / "notes.txt"));
+}
+
+TEST_F(TestCompilationCache, IgnoresDirectoriesItCannotUse) {
+  fs::create_directories(directory);
+  { std::ofstream{directory / "file"} << "in the way"; }
+  const fluir::CompilationCache cache{directory / "file" / "cache"};
+  const auto key = fluir::CompilationCache::key("source", "");
+
+  EXPECT_NO_THROW(cache.store(key, "code"));
+  EXPECT_FALSE(cache.find(key).has_value());
+}
@@ -0,0 +1,105 @@
+#include "compiler/frontend/xml_reader.hpp"
+
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using Event = fluir::XmlReader::Event;
+
+TEST(TestXmlReader, ReadsTagsInOrder) {
+  fluir::XmlReader reader{R"(<?xml version="1.0"?>
+<!DOCTYPE fluir>
+<fluir>
+  <!-- <ignored/> -->
+  <body id="1" name='main'><constant/></body>
+</fluir>)"};
+
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("fluir", reader.name());
+  EXPECT_EQ(3, reader.line());
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("body", reader.name());
+  EXPECT_EQ(5, reader.line());
+  EXPECT_EQ("1", reader.attribute("id"));
+  EXPECT_EQ("main", reader.attribute("name"));
+  EXPECT_FALSE(reader.attribute("x").has_value());
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("constant", reader.name());
+  EXPECT_EQ(3, reader.depth());
+  // A self-closing tag ends straight away
+  ASSERT_EQ(Event::END, reader.next());
+  EXPECT_EQ(2, reader.depth());
+  ASSERT_EQ(Event::END, reader.next());
+  EXPECT_EQ("body", reader.name());
+  ASSERT_EQ(Event::END, reader.next());
+  EXPECT_EQ("fluir", reader.name());
+  EXPECT_EQ(Event::END_OF_DOCUMENT, reader.next());
+}
+
+TEST(TestXmlReader, ReadsStreamsThroughASmallWindow) {
+  std::istringstream in{
+    "<fluir>\n  <float value=\"&lt;&#x41;&#66;&gt;\">\n  1.5 &amp; <![CDATA[<2>]]></float>\n</fluir>"};
+  fluir::XmlReader reader{in, 3};
+
+  ASSERT_EQ(Event::START, reader.next());
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("float", reader.name());
+  EXPECT_EQ(2, reader.line());
+  EXPECT_EQ("<AB>", reader.attribute("value"));
+  EXPECT_EQ("\n  1.5 & <2>", reader.text());
+  ASSERT_EQ(Event::END, reader.next());
+  EXPECT_EQ(3, reader.line());
+  ASSERT_EQ(Event::END, reader.next());
+  EXPECT_EQ(4, reader.line());
+  EXPECT_EQ(Event::END_OF_DOCUMENT, reader.next());
+}
+
+TEST(TestXmlReader, SkipsTheRestOfAnElement) {
+  fluir::XmlReader reader{"<fluir><function><body><constant><float>1</float></constant></body></function><a/></fluir>"};
+  reader.next();
+  reader.next();
+  reader.next();
+
+  reader.skipTo(1);
+
+  EXPECT_EQ("function", reader.name());
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("a", reader.name());
+  reader.skipElement();
+  EXPECT_EQ(1, reader.depth());
+}
+
+TEST(TestXmlReader, HasNoTextWithOnlyWhitespaceOrChildren) {
+  fluir::XmlReader reader{"<fluir>\n  <float/>\n</fluir>"};
+  reader.next();
+
+  EXPECT_FALSE(reader.text().has_value());
+  // Reading the text leaves the reader at the next tag
+  ASSERT_EQ(Event::START, reader.next());
+  EXPECT_EQ("float", reader.name());
+  EXPECT_FALSE(reader.text().has_value());
+}
+
+TEST(TestXmlReader, RejectsMalformedDocuments) {
+  const auto errorIn = [](std::string source) -> std::optional<fluir::XmlReader::SyntaxError> {
+    fluir::XmlReader reader{source};
+    try {
+      while (reader.next() != Event::END_OF_DOCUMENT) { }
+    } catch (const fluir::XmlReader::SyntaxError& error) {
+      return error;
+    }
+    return std::nullopt;
+  };
+
+  const auto mismatched = errorIn("<fluir>\n<body>\n</fluir>");
+  ASSERT_TRUE(mismatched.has_value());
+  EXPECT_EQ(3, mismatched->line);
+  EXPECT_EQ("Expected '</body>', found '</fluir>'.", mismatched->message);
+  EXPECT_TRUE(errorIn("<fluir><body></body>").has_value());
+  EXPECT_TRUE(errorIn("<fluir id=\"1\" id=\"2\"/>").has_value());
+  EXPECT_TRUE(errorIn("<fluir id=1/>").has_value());
+  EXPECT_TRUE(errorIn("<fluir><!-- unterminated </fluir>").has_value());
+  EXPECT_FALSE(errorIn("<fluir a=\"&unknown;\"/>").has_value());
+}
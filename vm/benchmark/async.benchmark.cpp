@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "vm/async.hpp"
+#include "vm/program.hpp"
+#include "vm/thread_pool.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr std::size_t ADDITIONS = 1'000;
+  constexpr std::size_t EXECUTIONS = 1'000;
+
+  /* Sums 1.5 ADDITIONS times */
+  fc::ByteCode sum() {
+    fc::Chunk main{.name = "main", .code = {PUSH, 0}, .constants = {1.5_f64}};
+    for (std::size_t i = 0; i != ADDITIONS; ++i) {
+      main.code.insert(main.code.end(), {PUSH, 0, F64_ADD});
+    }
+    main.code.push_back(EXIT);
+    return fc::ByteCode{.header = {}, .chunks = {std::move(main)}};
+  }
+
+  void label(benchmark::State& state) {
+    state.SetLabel(state.range(0) != 0 ? std::to_string(state.range(0)) + " instruction budget" : "no budget");
+  }
+}  // namespace
+
+/* Executes on one thread, resuming each time the budget in the argument runs out */
+static void BM_Budgeted(benchmark::State& state) {
+  const auto code = sum();
+  const fluir::ExecOptions options{.budget = {.instructions = static_cast<std::size_t>(state.range(0))}};
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    auto result = vm.execute(code, options);
+    while (result == fluir::ExecResult::SUSPENDED) {
+      result = vm.resume();
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  label(state);
+  state.SetItemsProcessed(state.iterations() * (2 * ADDITIONS + 1));
+}
+BENCHMARK(BM_Budgeted)->Arg(0)->Arg(64)->Arg(1024);
+
+/* Starts EXECUTIONS executions on two worker threads, which take turns between them each time a budget runs out */
+static void BM_AsyncExecutions(benchmark::State& state) {
+  const auto program = fluir::LoadedProgram::load(sum());
+  const fluir::ExecOptions options{.budget = {.instructions = static_cast<std::size_t>(state.range(0))}};
+  fluir::ThreadPool threads{2};
+  std::vector<fluir::ExecutionContext> contexts;
+  for (std::size_t i = 0; i != EXECUTIONS; ++i) {
+    contexts.emplace_back(program);
+  }
+  std::vector<fluir::AsyncExecution> executions;
+  executions.reserve(EXECUTIONS);
+  for (auto _ : state) {
+    executions.clear();
+    for (auto& context : contexts) {
+      executions.push_back(context.executeAsync(threads, options));
+      executions.back().start();
+    }
+    for (auto& execution : executions) {
+      benchmark::DoNotOptimize(execution.wait());
+    }
+  }
+  label(state);
+  state.SetItemsProcessed(state.iterations() * EXECUTIONS);
+}
+BENCHMARK(BM_AsyncExecutions)->Arg(0)->Arg(64)->Arg(1024)->UseRealTime();
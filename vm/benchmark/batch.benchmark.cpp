@@ -0,0 +1,69 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  /* a * b + c * d - a / c over four inputs, keeping the result on the stack */
+  fc::ByteCode expression() {
+    fc::Chunk chunk{.name = "main",
+                    .code = {PUSH, 0, PUSH, 1, F64_MUL, PUSH, 2, PUSH, 3, F64_MUL, F64_ADD, PUSH, 0, PUSH, 2, F64_DIV,
+                             F64_SUB, EXIT},
+                    .constants = {1.0_f64, 2.0_f64, 3.0_f64, 4.0_f64}};
+    return fc::ByteCode{.header = {}, .chunks = {std::move(chunk)}};
+  }
+
+  std::vector<fluir::Column> inputs(std::size_t rows) {
+    std::vector<fluir::Column> columns;
+    for (int input = 0; input != 4; ++input) {
+      std::vector<fc::F64> values(rows);
+      for (std::size_t row = 0; row != rows; ++row) {
+        values[row] = static_cast<fc::F64>(row + 1) * (input + 1);
+      }
+      columns.push_back(fluir::Column::from(std::span<const fc::F64>{values}));
+    }
+    return columns;
+  }
+}  // namespace
+
+/* What a caller has to do without batches: rewrite the constants and execute once per row */
+static void BM_RowAtATime(benchmark::State& state) {
+  const auto rows = static_cast<std::size_t>(state.range(0));
+  auto code = expression();
+  auto verified = fluir::verify(code);
+  auto columns = inputs(rows);
+  auto& constants = code.chunks[0].constants;
+
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    for (std::size_t row = 0; row != rows; ++row) {
+      for (std::size_t input = 0; input != columns.size(); ++input) {
+        constants[input] = columns[input].at(row);
+      }
+      auto result = vm.execute(verified);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RowAtATime)->Arg(1024)->Arg(65536);
+
+static void BM_Batch(benchmark::State& state) {
+  auto code = expression();
+  auto verified = fluir::verify(code);
+  auto columns = inputs(static_cast<std::size_t>(state.range(0)));
+
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    auto result = vm.executeBatch(verified, columns);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Batch)->Arg(1024)->Arg(65536);
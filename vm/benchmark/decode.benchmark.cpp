@@ -0,0 +1,264 @@
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "bytecode/binary_format.hpp"
+#include "vm/decoder/decode.hpp"
+#include "vm/fuser.hpp"
+#include "vm/output.hpp"
+#include "vm/program.hpp"
+#include "vm/thread_pool.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+
+namespace {
+  constexpr std::size_t CONSTANTS = 256;
+  constexpr std::size_t ADDITIONS = 1'000;
+
+  /* A module of the given number of chunks, each of which sums its CONSTANTS constants ADDITIONS times */
+  fc::ByteCode module(std::size_t chunks) {
+    fc::ByteCode code{.header = {.filetype = fc::FILETYPE_INSPECT}, .chunks = {}};
+    for (std::size_t i = 0; i != chunks; ++i) {
+      fc::Chunk chunk{.name = std::format("chunk{}", i), .code = {PUSH, 0}};
+      for (std::size_t constant = 0; constant != CONSTANTS; ++constant) {
+        chunk.constants.emplace_back(static_cast<double>(i * CONSTANTS + constant) + 0.5);
+      }
+      for (std::size_t addition = 0; addition != ADDITIONS; ++addition) {
+        chunk.code.insert(chunk.code.end(), {PUSH, static_cast<std::uint8_t>(addition % CONSTANTS), F64_ADD});
+      }
+      chunk.code.insert(chunk.code.end(), {POP, EXIT});
+      code.chunks.push_back(std::move(chunk));
+    }
+    return code;
+  }
+
+  /* The module as the compiler's InspectWriter writes it */
+  std::string inspect(const fc::ByteCode& code) {
+    std::string text = "I0000000000000000000000\n";
+    for (const auto& chunk : code.chunks) {
+      text += std::format("CHUNK {}\n  CONSTANTS x{:X}\n", chunk.name, chunk.constants.size());
+      for (const auto& constant : chunk.constants) {
+        text += std::format("    VF64 {:.12f}\n", constant.asF64());
+      }
+      text += std::format("  CODE x{:X}\n", chunk.code.size());
+      for (std::size_t i = 0; i != chunk.code.size(); ++i) {
+        switch (chunk.code[i]) {
+          case PUSH:
+            text += std::format("    IPUSH x{:X}\n", chunk.code[++i]);
+            break;
+          case F64_ADD:
+            text += "    IF64_ADD\n";
+            break;
+          case POP:
+            text += "    IPOP\n";
+            break;
+          default:
+            text += "    IEXIT\n";
+            break;
+        }
+      }
+    }
+    return text;
+  }
+
+  std::string binary(const fc::ByteCode& code) {
+    const auto bytes = fc::binary::encode(code);
+    return std::string{bytes.begin(), bytes.end()};
+  }
+
+  void decode(benchmark::State& state, const std::string& source) {
+    for (auto _ : state) {
+      auto code = fluir::decode(source);
+      benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["file_bytes"] = static_cast<double>(source.size());
+  }
+
+  /* Writes the module in the binary format to a temporary file, returning its path */
+  std::string binaryFile(std::size_t chunks) {
+    const auto path = std::filesystem::temp_directory_path() / std::format("fluir_load_{}.flb", chunks);
+    std::ofstream fout{path, std::ios::binary};
+    fout << binary(module(chunks));
+    return path.string();
+  }
+
+  /* Writes the module in the inspect format to a temporary .flc file, returning its path */
+  std::string inspectFile(std::size_t chunks) {
+    const auto path = std::filesystem::temp_directory_path() / std::format("fluir_load_{}.flc", chunks);
+    std::ofstream fout{path, std::ios::binary};
+    fout << inspect(module(chunks));
+    return path.string();
+  }
+
+  /* The memory the process has resident, including the pages of mapped files it has touched, or 0 without /proc */
+  std::size_t residentBytes() {
+#if defined(__linux__)
+    std::ifstream statm{"/proc/self/statm"};
+    std::size_t size = 0;
+    std::size_t resident = 0;
+    statm >> size >> resident;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+  }
+
+  /* Starts a run of the entry chunk of the module in path, decoding everything (0) or only what it enters (1) */
+  fluir::ExecResult startAndRun(const std::string& path, bool lazy, fluir::VirtualMachine& vm, fluir::TextSink& sink) {
+    if (lazy) {
+      const auto program = fluir::LazyProgram::open(path);
+      return vm.execute(program.enter(program.entry()), {.output = &sink});
+    }
+    auto code = fluir::load(path);
+    fluir::fuse(code);
+    return vm.execute(fluir::verify(code), {.output = &sink});
+  }
+}  // namespace
+
+static void BM_DecodeInspect(benchmark::State& state) {
+  decode(state, inspect(module(static_cast<std::size_t>(state.range(0)))));
+}
+BENCHMARK(BM_DecodeInspect)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/* Maps and decodes multi-megabyte .flc files, as tools exchanging the text format in bulk do */
+static void BM_LoadInspect(benchmark::State& state) {
+  const auto path = inspectFile(static_cast<std::size_t>(state.range(0)));
+  const auto size = std::filesystem::file_size(path);
+  for (auto _ : state) {
+    auto code = fluir::load(path);
+    benchmark::DoNotOptimize(code);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+  state.counters["file_bytes"] = static_cast<double>(size);
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_LoadInspect)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+/* Loads large .flc files with their chunks decoded on a pool of the given number of threads, or on the calling thread
+ * for 0, to measure the cold start of the largest generated modules */
+static void BM_LoadInspectOnThreads(benchmark::State& state) {
+  const auto path = inspectFile(static_cast<std::size_t>(state.range(0)));
+  const auto size = std::filesystem::file_size(path);
+  std::optional<fluir::ThreadPool> pool;
+  if (state.range(1) != 0) {
+    pool.emplace(static_cast<std::size_t>(state.range(1)));
+  }
+  for (auto _ : state) {
+    auto code = pool ? fluir::load(path, *pool) : fluir::load(path);
+    benchmark::DoNotOptimize(code);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_LoadInspectOnThreads)
+  ->ArgsProduct({{256, 1024}, {0, 1, 2, 4}})
+  ->ArgNames({"chunks", "threads"})
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+
+static void BM_DecodeBinary(benchmark::State& state) {
+  decode(state, binary(module(static_cast<std::size_t>(state.range(0)))));
+}
+BENCHMARK(BM_DecodeBinary)->Arg(16)->Arg(256)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadBinary(benchmark::State& state) {
+  const auto path = binaryFile(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto code = fluir::load(path);
+    benchmark::DoNotOptimize(code);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_LoadBinary)->Arg(16)->Arg(256)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+/* Decodes binary modules by copying their chunks on a pool of the given number of threads, or on the calling thread
+ * for 0 */
+static void BM_DecodeBinaryOnThreads(benchmark::State& state) {
+  const auto source = binary(module(static_cast<std::size_t>(state.range(0))));
+  std::optional<fluir::ThreadPool> pool;
+  if (state.range(1) != 0) {
+    pool.emplace(static_cast<std::size_t>(state.range(1)));
+  }
+  for (auto _ : state) {
+    auto code = pool ? fluir::decode(source, *pool) : fluir::decode(source);
+    benchmark::DoNotOptimize(code);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+}
+BENCHMARK(BM_DecodeBinaryOnThreads)
+  ->ArgsProduct({{256, 4096}, {0, 1, 2, 4}})
+  ->ArgNames({"chunks", "threads"})
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+
+/* Runs the first chunk of a module decoded into vectors (0) or loaded in place (1) */
+static void BM_ExecuteLoaded(benchmark::State& state) {
+  const auto path = binaryFile(1);
+  std::ifstream fin{path, std::ios::binary};
+  const std::string source{std::istreambuf_iterator<char>{fin}, {}};
+  const auto code = state.range(0) != 0 ? fluir::load(path) : fluir::decode(source);
+  std::filesystem::remove(path);
+  state.SetLabel(state.range(0) != 0 ? "in place" : "copied");
+
+  const auto verified = fluir::verify(code);
+  fluir::VirtualMachine vm;
+  fluir::TextSink sink;
+  for (auto _ : state) {
+    auto result = vm.execute(verified, {.output = &sink});
+    benchmark::DoNotOptimize(result);
+    sink.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(2 * ADDITIONS + 3));
+}
+BENCHMARK(BM_ExecuteLoaded)->Arg(0)->Arg(1);
+
+/* Starts and runs the entry chunk of a module of range(0) chunks, loading every chunk up front (0) or only the ones
+ * the run enters (1) */
+static void BM_StartProgram(benchmark::State& state) {
+  const auto path = binaryFile(static_cast<std::size_t>(state.range(0)));
+  const bool lazy = state.range(1) != 0;
+  state.SetLabel(lazy ? "lazy" : "eager");
+  fluir::VirtualMachine vm;
+  fluir::TextSink sink;
+
+  // Measure the memory a single start makes resident before the file is in every page table
+  const auto before = residentBytes();
+  {
+    const auto program = lazy ? std::optional{fluir::LazyProgram::open(path)} : std::nullopt;
+    auto code = lazy ? fc::ByteCode{} : fluir::load(path);
+    if (lazy) {
+      benchmark::DoNotOptimize(program->enter(program->entry()));
+    } else {
+      fluir::fuse(code);
+      benchmark::DoNotOptimize(fluir::verify(code));
+    }
+    state.counters["resident_kb"] = static_cast<double>(residentBytes() - before) / 1024;
+  }
+
+  for (auto _ : state) {
+    auto result = startAndRun(path, lazy, vm, sink);
+    benchmark::DoNotOptimize(result);
+    sink.clear();
+  }
+  state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_StartProgram)
+  ->ArgsProduct({{16, 256, 4096}, {0, 1}})
+  ->Unit(benchmark::kMicrosecond);
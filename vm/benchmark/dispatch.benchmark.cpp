@@ -0,0 +1,191 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "vm/fuser.hpp"
+#include "vm/jit.hpp"
+#include "vm/profiler.hpp"
+#include "vm/sampler.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr int REPETITIONS = 1000;
+
+  /* Builds a chunk which runs `body` REPETITIONS times, keeping a single value on the stack throughout */
+  fc::ByteCode repeat(std::vector<std::uint8_t> preamble, const std::vector<std::uint8_t>& body,
+                      std::vector<fc::Value> constants) {
+    fc::Chunk chunk{.name = "main", .code = std::move(preamble), .constants = std::move(constants)};
+    for (int i = 0; i != REPETITIONS; ++i) {
+      chunk.code.insert(chunk.code.end(), body.begin(), body.end());
+    }
+    chunk.code.push_back(EXIT);
+    return fc::ByteCode{.header = {}, .chunks = {std::move(chunk)}};
+  }
+
+  void runMix(benchmark::State& state, const fc::ByteCode& code, std::int64_t instructionsPerRun) {
+    fluir::VirtualMachine vm;
+    for (auto _ : state) {
+      auto result = vm.execute(&code);
+      benchmark::DoNotOptimize(result);
+      if (result != fluir::ExecResult::SUCCESS) {
+        state.SkipWithError("The benchmark program failed to execute");
+        break;
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * instructionsPerRun);
+  }
+}  // namespace
+
+static void BM_DispatchF64(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, F64_ADD, PUSH, 2, F64_MUL, PUSH, 1, F64_SUB, PUSH, 2, F64_DIV, F64_NEG},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  runMix(state, code, 9 * REPETITIONS);
+}
+BENCHMARK(BM_DispatchF64);
+
+static void BM_DispatchI64(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, I64_ADD, PUSH, 2, I64_MUL, PUSH, 1, I64_SUB, PUSH, 2, I64_DIV, I64_NEG},
+                     {1_i64, 3_i64, 2_i64});
+  runMix(state, code, 9 * REPETITIONS);
+}
+BENCHMARK(BM_DispatchI64);
+
+/* BM_DispatchI64 on I32s, with the generic instructions or the ones specialized to I32 */
+static void BM_DispatchSized(benchmark::State& state) {
+  std::vector<std::uint8_t> body{PUSH, 1, I64_ADD, PUSH, 2, I64_MUL, PUSH, 1, I64_SUB, PUSH, 2, I64_DIV, I64_NEG};
+  if (state.range(0) != 0) {
+    for (auto i : {2, 5, 8, 11, 12}) {
+      body[i] = fc::sized(static_cast<fc::Instruction>(body[i]), fc::PrimitiveType::I32);
+    }
+  }
+  state.SetLabel(state.range(0) != 0 ? "sized" : "generic");
+  auto code = repeat({PUSH, 0}, body, {1_i32, 3_i32, 2_i32});
+  runMix(state, code, 9 * REPETITIONS);
+}
+BENCHMARK(BM_DispatchSized)->Arg(0)->Arg(1);
+
+static void BM_DispatchCasts(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {CAST_IF, CAST_FU, WIDTH_32, CAST_UI, WIDTH_16, CAST_IU, WIDTH_64, CAST_UF, CAST_FI, WIDTH_64},
+                     {7_i64});
+  runMix(state, code, 6 * REPETITIONS);
+}
+BENCHMARK(BM_DispatchCasts);
+
+static void BM_DispatchMixed(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, I64_ADD, CAST_IF, PUSH, 2, F64_MUL, CAST_FU, WIDTH_64, PUSH, 3, U64_ADD,
+                      CAST_UI, WIDTH_64, I64_NEG, I64_NEG, U64_AFF},
+                     {1_i64, 2_i64, 0.5_f64, 4_u64});
+  runMix(state, code, 12 * REPETITIONS);
+}
+BENCHMARK(BM_DispatchMixed);
+
+/* The shape the compiler emits for nested arithmetic on constants, run with and without the fuser */
+static void BM_Superinstructions(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, PUSH, 2, F64_MUL, F64_ADD, PUSH, 1, PUSH, 2, F64_DIV, F64_SUB, PUSH, 2, PUSH, 1, PUSH,
+                      1, F64_MUL, F64_ADD, F64_ADD},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  if (state.range(0) != 0) {
+    fluir::fuse(code);
+  }
+  state.SetLabel(state.range(0) != 0 ? "fused" : "plain");
+  // Count the instructions of the unfused code so both variants report the same amount of work
+  runMix(state, code, 14 * REPETITIONS);
+}
+BENCHMARK(BM_Superinstructions)->Arg(0)->Arg(1);
+
+/* The same computation as BM_Superinstructions in register code, with the accumulator in r3 and a temporary in r4 */
+static void BM_Registers(benchmark::State& state) {
+  auto code = repeat({F64_AFF, 3, 0},
+                     {F64_MUL, 4, 1, 2, F64_ADD, 3, 3, 4, F64_DIV, 4, 1, 2, F64_SUB, 3, 3, 4, F64_MUL, 4, 1, 1,
+                      F64_ADD, 4, 2, 4, F64_ADD, 3, 3, 4},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  code.header.filetype = fc::FILETYPE_REGISTERS;
+  // Count the instructions of the equivalent stack code so the rate compares with BM_Superinstructions
+  runMix(state, code, 14 * REPETITIONS);
+}
+BENCHMARK(BM_Registers);
+
+/* The fused BM_Superinstructions code run on the interpreter without checks and as native code */
+static void BM_Jit(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, PUSH, 2, F64_MUL, F64_ADD, PUSH, 1, PUSH, 2, F64_DIV, F64_SUB, PUSH, 2, PUSH, 1, PUSH,
+                      1, F64_MUL, F64_ADD, F64_ADD},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  fluir::fuse(code);
+  auto verified = fluir::verify(code);
+  auto jit = fluir::compile(verified);
+  if (state.range(0) != 0 && jit.chunk(0) == nullptr) {
+    state.SkipWithError("The JIT does not support this platform");
+    return;
+  }
+  state.SetLabel(state.range(0) != 0 ? "native" : "interpreter");
+
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    auto result = state.range(0) != 0 ? vm.execute(jit) : vm.execute(verified);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * 14 * REPETITIONS);
+}
+BENCHMARK(BM_Jit)->Arg(0)->Arg(1);
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::AddCustomContext("dispatch", FLUIR_VM_DISPATCH_ENGINE);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
+
+/* BM_DispatchF64 with and without a Profiler counting every instruction */
+static void BM_Profiled(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, F64_ADD, PUSH, 2, F64_MUL, PUSH, 1, F64_SUB, PUSH, 2, F64_DIV, F64_NEG},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  fluir::Profiler profiler;
+  const fluir::ExecOptions options{.profiler = state.range(0) != 0 ? &profiler : nullptr};
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    auto result = vm.execute(code, options);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetLabel(state.range(0) != 0 ? "profiled" : "unprofiled");
+  state.SetItemsProcessed(state.iterations() * 9 * REPETITIONS);
+}
+BENCHMARK(BM_Profiled)->Arg(0)->Arg(1);
+
+/* BM_DispatchF64 with and without a started SamplingProfiler taking a sample every millisecond of CPU time */
+static void BM_Sampled(benchmark::State& state) {
+  auto code = repeat({PUSH, 0},
+                     {PUSH, 1, F64_ADD, PUSH, 2, F64_MUL, PUSH, 1, F64_SUB, PUSH, 2, F64_DIV, F64_NEG},
+                     {1.0_f64, 0.5_f64, 2.0_f64});
+  fluir::SamplingProfiler sampler;
+  const fluir::ExecOptions options{.sampler = state.range(0) != 0 ? &sampler : nullptr};
+  fluir::VirtualMachine vm;
+  if (state.range(0) != 0) {
+    sampler.start();
+  }
+  for (auto _ : state) {
+    auto result = vm.execute(code, options);
+    benchmark::DoNotOptimize(result);
+  }
+  sampler.stop();
+  state.SetLabel(state.range(0) != 0 ? "sampled" : "unsampled");
+  state.SetItemsProcessed(state.iterations() * 9 * REPETITIONS);
+}
+BENCHMARK(BM_Sampled)->Arg(0)->Arg(1);
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <type_traits>
+
+#include "vm/output.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr std::size_t VALUES = 1'000;
+
+  /* Pops VALUES values, alternating between an F64 and an I64 */
+  fc::ByteCode pops() {
+    fc::Chunk main{.name = "main", .code = {}, .constants = {1.5_f64, 42_i64}};
+    for (std::size_t i = 0; i != VALUES; ++i) {
+      main.code.insert(main.code.end(), {PUSH, static_cast<std::uint8_t>(i % 2), POP});
+    }
+    main.code.push_back(EXIT);
+    return fc::ByteCode{.header = {}, .chunks = {std::move(main)}};
+  }
+
+  template <typename Sink, typename Reset>
+  void run(benchmark::State& state, Sink& sink, Reset reset) {
+    const auto code = pops();
+    fluir::VirtualMachine vm;
+    for (auto _ : state) {
+      auto result = vm.execute(code, {.output = &sink});
+      benchmark::DoNotOptimize(result);
+      reset();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+  }
+}  // namespace
+
+/* Formats into a TextSink which writes to a stream once per execution */
+static void BM_TextSinkToStream(benchmark::State& state) {
+  std::ostringstream target;
+  fluir::TextSink sink{&target};
+  run(state, sink, [&target] { target.str(""); });
+}
+BENCHMARK(BM_TextSinkToStream);
+
+/* Formats into a TextSink which keeps the text */
+static void BM_TextSink(benchmark::State& state) {
+  fluir::TextSink sink;
+  run(state, sink, [&sink] { sink.clear(); });
+}
+BENCHMARK(BM_TextSink);
+
+static void BM_RingBufferSink(benchmark::State& state) {
+  fluir::RingBufferSink sink{VALUES};
+  run(state, sink, [&sink] { sink.clear(); });
+}
+BENCHMARK(BM_RingBufferSink);
+
+/* Counts the values of each type as they arrive */
+static void BM_CallbackSink(benchmark::State& state) {
+  std::size_t floats = 0;
+  std::size_t others = 0;
+  fluir::CallbackSink sink{[&floats, &others](auto value) {
+    if constexpr (std::is_floating_point_v<decltype(value)>) {
+      ++floats;
+    } else {
+      ++others;
+    }
+  }};
+  run(state, sink, [] { });
+  benchmark::DoNotOptimize(floats + others);
+}
+BENCHMARK(BM_CallbackSink);
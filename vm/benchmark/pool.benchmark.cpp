@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include "vm/pool.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr benchmark::IterationCount EXECUTIONS = 1'000'000;
+
+  /* A short request: 1.5 * 2.0 + 1.5, as stack code or as register code */
+  fc::ByteCode request(bool registers) {
+    if (registers) {
+      return fc::ByteCode{.header = {.filetype = fc::FILETYPE_REGISTERS},
+                          .chunks = {fc::Chunk{.name = "main",
+                                               .code = {F64_MUL, 2, 0, 1, F64_ADD, 2, 2, 0, EXIT},
+                                               .constants = {1.5_f64, 2.0_f64}}}};
+    }
+    return fc::ByteCode{.header = {},
+                        .chunks = {fc::Chunk{.name = "main",
+                                             .code = {PUSH, 0, PUSH, 1, F64_MUL, PUSH, 0, F64_ADD, EXIT},
+                                             .constants = {1.5_f64, 2.0_f64}}}};
+  }
+
+  void label(benchmark::State& state) { state.SetLabel(state.range(0) != 0 ? "registers" : "stack"); }
+}  // namespace
+
+/* Every request constructs its own VM, which allocates its stack and registers again */
+static void BM_ConstructPerRequest(benchmark::State& state) {
+  const auto code = request(state.range(0) != 0);
+  for (auto _ : state) {
+    fluir::VirtualMachine vm;
+    auto result = vm.execute(code, {});
+    benchmark::DoNotOptimize(result);
+  }
+  label(state);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConstructPerRequest)->Arg(0)->Arg(1)->Iterations(EXECUTIONS);
+
+/* Every request leases a VM from a pool and returns it afterwards */
+static void BM_Pooled(benchmark::State& state) {
+  const auto code = request(state.range(0) != 0);
+  fluir::VmPool pool{1};
+  for (auto _ : state) {
+    auto vm = pool.acquire();
+    auto result = vm->execute(code, {});
+    benchmark::DoNotOptimize(result);
+  }
+  label(state);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Pooled)->Arg(0)->Arg(1)->Iterations(EXECUTIONS);
+
+/* A single VM executing every request, the lower bound for the pool */
+static void BM_Reused(benchmark::State& state) {
+  const auto code = request(state.range(0) != 0);
+  fluir::VirtualMachine vm;
+  for (auto _ : state) {
+    auto result = vm.execute(code, {});
+    benchmark::DoNotOptimize(result);
+  }
+  label(state);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Reused)->Arg(0)->Arg(1)->Iterations(EXECUTIONS);
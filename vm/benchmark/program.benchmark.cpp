@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include "vm/program.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr std::size_t ADDITIONS = 1'000;
+
+  /* One program shared by every thread, which sums 1.5 ADDITIONS times */
+  const fluir::LoadedProgram& program() {
+    static const auto loaded = [] {
+      fc::Chunk main{.name = "main", .code = {PUSH, 0}, .constants = {1.5_f64}};
+      for (std::size_t i = 0; i != ADDITIONS; ++i) {
+        main.code.insert(main.code.end(), {PUSH, 0, F64_ADD});
+      }
+      main.code.push_back(EXIT);
+      return fluir::LoadedProgram::load(fc::ByteCode{.header = {}, .chunks = {std::move(main)}});
+    }();
+    return loaded;
+  }
+}  // namespace
+
+/* Every thread executes the shared program with an ExecutionContext of its own */
+static void BM_SharedProgram(benchmark::State& state) {
+  fluir::ExecutionContext context{program()};
+  for (auto _ : state) {
+    auto result = context.execute();
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedProgram)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "vm/pool.hpp"
+#include "vm/scheduler.hpp"
+#include "vm/thread_pool.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr std::size_t SINKS = 16;
+  constexpr std::size_t ADDITIONS = 20'000;
+
+  /* A function of SINKS independent sinks, each summing 1.5 ADDITIONS times before printing */
+  fc::ByteCode sinks() {
+    fc::ByteCode code{.header = {}, .chunks = {fc::Chunk{.name = "main", .code = {EXIT}, .constants = {}}}};
+    for (std::size_t i = 0; i != SINKS; ++i) {
+      fc::Chunk sink{.name = "main_sink" + std::to_string(i), .code = {PUSH, 0}, .constants = {1.5_f64}};
+      for (std::size_t j = 0; j != ADDITIONS; ++j) {
+        sink.code.insert(sink.code.end(), {PUSH, 0, F64_ADD});
+      }
+      sink.code.insert(sink.code.end(), {POP, EXIT});
+      code.chunks.push_back(std::move(sink));
+      code.chunks.front().subgraphs.push_back(fc::Subgraph{.chunk = i + 1, .dependencies = {}});
+    }
+    return code;
+  }
+}  // namespace
+
+/* Runs the sinks with as many worker threads as the argument */
+static void BM_ParallelSinks(benchmark::State& state) {
+  const auto code = sinks();
+  fluir::ThreadPool threads{static_cast<std::size_t>(state.range(0))};
+  fluir::VmPool vms{static_cast<std::size_t>(state.range(0))};
+  fluir::Scheduler scheduler{threads, vms};
+  for (auto _ : state) {
+    fluir::TextSink out;
+    auto result = scheduler.execute(code, {.output = &out});
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * SINKS * ADDITIONS);
+}
+BENCHMARK(BM_ParallelSinks)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
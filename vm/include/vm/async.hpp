@@ -0,0 +1,85 @@
+#ifndef FLUIR_VM_ASYNC_HPP
+#define FLUIR_VM_ASYNC_HPP
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+#include "vm/vm.hpp"
+
+namespace fluir {
+  /** An execution running as a coroutine, returned by VirtualMachine::executeAsync.
+   *
+   * Nothing runs until the execution is either awaited from another coroutine, which resumes once it finishes, or
+   * started. A started execution runs on its pool while the thread which started it carries on, and wait() blocks
+   * until it is done. Starting many executions and then waiting for each lets a few threads share all of them.
+   */
+  class AsyncExecution {
+   public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+      void await_resume() noexcept { }
+    };
+
+    struct promise_type {
+      ExecResult result{ExecResult::ERROR};
+      std::exception_ptr exception{};
+      /** The coroutine awaiting the execution, if any. Otherwise, the execution was started and done is set. */
+      std::coroutine_handle<> continuation{};
+      std::mutex mutex{};
+      std::condition_variable finished{};
+      bool done{false};
+
+      AsyncExecution get_return_object() { return AsyncExecution{Handle::from_promise(*this)}; }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      FinalAwaiter final_suspend() noexcept { return {}; }
+      void return_value(ExecResult value) { result = value; }
+      void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    struct Awaiter {
+      Handle handle;
+
+      bool await_ready() noexcept { return false; }
+      /** Starts the execution on the awaiting thread, which hands it to the pool straight away */
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+      ExecResult await_resume() const;
+    };
+
+    AsyncExecution(const AsyncExecution&) = delete;
+    AsyncExecution& operator=(const AsyncExecution&) = delete;
+    AsyncExecution(AsyncExecution&& other) noexcept
+      : handle_(std::exchange(other.handle_, {})), started_(std::exchange(other.started_, false)) { }
+    AsyncExecution& operator=(AsyncExecution&& other) noexcept;
+    /** Waits for a started execution to finish first */
+    ~AsyncExecution();
+
+    Awaiter operator co_await() && noexcept { return Awaiter{handle_}; }
+    /** Starts the execution without waiting for it. It must not be awaited afterwards. */
+    void start();
+    /** Starts the execution unless it already has been, then blocks the calling thread until it finishes */
+    ExecResult wait();
+
+   private:
+    explicit AsyncExecution(Handle handle) : handle_(handle) { }
+
+    Handle handle_;
+    bool started_{false};
+
+    /** Blocks until a started execution is done */
+    void finish();
+    /** Destroys the coroutine, once it is done if it was started */
+    void release();
+  };
+}  // namespace fluir
+
+#endif
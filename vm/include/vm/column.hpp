@@ -0,0 +1,97 @@
+#ifndef FLUIR_VM_COLUMN_HPP
+#define FLUIR_VM_COLUMN_HPP
+
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <bytecode/value.hpp>
+
+namespace fluir {
+  /** One value per row of a batch, all of the same type.
+   *
+   * Every value is widened into a 64 bit lane so that kernels can treat all columns alike: F64s are stored as their
+   * bits, signed integers are sign extended and unsigned integers are zero extended.
+   */
+  class Column {
+   public:
+    using Lanes = std::vector<std::uint64_t>;
+
+    Column() = default;
+    Column(code::PrimitiveType type, Lanes lanes) : type_(type), lanes_(std::move(lanes)) { }
+
+#define FLUIR_COLUMN_FROM(Type, Concrete)                        \
+  static Column from(std::span<const Concrete> values) {         \
+    Lanes lanes;                                                 \
+    lanes.reserve(values.size());                                \
+    for (Concrete value : values) {                              \
+      lanes.push_back(widen(value));                             \
+    }                                                            \
+    return Column{code::PrimitiveType::Type, std::move(lanes)};  \
+  }
+
+    FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_COLUMN_FROM)
+#undef FLUIR_COLUMN_FROM
+
+    /** The lane holding value, widened according to its type */
+    static std::uint64_t toLane(const code::Value& value) {
+      switch (value.type()) {
+#define FLUIR_VALUE_TO_LANE(Type, Concrete) \
+  case code::PrimitiveType::Type:           \
+    return widen(value.uncheckedAs##Type());
+
+        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_VALUE_TO_LANE)
+#undef FLUIR_VALUE_TO_LANE
+      }
+      return 0;
+    }
+
+    [[nodiscard]] code::PrimitiveType type() const { return type_; }
+    [[nodiscard]] std::size_t size() const { return lanes_.size(); }
+    [[nodiscard]] std::span<const std::uint64_t> lanes() const { return lanes_; }
+
+    [[nodiscard]] code::Value at(std::size_t row) const {
+      const auto lane = lanes_.at(row);
+      switch (type_) {
+#define FLUIR_LANE_TO_VALUE(Type, Concrete) \
+  case code::PrimitiveType::Type:           \
+    return code::Value{narrow<Concrete>(lane)};
+
+        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_LANE_TO_VALUE)
+#undef FLUIR_LANE_TO_VALUE
+      }
+      return code::Value{narrow<code::F64>(lane)};
+    }
+
+   private:
+    friend class VirtualMachine;
+
+    code::PrimitiveType type_{code::PrimitiveType::F64};
+    Lanes lanes_;
+
+    template <typename Concrete>
+    static std::uint64_t widen(Concrete value) {
+      if constexpr (std::is_floating_point_v<Concrete>) {
+        return std::bit_cast<std::uint64_t>(value);
+      } else if constexpr (std::is_signed_v<Concrete>) {
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+      } else {
+        return static_cast<std::uint64_t>(value);
+      }
+    }
+
+    template <typename Concrete>
+    static Concrete narrow(std::uint64_t lane) {
+      if constexpr (std::is_floating_point_v<Concrete>) {
+        return std::bit_cast<Concrete>(lane);
+      } else {
+        return static_cast<Concrete>(lane);
+      }
+    }
+  };
+}  // namespace fluir
+
+#endif
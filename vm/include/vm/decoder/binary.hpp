@@ -0,0 +1,73 @@
+#ifndef FLUIR_VM_DECODER_BINARY_HPP
+#define FLUIR_VM_DECODER_BINARY_HPP
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "bytecode/binary_format.hpp"
+#include "bytecode/byte_code.hpp"
+#include "vm/thread_pool.hpp"
+
+namespace fluir {
+  /** Decodes code in the binary format described in bytecode/binary_format.hpp. Throws a std::runtime_error if the
+   * file is truncated or a section lies outside of it. */
+  class BinaryDecoder {
+   public:
+    code::ByteCode decode(std::string_view source);
+    /** Decodes without copying the code and constants of each chunk. They are left in their views, pointing into file,
+     * which must outlive the ByteCode. Set the ByteCode's storage to whatever keeps file alive. */
+    code::ByteCode decodeInPlace(std::span<const std::uint8_t> file);
+    /** Decodes like decode, but reads the chunk directory first and then decodes the chunks on threads. The chunks keep
+     * the order of the file. Files without a directory are decoded all at once on the calling thread. */
+    code::ByteCode decode(std::string_view source, ThreadPool& threads);
+    /** Decodes like decodeInPlace, but decodes the chunks on threads like decode does */
+    code::ByteCode decodeInPlace(std::span<const std::uint8_t> file, ThreadPool& threads);
+    /** Decodes only the header, the chunk directory and the module's sections of file, in place. Every chunk is left
+     * empty until decodeChunk decodes it, so only the pages of the file holding the chunks which are used are ever
+     * read. Returns nullopt if the file has no directory, in which case it can only be decoded all at once. */
+    std::optional<code::ByteCode> decodeDirectory(std::span<const std::uint8_t> file);
+    /** Decodes the chunk at index of the file given to decodeDirectory in place. Only reads the decoder, so different
+     * chunks may be decoded from several threads at the same time. */
+    [[nodiscard]] code::Chunk decodeChunk(std::size_t index) const;
+    /** The name of the chunk at index of the file given to decodeDirectory, without decoding the chunk */
+    [[nodiscard]] std::string_view chunkName(std::size_t index) const;
+
+   private:
+    std::span<const std::uint8_t> file_;
+    code::ByteCode code_;
+    bool inPlace_{false};
+    std::vector<code::binary::DirectoryEntry> directory_;
+    /** The shared constant table of a file decoded with decodeDirectory */
+    code::ConstantView shared_;
+
+    code::ByteCode decodeSections();
+    code::ByteCode decodeChunks(ThreadPool& threads);
+    /** Decodes the header, the directory and the module's sections, leaving the chunks empty. Returns false if the file
+     * has no directory. */
+    bool readDirectory();
+    /** Decodes a CODE, CONSTANTS, SUBGRAPHS or DEBUG section into chunk */
+    void decodeSection(code::Chunk& chunk, code::binary::SectionKind kind, std::span<const std::uint8_t> bytes) const;
+
+    code::Header header();
+    /** The number of sections, checked to fit in the file */
+    [[nodiscard]] std::size_t sectionCount() const;
+    [[nodiscard]] code::binary::Section section(std::size_t index) const;
+    /** The bytes of section, checked to lie within the file */
+    [[nodiscard]] std::span<const std::uint8_t> contents(const code::binary::Section& section) const;
+    /** The chunk a section belongs to, which its NAME section must already have started */
+    code::Chunk& chunk(const code::binary::Section& section);
+    /** The entries of the DIRECTORY section in bytes, checked to only refer to sections in the table */
+    [[nodiscard]] std::vector<code::binary::DirectoryEntry> directory(std::span<const std::uint8_t> bytes) const;
+
+    /** The constant table in bytes, checked to only hold PrimitiveTypes */
+    static code::ConstantView constantView(std::span<const std::uint8_t> bytes);
+    static std::vector<code::Value> constants(std::span<const std::uint8_t> bytes);
+    static std::vector<code::Subgraph> subgraphs(std::span<const std::uint8_t> bytes);
+    static std::vector<code::DebugEntry> debug(std::span<const std::uint8_t> bytes);
+  };
+}  // namespace fluir
+
+#endif
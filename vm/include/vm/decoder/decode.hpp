@@ -4,9 +4,17 @@
 #include <string>
 
 #include "bytecode/byte_code.hpp"
+#include "vm/thread_pool.hpp"
 
 namespace fluir {
   code::ByteCode decode(std::string_view source);
+  /** Maps the file at path and decodes it. Binary files are decoded in place, so their code and constants are read
+   * straight out of the mapping, which the ByteCode's storage keeps alive. */
+  code::ByteCode load(const std::string& path);
+  /** Decodes like decode, but decodes the chunks on threads, which must not be called from one of its own workers */
+  code::ByteCode decode(std::string_view source, ThreadPool& threads);
+  /** Loads like load, but decodes the chunks on threads */
+  code::ByteCode load(const std::string& path, ThreadPool& threads);
 }  // namespace fluir
 
 #endif
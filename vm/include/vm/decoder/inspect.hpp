@@ -2,8 +2,10 @@
 #define FLUIR_VM_DECODER_INSPECT_HPP
 
 #include <string>
+#include <vector>
 
 #include "bytecode/byte_code.hpp"
+#include "vm/thread_pool.hpp"
 
 namespace fluir {
   // clang-format off
@@ -11,7 +13,7 @@ namespace fluir {
     // Literals
     HEX_LITERAL, FLOAT_LITERAL, IDENTIFIER,
     // Sections
-    CHUNK, CODE, CONSTANTS,
+    CHUNK, CODE, CONSTANTS, SUBGRAPHS, DEBUG,
     // Data Types
 #define FLUIR_TYPE_TOKEN(type, concrete) TYPE_## type,
     FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_TYPE_TOKEN)
@@ -30,40 +32,55 @@ namespace fluir {
     std::string_view source;
   };
 
+  /** Decodes code in the text format the compiler's InspectWriter writes. Keywords are recognized with a perfect hash
+   * of every section, type and instruction name, built at compile time. Throws a std::runtime_error on malformed
+   * input. */
   class InspectDecoder {
    public:
     code::ByteCode decode(const std::string_view source);
+    /** Decodes like decode, but in two passes: the first only finds where each chunk's text starts, then the chunks are
+     * decoded on threads, since none of them depend on each other. The chunks keep the order of the source. */
+    code::ByteCode decode(const std::string_view source, ThreadPool& threads);
 
    private:
     std::string_view source_;
     char const* start_;
     char const* current_;
+    char const* end_;
     size_t line_;
     code::ByteCode code_;
 
+    /** Decodes the header and the module's shared constants, leaving current_ at the first chunk */
+    void decodeModule(std::string_view source);
     void decodeHeader();
     void decodeChunks();
+    /** The text of each chunk after current_, found by looking for CHUNK keywords without decoding anything else */
+    std::vector<std::string_view> chunkSources();
+    /** Decodes text, which must hold exactly one chunk */
+    code::Chunk decodeChunk(std::string_view text);
 
     void chunk();
     std::vector<code::Value> constants();
+    /** The count and values of a CONSTANTS section, whose keyword has already been read. A module's shared constants
+     * are the same section before its first chunk. */
+    std::vector<code::Value> constantTable();
     std::vector<uint8_t> code();
+    /** The optional SUBGRAPHS section at the end of a chunk, or an empty table if the chunk has none */
+    std::vector<code::Subgraph> subgraphs();
+    /** The optional DEBUG section after the subgraphs, or an empty table if the chunk has no debug info */
+    std::vector<code::DebugEntry> debug();
+    /** Whether the next token has type section, consuming it only if so */
+    bool matchSection(TokenType section);
     Token identifier();
     Token number();
 
     bool atEnd();
     char next();
-    char peek();
     Token scanNext();
     void eatWhitespace();
 
-    TokenType decodeIdentifierType();
-    TokenType checkKeyword(std::string_view expected, TokenType type);
-    TokenType checkPrimitiveType();
-    TokenType checkInstruction();
-    TokenType checkCastInstruction();
-    TokenType checkFPInstruction();
-    TokenType checkIntInstruction();
-    TokenType checkUintInstruction();
+    /** How many of count items to reserve room for, which is never more than the rest of the source can hold */
+    [[nodiscard]] std::size_t reservable(std::size_t count) const;
     Token createToken(TokenType type);
     size_t toUnsignedInteger(Token rawNumber);
 
@@ -8,7 +8,7 @@ namespace fluir {
     using std::runtime_error::runtime_error;
   };
 
-  struct DivideByZeroError final : VirtualMachineError {
+  struct VerificationError final : VirtualMachineError {
     using VirtualMachineError::VirtualMachineError;
   };
 }  // namespace fluir
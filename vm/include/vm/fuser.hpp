@@ -0,0 +1,47 @@
+#ifndef FLUIR_VM_FUSER_HPP
+#define FLUIR_VM_FUSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bytecode/byte_code.hpp"
+
+namespace fluir {
+  /** Rewrites common instruction sequences in every chunk into the equivalent superinstructions. Register code is left
+   * untouched.
+   *
+   * Fusing never changes what a program does, so it can run on any decoded ByteCode before it is verified. Code which
+   * is malformed is left for the verifier to reject. There are no jumps in the instruction set yet, so the only offsets
+   * to fix up after a chunk shrinks are those of its debug entries. Chunks loaded in place are only copied out of their
+   * file if something in them was fused.
+   */
+  void fuse(code::ByteCode& code);
+
+  class Fuser {
+   public:
+    void fuse(code::ByteCode& code);
+    /** Fuses only the chunk at index, for code whose chunks are loaded the first time they are entered */
+    void fuse(code::ByteCode& code, std::size_t index);
+
+   private:
+    code::Chunk const* chunk_{nullptr};
+    /** The chunk's code before fusing, which may point into a mapped file */
+    std::span<const std::uint8_t> code_;
+    code::Bytes fused_;
+
+    void fuseChunk(code::Chunk& chunk);
+    /** Fuses the instructions starting at offset. Returns the number of bytes consumed, or 0 to stop fusing. */
+    std::size_t fuseAt(std::size_t offset);
+    /** Keeps only the last of the entries which ended up at the same offset */
+    static void dropMergedEntries(std::vector<code::DebugEntry>& debug);
+
+    [[nodiscard]] bool isInstruction(std::size_t offset, code::Instruction instruction) const;
+    [[nodiscard]] bool isF64Constant(std::size_t offset) const;
+    /** Whether offset starts PUSH a, PUSH b, F64_<op> with two F64 constants */
+    [[nodiscard]] bool startsPushPushF64(std::size_t offset) const;
+  };
+}  // namespace fluir
+
+#endif
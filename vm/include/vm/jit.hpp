@@ -0,0 +1,98 @@
+#ifndef FLUIR_VM_JIT_HPP
+#define FLUIR_VM_JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "bytecode/byte_code.hpp"
+#include "vm/output.hpp"
+#include "vm/verifier.hpp"
+
+namespace fluir {
+  /** Native code for a single chunk. Owns the executable mapping the code lives in. */
+  class NativeChunk {
+   public:
+    /** Runs the chunk on a stack of F64 values starting at `stack`, writing what it POPs to `output`. Returns one past
+     * the top of the stack at EXIT. */
+    using Entry = code::F64* (*)(code::F64* stack, OutputSink* output);
+
+    NativeChunk(const NativeChunk&) = delete;
+    NativeChunk& operator=(const NativeChunk&) = delete;
+    NativeChunk(NativeChunk&& other) noexcept;
+    NativeChunk& operator=(NativeChunk&& other) noexcept;
+    ~NativeChunk();
+
+    [[nodiscard]] Entry entry() const;
+    /** The number of bytes of machine code */
+    [[nodiscard]] std::size_t size() const { return size_; }
+
+   private:
+    friend class Jit;
+
+    NativeChunk(void* memory, std::size_t mapped, std::size_t size) : memory_(memory), mapped_(mapped), size_(size) { }
+
+    void* memory_;
+    std::size_t mapped_;
+    std::size_t size_;
+  };
+
+  /** Verified code along with native code for every chunk the JIT could translate */
+  class JitCode {
+   public:
+    [[nodiscard]] const VerifiedCode& verified() const { return verified_; }
+    /** The native code for the chunk at index, or nullptr if the chunk runs on the interpreter */
+    [[nodiscard]] const NativeChunk* chunk(std::size_t index) const {
+      return chunks_.at(index).has_value() ? &*chunks_[index] : nullptr;
+    }
+
+   private:
+    friend class Jit;
+
+    explicit JitCode(const VerifiedCode& verified) : verified_(verified) { }
+
+    VerifiedCode verified_;
+    std::vector<std::optional<NativeChunk>> chunks_;
+  };
+
+  /** Translates every chunk of verified code which the JIT supports into x86-64 machine code. */
+  JitCode compile(const VerifiedCode& code);
+
+  /** A baseline template JIT.
+   *
+   * Each instruction is translated by copying a fixed machine code stencil and patching its holes with the
+   * instruction's operands. The native stack is an array of F64 values whose top is kept in rbx, so the JIT supports
+   * the stack instruction set restricted to F64 constants and F64 operations, which is everything the compiler emits
+   * today. Any chunk using something else, register code, and every chunk on platforms other than x86-64 are left to
+   * the interpreter. Verification has already proven the stack never under- or overflows, so the native code does
+   * no checks at all.
+   */
+  class Jit {
+   public:
+    JitCode compile(const VerifiedCode& code);
+
+    /** Whether this build can generate native code at all */
+    static bool available();
+
+   private:
+    code::Chunk const* chunk_{nullptr};
+    std::vector<std::uint8_t> native_;
+
+    std::optional<NativeChunk> compileChunk(const code::Chunk& chunk);
+    /** Whether every instruction up to the chunk's first EXIT has a stencil */
+    [[nodiscard]] bool supports(const code::Chunk& chunk) const;
+
+    /** Copies a stencil to the end of the native code and returns the offset it starts at */
+    std::size_t copy(std::span<const std::uint8_t> stencil);
+    void patch(std::size_t offset, std::uint64_t value);
+    void patch(std::size_t offset, std::uint8_t value);
+    void emitPush(std::size_t constant);
+
+    /** Maps native_ into executable memory. Returns nullopt if the system refuses to map it. */
+    [[nodiscard]] std::optional<NativeChunk> load() const;
+  };
+}  // namespace fluir
+
+#endif
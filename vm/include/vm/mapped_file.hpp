@@ -0,0 +1,38 @@
+#ifndef FLUIR_VM_MAPPED_FILE_HPP
+#define FLUIR_VM_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fluir {
+  /** A file mapped read only into memory, so it can be read without copying it. The mapping lasts as long as the
+   * MappedFile. Where there is no mmap, the file is read into a buffer the MappedFile owns instead. Throws a
+   * std::runtime_error if the file cannot be opened or mapped. */
+  class MappedFile {
+   public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::uint8_t> bytes() const { return {data_, size_}; }
+    [[nodiscard]] std::string_view text() const { return {reinterpret_cast<const char*>(data_), size_}; }
+
+   private:
+    const std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    /** The contents of the file where it cannot be mapped. The allocation is aligned for any scalar, as a mapping
+     * is. */
+    std::vector<std::uint8_t> buffer_;
+
+    void unmap();
+  };
+}  // namespace fluir
+
+#endif
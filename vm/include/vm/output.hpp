@@ -0,0 +1,109 @@
+#ifndef FLUIR_VM_OUTPUT_HPP
+#define FLUIR_VM_OUTPUT_HPP
+
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bytecode/value.hpp"
+
+namespace fluir {
+  /** Where a VirtualMachine writes the values its code POPs.
+   *
+   * A sink is only used by one execution at a time, so implementations need no locking.
+   */
+  class OutputSink {
+   public:
+    OutputSink() = default;
+    OutputSink(const OutputSink&) = default;
+    OutputSink& operator=(const OutputSink&) = default;
+    OutputSink(OutputSink&&) = default;
+    OutputSink& operator=(OutputSink&&) = default;
+    virtual ~OutputSink() = default;
+
+    virtual void write(const code::Value& value) = 0;
+    /** Called whenever an execution ends or suspends */
+    virtual void flush() { }
+  };
+
+  /** Calls a callback with each value as its concrete type, such as code::F64 or std::int32_t */
+  template <typename Callback>
+  class CallbackSink final : public OutputSink {
+   public:
+    explicit CallbackSink(Callback callback) : callback_(std::move(callback)) { }
+
+    void write(const code::Value& value) override {
+      switch (value.type()) {
+#define FLUIR_CALLBACK_VALUE(Type, Concrete) \
+  case code::PrimitiveType::Type:            \
+    callback_(value.uncheckedAs##Type());    \
+    break;
+
+        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_CALLBACK_VALUE)
+#undef FLUIR_CALLBACK_VALUE
+      }
+    }
+
+   private:
+    Callback callback_;
+  };
+
+  /** Keeps the last values written in a fixed amount of memory, overwriting the oldest once it is full */
+  class RingBufferSink final : public OutputSink {
+   public:
+    /** Allocates room for capacity values, which must be at least one */
+    explicit RingBufferSink(std::size_t capacity);
+
+    void write(const code::Value& value) override;
+
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] std::size_t capacity() const { return values_.size(); }
+    /** The number of values which were overwritten before they were read */
+    [[nodiscard]] std::size_t overwritten() const { return overwritten_; }
+    /** The ith value still held, starting from the oldest */
+    [[nodiscard]] const code::Value& operator[](std::size_t i) const { return values_[(first_ + i) % values_.size()]; }
+    void clear();
+
+   private:
+    std::vector<code::Value> values_;
+    std::size_t first_{0};
+    std::size_t size_{0};
+    std::size_t overwritten_{0};
+  };
+
+  /** Formats each value as text such as "(F64)1.5\n" into a buffer.
+   *
+   * With a target, the text is written to the target whenever the buffer fills up and when it is flushed, so each
+   * execution takes the target's lock once rather than once for every value. Without one, the text stays in the buffer
+   * until it is cleared, and the buffer grows if it must.
+   */
+  class TextSink final : public OutputSink {
+   public:
+    /** The most characters a single value takes up */
+    static constexpr std::size_t MAX_VALUE_LENGTH = 32;
+
+    /** The buffer is only allocated once the first value is written */
+    explicit TextSink(std::ostream* target = nullptr, std::size_t capacity = 64 * 1024);
+
+    void write(const code::Value& value) override;
+    void flush() override;
+
+    /** The text which has not been written to the target yet */
+    [[nodiscard]] std::string_view view() const { return {buffer_.data(), used_}; }
+    void clear() { used_ = 0; }
+
+   private:
+    std::ostream* target_;
+    std::size_t capacity_;
+    std::vector<char> buffer_;
+    std::size_t used_{0};
+  };
+
+  /** Formats value like a TextSink into out, which must have room for MAX_VALUE_LENGTH characters. Returns the end of
+   * the text. */
+  char* format(const code::Value& value, char* out);
+}  // namespace fluir
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FLUIR_VM_POOL_HPP
+#define FLUIR_VM_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vm/vm.hpp"
+
+namespace fluir {
+  /** Hands out VirtualMachines which have already allocated their storage, and takes them back when a request is done
+   * so the next request reuses them. Any thread may acquire from the pool, and a lease may end on a different thread
+   * than the one which acquired it.
+   *
+   * The pool must outlive every lease.
+   */
+  class VmPool {
+   public:
+    /** A VirtualMachine borrowed from a pool. It goes back to the pool when the lease ends. */
+    class Lease {
+     public:
+      Lease(const Lease&) = delete;
+      Lease& operator=(const Lease&) = delete;
+      Lease(Lease&& other) noexcept;
+      Lease& operator=(Lease&& other) noexcept;
+      ~Lease();
+
+      VirtualMachine& operator*() { return *vm_; }
+      VirtualMachine* operator->() { return vm_.get(); }
+
+     private:
+      friend class VmPool;
+
+      Lease(VmPool& pool, std::unique_ptr<VirtualMachine> vm) : pool_(&pool), vm_(std::move(vm)) { }
+
+      VmPool* pool_;
+      std::unique_ptr<VirtualMachine> vm_;
+    };
+
+    /** Starts the pool with prepared idle VMs, so that the first requests do not allocate either */
+    explicit VmPool(std::size_t prepared = 0);
+    VmPool(const VmPool&) = delete;
+    VmPool& operator=(const VmPool&) = delete;
+    VmPool(VmPool&&) = delete;
+    VmPool& operator=(VmPool&&) = delete;
+    ~VmPool() = default;
+
+    /** An idle VM, or a newly prepared one if every VM in the pool is leased */
+    Lease acquire();
+    /** The number of VMs waiting to be acquired */
+    [[nodiscard]] std::size_t idle() const;
+
+   private:
+    mutable std::mutex mutex_;
+    /** Idle VMs live on the heap so that leasing one only moves a pointer */
+    std::vector<std::unique_ptr<VirtualMachine>> idle_;
+
+    void release(std::unique_ptr<VirtualMachine> vm);
+  };
+}  // namespace fluir
+
+#endif
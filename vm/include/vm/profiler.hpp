@@ -0,0 +1,112 @@
+#ifndef FLUIR_VM_PROFILER_HPP
+#define FLUIR_VM_PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__)
+#define FLUIR_VM_PROFILE_RDTSC 1
+#include <x86intrin.h>
+#else
+#define FLUIR_VM_PROFILE_RDTSC 0
+#endif
+
+#include "bytecode/instruction.hpp"
+
+namespace fluir {
+  /** Counts how often each instruction is dispatched and the clock ticks spent in it.
+   *
+   * Ticks are time stamp counter cycles on x86-64 and steady_clock nanoseconds elsewhere. They include reading the
+   * clock, which costs a few cycles per instruction, so they are best compared with each other rather than with
+   * unprofiled runs. A profiler accumulates over every execution it is passed to until it is cleared, but only one
+   * execution may use it at a time.
+   */
+  class Profiler {
+   public:
+    struct Entry {
+      code::Instruction instruction;
+      std::uint64_t executions{0};
+      std::uint64_t ticks{0};
+    };
+
+    /** The name of the clock ticks are counted in */
+    static constexpr std::string_view CLOCK = FLUIR_VM_PROFILE_RDTSC ? "rdtsc" : "steady_clock";
+
+    static std::uint64_t now() {
+#if FLUIR_VM_PROFILE_RDTSC
+      return __rdtsc();
+#else
+      return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    void record(std::uint8_t instruction, std::uint64_t ticks) {
+      auto& counter = counters_[instruction];
+      ++counter.executions;
+      counter.ticks += ticks;
+    }
+
+    /** Every instruction which was dispatched, most ticks first */
+    [[nodiscard]] std::vector<Entry> histogram() const;
+    void clear() { counters_ = {}; }
+
+    /** Writes the histogram as a table for people to read */
+    void writeText(std::ostream& out) const;
+    /** Writes the histogram as JSON for tools to track, e.g.
+     * {"clock":"rdtsc","ticks":1200,"instructions":[{"name":"F64_ADD","opcode":1,"executions":100,"ticks":900}]}
+     */
+    void writeJson(std::ostream& out) const;
+
+   private:
+    struct Counter {
+      std::uint64_t executions{0};
+      std::uint64_t ticks{0};
+    };
+
+    /** One counter for every possible opcode byte, so recording never needs a bounds check */
+    std::array<Counter, 256> counters_{};
+  };
+
+  /** The default instrumentation policy of the interpreter loops. It does nothing, so they compile exactly as if they
+   * were not instrumented at all. */
+  struct NoInstrumentation {
+    std::uint8_t dispatch(std::uint8_t instruction) { return instruction; }
+    void stop() { }
+  };
+
+  /** Records each instruction in a Profiler, with the ticks until the next instruction is dispatched */
+  class ProfilingInstrumentation {
+   public:
+    explicit ProfilingInstrumentation(Profiler& profiler) : profiler_(profiler) { }
+
+    std::uint8_t dispatch(std::uint8_t instruction) {
+      const auto now = Profiler::now();
+      stop(now);
+      current_ = instruction;
+      started_ = now;
+      running_ = true;
+      return instruction;
+    }
+    /** Records the last instruction once the loop has returned */
+    void stop() { stop(Profiler::now()); }
+
+   private:
+    Profiler& profiler_;
+    std::uint8_t current_{0};
+    std::uint64_t started_{0};
+    bool running_{false};
+
+    void stop(std::uint64_t now) {
+      if (running_) {
+        profiler_.record(current_, now - started_);
+        running_ = false;
+      }
+    }
+  };
+}  // namespace fluir
+
+#endif
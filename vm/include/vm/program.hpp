@@ -0,0 +1,126 @@
+#ifndef FLUIR_VM_PROGRAM_HPP
+#define FLUIR_VM_PROGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "bytecode/byte_code.hpp"
+#include "vm/async.hpp"
+#include "vm/decoder/binary.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fluir {
+  /** Verified ByteCode which is loaded once and then executed from any number of threads at the same time.
+   *
+   * A loaded program is never modified, so copies share the same code without any locking. The code lives as long as
+   * any copy of the program or any ExecutionContext running it.
+   */
+  class LoadedProgram {
+   public:
+    /** Verifies and takes ownership of code. Throws a VerificationError if the code is not safe to execute. */
+    static LoadedProgram load(code::ByteCode code);
+
+    [[nodiscard]] const code::ByteCode& code() const { return loaded_->code; }
+    [[nodiscard]] const VerifiedCode& verified() const { return loaded_->verified; }
+
+   private:
+    struct Loaded {
+      explicit Loaded(code::ByteCode loaded) : code(std::move(loaded)), verified(verify(code)) { }
+
+      const code::ByteCode code;
+      /** Refers to code above, which never moves since a Loaded only lives behind a shared_ptr */
+      const VerifiedCode verified;
+    };
+
+    explicit LoadedProgram(std::shared_ptr<const Loaded> loaded) : loaded_(std::move(loaded)) { }
+
+    std::shared_ptr<const Loaded> loaded_;
+  };
+
+  /** ByteCode whose chunks are decoded, fused and verified the first time they are entered rather than when it is
+   * loaded, so starting a run costs time and memory in proportion to the chunks it uses rather than to the module.
+   *
+   * Only the header and the chunk directory of a binary file are read up front; the rest of the file is mapped but not
+   * touched until a chunk in it is entered. Files without a directory are decoded all at once, but their chunks are
+   * still fused and verified as they are entered. Copies share the same code, and chunks may be entered from any
+   * number of threads at the same time.
+   */
+  class LazyProgram {
+   public:
+    /** Maps the file at path and reads its directory. Throws a std::runtime_error if the file cannot be read or its
+     * directory is malformed. */
+    static LazyProgram open(const std::string& path);
+    /** Takes ownership of code which has already been decoded */
+    static LazyProgram load(code::ByteCode code);
+
+    /** The code, in which every chunk which has not been entered yet may still be empty */
+    [[nodiscard]] const code::ByteCode& code() const { return lazy_->code; }
+    /** The index of the chunk the header's entryOffset names */
+    [[nodiscard]] std::size_t entry() const { return lazy_->code.header.entryOffset; }
+    /** The index of the chunk called name, or nullopt if there is none. Does not decode any chunk. */
+    [[nodiscard]] std::optional<std::size_t> find(std::string_view name) const;
+    [[nodiscard]] bool entered(std::size_t index) const;
+
+    /** Decodes, fuses and verifies the chunk at index and the chunks its subgraphs run, unless that was already done.
+     * The result may only be executed starting from chunks which have been entered; the VM refuses any other entry.
+     * Throws a VerificationError if there is no such chunk or one of them is not safe to execute, or a
+     * std::runtime_error if one of them is malformed. */
+    const VerifiedCode& enter(std::size_t index) const;
+
+   private:
+    struct Lazy {
+      Lazy(code::ByteCode loaded, std::optional<BinaryDecoder> chunkDecoder);
+
+      code::ByteCode code;
+      /** Decodes the chunks of a file with a directory, or nullopt if every chunk was decoded up front */
+      const std::optional<BinaryDecoder> decoder;
+      std::unique_ptr<std::once_flag[]> loaded;
+      std::unique_ptr<std::atomic<bool>[]> entered;
+      /** Refers to code above, which never moves since a Lazy only lives behind a shared_ptr */
+      std::optional<VerifiedCode> verified;
+    };
+
+    explicit LazyProgram(std::shared_ptr<Lazy> lazy);
+
+    /** Decodes, fuses and verifies the chunk at index exactly once */
+    void materialize(std::size_t index) const;
+
+    std::shared_ptr<Lazy> lazy_;
+  };
+
+  /** Everything a single thread needs to execute a LoadedProgram: the stack, the registers and the instruction
+   * pointer. Contexts share nothing mutable with each other, so each thread executes with a context of its own while
+   * they all share the program.
+   */
+  class ExecutionContext {
+   public:
+    explicit ExecutionContext(LoadedProgram program) : program_(std::move(program)) { vm_.reserve(); }
+
+    /** Executes the program starting from the entry chunk in options. Returns ERROR if there is no such chunk. */
+    ExecResult execute(ExecOptions options = {}) { return vm_.execute(program_.verified(), options); }
+    /** Executes the program on the workers of threads, giving way to other work each time the budget in options runs
+     * out. The context must outlive the execution. */
+    AsyncExecution executeAsync(ThreadPool& threads, ExecOptions options = {}) {
+      return vm_.executeAsync(threads, program_.verified(), options);
+    }
+
+    [[nodiscard]] const LoadedProgram& program() const { return program_; }
+    const VirtualMachine::Stack& viewStack() const { return vm_.viewStack(); }
+    const VirtualMachine::Registers& viewRegisters() const { return vm_.viewRegisters(); }
+    /** Where the last execution failed, or nullopt if it succeeded */
+    const std::optional<FaultReport>& viewFault() const { return vm_.viewFault(); }
+
+   private:
+    LoadedProgram program_;
+    VirtualMachine vm_;
+  };
+}  // namespace fluir
+
+#endif
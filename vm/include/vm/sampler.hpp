@@ -0,0 +1,108 @@
+#ifndef FLUIR_VM_SAMPLER_HPP
+#define FLUIR_VM_SAMPLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bytecode/code_chunk.hpp"
+
+namespace fluir {
+  /** Periodically samples which instruction the VM is running and attributes it to the flow graph node the instruction
+   * was generated for, using the chunk's debug entries.
+   *
+   * While started, a SIGPROF timer fires every interval of CPU time the process uses. The signal handler only sets a
+   * flag, and the next instruction dispatched by an execution with this sampler records the sample, so no sample is
+   * ever taken in the middle of an instruction. Samples accumulate until the sampler is cleared. Only one sampler may
+   * be started at a time, since the timer and the flag belong to the whole process. The timer needs a Unix; elsewhere
+   * the sampler cannot start, but samples can still be requested and recorded.
+   */
+  class SamplingProfiler {
+   public:
+    /** The samples taken in one node */
+    struct Hotspot {
+      std::string chunk;
+      /** The node and where it is drawn. Node 0 collects the samples in code without debug info. */
+      code::DebugEntry node;
+      std::uint64_t samples{0};
+    };
+
+    explicit SamplingProfiler(std::chrono::microseconds interval = std::chrono::milliseconds{1});
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+    ~SamplingProfiler();
+
+    /** Whether this platform has the timer */
+    static bool available();
+    /** Starts the timer. Returns false if it could not be installed, or the platform has none. */
+    bool start();
+    void stop();
+
+    /** Asks for a sample at the next dispatch, as the timer does */
+    static void request() { pending_.store(true, std::memory_order_relaxed); }
+    /** Whether a sample was asked for, clearing the request. Cheap enough to call for every instruction. */
+    static bool pending() {
+      return pending_.load(std::memory_order_relaxed) && pending_.exchange(false, std::memory_order_relaxed);
+    }
+
+    /** Records a sample of instruction at offset in chunk */
+    void sample(const code::Chunk& chunk, std::size_t offset, std::uint8_t instruction);
+
+    /** The samples of every node, most samples first */
+    [[nodiscard]] std::vector<Hotspot> hotspots() const;
+    [[nodiscard]] std::uint64_t total() const;
+    void clear();
+
+    /** Writes the hotspots as a table for people to read */
+    void writeText(std::ostream& out) const;
+    /** Writes every sample as a folded stack of chunk, node and instruction, e.g. "main;node 3 (10,20);F64_ADD 12",
+     * which flame graph tools read directly */
+    void writeFolded(std::ostream& out) const;
+
+   private:
+    /** The chunk, node and instruction of a sample */
+    using Key = std::tuple<std::string, std::uint64_t, std::uint8_t>;
+    struct Counter {
+      code::DebugEntry node;
+      std::uint64_t samples{0};
+    };
+
+    static_assert(std::atomic<bool>::is_always_lock_free, "The signal handler may only touch lock free atomics");
+    static std::atomic<bool> pending_;
+
+    std::chrono::microseconds interval_;
+    bool started_{false};
+    mutable std::mutex mutex_;
+    std::map<Key, Counter> samples_;
+  };
+
+  /** Hands samples requested by the timer of a SamplingProfiler to it, with the offset of the instruction being
+   * dispatched. Only reads the VM's chunk and instruction pointer when a sample is pending. */
+  class SamplingInstrumentation {
+   public:
+    SamplingInstrumentation(SamplingProfiler& sampler, code::Chunk const* const& chunk, std::uint8_t const* const& ip) :
+      sampler_(sampler), chunk_(chunk), ip_(ip) { }
+
+    std::uint8_t dispatch(std::uint8_t instruction) {
+      if (SamplingProfiler::pending()) [[unlikely]] {
+        // The instruction pointer has already moved past the opcode
+        sampler_.sample(*chunk_, static_cast<std::size_t>(ip_ - 1 - chunk_->instructions().data()), instruction);
+      }
+      return instruction;
+    }
+    void stop() { }
+
+   private:
+    SamplingProfiler& sampler_;
+    code::Chunk const* const& chunk_;
+    std::uint8_t const* const& ip_;
+  };
+}  // namespace fluir
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FLUIR_VM_SCHEDULER_HPP
+#define FLUIR_VM_SCHEDULER_HPP
+
+#include <optional>
+
+#include "bytecode/byte_code.hpp"
+#include "vm/pool.hpp"
+#include "vm/thread_pool.hpp"
+#include "vm/vm.hpp"
+
+namespace fluir {
+  /** Runs the subgraphs of a chunk concurrently on a thread pool.
+   *
+   * Each subgraph runs on a VM leased from the VmPool once every subgraph it depends on has succeeded. Subgraphs which
+   * depend on a failed one are skipped. What each subgraph writes is buffered until all of them are done, then written
+   * out in the order of the subgraph table up to and including the first subgraph which failed, so the output is
+   * exactly what running the chunk as a whole produces. A chunk without subgraphs simply runs as a whole.
+   *
+   * Several schedulers may share the pools, but each one runs a single chunk at a time. A scheduler must not be used
+   * from a task on its own thread pool, since it blocks until the subgraphs are done.
+   */
+  class Scheduler {
+   public:
+    Scheduler(ThreadPool& threads, VmPool& vms) : threads_(threads), vms_(vms) { }
+
+    /** Executes the entry chunk in options. Returns the result of the first subgraph in the table that failed, or ERROR
+     * without running anything if a subgraph depends on one which does not come before it. */
+    ExecResult execute(const code::ByteCode& code, ExecOptions options = {});
+    /** Where the first failed subgraph failed, or nullopt if the last execution succeeded */
+    const std::optional<FaultReport>& viewFault() const { return fault_; }
+
+   private:
+    ThreadPool& threads_;
+    VmPool& vms_;
+    std::optional<FaultReport> fault_;
+  };
+}  // namespace fluir
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef FLUIR_VM_THREAD_POOL_HPP
+#define FLUIR_VM_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace fluir {
+  /** A fixed set of worker threads which steal work from each other.
+   *
+   * Every worker has its own queue. A task submitted by a worker goes on that worker's queue, which it works through
+   * newest first while the task's data is still in its cache. Tasks submitted from any other thread are dealt out to
+   * the queues in turn. A worker whose queue is empty steals the oldest task of another worker before going to sleep.
+   */
+  class ThreadPool {
+   public:
+    using Task = std::function<void()>;
+
+    /** Starts the workers. A pool always has at least one worker. */
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    /** Finishes every task which was already submitted, then stops the workers */
+    ~ThreadPool();
+
+    void submit(Task task);
+    /** Submits a task which should only run after the tasks queued so far. It goes on the end of a queue that its
+     * worker takes from last and other workers steal from first, which lets a long computation give way by deferring
+     * its remainder. */
+    void defer(Task task);
+    /** Calls body with every index below count, spread over the workers in batches of consecutive indices, and waits
+     * until they are all done. If any calls throw, the exception of the lowest index is rethrown once every batch has
+     * finished; the rest of that index's batch is skipped. Must not be called from a worker of this pool, which would
+     * wait on batches queued behind it. */
+    void forEach(std::size_t count, const std::function<void(std::size_t)>& body);
+    [[nodiscard]] std::size_t size() const { return threads_.size(); }
+
+   private:
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    /** Guards queued_ and stopping_, which the workers sleep on */
+    std::mutex sleep_;
+    std::condition_variable wake_;
+    std::size_t queued_{0};
+    bool stopping_{false};
+    /** The queue the next task from outside the pool goes on */
+    std::atomic<std::size_t> next_{0};
+
+    /** Queues task at the back of a queue, where its worker takes it next, or at the front */
+    void enqueue(Task task, bool back);
+    void work(std::size_t index);
+    /** The newest task of the worker's own queue, or else the oldest task of another worker's */
+    std::optional<Task> take(std::size_t index);
+  };
+}  // namespace fluir
+
+#endif
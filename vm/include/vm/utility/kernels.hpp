@@ -0,0 +1,45 @@
+#ifndef FLUIR_VM_UTILITY_KERNELS_HPP
+#define FLUIR_VM_UTILITY_KERNELS_HPP
+
+#include <cstdint>
+#include <span>
+
+#include <bytecode/primitives.hpp>
+
+/** Vectorized kernels over the 64 bit lanes of a Column.
+ *
+ * Binary kernels update lhs in place and require rhs to be at least as long. Integer arithmetic wraps, so the same
+ * kernels serve signed and unsigned lanes. On x86-64 every kernel is built for both AVX2 and the SSE2 baseline and the
+ * best version for the running CPU is picked when the program loads.
+ */
+namespace fluir::kernels {
+  using Lanes = std::span<std::uint64_t>;
+  using ConstLanes = std::span<const std::uint64_t>;
+
+  void addF64(Lanes lhs, ConstLanes rhs);
+  void subF64(Lanes lhs, ConstLanes rhs);
+  void mulF64(Lanes lhs, ConstLanes rhs);
+  void divF64(Lanes lhs, ConstLanes rhs);
+  void negF64(Lanes values);
+
+  void addInt(Lanes lhs, ConstLanes rhs);
+  void subInt(Lanes lhs, ConstLanes rhs);
+  void mulInt(Lanes lhs, ConstLanes rhs);
+  void negInt(Lanes values);
+  /** Returns false, leaving lhs partly divided, if any rhs lane is zero */
+  bool divI64(Lanes lhs, ConstLanes rhs);
+  /** Returns false, leaving lhs partly divided, if any rhs lane is zero */
+  bool divU64(Lanes lhs, ConstLanes rhs);
+
+  /** Truncates every lane to width bits and sign extends it back to 64 */
+  void narrowI(Lanes values, code::NumericWidth width);
+  /** Truncates every lane to width bits */
+  void narrowU(Lanes values, code::NumericWidth width);
+
+  void castIF(Lanes values);
+  void castUF(Lanes values);
+  void castFI(Lanes values);
+  void castFU(Lanes values);
+}  // namespace fluir::kernels
+
+#endif
@@ -1,38 +1,105 @@
 #ifndef FLUIR_VM_UTILITY_NARROW_WIDEN_HPP
 #define FLUIR_VM_UTILITY_NARROW_WIDEN_HPP
 
-#include <bytecode/value.hpp>
+#include <limits>
+#include <type_traits>
 
-#include "vm/exceptions.hpp"
+#include <bytecode/value.hpp>
 
 namespace fluir::utility {
+  constexpr bool isFloat(code::PrimitiveType type) { return type == code::PrimitiveType::F64; }
+  constexpr bool isInt(code::PrimitiveType type) { return (static_cast<std::uint8_t>(type) & code::SIGNED) != 0; }
+  constexpr bool isUint(code::PrimitiveType type) { return !isFloat(type) && !isInt(type); }
+  constexpr bool isWidth(std::uint8_t width) {
+    return width == code::WIDTH_8 || width == code::WIDTH_16 || width == code::WIDTH_32 || width == code::WIDTH_64;
+  }
+
+  /** Division which reports a zero divisor instead of dividing by it. Returns false if rhs is zero. The quotient of the
+   * smallest int and -1 does not fit, and wraps around to the smallest int instead of trapping. */
   template <typename T>
   struct checkedDivide {
-    T operator()(const T& lhs, const T& rhs) const {
+    bool operator()(const T& lhs, const T& rhs, T& result) const {
       if (rhs == 0) {
-        throw DivideByZeroError{"DIVISION BY ZERO"};
+        return false;
+      }
+      if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        if (rhs == -1) {
+          result = static_cast<T>(T{0} - static_cast<std::make_unsigned_t<T>>(lhs));
+          return true;
+        }
+      }
+      result = lhs / rhs;
+      return true;
+    }
+  };
+
+  /** Whether type is the type of a Value holding a T */
+  template <typename T>
+  constexpr bool isType(code::PrimitiveType type);
+  /** The T inside a Value, which must already be known to hold a T */
+  template <typename T>
+  T& uncheckedAs(code::Value& value);
+
+#define FLUIR_TYPED_ACCESS(Type, Concrete)                      \
+  template <>                                                   \
+  constexpr bool isType<Concrete>(code::PrimitiveType type) {   \
+    return type == code::PrimitiveType::Type;                   \
+  }                                                             \
+  template <>                                                   \
+  inline Concrete& uncheckedAs<Concrete>(code::Value& value) {  \
+    return value.uncheckedAs##Type();                           \
+  }
+
+  FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_TYPED_ACCESS)
+#undef FLUIR_TYPED_ACCESS
+
+  /** Applies Op to ints of type T without leaving that width, wrapping around on overflow. Every int instruction,
+   * including the 64 bit ones, computes through it. The arithmetic runs on unsigned ints, which wrap rather than
+   * overflowing, and are at least as wide as an int so that promotion never turns them back into signed ints. */
+  template <typename T, template <typename> typename Op>
+  struct wrapping {
+    using Unsigned = std::common_type_t<std::make_unsigned_t<T>, unsigned>;
+
+    T operator()(T lhs, T rhs) const {
+      return static_cast<T>(Op<Unsigned>{}(static_cast<Unsigned>(lhs), static_cast<Unsigned>(rhs)));
+    }
+    T operator()(T operand) const { return static_cast<T>(Op<Unsigned>{}(static_cast<Unsigned>(operand))); }
+  };
+
+  /** checkedDivide for ints of type T. The quotient of the smallest int and -1 does not fit in T, so the division runs
+   * on 64 bits and narrows the quotient like the 64 bit instructions do. */
+  template <typename T>
+  struct sizedDivide {
+    bool operator()(T lhs, T rhs, T& result) const {
+      using Wide = std::conditional_t<std::is_signed_v<T>, code::I64, code::U64>;
+      Wide quotient;
+      if (!checkedDivide<Wide>{}(lhs, rhs, quotient)) {
+        return false;
       }
-      return lhs / rhs;
+      result = static_cast<T>(quotient);
+      return true;
     }
   };
 
+  /** Widens an int Value to 64 bits and sets type to the Value's type. A Value which is not an int widens to 0, and
+   * callers which have not already proven the type must reject it with isInt(type). */
   inline code::I64 widenI(const code::Value& value, code::PrimitiveType& type) {
     type = value.type();
     switch (value.type()) {
       case code::PrimitiveType::I8:
-        return static_cast<code::I64>(value.asI8());
+        return static_cast<code::I64>(value.uncheckedAsI8());
       case code::PrimitiveType::I16:
-        return static_cast<code::I64>(value.asI16());
+        return static_cast<code::I64>(value.uncheckedAsI16());
       case code::PrimitiveType::I32:
-        return static_cast<code::I64>(value.asI32());
+        return static_cast<code::I64>(value.uncheckedAsI32());
       case code::PrimitiveType::I64:
-        return value.asI64();
+        return value.uncheckedAsI64();
       default:
-        break;
+        return 0;
     }
-    throw VirtualMachineError{"EXPECTED AN INT TYPE"};
   }
 
+  /** Narrows a 64 bit int to type, which must be an int type */
   inline code::Value narrowI(code::I64 val, const code::PrimitiveType& type) {
     switch (type) {
       case code::PrimitiveType::I8:
@@ -41,31 +108,30 @@ namespace fluir::utility {
         return code::Value{static_cast<std::int16_t>(val)};
       case code::PrimitiveType::I32:
         return code::Value{static_cast<std::int32_t>(val)};
-      case code::PrimitiveType::I64:
-        return code::Value{val};
       default:
-        break;
+        return code::Value{val};
     }
-    throw VirtualMachineError{"EXPECTED AN INT TYPE"};
   }
 
+  /** Widens an uint Value to 64 bits and sets type to the Value's type. A Value which is not an uint widens to 0, and
+   * callers which have not already proven the type must reject it with isUint(type). */
   inline code::U64 widenU(const code::Value& value, code::PrimitiveType& type) {
     type = value.type();
     switch (value.type()) {
       case code::PrimitiveType::U8:
-        return static_cast<code::U64>(value.asU8());
+        return static_cast<code::U64>(value.uncheckedAsU8());
       case code::PrimitiveType::U16:
-        return static_cast<code::U64>(value.asU16());
+        return static_cast<code::U64>(value.uncheckedAsU16());
       case code::PrimitiveType::U32:
-        return static_cast<code::U64>(value.asU32());
+        return static_cast<code::U64>(value.uncheckedAsU32());
       case code::PrimitiveType::U64:
-        return value.asU64();
+        return value.uncheckedAsU64();
       default:
-        break;
+        return 0;
     }
-    throw VirtualMachineError{"EXPECTED A UINT TYPE"};
   }
 
+  /** Narrows a 64 bit uint to type, which must be an uint type */
   inline code::Value narrowU(code::U64 val, const code::PrimitiveType& type) {
     switch (type) {
       case code::PrimitiveType::U8:
@@ -74,12 +140,9 @@ namespace fluir::utility {
         return code::Value{static_cast<std::uint16_t>(val)};
       case code::PrimitiveType::U32:
         return code::Value{static_cast<std::uint32_t>(val)};
-      case code::PrimitiveType::U64:
-        return code::Value{val};
       default:
-        break;
+        return code::Value{val};
     }
-    throw VirtualMachineError{"EXPECTED A UINT TYPE"};
   }
 }  // namespace fluir::utility
 
@@ -0,0 +1,86 @@
+#ifndef FLUIR_VM_VERIFIER_HPP
+#define FLUIR_VM_VERIFIER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "bytecode/byte_code.hpp"
+
+namespace fluir {
+  /** ByteCode which the Verifier has proven to be safe to execute without any runtime type or bounds checks.
+   *
+   * Only refers to the verified ByteCode, which must outlive it and must not be modified. Code verified a chunk at a
+   * time may only be executed starting from the chunks verified so far.
+   */
+  class VerifiedCode {
+   public:
+    [[nodiscard]] const code::ByteCode& code() const { return *code_; }
+    /** Whether the chunk at index exists and has been verified */
+    [[nodiscard]] bool verified(std::size_t index) const {
+      return index < code_->chunks.size() && (chunks_ == nullptr || chunks_[index].load(std::memory_order_acquire));
+    }
+
+   private:
+    friend class Verifier;
+    friend class LazyProgram;
+
+    explicit VerifiedCode(const code::ByteCode& code) : code_(&code) { }
+    VerifiedCode(const code::ByteCode& code, std::atomic<bool> const* chunks) : code_(&code), chunks_(chunks) { }
+
+    code::ByteCode const* code_;
+    /** Which chunks have been verified, or null if every chunk has */
+    std::atomic<bool> const* chunks_{nullptr};
+  };
+
+  /** Verifies decoded ByteCode. Throws a VerificationError describing the first problem found. */
+  VerifiedCode verify(const code::ByteCode& code);
+
+  class Verifier {
+   public:
+    VerifiedCode verify(const code::ByteCode& code);
+    /** Verifies only the chunk at index, for code whose chunks are loaded the first time they are entered. The chunks
+     * its subgraphs run must exist but are verified separately. */
+    void verify(const code::ByteCode& code, std::size_t index);
+
+   private:
+    code::Chunk const* chunk_{nullptr};
+    std::span<const std::uint8_t> code_;
+    size_t offset_{0};
+    bool usesRegisters_{false};
+    std::vector<code::PrimitiveType> stack_;
+    /** The type of each register, or nullopt if it has not been written yet */
+    std::array<std::optional<code::PrimitiveType>, 256> registers_;
+
+    void verifyChunk(const code::Chunk& chunk);
+    /** Checks that the header's entryOffset names one of the chunks */
+    void verifyEntry(const code::ByteCode& code);
+    /** Checks that the subgraphs of the chunk at index refer to other chunks and only depend on earlier subgraphs */
+    void verifySubgraphs(const code::ByteCode& code, std::size_t index);
+    /** Checks that the debug entries of the chunk are in order and point into its code */
+    void verifyDebug(const code::Chunk& chunk);
+    /** Abstractly executes the instruction at offset_. Returns false once the chunk EXITs. */
+    bool verifyInstruction();
+    /** Abstractly executes the register instruction at offset_. Returns false once the chunk EXITs. */
+    bool verifyRegisterInstruction();
+
+    void push(code::PrimitiveType type);
+    code::PrimitiveType pop(std::string_view expected, bool (*accepts)(code::PrimitiveType));
+    /** The type of the register named by the instruction's operand at the given position */
+    code::PrimitiveType read(std::size_t operand, std::string_view expected, bool (*accepts)(code::PrimitiveType));
+    void write(std::size_t operand, code::PrimitiveType type);
+    /** The type of the constant named by the instruction's operand at the given position */
+    code::PrimitiveType constant(std::size_t operand);
+    /** The type of the constant at index */
+    code::PrimitiveType constantType(std::size_t index);
+    code::NumericWidth width(std::size_t operand = 1);
+
+    [[noreturn]] void fail(std::string_view message);
+  };
+}  // namespace fluir
+
+#endif
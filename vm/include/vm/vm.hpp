@@ -1,46 +1,275 @@
 #ifndef FLUIR_VM_VM_HPP
 #define FLUIR_VM_VM_HPP
 
+#include <chrono>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string>
+
 #include <bytecode/byte_code.hpp>
 
+#include "vm/column.hpp"
+#include "vm/output.hpp"
+#include "vm/profiler.hpp"
+#include "vm/sampler.hpp"
+
 namespace fluir {
-  enum class ExecResult { SUCCESS = 0, ERROR, ERROR_DIVIDE_BY_ZERO };
+  class VerifiedCode;
+  class JitCode;
+  class NativeChunk;
+
+  /** How an execution ended. SUSPENDED executions ran out of budget and continue with VirtualMachine::resume(). */
+  enum class ExecResult { SUCCESS = 0, ERROR, ERROR_DIVIDE_BY_ZERO, SUSPENDED };
+
+  /** Why an execution stopped before reaching EXIT */
+  enum class Fault : std::uint8_t {
+    NONE = 0,
+    TYPE_MISMATCH,
+    DIVIDE_BY_ZERO,
+    STACK_OVERFLOW,
+    STACK_UNDERFLOW,
+    INVALID_OPERAND,
+    INVALID_INSTRUCTION,
+  };
+
+  /** Where and why the last execution failed */
+  struct FaultReport {
+    Fault fault{Fault::NONE};
+    std::string chunk{};
+    /** The offset of the failing instruction in the chunk's code */
+    std::size_t offset{0};
+  };
+
+  /** A message such as "DIVISION BY ZERO in chunk 'main' at offset x4" */
+  std::string describe(const FaultReport& report);
+
+  /** How long an execution may run before it suspends. Zero means no limit. */
+  struct Budget {
+    /** The number of instructions to dispatch, counting each superinstruction once */
+    std::size_t instructions{0};
+    /** The time to run for. The clock is only read every few hundred instructions, so this may overrun slightly. */
+    std::chrono::nanoseconds time{0};
+  };
+
+  /** How a single execution runs */
+  struct ExecOptions {
+    /** The index of the chunk to start executing, or nullopt for the one the header's entryOffset names */
+    std::optional<std::size_t> entry{};
+    /** Where POP writes values, or nullptr for the VM's own TextSink on standard output */
+    OutputSink* output{nullptr};
+    /** The budget for the execution and for every time it resumes. Only stack and register code observe it. */
+    Budget budget{};
+    /** Where to count the instructions the execution dispatches, or nullptr to run without instrumentation. Like the
+     * budget, only stack and register code observe it. */
+    Profiler* profiler{nullptr};
+    /** Where to record samples of the flow graph nodes the execution spends its time in, or nullptr to not sample.
+     * The sampler must be started for any samples to be taken. Ignored if there is also a profiler. */
+    SamplingProfiler* sampler{nullptr};
+  };
+
+  /** The index of the chunk an execution of code with options starts in */
+  std::size_t entryChunk(const code::ByteCode& code, const ExecOptions& options);
+
+  class ThreadPool;
+  class AsyncExecution;
 
   class VirtualMachine {
    public:
     using Stack = std::vector<code::Value>;
+    using Registers = std::vector<code::Value>;
+    using Columns = std::vector<Column>;
+
+    static constexpr std::size_t STACK_CAPACITY = 256;
+    /** Every register operand is a single byte, so register code can never address more than this */
+    static constexpr std::size_t REGISTER_COUNT = 256;
 
-    VirtualMachine() = default;
+    VirtualMachine();
     VirtualMachine(const VirtualMachine&) = delete;
     VirtualMachine& operator=(const VirtualMachine&) = delete;
-    VirtualMachine(VirtualMachine&&) = delete;
-    VirtualMachine& operator=(VirtualMachine&&) = delete;
+    /** A VM only refers to the code it last executed, so it can move between threads and owners between executions.
+     * Executing never modifies the code, so any number of VMs may execute the same code at once. */
+    VirtualMachine(VirtualMachine&&) noexcept = default;
+    VirtualMachine& operator=(VirtualMachine&&) noexcept = default;
     ~VirtualMachine() = default;
 
+    /** Allocates the stack and registers up front. Every execution reuses them, so only the first execution of a VM
+     * which was not reserved allocates. */
+    void reserve();
+
+    /** Executes code with the stack or register interpreter, depending on the header's filetype */
     ExecResult execute(code::ByteCode const* code);
+    /** Executes code starting from the entry chunk in options. Returns ERROR if there is no such chunk. */
+    ExecResult execute(const code::ByteCode& code, ExecOptions options);
+    /** Executes code the verifier has already accepted, skipping all per-instruction type and bounds checks */
+    ExecResult execute(const VerifiedCode& code);
+    /** Executes verified code starting from the entry chunk in options. Returns ERROR if there is no such chunk. */
+    ExecResult execute(const VerifiedCode& code, ExecOptions options);
+    /** Executes the entry chunk as native code, falling back to the interpreter if the JIT could not translate it */
+    ExecResult execute(const JitCode& code);
+    /** Executes the entry chunk in options as native code. Executions with a budget, profiler or sampler are
+     * interpreted, since native code cannot observe them. Returns ERROR if there is no such chunk. */
+    ExecResult execute(const JitCode& code, ExecOptions options);
+
+    /** Continues a SUSPENDED execution where it stopped, with a fresh budget. The VM may have moved to another thread
+     * in the meantime. Returns ERROR if the last execution was not suspended. */
+    ExecResult resume();
+
+    /** Executes code on the workers of threads, suspending the coroutine whenever the budget in options runs out so
+     * that other work queued on the pool runs in between. Execution starts once the result is awaited or waited for.
+     *
+     * The VM and code must outlive the execution, and the VM must not be used for anything else until it finishes.
+     */
+    AsyncExecution executeAsync(ThreadPool& threads, const code::ByteCode& code, ExecOptions options);
+    /** Executes verified code asynchronously, skipping all per-instruction type and bounds checks */
+    AsyncExecution executeAsync(ThreadPool& threads, const VerifiedCode& code, ExecOptions options);
+
+    /** Executes verified stack code once for every row of a batch, running each instruction over a whole column at
+     * a time.
+     *
+     * Input column i takes the place of constant i, so it must have the constant's type. Constants without an input
+     * column hold the same value in every row. All inputs must have the same number of rows, and a batch without
+     * inputs has a single row. Every value the code POPs becomes a column of viewOutputs().
+     */
+    ExecResult executeBatch(const VerifiedCode& code, std::span<const Column> inputs);
 
     const Stack& viewStack() const { return stack_; }
+    /** Where the last execution failed, or nullopt if it succeeded */
+    const std::optional<FaultReport>& viewFault() const { return fault_; }
+    const Registers& viewRegisters() const { return registers_; }
+    /** The columns left on the stack by the last batch */
+    const Columns& viewColumns() const { return columns_; }
+    const Columns& viewOutputs() const { return outputs_; }
 
    private:
     code::ByteCode const* code_{nullptr};
     code::Chunk const* current_{nullptr};
     std::uint8_t const* ip_{nullptr};
+    /** Where the current execution writes, or nullptr for console_ */
+    OutputSink* output_{nullptr};
+    /** Buffers what executions without a sink of their own write to standard output */
+    TextSink console_;
+    /** Whether the current execution checks every instruction, so that it resumes the same way */
+    bool checked_{true};
+    Profiler* profiler_{nullptr};
+    SamplingProfiler* sampler_{nullptr};
+    /** Whether the current execution is suspended */
+    bool suspended_{false};
+    Budget budget_{};
+    /** Instructions left until the budget is next looked at */
+    std::size_t countdown_{0};
+    /** The instructions in the current slice of the budget, counted down by countdown_ */
+    std::size_t slice_{0};
+    /** Instructions left in the budget, including the current slice */
+    std::size_t remaining_{0};
+    std::chrono::steady_clock::time_point deadline_{};
     Stack stack_;
+    std::optional<FaultReport> fault_;
+    Registers registers_;
+    Columns columns_;
+    Columns outputs_;
+    /** Lanes of columns which have been consumed, kept to avoid allocating for every PUSH */
+    std::vector<Column::Lanes> spareLanes_;
+
+    template <bool Checked>
+    ExecResult start(code::ByteCode const* code, ExecOptions options = {});
+    /** Runs stack code from ip_ until it exits, fails or, if Budgeted, runs out of budget. Every instruction is passed
+     * through instrument as it is dispatched. */
+    template <bool Checked, bool Budgeted, typename Instrument>
+    ExecResult run(Instrument& instrument);
+    template <bool Checked, bool Budgeted, typename Instrument>
+    ExecResult runRegisters(Instrument& instrument);
+    /** Runs the current chunk from ip_ with the interpreter its code is for, profiling or sampling it if the execution
+     * has a profiler or sampler */
+    template <bool Checked>
+    ExecResult dispatch();
+    template <bool Checked, typename Instrument>
+    ExecResult interpret(Instrument& instrument);
+    /** Starts a new slice of the budget */
+    void renewBudget();
+    /** Called each time countdown_ reaches zero. Returns true if the budget has run out, or starts its next slice. */
+    bool exhausted();
+    /** Runs native code for the chunk at entry of code, which it was compiled from */
+    ExecResult runNative(const code::ByteCode& code, std::size_t entry, const NativeChunk& chunk, ExecOptions options);
+    OutputSink& output() { return output_ != nullptr ? *output_ : console_; }
+    /** Records and reports a fault in the instruction ip_ is part of. Only runs once execution has failed, so it finds
+     * the instruction by decoding the chunk from the start rather than tracking it on every dispatch. */
+    ExecResult raise(Fault fault);
+
+    /** In checked mode, whether the top count values on the stack exist and all have a type accepted by accepts */
+    template <bool Checked>
+    Fault checkOperands(std::size_t count, bool (*accepts)(code::PrimitiveType)) const;
+    /** In checked mode, whether the stack has room for count more values */
+    template <bool Checked>
+    Fault checkCapacity(std::size_t count) const;
+    /** In checked mode, whether the constant exists and has a type accepted by accepts */
+    template <bool Checked>
+    Fault checkConstant(std::size_t index, bool (*accepts)(code::PrimitiveType)) const;
+    /** Pushes a constant of the current chunk, which must exist */
+    void pushConstant(std::size_t index);
+    /** pushConstant for chunks whose constants are still in the file they were loaded from */
+    void pushViewConstant(std::size_t index);
+    /** In checked mode, whether the code has count more operand bytes after ip_ */
+    template <bool Checked>
+    Fault checkOperandBytes(std::size_t count) const;
+    /** In checked mode, whether every register has a type accepted by accepts */
+    template <bool Checked>
+    Fault checkRegisters(std::initializer_list<std::uint8_t> indices, bool (*accepts)(code::PrimitiveType)) const;
+    ExecResult runBatch(std::span<const Column> inputs, std::size_t rows);
+
+    void pushColumn(std::span<const Column> inputs, std::size_t constant, std::size_t rows);
+    /** Pushes a column holding value in every row */
+    void pushColumn(const code::Value& value, std::size_t rows);
+    Column popColumn();
+    /** Keeps the lanes of a column which is no longer needed for the next push */
+    void recycle(Column&& column);
+    template <typename Kernel>
+    void floatColumns(Kernel kernel);
+    /** Applies kernel to the top two columns and narrows the result to the wider of their types with Narrow. Kernels
+     * which can fail, such as division, return false to report a division by zero. */
+    template <typename Kernel, typename Narrow>
+    Fault intColumns(Kernel kernel, Narrow narrow);
+    /** Converts the lanes of the top column in place with kernel, then narrows them to type */
+    template <typename Kernel, typename Narrow>
+    void castColumn(Kernel kernel, Narrow narrow, code::PrimitiveType type);
+
+    template <bool Checked, typename Op>
+    Fault floatBinary();
+    template <bool Checked, typename Op>
+    Fault floatUnary();
+    /** Applies Op to the two constants named by the operands and pushes the result */
+    template <bool Checked, typename Op>
+    Fault floatConstantBinary();
+    template <bool Checked, typename Op>
+    Fault intBinary();
+    template <bool Checked, typename Op>
+    Fault intUnary();
+    template <bool Checked, typename Op>
+    Fault uintBinary();
+    template <bool Checked, typename Op>
+    Fault uintUnary();
+    /** Applies Op to the top two values on the stack, which must both be a T */
+    template <bool Checked, typename T, typename Op>
+    Fault sizedBinary();
+    template <bool Checked, typename T, typename Op>
+    Fault sizedUnary();
 
-    ExecResult run();
-
-    template <typename Op>
-    void floatBinary();
-    template <typename Op>
-    void floatUnary();
-    template <typename Op>
-    void intBinary();
-    template <typename Op>
-    void intUnary();
-    template <typename Op>
-    void uintBinary();
-    template <typename Op>
-    void uintUnary();
+    template <bool Checked, typename Op>
+    Fault floatBinaryRegisters();
+    template <bool Checked, typename Op>
+    Fault floatUnaryRegisters();
+    template <bool Checked, typename Op>
+    Fault intBinaryRegisters();
+    template <bool Checked, typename Op>
+    Fault intUnaryRegisters();
+    template <bool Checked, typename Op>
+    Fault uintBinaryRegisters();
+    template <bool Checked, typename Op>
+    Fault uintUnaryRegisters();
+    template <bool Checked, typename T, typename Op>
+    Fault sizedBinaryRegisters();
+    template <bool Checked, typename T, typename Op>
+    Fault sizedUnaryRegisters();
   };
 }  // namespace fluir
 
@@ -0,0 +1,99 @@
+#include "vm/async.hpp"
+
+#include "vm/thread_pool.hpp"
+#include "vm/verifier.hpp"
+
+namespace fluir {
+  namespace {
+    /** Suspends a coroutine and defers its remainder to a thread pool, behind the work which is already queued */
+    struct Yield {
+      ThreadPool& threads;
+
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) {
+        threads.defer([handle] { handle.resume(); });
+      }
+      void await_resume() noexcept { }
+    };
+
+    template <typename Code>
+    AsyncExecution executeOn(VirtualMachine& vm, ThreadPool& threads, const Code& code, ExecOptions options) {
+      // Whoever starts the execution only hands it over to the pool, so starting never blocks them
+      co_await Yield{threads};
+      auto result = vm.execute(code, options);
+      while (result == ExecResult::SUSPENDED) {
+        co_await Yield{threads};
+        result = vm.resume();
+      }
+      co_return result;
+    }
+  }  // namespace
+
+  std::coroutine_handle<> AsyncExecution::FinalAwaiter::await_suspend(Handle handle) noexcept {
+    auto& promise = handle.promise();
+    if (promise.continuation) {
+      return promise.continuation;
+    }
+    // Notify while holding the lock, since the waiting thread may destroy the execution as soon as it takes the lock
+    std::lock_guard lock{promise.mutex};
+    promise.done = true;
+    promise.finished.notify_one();
+    return std::noop_coroutine();
+  }
+
+  ExecResult AsyncExecution::Awaiter::await_resume() const {
+    if (handle.promise().exception) {
+      std::rethrow_exception(handle.promise().exception);
+    }
+    return handle.promise().result;
+  }
+
+  AsyncExecution& AsyncExecution::operator=(AsyncExecution&& other) noexcept {
+    if (this != &other) {
+      release();
+      handle_ = std::exchange(other.handle_, {});
+      started_ = std::exchange(other.started_, false);
+    }
+    return *this;
+  }
+
+  AsyncExecution::~AsyncExecution() { release(); }
+
+  void AsyncExecution::start() {
+    started_ = true;
+    handle_.resume();
+  }
+
+  ExecResult AsyncExecution::wait() {
+    if (!started_) {
+      start();
+    }
+    finish();
+    return Awaiter{handle_}.await_resume();
+  }
+
+  void AsyncExecution::finish() {
+    auto& promise = handle_.promise();
+    std::unique_lock lock{promise.mutex};
+    promise.finished.wait(lock, [&promise] { return promise.done; });
+  }
+
+  void AsyncExecution::release() {
+    if (!handle_) {
+      return;
+    }
+    // A started execution is still running on its pool, so it can only be destroyed once it is done
+    if (started_) {
+      finish();
+    }
+    handle_.destroy();
+  }
+
+  AsyncExecution VirtualMachine::executeAsync(ThreadPool& threads, const code::ByteCode& code, ExecOptions options) {
+    return executeOn(*this, threads, code, options);
+  }
+
+  AsyncExecution VirtualMachine::executeAsync(ThreadPool& threads, const VerifiedCode& code, ExecOptions options) {
+    return executeOn(*this, threads, code, options);
+  }
+}  // namespace fluir
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <type_traits>
+
+#include "vm/utility/kernels.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fluir {
+  namespace {
+    code::NumericWidth widthOf(code::PrimitiveType type) {
+      return static_cast<code::NumericWidth>(static_cast<std::uint8_t>(type) & 0x0F);
+    }
+
+    /** A cast's operand: the width to narrow to, combined with the category of the result */
+    code::PrimitiveType castType(code::NumericCategory category, std::uint8_t width) {
+      return static_cast<code::PrimitiveType>(category | static_cast<code::NumericWidth>(width));
+    }
+
+    /** Casting needs no conversion of the lanes themselves, only narrowing */
+    void keepLanes(kernels::Lanes) { }
+  }  // namespace
+
+  ExecResult VirtualMachine::executeBatch(const VerifiedCode& code, std::span<const Column> inputs) {
+    columns_.clear();
+    outputs_.clear();
+    suspended_ = false;
+
+    // Batches take no ExecOptions, so they always start from the header's entry chunk
+    const auto entry = entryChunk(code.code(), {});
+    if (!code.verified(entry)) {
+      std::cerr << std::format("ENTRY CHUNK {} HAS NOT BEEN VERIFIED", entry) << std::endl;
+      return ExecResult::ERROR;
+    }
+    code_ = &code.code();
+    current_ = &code_->chunks[entry];
+    ip_ = current_->instructions().data();
+
+    fault_.reset();
+
+    if (code::usesRegisters(code_->header)) {
+      std::cerr << "BATCHES ONLY RUN STACK CODE" << std::endl;
+      return ExecResult::ERROR;
+    }
+    if (inputs.size() > current_->constantCount()) {
+      std::cerr << std::format("EXPECTED AT MOST {} INPUT COLUMNS", current_->constantCount()) << std::endl;
+      return ExecResult::ERROR;
+    }
+    const std::size_t rows = inputs.empty() ? 1 : inputs.front().size();
+    for (std::size_t i = 0; i != inputs.size(); ++i) {
+      if (inputs[i].type() != current_->constantType(i) || inputs[i].size() != rows) {
+        std::cerr << std::format("INPUT COLUMN {} DOES NOT MATCH CONSTANT {}", i, i) << std::endl;
+        return ExecResult::ERROR;
+      }
+    }
+    return runBatch(inputs, rows);
+  }
+
+  void VirtualMachine::pushColumn(std::span<const Column> inputs, std::size_t constant, std::size_t rows) {
+    if (constant >= inputs.size()) {
+      return pushColumn(current_->constant(constant), rows);
+    }
+    Column::Lanes lanes;
+    if (!spareLanes_.empty()) {
+      lanes = std::move(spareLanes_.back());
+      spareLanes_.pop_back();
+    }
+    lanes.assign(inputs[constant].lanes().begin(), inputs[constant].lanes().end());
+    columns_.emplace_back(inputs[constant].type(), std::move(lanes));
+  }
+
+  void VirtualMachine::pushColumn(const code::Value& value, std::size_t rows) {
+    Column::Lanes lanes;
+    if (!spareLanes_.empty()) {
+      lanes = std::move(spareLanes_.back());
+      spareLanes_.pop_back();
+    }
+    lanes.assign(rows, Column::toLane(value));
+    columns_.emplace_back(value.type(), std::move(lanes));
+  }
+
+  Column VirtualMachine::popColumn() {
+    Column column = std::move(columns_.back());
+    columns_.pop_back();
+    return column;
+  }
+
+  void VirtualMachine::recycle(Column&& column) { spareLanes_.push_back(std::move(column.lanes_)); }
+
+  template <typename Kernel>
+  void VirtualMachine::floatColumns(Kernel kernel) {
+    auto rhs = popColumn();
+    kernel(columns_.back().lanes_, rhs.lanes_);
+    recycle(std::move(rhs));
+  }
+
+  template <typename Kernel, typename Narrow>
+  Fault VirtualMachine::intColumns(Kernel kernel, Narrow narrow) {
+    auto rhs = popColumn();
+    auto& lhs = columns_.back();
+    if constexpr (std::is_same_v<std::invoke_result_t<Kernel, kernels::Lanes, kernels::ConstLanes>, bool>) {
+      if (!kernel(lhs.lanes_, rhs.lanes_)) {
+        return Fault::DIVIDE_BY_ZERO;
+      }
+    } else {
+      kernel(lhs.lanes_, rhs.lanes_);
+    }
+    lhs.type_ = std::max(lhs.type_, rhs.type_);
+    narrow(lhs.lanes_, widthOf(lhs.type_));
+    recycle(std::move(rhs));
+    return Fault::NONE;
+  }
+
+  template <typename Kernel, typename Narrow>
+  void VirtualMachine::castColumn(Kernel kernel, Narrow narrow, code::PrimitiveType type) {
+    auto& column = columns_.back();
+    kernel(column.lanes_);
+    narrow(column.lanes_, widthOf(type));
+    column.type_ = type;
+  }
+
+  // Every instruction runs over a whole column, so dispatch is amortized across the batch and a plain switch is fast
+  // enough. The code has been verified, so there are no type or bounds checks.
+  ExecResult VirtualMachine::runBatch(std::span<const Column> inputs, std::size_t rows) {
+    using enum code::Instruction;
+    for (;;) {
+      switch (*ip_++) {
+        case PUSH:
+          pushColumn(inputs, *ip_++, rows);
+          break;
+        case PUSH2:
+          pushColumn(inputs, ip_[0], rows);
+          pushColumn(inputs, ip_[1], rows);
+          ip_ += 2;
+          break;
+        case PUSH_WIDE:
+          pushColumn(inputs, code::readOperand<std::uint16_t>(ip_), rows);
+          ip_ += 2;
+          break;
+        // Immediates are never replaced by inputs, so they hold the same value in every row
+        case PUSH_F64_IMM:
+          pushColumn(code::Value{code::readOperand<code::F64>(ip_)}, rows);
+          ip_ += 8;
+          break;
+        case PUSH_I64_IMM:
+          pushColumn(code::Value{code::readOperand<code::I64>(ip_)}, rows);
+          ip_ += 8;
+          break;
+        case PUSH_SMALL_INT:
+          pushColumn(code::Value{static_cast<code::I64>(static_cast<std::int8_t>(*ip_++))}, rows);
+          break;
+        case POP:
+          outputs_.push_back(popColumn());
+          break;
+        case PUSH_POP:
+          pushColumn(inputs, *ip_++, rows);
+          outputs_.push_back(popColumn());
+          break;
+        case F64_ADD:
+          floatColumns(kernels::addF64);
+          break;
+        case F64_SUB:
+          floatColumns(kernels::subF64);
+          break;
+        case F64_MUL:
+          floatColumns(kernels::mulF64);
+          break;
+        case F64_DIV:
+          floatColumns(kernels::divF64);
+          break;
+        case F64_NEG:
+          kernels::negF64(columns_.back().lanes_);
+          break;
+        case PUSH_PUSH_F64_ADD:
+        case PUSH_PUSH_F64_SUB:
+        case PUSH_PUSH_F64_MUL:
+        case PUSH_PUSH_F64_DIV: {
+          const auto instruction = ip_[-1];
+          pushColumn(inputs, ip_[0], rows);
+          pushColumn(inputs, ip_[1], rows);
+          ip_ += 2;
+          const auto kernel = instruction == PUSH_PUSH_F64_ADD   ? kernels::addF64
+                              : instruction == PUSH_PUSH_F64_SUB ? kernels::subF64
+                              : instruction == PUSH_PUSH_F64_MUL ? kernels::mulF64
+                                                                 : kernels::divF64;
+          floatColumns(kernel);
+          break;
+        }
+        case F64_MUL_ADD: {
+          // Multiply into the middle column, then add it to the bottom one, like F64_MUL followed by F64_ADD
+          auto rhs = popColumn();
+          kernels::mulF64(columns_.back().lanes_, rhs.lanes_);
+          recycle(std::move(rhs));
+          floatColumns(kernels::addF64);
+          break;
+        }
+        // Both operands of a width specialized instruction already have its width, and lanes hold ints sign or zero
+        // extended to 64 bits, so the generic kernels narrow their result back to the same width
+#define FLUIR_SIZED_CASE(Type, Concrete, Op) case Type##_##Op:
+#define FLUIR_SIZED_ADD(Type, Concrete) FLUIR_SIZED_CASE(Type, Concrete, ADD)
+#define FLUIR_SIZED_SUB(Type, Concrete) FLUIR_SIZED_CASE(Type, Concrete, SUB)
+#define FLUIR_SIZED_MUL(Type, Concrete) FLUIR_SIZED_CASE(Type, Concrete, MUL)
+#define FLUIR_SIZED_DIV(Type, Concrete) FLUIR_SIZED_CASE(Type, Concrete, DIV)
+#define FLUIR_SIZED_NEG(Type, Concrete) FLUIR_SIZED_CASE(Type, Concrete, NEG)
+        case I64_ADD:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_ADD)
+          intColumns(kernels::addInt, kernels::narrowI);
+          break;
+        case I64_SUB:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_SUB)
+          intColumns(kernels::subInt, kernels::narrowI);
+          break;
+        case I64_MUL:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_MUL)
+          intColumns(kernels::mulInt, kernels::narrowI);
+          break;
+        case I64_DIV:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_DIV)
+          if (auto fault = intColumns(kernels::divI64, kernels::narrowI); fault != Fault::NONE) {
+            return raise(fault);
+          }
+          break;
+        case I64_NEG:
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_NEG)
+          castColumn(kernels::negInt, kernels::narrowI, columns_.back().type_);
+          break;
+        case U64_ADD:
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_ADD)
+          intColumns(kernels::addInt, kernels::narrowU);
+          break;
+        case U64_SUB:
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_SUB)
+          intColumns(kernels::subInt, kernels::narrowU);
+          break;
+        case U64_MUL:
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_MUL)
+          intColumns(kernels::mulInt, kernels::narrowU);
+          break;
+        case U64_DIV:
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_DIV)
+          if (auto fault = intColumns(kernels::divU64, kernels::narrowU); fault != Fault::NONE) {
+            return raise(fault);
+          }
+          break;
+#undef FLUIR_SIZED_NEG
+#undef FLUIR_SIZED_DIV
+#undef FLUIR_SIZED_MUL
+#undef FLUIR_SIZED_SUB
+#undef FLUIR_SIZED_ADD
+#undef FLUIR_SIZED_CASE
+        case F64_AFF:
+        case I64_AFF:
+        case U64_AFF:
+          break;  // This is a No-Op
+        case CAST_IU:
+          castColumn(keepLanes, kernels::narrowU, castType(code::UNSIGNED, *ip_++));
+          break;
+        case CAST_UI:
+          castColumn(keepLanes, kernels::narrowI, castType(code::SIGNED, *ip_++));
+          break;
+        case CAST_IF:
+          castColumn(kernels::castIF, kernels::narrowU, code::PrimitiveType::F64);
+          break;
+        case CAST_UF:
+          castColumn(kernels::castUF, kernels::narrowU, code::PrimitiveType::F64);
+          break;
+        case CAST_FI:
+          castColumn(kernels::castFI, kernels::narrowI, castType(code::SIGNED, *ip_++));
+          break;
+        case CAST_FU:
+          castColumn(kernels::castFU, kernels::narrowU, castType(code::UNSIGNED, *ip_++));
+          break;
+        case EXIT:
+          return ExecResult::SUCCESS;
+        default:
+          return raise(Fault::INVALID_INSTRUCTION);
+      }
+    }
+  }
+}  // namespace fluir
@@ -1,16 +1,58 @@
 #include "vm/decoder/decode.hpp"
 
+#include <memory>
 #include <stdexcept>
 
+#include "vm/decoder/binary.hpp"
 #include "vm/decoder/inspect.hpp"
+#include "vm/mapped_file.hpp"
+
 namespace fluir {
   code::ByteCode decode(std::string_view source) {
     if (source.size() >= 1) {
       switch (source.at(0)) {
-        case 'I':
+        case code::FILETYPE_INSPECT:
+        case code::FILETYPE_REGISTERS:
+          // Register code is written in the inspect format too; only the instruction set differs
           return InspectDecoder{}.decode(source);
+        case code::FILETYPE_BINARY:
+          return BinaryDecoder{}.decode(source);
       }
     }
-    throw std::runtime_error("Invalid header. File type must be 'I' (0x4C).");
+    throw std::runtime_error("Invalid header. File type must be 'I' (0x49), 'R' (0x52) or 'B' (0x42).");
+  }
+
+  code::ByteCode load(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    if (file->text().starts_with(code::FILETYPE_BINARY)) {
+      auto code = BinaryDecoder{}.decodeInPlace(file->bytes());
+      code.storage = std::move(file);
+      return code;
+    }
+    // The text formats are copied out of the file as they are decoded, so the mapping is no longer needed
+    return decode(file->text());
+  }
+
+  code::ByteCode decode(std::string_view source, ThreadPool& threads) {
+    if (source.size() >= 1) {
+      switch (source.at(0)) {
+        case code::FILETYPE_INSPECT:
+        case code::FILETYPE_REGISTERS:
+          return InspectDecoder{}.decode(source, threads);
+        case code::FILETYPE_BINARY:
+          return BinaryDecoder{}.decode(source, threads);
+      }
+    }
+    throw std::runtime_error("Invalid header. File type must be 'I' (0x49), 'R' (0x52) or 'B' (0x42).");
+  }
+
+  code::ByteCode load(const std::string& path, ThreadPool& threads) {
+    auto file = std::make_shared<const MappedFile>(path);
+    if (file->text().starts_with(code::FILETYPE_BINARY)) {
+      auto code = BinaryDecoder{}.decodeInPlace(file->bytes(), threads);
+      code.storage = std::move(file);
+      return code;
+    }
+    return decode(file->text(), threads);
   }
 }  // namespace fluir
@@ -0,0 +1,369 @@
+#include "vm/decoder/binary.hpp"
+
+#include <format>
+#include <stdexcept>
+#include <string>
+
+namespace fluir {
+  namespace binary = code::binary;
+
+  namespace {
+    /** Reads consecutive little endian values from bytes, throwing instead of reading past their end */
+    class Reader {
+     public:
+      explicit Reader(std::span<const std::uint8_t> bytes) : bytes_(bytes) { }
+
+      template <typename T>
+      T read() {
+        need(sizeof(T));
+        auto value = code::readOperand<T>(bytes_.data() + at_);
+        at_ += sizeof(T);
+        return value;
+      }
+
+      /** The next count bytes */
+      std::span<const std::uint8_t> take(std::size_t count) {
+        need(count);
+        auto taken = bytes_.subspan(at_, count);
+        at_ += count;
+        return taken;
+      }
+
+      /** Reads a u64 count of items which take at least itemSize bytes each, rejecting counts which cannot fit */
+      std::size_t count(std::size_t itemSize) {
+        const auto count = read<std::uint64_t>();
+        if (count > (bytes_.size() - at_) / itemSize) {
+          throw std::runtime_error("Invalid bytecode. A section's count is larger than the section.");
+        }
+        return count;
+      }
+
+      void skipTo(std::size_t offset) {
+        need(offset - at_);
+        at_ = offset;
+      }
+      [[nodiscard]] std::size_t at() const { return at_; }
+
+     private:
+      std::span<const std::uint8_t> bytes_;
+      std::size_t at_{0};
+
+      void need(std::size_t count) const {
+        if (count > bytes_.size() - at_) {
+          throw std::runtime_error("Invalid bytecode. The file ends in the middle of a section.");
+        }
+      }
+    };
+  }  // namespace
+
+  code::ByteCode BinaryDecoder::decode(std::string_view source) {
+    file_ = std::span{reinterpret_cast<const std::uint8_t*>(source.data()), source.size()};
+    inPlace_ = false;
+    return decodeSections();
+  }
+
+  code::ByteCode BinaryDecoder::decodeInPlace(std::span<const std::uint8_t> file) {
+    file_ = file;
+    inPlace_ = true;
+    return decodeSections();
+  }
+
+  code::ByteCode BinaryDecoder::decodeSections() {
+    code_ = code::ByteCode{};
+    code_.header = header();
+
+    const auto sections = sectionCount();
+    code::ConstantView shared;
+    for (std::size_t i = 0; i != sections; ++i) {
+      const auto entry = section(i);
+      const auto bytes = contents(entry);
+      switch (entry.kind) {
+        case binary::SectionKind::NAME:
+          if (entry.chunk != code_.chunks.size()) {
+            throw std::runtime_error(std::format("Invalid bytecode. Expected chunk x{:X} to start next, not x{:X}.",
+                                                 code_.chunks.size(),
+                                                 entry.chunk));
+          }
+          code_.chunks.push_back(code::Chunk{.name = std::string{bytes.begin(), bytes.end()}});
+          break;
+        case binary::SectionKind::CODE:
+        case binary::SectionKind::CONSTANTS:
+        case binary::SectionKind::SUBGRAPHS:
+        case binary::SectionKind::DEBUG:
+          decodeSection(chunk(entry), entry.kind, bytes);
+          break;
+        case binary::SectionKind::SHARED_CONSTANTS:
+          if (inPlace_) {
+            shared = constantView(bytes);
+          } else {
+            code_.constants = constants(bytes);
+          }
+          break;
+        default:
+          // Sections added by later versions of the format are not needed to run the code. Decoding everything at
+          // once does not need the directory either.
+          break;
+      }
+    }
+    // The VM only reads each chunk's own constants. Chunks decoded in place point at the shared table instead.
+    code::expandSharedConstants(code_);
+    for (auto& chunk : code_.chunks) {
+      if (chunk.constantCount() == 0) {
+        chunk.constantView = shared;
+      }
+    }
+
+    return std::move(code_);
+  }
+
+  code::ByteCode BinaryDecoder::decode(std::string_view source, ThreadPool& threads) {
+    file_ = std::span{reinterpret_cast<const std::uint8_t*>(source.data()), source.size()};
+    inPlace_ = false;
+    return decodeChunks(threads);
+  }
+
+  code::ByteCode BinaryDecoder::decodeInPlace(std::span<const std::uint8_t> file, ThreadPool& threads) {
+    file_ = file;
+    inPlace_ = true;
+    return decodeChunks(threads);
+  }
+
+  code::ByteCode BinaryDecoder::decodeChunks(ThreadPool& threads) {
+    if (!readDirectory()) {
+      return decodeSections();
+    }
+    threads.forEach(code_.chunks.size(), [this](std::size_t i) { code_.chunks[i] = decodeChunk(i); });
+    code::expandSharedConstants(code_);
+    return std::move(code_);
+  }
+
+  std::optional<code::ByteCode> BinaryDecoder::decodeDirectory(std::span<const std::uint8_t> file) {
+    file_ = file;
+    inPlace_ = true;
+    if (!readDirectory()) {
+      return std::nullopt;
+    }
+    return std::move(code_);
+  }
+
+  bool BinaryDecoder::readDirectory() {
+    code_ = code::ByteCode{};
+    code_.header = header();
+    shared_ = {};
+
+    const auto sections = sectionCount();
+    if (sections == 0 || section(0).kind != binary::SectionKind::DIRECTORY) {
+      return false;
+    }
+    directory_ = directory(contents(section(0)));
+    // The module's sections come between the directory and the first chunk
+    const auto moduleSections = directory_.empty() ? sections : directory_.front().firstSection;
+    for (std::size_t i = 1; i < moduleSections; ++i) {
+      const auto entry = section(i);
+      if (entry.kind != binary::SectionKind::SHARED_CONSTANTS) {
+        continue;
+      }
+      // Copied constants are expanded into the chunks once they are decoded, instead of pointing into the file
+      if (inPlace_) {
+        shared_ = constantView(contents(entry));
+      } else {
+        code_.constants = constants(contents(entry));
+      }
+    }
+    code_.chunks.resize(directory_.size());
+    return true;
+  }
+
+  code::Chunk BinaryDecoder::decodeChunk(std::size_t index) const {
+    const auto& range = directory_.at(index);
+    code::Chunk chunk{.name = std::string{chunkName(index)}};
+    for (std::size_t i = range.firstSection + 1; i != range.firstSection + range.sections; ++i) {
+      const auto entry = section(i);
+      if (entry.chunk != index || entry.offset < range.offset || entry.offset - range.offset > range.size ||
+          entry.size > range.size - (entry.offset - range.offset)) {
+        throw std::runtime_error(
+          std::format("Invalid bytecode. Section x{:X} lies outside of the directory entry of chunk x{:X}.", i, index));
+      }
+      const auto bytes = contents(entry);
+      switch (entry.kind) {
+        case binary::SectionKind::CODE:
+        case binary::SectionKind::CONSTANTS:
+        case binary::SectionKind::SUBGRAPHS:
+        case binary::SectionKind::DEBUG:
+          decodeSection(chunk, entry.kind, bytes);
+          break;
+        default:
+          break;
+      }
+    }
+    if (chunk.constantCount() == 0) {
+      chunk.constantView = shared_;
+    }
+    return chunk;
+  }
+
+  std::string_view BinaryDecoder::chunkName(std::size_t index) const {
+    const auto& range = directory_.at(index);
+    const auto entry = section(range.firstSection);
+    if (entry.kind != binary::SectionKind::NAME || entry.chunk != index) {
+      throw std::runtime_error(
+        std::format("Invalid bytecode. The directory entry of chunk x{:X} does not start with its NAME.", index));
+    }
+    const auto bytes = contents(entry);
+    return std::string_view{reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+
+  void BinaryDecoder::decodeSection(code::Chunk& chunk,
+                                    binary::SectionKind kind,
+                                    std::span<const std::uint8_t> bytes) const {
+    switch (kind) {
+      case binary::SectionKind::CODE:
+        if (inPlace_) {
+          chunk.codeView = bytes;
+        } else {
+          chunk.code.assign(bytes.begin(), bytes.end());
+        }
+        break;
+      case binary::SectionKind::CONSTANTS:
+        if (inPlace_) {
+          chunk.constantView = constantView(bytes);
+        } else {
+          chunk.constants = constants(bytes);
+        }
+        break;
+      case binary::SectionKind::SUBGRAPHS:
+        chunk.subgraphs = subgraphs(bytes);
+        break;
+      case binary::SectionKind::DEBUG:
+        chunk.debug = debug(bytes);
+        break;
+      default:
+        break;
+    }
+  }
+
+  code::Header BinaryDecoder::header() {
+    if (file_.size() < binary::HEADER_SIZE || file_[0] != code::FILETYPE_BINARY) {
+      throw std::runtime_error("Invalid bytecode. The binary header is missing.");
+    }
+    const auto instructions = static_cast<char>(file_[4]);
+    if (instructions != code::FILETYPE_INSPECT && instructions != code::FILETYPE_REGISTERS) {
+      throw std::runtime_error("Invalid bytecode. The instruction set must be 'I' (0x49) or 'R' (0x52).");
+    }
+    return code::Header{.filetype = instructions,
+                        .major = file_[1],
+                        .minor = file_[2],
+                        .patch = file_[3],
+                        .entryOffset = code::readOperand<std::uint64_t>(file_.data() + 8)};
+  }
+
+  std::size_t BinaryDecoder::sectionCount() const {
+    const auto sections = Reader{file_.subspan(16)}.read<std::uint32_t>();
+    if (sections > (file_.size() - binary::HEADER_SIZE) / binary::SECTION_ENTRY_SIZE) {
+      throw std::runtime_error("Invalid bytecode. The section table is larger than the file.");
+    }
+    return sections;
+  }
+
+  binary::Section BinaryDecoder::section(std::size_t index) const {
+    Reader entry{file_.subspan(binary::HEADER_SIZE + index * binary::SECTION_ENTRY_SIZE, binary::SECTION_ENTRY_SIZE)};
+    const auto kind = static_cast<binary::SectionKind>(entry.read<std::uint32_t>());
+    const auto chunk = entry.read<std::uint32_t>();
+    const auto offset = entry.read<std::uint64_t>();
+    const auto size = entry.read<std::uint64_t>();
+    return binary::Section{.kind = kind, .chunk = chunk, .offset = offset, .size = size};
+  }
+
+  std::span<const std::uint8_t> BinaryDecoder::contents(const binary::Section& section) const {
+    if (section.offset % binary::ALIGNMENT != 0 || section.offset > file_.size() ||
+        section.size > file_.size() - section.offset) {
+      throw std::runtime_error(std::format(
+        "Invalid bytecode. The section at x{:X} of size x{:X} is not within the file.", section.offset, section.size));
+    }
+    return file_.subspan(section.offset, section.size);
+  }
+
+  code::Chunk& BinaryDecoder::chunk(const binary::Section& section) {
+    if (section.chunk >= code_.chunks.size()) {
+      throw std::runtime_error(
+        std::format("Invalid bytecode. Chunk x{:X} has a section before its NAME section.", section.chunk));
+    }
+    return code_.chunks[section.chunk];
+  }
+
+  std::vector<binary::DirectoryEntry> BinaryDecoder::directory(std::span<const std::uint8_t> bytes) const {
+    Reader reader{bytes};
+    const auto sections = sectionCount();
+    std::vector<binary::DirectoryEntry> directory(reader.count(binary::DIRECTORY_ENTRY_SIZE));
+    for (std::size_t i = 0; i != directory.size(); ++i) {
+      auto& entry = directory[i];
+      entry.offset = reader.read<std::uint64_t>();
+      entry.size = reader.read<std::uint64_t>();
+      entry.firstSection = reader.read<std::uint32_t>();
+      entry.sections = reader.read<std::uint32_t>();
+      // Chunks start with their NAME and follow each other in the table, after the directory itself
+      const auto start = i == 0 ? std::size_t{1} : directory[i - 1].firstSection + directory[i - 1].sections;
+      if (entry.sections == 0 || entry.firstSection < start || entry.firstSection > sections ||
+          entry.sections > sections - entry.firstSection) {
+        throw std::runtime_error(std::format(
+          "Invalid bytecode. The directory entry of chunk x{:X} refers to sections which do not exist.", i));
+      }
+    }
+    return directory;
+  }
+
+  code::ConstantView BinaryDecoder::constantView(std::span<const std::uint8_t> bytes) {
+    Reader reader{bytes};
+    // Each constant takes a type byte and a u64
+    const auto count = reader.count(1 + sizeof(std::uint64_t));
+    const auto types = reader.take(count);
+    reader.skipTo(binary::aligned(reader.at()));
+    const auto bits = reader.take(count * sizeof(std::uint64_t));
+
+    for (auto type : types) {
+      if (!code::valueFromBits(type, 0)) {
+        throw std::runtime_error(std::format("Invalid bytecode. x{:X} is not a constant type.", type));
+      }
+    }
+    return code::ConstantView{types, bits};
+  }
+
+  std::vector<code::Value> BinaryDecoder::constants(std::span<const std::uint8_t> bytes) {
+    const auto view = constantView(bytes);
+    std::vector<code::Value> constants;
+    constants.reserve(view.size());
+    for (std::size_t i = 0; i != view.size(); ++i) {
+      constants.push_back(view[i]);
+    }
+    return constants;
+  }
+
+  std::vector<code::Subgraph> BinaryDecoder::subgraphs(std::span<const std::uint8_t> bytes) {
+    Reader reader{bytes};
+    // Each subgraph takes at least its chunk and its number of dependencies
+    const auto count = reader.count(2 * sizeof(std::uint64_t));
+    std::vector<code::Subgraph> subgraphs(count);
+    for (auto& subgraph : subgraphs) {
+      subgraph.chunk = reader.read<std::uint64_t>();
+      subgraph.dependencies.resize(reader.count(sizeof(std::uint64_t)));
+      for (auto& dependency : subgraph.dependencies) {
+        dependency = reader.read<std::uint64_t>();
+      }
+    }
+    return subgraphs;
+  }
+
+  std::vector<code::DebugEntry> BinaryDecoder::debug(std::span<const std::uint8_t> bytes) {
+    Reader reader{bytes};
+    std::vector<code::DebugEntry> debug(reader.count(binary::DEBUG_ENTRY_SIZE));
+    for (auto& entry : debug) {
+      entry.offset = reader.read<std::uint64_t>();
+      entry.node = reader.read<std::uint64_t>();
+      for (auto* coordinate : {&entry.x, &entry.y, &entry.z, &entry.width, &entry.height}) {
+        *coordinate = reader.read<std::int32_t>();
+      }
+      reader.read<std::uint32_t>();
+    }
+    return debug;
+  }
+}  // namespace fluir
@@ -1,11 +1,185 @@
 #include "vm/decoder/inspect.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 
+#if defined(__SSE2__)
+#define FLUIR_VM_SIMD_WHITESPACE 1
+#include <emmintrin.h>
+#else
+#define FLUIR_VM_SIMD_WHITESPACE 0
+#endif
+
 namespace fluir {
+  namespace {
+    enum CharClass : std::uint8_t { OTHER = 0, ALPHA = 1, DIGIT = 2, UNDERSCORE = 4, WHITESPACE = 8 };
+    /** The characters which may continue a word after its first letter */
+    constexpr std::uint8_t WORD = ALPHA | DIGIT | UNDERSCORE;
+
+    /** The class of every byte, which unlike std::isalnum and friends does not depend on the locale */
+    constexpr auto CHAR_CLASSES = [] {
+      std::array<std::uint8_t, 256> classes{};
+      for (int c = 'A'; c <= 'Z'; ++c) {
+        classes[c] = ALPHA;
+        classes[c - 'A' + 'a'] = ALPHA;
+      }
+      for (int c = '0'; c <= '9'; ++c) {
+        classes[c] = DIGIT;
+      }
+      classes['_'] = UNDERSCORE;
+      for (char c : {' ', '\t', '\r', '\n'}) {
+        classes[static_cast<std::uint8_t>(c)] = WHITESPACE;
+      }
+      return classes;
+    }();
+
+    CharClass classOf(char c) { return static_cast<CharClass>(CHAR_CLASSES[static_cast<std::uint8_t>(c)]); }
+
+    struct Keyword {
+      std::string_view name;
+      TokenType type{TokenType::IDENTIFIER};
+    };
+
+    // clang-format off
+    constexpr Keyword KEYWORD_LIST[] = {
+      {"CHUNK", TokenType::CHUNK}, {"CODE", TokenType::CODE}, {"CONSTANTS", TokenType::CONSTANTS},
+      {"SUBGRAPHS", TokenType::SUBGRAPHS}, {"DEBUG", TokenType::DEBUG},
+#define FLUIR_TYPE_KEYWORD(Type, Concrete) {"V" #Type, TokenType::TYPE_##Type},
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_TYPE_KEYWORD)
+#undef FLUIR_TYPE_KEYWORD
+#define FLUIR_INSTRUCTION_KEYWORD(Inst) {"I" #Inst, TokenType::INST_##Inst},
+      FLUIR_CODE_INSTRUCTIONS(FLUIR_INSTRUCTION_KEYWORD)
+#undef FLUIR_INSTRUCTION_KEYWORD
+    };
+    // clang-format on
+
+    constexpr std::uint64_t FNV_OFFSET = 0xCBF2'9CE4'8422'2325;
+
+    /** One step of FNV-1a, so words can be hashed as they are scanned */
+    constexpr std::uint64_t hashChar(std::uint64_t hash, char c) {
+      return (hash ^ static_cast<std::uint8_t>(c)) * 0x0000'0100'0000'01B3;
+    }
+
+    constexpr std::uint64_t hashWord(std::string_view word) {
+      std::uint64_t hash = FNV_OFFSET;
+      for (char c : word) {
+        hash = hashChar(hash, c);
+      }
+      return hash;
+    }
+
+    /** Scrambles a word's hash with a bucket's displacement, giving a different slot for every displacement */
+    constexpr std::uint64_t displace(std::uint64_t hash, std::uint32_t displacement) {
+      hash ^= displacement * 0x9E37'79B9'7F4A'7C15;
+      hash ^= hash >> 33;
+      hash *= 0xFF51'AFD7'ED55'8CCD;
+      return hash ^ (hash >> 33);
+    }
+
+    /** A perfect hash table of every keyword, built at compile time by hash and displace.
+     *
+     * A word's hash picks one of BUCKETS buckets, and each bucket has a displacement which sends all of its keywords
+     * to distinct free slots. Buckets are placed largest first while the table is still empty. Looking a word up then
+     * takes one hash and one comparison, and anything which is not a keyword lands on a slot holding another word or
+     * none.
+     */
+    class KeywordTable {
+     public:
+      consteval KeywordTable() {
+        std::array<std::size_t, BUCKETS> sizes{};
+        for (const auto& keyword : KEYWORD_LIST) {
+          ++sizes[hashWord(keyword.name) % BUCKETS];
+        }
+        std::array<std::size_t, BUCKETS> order{};
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) { return sizes[a] > sizes[b]; });
+
+        for (auto bucket : order) {
+          for (std::uint32_t displacement = 0; sizes[bucket] != 0; ++displacement) {
+            if (place(bucket, displacement)) {
+              displacements_[bucket] = displacement;
+              break;
+            }
+          }
+        }
+      }
+
+      /** The type of word, whose hashWord is hash, or IDENTIFIER if it is not a keyword */
+      [[nodiscard]] constexpr TokenType find(std::string_view word, std::uint64_t hash) const {
+        const auto& slot = slots_[displace(hash, displacements_[hash % BUCKETS]) & (SLOTS - 1)];
+        return slot.name == word ? slot.type : TokenType::IDENTIFIER;
+      }
+
+     private:
+      static constexpr std::size_t KEYWORD_COUNT = std::size(KEYWORD_LIST);
+      static constexpr std::size_t SLOTS = std::bit_ceil(KEYWORD_COUNT);
+      static constexpr std::size_t BUCKETS = KEYWORD_COUNT / 2 + 1;
+
+      std::array<std::uint32_t, BUCKETS> displacements_{};
+      std::array<Keyword, SLOTS> slots_{};
+
+      /** Puts every keyword in bucket into the slot displacement sends it to, unless one of them is taken */
+      constexpr bool place(std::size_t bucket, std::uint32_t displacement) {
+        std::array<std::size_t, KEYWORD_COUNT> placed{};
+        std::size_t count = 0;
+        for (std::size_t i = 0; i != KEYWORD_COUNT; ++i) {
+          const auto hash = hashWord(KEYWORD_LIST[i].name);
+          if (hash % BUCKETS != bucket) {
+            continue;
+          }
+          const auto slot = displace(hash, displacement) & (SLOTS - 1);
+          // Keywords of this bucket placed earlier in this attempt are already in their slots too
+          if (!slots_[slot].name.empty()) {
+            for (std::size_t j = 0; j != count; ++j) {
+              slots_[placed[j]] = Keyword{};
+            }
+            return false;
+          }
+          slots_[slot] = KEYWORD_LIST[i];
+          placed[count++] = slot;
+        }
+        return true;
+      }
+    };
+
+    constexpr KeywordTable KEYWORDS{};
+
+    static_assert(
+      [] {
+        return std::ranges::all_of(KEYWORD_LIST, [](const auto& keyword) {
+          return KEYWORDS.find(keyword.name, hashWord(keyword.name)) == keyword.type;
+        });
+      }(),
+      "Every keyword must be found in its own slot");
+  }  // namespace
+
   code::ByteCode InspectDecoder::decode(const std::string_view source) {
+    decodeModule(source);
+    decodeChunks();
+    // The VM only reads each chunk's own constants
+    code::expandSharedConstants(code_);
+
+    return std::move(code_);
+  }
+
+  code::ByteCode InspectDecoder::decode(const std::string_view source, ThreadPool& threads) {
+    decodeModule(source);
+    const auto sources = chunkSources();
+    code_.chunks.resize(sources.size());
+    threads.forEach(sources.size(), [&](std::size_t i) { code_.chunks[i] = InspectDecoder{}.decodeChunk(sources[i]); });
+    code::expandSharedConstants(code_);
+
+    return std::move(code_);
+  }
+
+  void InspectDecoder::decodeModule(std::string_view source) {
     source_ = source;
     line_ = 1;
     code_ = code::ByteCode{};
@@ -13,10 +187,11 @@ namespace fluir {
     decodeHeader();
     start_ = source_.data();
     current_ = source_.data();
+    end_ = source_.data() + source_.size();
 
-    decodeChunks();
-
-    return std::move(code_);
+    if (matchSection(TokenType::CONSTANTS)) {
+      code_.constants = constantTable();
+    }
   }
 
   void InspectDecoder::decodeHeader() {
@@ -58,22 +233,89 @@ namespace fluir {
     }
   }
 
+  std::vector<std::string_view> InspectDecoder::chunkSources() {
+    eatWhitespace();
+    const std::string_view rest{current_, end_};
+    constexpr std::string_view keyword = "CHUNK";
+    if (!rest.empty() && !rest.starts_with(keyword)) {
+      throw std::runtime_error("Invalid bytecode. Expected token 'CHUNK'.");
+    }
+
+    std::vector<std::size_t> starts;
+    for (auto at = rest.find(keyword); at != std::string_view::npos; at = rest.find(keyword, at)) {
+      const auto after = at + keyword.size();
+      // Only whole words are keywords, so names and instructions which contain CHUNK are skipped
+      const bool startsWord = at == 0 || classOf(rest[at - 1]) == WHITESPACE;
+      const bool endsWord = after == rest.size() || classOf(rest[after]) == WHITESPACE;
+      if (!startsWord || !endsWord) {
+        at = after;
+        continue;
+      }
+      starts.push_back(at);
+      // Skip the chunk's name, which could be CHUNK itself
+      at = after;
+      while (at != rest.size() && classOf(rest[at]) == WHITESPACE) {
+        ++at;
+      }
+      while (at != rest.size() && classOf(rest[at]) != WHITESPACE) {
+        ++at;
+      }
+    }
+
+    std::vector<std::string_view> sources;
+    sources.reserve(starts.size());
+    for (std::size_t i = 0; i != starts.size(); ++i) {
+      const auto end = i + 1 == starts.size() ? rest.size() : starts[i + 1];
+      sources.push_back(rest.substr(starts[i], end - starts[i]));
+    }
+    return sources;
+  }
+
+  code::Chunk InspectDecoder::decodeChunk(std::string_view text) {
+    source_ = text;
+    line_ = 1;
+    code_ = code::ByteCode{};
+    start_ = text.data();
+    current_ = text.data();
+    end_ = text.data() + text.size();
+
+    if (scanNext().type != TokenType::CHUNK) {
+      throw std::runtime_error("Invalid bytecode. Expected token 'CHUNK'.");
+    }
+    chunk();
+    // Anything after the chunk's sections would have been read as the start of the next chunk
+    if (scanNext().type != TokenType::END_OF_FILE) {
+      throw std::runtime_error("Invalid bytecode. Expected token 'CHUNK'.");
+    }
+    return std::move(code_.chunks.back());
+  }
+
   void InspectDecoder::chunk() {
     auto name = scanNext();
     auto constantBlock = constants();
     auto codeBlock = code();
+    auto subgraphBlock = subgraphs();
+    auto debugBlock = debug();
     // TODO: Check for errors
 
-    code_.chunks.push_back(
-      code::Chunk{.name = std::string{name.source}, .code = codeBlock, .constants = constantBlock});
+    code_.chunks.push_back(code::Chunk{.name = std::string{name.source},
+                                       .code = std::move(codeBlock),
+                                       .constants = std::move(constantBlock),
+                                       .subgraphs = std::move(subgraphBlock),
+                                       .debug = std::move(debugBlock)});
   }
 
   std::vector<code::Value> InspectDecoder::constants() {
     [[maybe_unused]] auto constSection = scanNext();
+    return constantTable();
+  }
+
+  std::vector<code::Value> InspectDecoder::constantTable() {
     auto rawCount = scanNext();
     auto count = toUnsignedInteger(rawCount);
 
     std::vector<code::Value> constants;
+    constants.reserve(reservable(count));
     for (size_t i = 0; i != count; ++i) {
       constants.push_back(decodeConstant());
     }
@@ -87,6 +329,7 @@ namespace fluir {
     auto count = toUnsignedInteger(rawCount);
 
     std::vector<uint8_t> code;
+    code.reserve(reservable(count));
     for (size_t i = 0; i != count; ++i) {
       code.push_back(decodeInstruction());
     }
@@ -94,292 +337,144 @@ namespace fluir {
     return code;
   }
 
+  std::vector<code::Subgraph> InspectDecoder::subgraphs() {
+    if (!matchSection(TokenType::SUBGRAPHS)) {
+      return {};
+    }
+    auto count = toUnsignedInteger(scanNext());
+
+    std::vector<code::Subgraph> subgraphs;
+    subgraphs.reserve(reservable(count));
+    for (size_t i = 0; i != count; ++i) {
+      code::Subgraph subgraph{.chunk = toUnsignedInteger(scanNext()), .dependencies = {}};
+      auto dependencies = toUnsignedInteger(scanNext());
+      subgraph.dependencies.reserve(reservable(dependencies));
+      for (size_t j = 0; j != dependencies; ++j) {
+        subgraph.dependencies.push_back(toUnsignedInteger(scanNext()));
+      }
+      subgraphs.push_back(std::move(subgraph));
+    }
+
+    return subgraphs;
+  }
+
+  std::vector<code::DebugEntry> InspectDecoder::debug() {
+    if (!matchSection(TokenType::DEBUG)) {
+      return {};
+    }
+    auto count = toUnsignedInteger(scanNext());
+
+    // Coordinates are written as their 32 bit two's complement, so negative ones survive the round trip
+    const auto coordinate = [this] { return static_cast<std::int32_t>(toUnsignedInteger(scanNext())); };
+    std::vector<code::DebugEntry> entries;
+    entries.reserve(reservable(count));
+    for (size_t i = 0; i != count; ++i) {
+      code::DebugEntry entry{.offset = toUnsignedInteger(scanNext())};
+      entry.node = toUnsignedInteger(scanNext());
+      entry.x = coordinate();
+      entry.y = coordinate();
+      entry.z = coordinate();
+      entry.width = coordinate();
+      entry.height = coordinate();
+      entries.push_back(entry);
+    }
+
+    return entries;
+  }
+
+  bool InspectDecoder::matchSection(TokenType section) {
+    // Only look ahead at the next token, since it belongs to the next chunk if this one does not have the section
+    const auto restart = current_;
+    const auto line = line_;
+    if (scanNext().type != section) {
+      current_ = restart;
+      line_ = line;
+      return false;
+    }
+    return true;
+  }
+
   Token InspectDecoder::identifier() {
-    while (std::isalnum(peek()) || peek() == '_') {
-      next();
+    // Keywords never start with the 'x' of a hex literal, so those are not looked up
+    if (*start_ == 'x') {
+      while (current_ != end_ && (classOf(*current_) & WORD) != 0) {
+        next();
+      }
+      return createToken(TokenType::HEX_LITERAL);
+    }
+    auto hash = hashChar(FNV_OFFSET, *start_);
+    while (current_ != end_ && (classOf(*current_) & WORD) != 0) {
+      hash = hashChar(hash, next());
     }
-    return createToken(decodeIdentifierType());
+    return createToken(KEYWORDS.find(std::string_view{start_, current_}, hash));
   }
 
   Token InspectDecoder::number() {
-    while (std::isdigit(peek())) {
+    while (current_ != end_ && classOf(*current_) == DIGIT) {
       next();
     }
 
-    if (peek() == '.') {
+    if (current_ != end_ && *current_ == '.') {
       next();
     }
-    while (std::isdigit(peek())) {
+    while (current_ != end_ && classOf(*current_) == DIGIT) {
       next();
     }
 
     return createToken(TokenType::FLOAT_LITERAL);
   }
 
-  bool InspectDecoder::atEnd() { return current_ == source_.data() + source_.size(); }
+  bool InspectDecoder::atEnd() { return current_ == end_; }
 
   char InspectDecoder::next() {
     current_++;
     return current_[-1];
   }
 
-  char InspectDecoder::peek() { return *current_; }
-
   Token InspectDecoder::scanNext() {
     eatWhitespace();
     start_ = current_;
     if (atEnd()) {
       return Token{.type = TokenType::END_OF_FILE, .source{}};
     }
-    char c = next();
-    if (std::isalpha(c)) {
-      return identifier();
-    }
-    if (std::isdigit(c)) {
-      return number();
+    switch (classOf(next())) {
+      case ALPHA:
+        return identifier();
+      case DIGIT:
+        return number();
+      default:
+        return Token{.type = TokenType::ERR, .source{}};
     }
-
-    return Token{.type = TokenType::ERR, .source{}};
   }
 
   void InspectDecoder::eatWhitespace() {
-    for (;;) {
-      switch (peek()) {
-        case '\n':
-          ++line_;
-          [[fallthrough]];
-        case ' ':
-        case '\t':
-        case '\r':
-          next();
-          break;
-        default:
-          return;
-      }
-    }
-  }
-
-  TokenType InspectDecoder::decodeIdentifierType() {
-    switch (start_[0]) {
-      case 'C':
-        if (current_ - start_ > 1) {
-          switch (start_[1]) {
-            case 'H':
-              return checkKeyword("CHUNK", TokenType::CHUNK);
-            case 'O':
-              if (current_ - start_ > 2) {
-                switch (start_[2]) {
-                  case 'D':
-                    return checkKeyword("CODE", TokenType::CODE);
-                  case 'N':
-                    return checkKeyword("CONSTANTS", TokenType::CONSTANTS);
-                }
-              }
-          }
-        }
-        break;
-      case 'I':
-        return checkInstruction();
-        break;
-      case 'V':
-        return checkPrimitiveType();
-      case 'x':
-        return TokenType::HEX_LITERAL;
-    }
-    return TokenType::IDENTIFIER;
-  }
-
-  TokenType InspectDecoder::checkKeyword(std::string_view expected, TokenType type) {
-    std::string_view current{start_, current_};
-    if (current.size() == expected.size() && current == expected) {
-      return type;
-    }
-    return TokenType::IDENTIFIER;
-  }
-
-  TokenType InspectDecoder::checkPrimitiveType() {
-    if (current_ - start_ > 1) {
-      switch (start_[1]) {
-        case 'F':
-          return checkKeyword("VF64", TokenType::TYPE_F64);
-        case 'I':
-          if (current_ - start_ > 2) {
-            switch (start_[2]) {
-              case '1':
-                return checkKeyword("VI16", TokenType::TYPE_I16);
-              case '3':
-                return checkKeyword("VI32", TokenType::TYPE_I32);
-              case '6':
-                return checkKeyword("VI64", TokenType::TYPE_I64);
-              case '8':
-                return checkKeyword("VI8", TokenType::TYPE_I8);
-            }
-          }
-          break;
-        case 'U':
-          if (current_ - start_ > 2) {
-            switch (start_[2]) {
-              case '1':
-                return checkKeyword("VU16", TokenType::TYPE_U16);
-              case '3':
-                return checkKeyword("VU32", TokenType::TYPE_U32);
-              case '6':
-                return checkKeyword("VU64", TokenType::TYPE_U64);
-              case '8':
-                return checkKeyword("VU8", TokenType::TYPE_U8);
-            }
-          }
-          break;
-      }
-    }
-    return TokenType::IDENTIFIER;
-  }
-
-  TokenType InspectDecoder::checkInstruction() {
-    if (current_ - start_ > 1) {
-      switch (start_[1]) {
-        case 'C':
-          return checkCastInstruction();
-        case 'E':
-          return checkKeyword("IEXIT", TokenType::INST_EXIT);
-        case 'F':
-          return checkFPInstruction();
-        case 'I':
-          return checkIntInstruction();
-        case 'P':
-          if (current_ - start_ > 2) {
-            switch (start_[2]) {
-              case 'O':
-                return checkKeyword("IPOP", TokenType::INST_POP);
-              case 'U':
-                return checkKeyword("IPUSH", TokenType::INST_PUSH);
-            }
-          }
-          break;
-        case 'U':
-          return checkUintInstruction();
+#if FLUIR_VM_SIMD_WHITESPACE
+    // Indentation and line breaks come in runs, so skip them 16 bytes at a time while there are 16 bytes left
+    while (end_ - current_ >= 16) {
+      const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current_));
+      const auto newlines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+      const auto blanks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+                                       _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')));
+      const auto whitespace = newlines | static_cast<unsigned>(_mm_movemask_epi8(blanks));
+      const auto skipped = std::countr_one(whitespace);
+      line_ += static_cast<std::size_t>(std::popcount(newlines & ((1u << skipped) - 1)));
+      current_ += skipped;
+      if (skipped != 16) {
+        return;
       }
     }
-    return TokenType::IDENTIFIER;
-  }
-
-  TokenType InspectDecoder::checkCastInstruction() {
-    std::string_view current{start_, current_};
-    if (current.starts_with("ICAST_") && current.size() > 6) {
-      switch (current[6]) {
-        case 'F':
-          if (current.size() > 7) {
-            switch (current[7]) {
-              case 'I':
-                return checkKeyword("ICAST_FI", TokenType::INST_CAST_FI);
-              case 'U':
-                return checkKeyword("ICAST_FU", TokenType::INST_CAST_FU);
-            }
-          }
-          break;
-        case 'I':
-          if (current.size() > 7) {
-            switch (current[7]) {
-              case 'F':
-                return checkKeyword("ICAST_IF", TokenType::INST_CAST_IF);
-              case 'U':
-                return checkKeyword("ICAST_IU", TokenType::INST_CAST_IU);
-            }
-          }
-          break;
-        case 'U':
-          if (current.size() > 7) {
-            switch (current[7]) {
-              case 'F':
-                return checkKeyword("ICAST_UF", TokenType::INST_CAST_UF);
-              case 'I':
-                return checkKeyword("ICAST_UI", TokenType::INST_CAST_UI);
-            }
-          }
-          break;
-        case 'W':
-          return checkKeyword("ICAST_WIDTH", TokenType::INST_CAST_WIDTH);
+#endif
+    while (current_ != end_ && classOf(*current_) == WHITESPACE) {
+      if (next() == '\n') {
+        ++line_;
       }
     }
-    return TokenType::IDENTIFIER;
   }
 
-  TokenType InspectDecoder::checkFPInstruction() {
-    std::string_view current{start_, current_};
-    if (current.starts_with("IF64_") && current.size() > 5) {
-      switch (current[5]) {
-        case 'A':
-          if (current.size() > 6) {
-            switch (current[6]) {
-              case 'D':
-                return checkKeyword("IF64_ADD", TokenType::INST_F64_ADD);
-              case 'F':
-                return checkKeyword("IF64_AFF", TokenType::INST_F64_AFF);
-            }
-          }
-          break;
-        case 'D':
-          return checkKeyword("IF64_DIV", TokenType::INST_F64_DIV);
-        case 'M':
-          return checkKeyword("IF64_MUL", TokenType::INST_F64_MUL);
-        case 'N':
-          return checkKeyword("IF64_NEG", TokenType::INST_F64_NEG);
-        case 'S':
-          return checkKeyword("IF64_SUB", TokenType::INST_F64_SUB);
-      }
-    }
-    return TokenType::IDENTIFIER;
-  }
-
-  TokenType InspectDecoder::checkIntInstruction() {
-    std::string_view current{start_, current_};
-    if (current.starts_with("II64_") && current.size() > 5) {
-      switch (current[5]) {
-        case 'A':
-          if (current.size() > 6) {
-            switch (current[6]) {
-              case 'D':
-                return checkKeyword("II64_ADD", TokenType::INST_I64_ADD);
-              case 'F':
-                return checkKeyword("II64_AFF", TokenType::INST_I64_AFF);
-            }
-          }
-          break;
-        case 'D':
-          return checkKeyword("II64_DIV", TokenType::INST_I64_DIV);
-        case 'M':
-          return checkKeyword("II64_MUL", TokenType::INST_I64_MUL);
-        case 'N':
-          return checkKeyword("II64_NEG", TokenType::INST_I64_NEG);
-        case 'S':
-          return checkKeyword("II64_SUB", TokenType::INST_I64_SUB);
-      }
-    }
-    return TokenType::IDENTIFIER;
-  }
-  TokenType InspectDecoder::checkUintInstruction() {
-    std::string_view current{start_, current_};
-    if (current.starts_with("IU64_") && current.size() > 5) {
-      switch (current[5]) {
-        case 'A':
-          if (current.size() > 6) {
-            switch (current[6]) {
-              case 'D':
-                return checkKeyword("IU64_ADD", TokenType::INST_U64_ADD);
-              case 'F':
-                return checkKeyword("IU64_AFF", TokenType::INST_U64_AFF);
-            }
-          }
-          break;
-        case 'D':
-          return checkKeyword("IU64_DIV", TokenType::INST_U64_DIV);
-        case 'M':
-          return checkKeyword("IU64_MUL", TokenType::INST_U64_MUL);
-        case 'S':
-          return checkKeyword("IU64_SUB", TokenType::INST_U64_SUB);
-      }
-    }
-    return TokenType::IDENTIFIER;
+  std::size_t InspectDecoder::reservable(std::size_t count) const {
+    // Every item takes at least two characters, so a count larger than that is left to fail as it is read
+    return std::min(count, static_cast<std::size_t>(end_ - current_) / 2);
   }
 
   Token InspectDecoder::createToken(TokenType type) {
@@ -0,0 +1,143 @@
+#include "vm/fuser.hpp"
+
+namespace fluir {
+  namespace {
+    /** The superinstruction which pushes two constants and applies `operation` to them, or EXIT if there is none */
+    code::Instruction pushPushF64(std::uint8_t operation) {
+      using enum code::Instruction;
+      switch (operation) {
+        case F64_ADD:
+          return PUSH_PUSH_F64_ADD;
+        case F64_SUB:
+          return PUSH_PUSH_F64_SUB;
+        case F64_MUL:
+          return PUSH_PUSH_F64_MUL;
+        case F64_DIV:
+          return PUSH_PUSH_F64_DIV;
+        default:
+          return EXIT;
+      }
+    }
+  }  // namespace
+
+  void fuse(code::ByteCode& code) { Fuser{}.fuse(code); }
+
+  void Fuser::fuse(code::ByteCode& code) {
+    // Superinstructions only exist in the stack instruction set
+    if (code::usesRegisters(code.header)) {
+      return;
+    }
+    for (auto& chunk : code.chunks) {
+      fuseChunk(chunk);
+    }
+  }
+
+  void Fuser::fuse(code::ByteCode& code, std::size_t index) {
+    if (!code::usesRegisters(code.header)) {
+      fuseChunk(code.chunks.at(index));
+    }
+  }
+
+  void Fuser::fuseChunk(code::Chunk& chunk) {
+    chunk_ = &chunk;
+    code_ = chunk.instructions();
+    fused_.clear();
+    fused_.reserve(code_.size());
+
+    auto entry = chunk.debug.begin();
+    std::size_t offset = 0;
+    while (offset < code_.size()) {
+      const auto start = fused_.size();
+      auto consumed = fuseAt(offset);
+      if (consumed == 0) {
+        // Leave anything we cannot decode exactly as it was
+        fused_.insert(fused_.end(), code_.begin() + static_cast<std::ptrdiff_t>(offset), code_.end());
+        for (; entry != chunk.debug.end(); ++entry) {
+          entry->offset = start + (entry->offset - offset);
+        }
+        break;
+      }
+      // Every node with code in a superinstruction now starts where it does
+      for (; entry != chunk.debug.end() && entry->offset < offset + consumed; ++entry) {
+        entry->offset = start;
+      }
+      offset += consumed;
+    }
+
+    // Every superinstruction is shorter than what it replaces, so code of the same length was left as it was. Code
+    // loaded in place keeps pointing into its file unless there was something to fuse.
+    if (fused_.size() == code_.size() && !chunk.codeView.empty()) {
+      return;
+    }
+    chunk.code.swap(fused_);
+    chunk.codeView = {};
+    dropMergedEntries(chunk.debug);
+  }
+
+  void Fuser::dropMergedEntries(std::vector<code::DebugEntry>& debug) {
+    // The last node in a superinstruction consumes what the others produced, so it is the one the instruction runs for
+    std::vector<code::DebugEntry> kept;
+    for (const auto& entry : debug) {
+      if (!kept.empty() && kept.back().offset == entry.offset) {
+        kept.back() = entry;
+      } else {
+        kept.push_back(entry);
+      }
+    }
+    debug.swap(kept);
+  }
+
+  std::size_t Fuser::fuseAt(std::size_t offset) {
+    using enum code::Instruction;
+    const auto code = code_;
+
+    if (code[offset] >= code::INSTRUCTION_COUNT) {
+      return 0;
+    }
+    const std::size_t length = 1 + code::operandBytes(static_cast<code::Instruction>(code[offset]));
+    if (offset + length > code.size()) {
+      return 0;
+    }
+
+    if (startsPushPushF64(offset)) {
+      fused_.insert(fused_.end(), {pushPushF64(code[offset + 4]), code[offset + 1], code[offset + 3]});
+      return 5;
+    }
+    if (isInstruction(offset, PUSH) && isInstruction(offset + 2, POP)) {
+      fused_.insert(fused_.end(), {PUSH_POP, code[offset + 1]});
+      return 3;
+    }
+    // Prefer leaving the second PUSH to start a PUSH_PUSH_F64_<op>, as that saves more dispatches
+    if (isInstruction(offset, PUSH) && isInstruction(offset + 2, PUSH) && offset + 3 < code.size() &&
+        !startsPushPushF64(offset + 2)) {
+      fused_.insert(fused_.end(), {PUSH2, code[offset + 1], code[offset + 3]});
+      return 4;
+    }
+    if (isInstruction(offset, F64_MUL) && isInstruction(offset + 1, F64_ADD)) {
+      fused_.push_back(F64_MUL_ADD);
+      return 2;
+    }
+
+    fused_.insert(fused_.end(), code.begin() + static_cast<std::ptrdiff_t>(offset),
+                  code.begin() + static_cast<std::ptrdiff_t>(offset + length));
+    return length;
+  }
+
+  bool Fuser::isInstruction(std::size_t offset, code::Instruction instruction) const {
+    return offset < code_.size() && code_[offset] == instruction;
+  }
+
+  bool Fuser::isF64Constant(std::size_t offset) const {
+    if (offset >= code_.size()) {
+      return false;
+    }
+    auto index = code_[offset];
+    return index < chunk_->constantCount() && chunk_->constantType(index) == code::PrimitiveType::F64;
+  }
+
+  bool Fuser::startsPushPushF64(std::size_t offset) const {
+    using enum code::Instruction;
+    return isInstruction(offset, PUSH) && isInstruction(offset + 2, PUSH) && offset + 4 < code_.size() &&
+           pushPushF64(code_[offset + 4]) != EXIT && isF64Constant(offset + 1) && isF64Constant(offset + 3);
+  }
+}  // namespace fluir
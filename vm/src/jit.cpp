@@ -0,0 +1,273 @@
+#include "vm/jit.hpp"
+
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define FLUIR_VM_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define FLUIR_VM_JIT_X86_64 0
+#endif
+
+namespace fluir {
+  namespace {
+    // Stencils assume the System V calling convention: the stack pointer arrives in rdi and is kept in rbx, values
+    // below rbx are live and rbx points at the next free slot. The output sink arrives in rsi and is kept in r12 for
+    // POP. Bytes marked as holes are patched for each instruction.
+
+    // push rbx; push r12; sub rsp, 8; mov rbx, rdi; mov r12, rsi. The padding keeps rsp 16 byte aligned for calls.
+    constexpr std::uint8_t PROLOGUE[] = {0x53, 0x41, 0x54, 0x48, 0x83, 0xEC, 0x08, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4};
+    // mov rax, rbx; add rsp, 8; pop r12; pop rbx; ret
+    constexpr std::uint8_t EPILOGUE[] = {0x48, 0x89, 0xD8, 0x48, 0x83, 0xC4, 0x08, 0x41, 0x5C, 0x5B, 0xC3};
+    // mov rax, <constant>; mov [rbx], rax; add rbx, 8
+    constexpr std::uint8_t PUSH_STENCIL[] = {0x48, 0xB8, 0,    0,    0,    0,    0,    0,
+                                             0,    0,    0x48, 0x89, 0x03, 0x48, 0x83, 0xC3, 0x08};
+    constexpr std::size_t PUSH_CONSTANT = 2;
+    // movsd xmm0, [rbx - 16]; <op>sd xmm0, [rbx - 8]; movsd [rbx - 16], xmm0; sub rbx, 8
+    constexpr std::uint8_t BINARY_STENCIL[] = {0xF2, 0x0F, 0x10, 0x43, 0xF0, 0xF2, 0x0F, 0x00, 0x43, 0xF8,
+                                               0xF2, 0x0F, 0x11, 0x43, 0xF0, 0x48, 0x83, 0xEB, 0x08};
+    constexpr std::size_t BINARY_OPERATION = 7;
+    // xor byte [rbx - 1], 0x80, which flips the sign bit exactly like std::negate
+    constexpr std::uint8_t NEG_STENCIL[] = {0x80, 0x73, 0xFF, 0x80};
+    // mov rax, <lhs>; movq xmm0, rax; mov rax, <rhs>; movq xmm1, rax; <op>sd xmm0, xmm1; movsd [rbx], xmm0; add rbx, 8
+    constexpr std::uint8_t PUSH_PUSH_STENCIL[] = {0x48, 0xB8, 0,    0,    0,    0,    0,    0,    0,    0,    0x66,
+                                                  0x48, 0x0F, 0x6E, 0xC0, 0x48, 0xB8, 0,    0,    0,    0,    0,
+                                                  0,    0,    0,    0x66, 0x48, 0x0F, 0x6E, 0xC8, 0xF2, 0x0F, 0x00,
+                                                  0xC1, 0xF2, 0x0F, 0x11, 0x03, 0x48, 0x83, 0xC3, 0x08};
+    constexpr std::size_t PUSH_PUSH_LHS = 2;
+    constexpr std::size_t PUSH_PUSH_RHS = 17;
+    constexpr std::size_t PUSH_PUSH_OPERATION = 32;
+    // movsd xmm0, [rbx - 16]; mulsd xmm0, [rbx - 8]; movsd xmm1, [rbx - 24]; addsd xmm1, xmm0; movsd [rbx - 24], xmm1;
+    // sub rbx, 16. The multiply and add are rounded separately, like F64_MUL followed by F64_ADD.
+    constexpr std::uint8_t MUL_ADD_STENCIL[] = {0xF2, 0x0F, 0x10, 0x43, 0xF0, 0xF2, 0x0F, 0x59, 0x43, 0xF8, 0xF2, 0x0F,
+                                                0x10, 0x4B, 0xE8, 0xF2, 0x0F, 0x58, 0xC8, 0xF2, 0x0F, 0x11, 0x4B, 0xE8,
+                                                0x48, 0x83, 0xEB, 0x10};
+    // movsd xmm0, [rbx - 8]; sub rbx, 8; mov rdi, r12; mov rax, <writeF64>; call rax
+    constexpr std::uint8_t POP_STENCIL[] = {0xF2, 0x0F, 0x10, 0x43, 0xF8, 0x48, 0x83, 0xEB, 0x08, 0x4C, 0x89, 0xE7,
+                                            0x48, 0xB8, 0,    0,    0,    0,    0,    0,    0,    0,    0xFF, 0xD0};
+    constexpr std::size_t POP_WRITE = 14;
+    // mov rax, <constant>; movq xmm0, rax; mov rdi, r12; mov rax, <writeF64>; call rax
+    constexpr std::uint8_t PUSH_POP_STENCIL[] = {0x48, 0xB8, 0,    0,    0,    0,    0,    0,    0,    0,
+                                                 0x66, 0x48, 0x0F, 0x6E, 0xC0, 0x4C, 0x89, 0xE7, 0x48, 0xB8,
+                                                 0,    0,    0,    0,    0,    0,    0,    0,    0xFF, 0xD0};
+    constexpr std::size_t PUSH_POP_CONSTANT = 2;
+    constexpr std::size_t PUSH_POP_WRITE = 20;
+
+    static_assert(sizeof(PUSH_STENCIL) == PUSH_CONSTANT + 15);
+    static_assert(sizeof(PUSH_PUSH_STENCIL) == PUSH_PUSH_OPERATION + 10);
+    static_assert(sizeof(POP_STENCIL) == POP_WRITE + 10);
+    static_assert(sizeof(PUSH_POP_STENCIL) == PUSH_POP_WRITE + 10);
+
+    /** The second opcode byte of the SSE2 scalar double instruction for a binary F64 operation */
+    std::uint8_t sseOperation(code::Instruction instruction) {
+      using enum code::Instruction;
+      switch (instruction) {
+        case F64_ADD:
+        case PUSH_PUSH_F64_ADD:
+          return 0x58;
+        case F64_MUL:
+        case PUSH_PUSH_F64_MUL:
+          return 0x59;
+        case F64_SUB:
+        case PUSH_PUSH_F64_SUB:
+          return 0x5C;
+        default:
+          return 0x5E;
+      }
+    }
+
+    /** Writes a POPped F64 to the execution's sink, like POP does in the interpreter. Native code has no unwind
+     * information, so a sink which throws terminates the program. */
+    void writeF64(OutputSink* sink, code::F64 value) noexcept { sink->write(code::Value{value}); }
+  }  // namespace
+
+  NativeChunk::NativeChunk(NativeChunk&& other) noexcept :
+    memory_(std::exchange(other.memory_, nullptr)), mapped_(std::exchange(other.mapped_, 0)), size_(other.size_) { }
+
+  NativeChunk& NativeChunk::operator=(NativeChunk&& other) noexcept {
+    std::swap(memory_, other.memory_);
+    std::swap(mapped_, other.mapped_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  NativeChunk::~NativeChunk() {
+#if FLUIR_VM_JIT_X86_64
+    if (memory_ != nullptr) {
+      munmap(memory_, mapped_);
+    }
+#endif
+  }
+
+  NativeChunk::Entry NativeChunk::entry() const { return std::bit_cast<Entry>(memory_); }
+
+  JitCode compile(const VerifiedCode& code) { return Jit{}.compile(code); }
+
+  bool Jit::available() { return FLUIR_VM_JIT_X86_64 != 0; }
+
+  JitCode Jit::compile(const VerifiedCode& code) {
+    JitCode result{code};
+    result.chunks_.reserve(code.code().chunks.size());
+    const bool registers = code::usesRegisters(code.code().header);
+    for (const auto& chunk : code.code().chunks) {
+      // Chunks which have not been verified yet may not even be decoded
+      if (available() && !registers && code.verified(result.chunks_.size()) && supports(chunk)) {
+        result.chunks_.push_back(compileChunk(chunk));
+      } else {
+        result.chunks_.emplace_back(std::nullopt);
+      }
+    }
+    return result;
+  }
+
+  bool Jit::supports(const code::Chunk& chunk) const {
+    // Every value on the native stack is an F64, so PUSH may only ever see F64 constants
+    for (std::size_t i = 0; i != chunk.constantCount(); ++i) {
+      if (chunk.constantType(i) != code::PrimitiveType::F64) {
+        return false;
+      }
+    }
+
+    using enum code::Instruction;
+    const auto bytes = chunk.instructions();
+    for (std::size_t offset = 0; offset < bytes.size();) {
+      auto instruction = static_cast<code::Instruction>(bytes[offset]);
+      switch (instruction) {
+        case EXIT:
+          return true;
+        case PUSH:
+        case POP:
+        case F64_ADD:
+        case F64_SUB:
+        case F64_MUL:
+        case F64_DIV:
+        case F64_NEG:
+        case F64_AFF:
+        case PUSH2:
+        case PUSH_PUSH_F64_ADD:
+        case PUSH_PUSH_F64_SUB:
+        case PUSH_PUSH_F64_MUL:
+        case PUSH_PUSH_F64_DIV:
+        case PUSH_POP:
+        case F64_MUL_ADD:
+        case PUSH_F64_IMM:
+        case PUSH_WIDE:
+          offset += 1 + static_cast<std::size_t>(code::operandBytes(instruction));
+          break;
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  std::optional<NativeChunk> Jit::compileChunk(const code::Chunk& chunk) {
+    chunk_ = &chunk;
+    native_.clear();
+
+    using enum code::Instruction;
+    const auto write = std::bit_cast<std::uint64_t>(&writeF64);
+    const auto bytes = chunk.instructions();
+    copy(PROLOGUE);
+    for (std::size_t offset = 0;;) {
+      auto instruction = static_cast<code::Instruction>(bytes[offset]);
+      switch (instruction) {
+        case EXIT:
+          copy(EPILOGUE);
+          return load();
+        case PUSH:
+          emitPush(bytes[offset + 1]);
+          break;
+        case PUSH2:
+          emitPush(bytes[offset + 1]);
+          emitPush(bytes[offset + 2]);
+          break;
+        case PUSH_WIDE:
+          emitPush(code::readOperand<std::uint16_t>(&bytes[offset + 1]));
+          break;
+        case PUSH_F64_IMM:
+          // The stencil takes the bits of the F64, which are exactly the operand bytes
+          patch(copy(PUSH_STENCIL) + PUSH_CONSTANT, code::readOperand<std::uint64_t>(&bytes[offset + 1]));
+          break;
+        case F64_ADD:
+        case F64_SUB:
+        case F64_MUL:
+        case F64_DIV:
+          patch(copy(BINARY_STENCIL) + BINARY_OPERATION, sseOperation(instruction));
+          break;
+        case F64_NEG:
+          copy(NEG_STENCIL);
+          break;
+        case F64_AFF:
+          break;  // This is a No-Op
+        case PUSH_PUSH_F64_ADD:
+        case PUSH_PUSH_F64_SUB:
+        case PUSH_PUSH_F64_MUL:
+        case PUSH_PUSH_F64_DIV: {
+          auto start = copy(PUSH_PUSH_STENCIL);
+          patch(start + PUSH_PUSH_LHS, std::bit_cast<std::uint64_t>(chunk.f64Constant(bytes[offset + 1])));
+          patch(start + PUSH_PUSH_RHS, std::bit_cast<std::uint64_t>(chunk.f64Constant(bytes[offset + 2])));
+          patch(start + PUSH_PUSH_OPERATION, sseOperation(instruction));
+          break;
+        }
+        case F64_MUL_ADD:
+          copy(MUL_ADD_STENCIL);
+          break;
+        case POP:
+          patch(copy(POP_STENCIL) + POP_WRITE, write);
+          break;
+        case PUSH_POP: {
+          auto start = copy(PUSH_POP_STENCIL);
+          patch(start + PUSH_POP_CONSTANT, std::bit_cast<std::uint64_t>(chunk.f64Constant(bytes[offset + 1])));
+          patch(start + PUSH_POP_WRITE, write);
+          break;
+        }
+        default:
+          return std::nullopt;
+      }
+      offset += 1 + static_cast<std::size_t>(code::operandBytes(instruction));
+    }
+  }
+
+  std::size_t Jit::copy(std::span<const std::uint8_t> stencil) {
+    auto start = native_.size();
+    // Not insert, which GCC 12 wrongly warns overflows the vector once compileChunk has cleared it and inlined this
+    native_.resize(start + stencil.size());
+    std::memcpy(native_.data() + start, stencil.data(), stencil.size());
+    return start;
+  }
+
+  void Jit::patch(std::size_t offset, std::uint64_t value) {
+    // x86-64 immediates are little endian, like the host
+    std::memcpy(native_.data() + offset, &value, sizeof(value));
+  }
+
+  void Jit::patch(std::size_t offset, std::uint8_t value) { native_[offset] = value; }
+
+  void Jit::emitPush(std::size_t constant) {
+    patch(copy(PUSH_STENCIL) + PUSH_CONSTANT, std::bit_cast<std::uint64_t>(chunk_->f64Constant(constant)));
+  }
+
+  std::optional<NativeChunk> Jit::load() const {
+#if FLUIR_VM_JIT_X86_64
+    const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t mapped = (native_.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      return std::nullopt;
+    }
+    std::memcpy(memory, native_.data(), native_.size());
+    // Never writable and executable at the same time
+    if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+      munmap(memory, mapped);
+      return std::nullopt;
+    }
+    return NativeChunk{memory, mapped, native_.size()};
+#else
+    return std::nullopt;
+#endif
+  }
+}  // namespace fluir
@@ -0,0 +1,196 @@
+#include "vm/utility/kernels.hpp"
+
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+#include "vm/utility/narrow_widen.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+// Builds an AVX2 and a baseline version of the kernel and resolves between them once, when the program loads
+#define FLUIR_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define FLUIR_KERNEL
+#endif
+
+namespace fluir::kernels {
+  namespace {
+#if defined(__GNUC__)
+    constexpr std::size_t LANES = 4;
+
+    // One AVX2 register, or a pair of SSE2 registers on the baseline
+    using F64x4 = code::F64 __attribute__((vector_size(LANES * sizeof(code::F64))));
+    using I64x4 = code::I64 __attribute__((vector_size(LANES * sizeof(code::I64))));
+    using U64x4 = code::U64 __attribute__((vector_size(LANES * sizeof(code::U64))));
+
+    template <typename Scalar>
+    struct Vector;
+    template <>
+    struct Vector<code::F64> {
+      using type = F64x4;
+    };
+    template <>
+    struct Vector<code::I64> {
+      using type = I64x4;
+    };
+    template <>
+    struct Vector<code::U64> {
+      using type = U64x4;
+    };
+    template <typename Scalar>
+    using VectorOf = typename Vector<Scalar>::type;
+
+    template <typename Vector>
+    [[gnu::always_inline]] inline void load(Vector& vector, const std::uint64_t* lanes) {
+      std::memcpy(&vector, lanes, sizeof(vector));
+    }
+
+    template <typename Vector>
+    [[gnu::always_inline]] inline void store(std::uint64_t* lanes, const Vector& vector) {
+      std::memcpy(lanes, &vector, sizeof(vector));
+    }
+#endif
+
+    /* Converts each lane of from to the type of to */
+    template <typename To, typename From>
+    [[gnu::always_inline]] inline void convert(To& to, const From& from) {
+#if defined(__GNUC__)
+      if constexpr (!std::is_arithmetic_v<From>) {
+        to = __builtin_convertvector(from, To);
+      } else
+#endif
+      {
+        to = static_cast<To>(from);
+      }
+    }
+
+    /* Applies op(lhs, rhs), which updates lhs in place, to whole vectors and then to the scalar tail. Without vector
+     * extensions every row goes through the scalar loop. op must work on both vectors and Scalars, which it takes by
+     * reference so no vector is passed by value between functions built for different instruction sets. */
+    template <typename Scalar, typename Op>
+    [[gnu::always_inline]] inline void binary(Lanes lhs, ConstLanes rhs, Op op) {
+      const std::size_t rows = lhs.size();
+      std::size_t row = 0;
+#if defined(__GNUC__)
+      for (; row + LANES <= rows; row += LANES) {
+        VectorOf<Scalar> values, operands;
+        load(values, lhs.data() + row);
+        load(operands, rhs.data() + row);
+        op(values, operands);
+        store(lhs.data() + row, values);
+      }
+#endif
+      for (; row != rows; ++row) {
+        auto value = std::bit_cast<Scalar>(lhs[row]);
+        op(value, std::bit_cast<Scalar>(rhs[row]));
+        lhs[row] = std::bit_cast<std::uint64_t>(value);
+      }
+    }
+
+    /* Applies op(out, in), which writes the To result of a From value to out, to every row like binary */
+    template <typename From, typename To, typename Op>
+    [[gnu::always_inline]] inline void unary(Lanes values, Op op) {
+      const std::size_t rows = values.size();
+      std::size_t row = 0;
+#if defined(__GNUC__)
+      for (; row + LANES <= rows; row += LANES) {
+        VectorOf<From> operands;
+        VectorOf<To> result;
+        load(operands, values.data() + row);
+        op(result, operands);
+        store(values.data() + row, result);
+      }
+#endif
+      for (; row != rows; ++row) {
+        To result;
+        op(result, std::bit_cast<From>(values[row]));
+        values[row] = std::bit_cast<std::uint64_t>(result);
+      }
+    }
+
+    constexpr auto cast = [](auto& out, const auto& value) { convert(out, value); };
+
+    /* Division has no vector instruction for integers, and every divisor has to be checked anyway */
+    template <typename Scalar>
+    bool divide(Lanes lhs, ConstLanes rhs) {
+      utility::checkedDivide<Scalar> op;
+      for (std::size_t row = 0; row != lhs.size(); ++row) {
+        Scalar quotient;
+        if (!op(std::bit_cast<Scalar>(lhs[row]), std::bit_cast<Scalar>(rhs[row]), quotient)) {
+          return false;
+        }
+        lhs[row] = std::bit_cast<std::uint64_t>(quotient);
+      }
+      return true;
+    }
+
+    int shiftFor(code::NumericWidth width) {
+      switch (width) {
+        case code::WIDTH_8:
+          return 56;
+        case code::WIDTH_16:
+          return 48;
+        case code::WIDTH_32:
+          return 32;
+        default:
+          return 0;
+      }
+    }
+  }  // namespace
+
+  FLUIR_KERNEL void addF64(Lanes lhs, ConstLanes rhs) {
+    binary<code::F64>(lhs, rhs, [](auto& l, const auto& r) { l = l + r; });
+  }
+  FLUIR_KERNEL void subF64(Lanes lhs, ConstLanes rhs) {
+    binary<code::F64>(lhs, rhs, [](auto& l, const auto& r) { l = l - r; });
+  }
+  FLUIR_KERNEL void mulF64(Lanes lhs, ConstLanes rhs) {
+    binary<code::F64>(lhs, rhs, [](auto& l, const auto& r) { l = l * r; });
+  }
+  FLUIR_KERNEL void divF64(Lanes lhs, ConstLanes rhs) {
+    binary<code::F64>(lhs, rhs, [](auto& l, const auto& r) { l = l / r; });
+  }
+  FLUIR_KERNEL void negF64(Lanes values) {
+    unary<code::F64, code::F64>(values, [](auto& out, const auto& value) { out = -value; });
+  }
+
+  FLUIR_KERNEL void addInt(Lanes lhs, ConstLanes rhs) {
+    binary<code::U64>(lhs, rhs, [](auto& l, const auto& r) { l = l + r; });
+  }
+  FLUIR_KERNEL void subInt(Lanes lhs, ConstLanes rhs) {
+    binary<code::U64>(lhs, rhs, [](auto& l, const auto& r) { l = l - r; });
+  }
+  FLUIR_KERNEL void mulInt(Lanes lhs, ConstLanes rhs) {
+    binary<code::U64>(lhs, rhs, [](auto& l, const auto& r) { l = l * r; });
+  }
+  FLUIR_KERNEL void negInt(Lanes values) {
+    unary<code::U64, code::U64>(values, [](auto& out, const auto& value) { out = 0 - value; });
+  }
+  bool divI64(Lanes lhs, ConstLanes rhs) { return divide<code::I64>(lhs, rhs); }
+  bool divU64(Lanes lhs, ConstLanes rhs) { return divide<code::U64>(lhs, rhs); }
+
+  FLUIR_KERNEL void narrowI(Lanes values, code::NumericWidth width) {
+    const int shift = shiftFor(width);
+    if (shift == 0) {
+      return;
+    }
+    // Shift the value to the top and arithmetic shift it back down to sign extend it
+    unary<code::U64, code::I64>(values, [shift](auto& out, const auto& value) {
+      convert(out, value << shift);
+      out = out >> shift;
+    });
+  }
+  FLUIR_KERNEL void narrowU(Lanes values, code::NumericWidth width) {
+    const int shift = shiftFor(width);
+    if (shift == 0) {
+      return;
+    }
+    const code::U64 mask = ~code::U64{0} >> shift;
+    unary<code::U64, code::U64>(values, [mask](auto& out, const auto& value) { out = value & mask; });
+  }
+
+  FLUIR_KERNEL void castIF(Lanes values) { unary<code::I64, code::F64>(values, cast); }
+  FLUIR_KERNEL void castUF(Lanes values) { unary<code::U64, code::F64>(values, cast); }
+  FLUIR_KERNEL void castFI(Lanes values) { unary<code::F64, code::I64>(values, cast); }
+  FLUIR_KERNEL void castFU(Lanes values) { unary<code::F64, code::U64>(values, cast); }
+}  // namespace fluir::kernels
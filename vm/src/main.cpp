@@ -1,24 +1,103 @@
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
 
-#include "vm/decoder/decode.hpp"
+#include "vm/jit.hpp"
+#include "vm/profiler.hpp"
+#include "vm/program.hpp"
+#include "vm/sampler.hpp"
 #include "vm/vm.hpp"
 
+namespace {
+  struct Options {
+    bool jit{false};
+    /** Print an opcode histogram to standard error once the program exits */
+    bool profile{false};
+    /** Where to write the opcode histogram as JSON, if anywhere */
+    std::string profileJson{};
+    /** Print the flow graph nodes the program spends its time in to standard error once it exits */
+    bool sample{false};
+    /** Where to write the samples as folded stacks, if anywhere */
+    std::string sampleFolded{};
+    std::string file{};
+  };
+
+  bool parse(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+      std::string_view argument{argv[i]};
+      if (argument == "--jit") {
+        options.jit = true;
+      } else if (argument == "--profile") {
+        options.profile = true;
+      } else if (argument == "--profile-json" && i + 1 < argc) {
+        options.profileJson = argv[++i];
+      } else if (argument == "--sample") {
+        options.sample = true;
+      } else if (argument == "--sample-folded" && i + 1 < argc) {
+        options.sampleFolded = argv[++i];
+      } else if (!argument.starts_with("--") && options.file.empty()) {
+        options.file = argument;
+      } else {
+        return false;
+      }
+    }
+    return !options.file.empty();
+  }
+}  // namespace
+
 int main(int argc, char** argv) {
   // TODO: Make this work better and add other flags
-  if (argc != 2) {
-    std::cerr << "Usage: fluir <file to execute>.\n";
+  Options options;
+  if (!parse(argc, argv, options)) {
+    std::cerr << "Usage: fluir [--jit] [--profile] [--profile-json <output file>] [--sample] [--sample-folded <output "
+                 "file>] <file to execute>.\n";
     return -1;
   }
 
-  std::ifstream fin(argv[1]);
-  std::stringstream contents;
-  contents << fin.rdbuf();
-
-  auto bytecode = fluir::decode(contents.str());
   fluir::VirtualMachine vm;
-  auto result = vm.execute(&bytecode);
+  fluir::Profiler profiler;
+  fluir::SamplingProfiler sampler;
+  const bool profile = options.profile || !options.profileJson.empty();
+  const bool sample = options.sample || !options.sampleFolded.empty();
+  fluir::ExecResult result;
+  try {
+    // Binary files run straight out of the mapped file, and only the chunks the run enters are decoded, fused and
+    // verified. Of those, only the chunks fusing changes are copied.
+    const auto program = fluir::LazyProgram::open(options.file);
+    const auto& verified = program.enter(program.entry());
+    // Native code is not instrumented, so profiling and sampling always interpret
+    if (options.jit && !profile && !sample) {
+      result = vm.execute(fluir::compile(verified));
+    } else {
+      if (sample && !sampler.start()) {
+        std::cerr << "Could not start the sampling timer.\n";
+      }
+      result = vm.execute(verified,
+                          {.profiler = profile ? &profiler : nullptr, .sampler = sample ? &sampler : nullptr});
+      sampler.stop();
+    }
+  } catch (const std::runtime_error& e) {
+    // Files which cannot be read, are malformed or fail verification
+    std::cerr << e.what() << '\n';
+    result = fluir::ExecResult::ERROR;
+  }
+
+  if (options.profile) {
+    profiler.writeText(std::cerr);
+  }
+  if (!options.profileJson.empty()) {
+    std::ofstream json(options.profileJson);
+    profiler.writeJson(json);
+  }
+  if (options.sample) {
+    sampler.writeText(std::cerr);
+  }
+  if (!options.sampleFolded.empty()) {
+    std::ofstream folded(options.sampleFolded);
+    sampler.writeFolded(folded);
+  }
   return static_cast<std::underlying_type_t<fluir::ExecResult>>(result);
 }
@@ -0,0 +1,91 @@
+#include "vm/mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__)
+#define FLUIR_VM_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define FLUIR_VM_MMAP 0
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace fluir {
+  namespace {
+    std::runtime_error failure(std::string_view action, const std::string& path) {
+      return std::runtime_error(std::format("Could not {} '{}': {}", action, path, std::strerror(errno)));
+    }
+  }  // namespace
+
+  MappedFile::MappedFile(const std::string& path) {
+#if FLUIR_VM_MMAP
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+      throw failure("open", path);
+    }
+    struct stat status{};
+    if (::fstat(descriptor, &status) != 0) {
+      auto error = failure("read the size of", path);
+      ::close(descriptor);
+      throw error;
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    // Mapping nothing is an error, but an empty file is just empty
+    if (size_ != 0) {
+      void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (mapping == MAP_FAILED) {
+        auto error = failure("map", path);
+        ::close(descriptor);
+        throw error;
+      }
+      data_ = static_cast<const std::uint8_t*>(mapping);
+    }
+    // The mapping holds its own reference to the file
+    ::close(descriptor);
+#else
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+      throw failure("open", path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    if (file.bad()) {
+      throw failure("read", path);
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+  }
+
+  // Moving the buffer keeps its storage, so data_ still points into it
+  MappedFile::MappedFile(MappedFile&& other) noexcept :
+    data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+    buffer_(std::move(other.buffer_)) { }
+
+  MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+  }
+
+  MappedFile::~MappedFile() { unmap(); }
+
+  void MappedFile::unmap() {
+#if FLUIR_VM_MMAP
+    if (data_ != nullptr) {
+      ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+#endif
+  }
+}  // namespace fluir
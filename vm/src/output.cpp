@@ -0,0 +1,73 @@
+#include "vm/output.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <ostream>
+#include <type_traits>
+
+namespace fluir {
+  RingBufferSink::RingBufferSink(std::size_t capacity) :
+    values_(std::max<std::size_t>(capacity, 1), code::Value{0.0}) { }
+
+  void RingBufferSink::write(const code::Value& value) {
+    if (size_ == values_.size()) {
+      values_[first_] = value;
+      first_ = (first_ + 1) % values_.size();
+      ++overwritten_;
+      return;
+    }
+    values_[(first_ + size_) % values_.size()] = value;
+    ++size_;
+  }
+
+  void RingBufferSink::clear() {
+    first_ = 0;
+    size_ = 0;
+    overwritten_ = 0;
+  }
+
+  TextSink::TextSink(std::ostream* target, std::size_t capacity) :
+    target_(target), capacity_(std::max(capacity, MAX_VALUE_LENGTH)) { }
+
+  void TextSink::write(const code::Value& value) {
+    if (buffer_.size() - used_ < MAX_VALUE_LENGTH) {
+      if (target_ != nullptr && used_ != 0) {
+        flush();
+      } else {
+        buffer_.resize(std::max(capacity_, buffer_.size() * 2));
+      }
+    }
+    used_ = static_cast<std::size_t>(format(value, buffer_.data() + used_) - buffer_.data());
+  }
+
+  void TextSink::flush() {
+    if (target_ != nullptr) {
+      target_->write(buffer_.data(), static_cast<std::streamsize>(used_));
+      used_ = 0;
+    }
+  }
+
+  char* format(const code::Value& value, char* out) {
+    char* const last = out + TextSink::MAX_VALUE_LENGTH - 1;
+    // Floats keep the six significant digits of iostreams, so the text matches what POP used to print
+    const auto number = [last](char* first, auto concrete) {
+      if constexpr (std::is_floating_point_v<decltype(concrete)>) {
+        return std::to_chars(first, last, concrete, std::chars_format::general, 6).ptr;
+      } else {
+        return std::to_chars(first, last, concrete).ptr;
+      }
+    };
+    switch (value.type()) {
+#define FLUIR_FORMAT_VALUE(Type, Concrete)                             \
+  case code::PrimitiveType::Type:                                      \
+    out = std::ranges::copy(std::string_view{"(" #Type ")"}, out).out; \
+    out = number(out, value.uncheckedAs##Type());                      \
+    break;
+
+      FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_FORMAT_VALUE)
+#undef FLUIR_FORMAT_VALUE
+    }
+    *out++ = '\n';
+    return out;
+  }
+}  // namespace fluir
@@ -0,0 +1,63 @@
+#include "vm/pool.hpp"
+
+#include <utility>
+
+namespace fluir {
+  namespace {
+    std::unique_ptr<VirtualMachine> prepare() {
+      auto vm = std::make_unique<VirtualMachine>();
+      vm->reserve();
+      return vm;
+    }
+  }  // namespace
+
+  VmPool::Lease::Lease(Lease&& other) noexcept : pool_(other.pool_), vm_(std::move(other.vm_)) { }
+
+  VmPool::Lease& VmPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+      if (vm_ != nullptr) {
+        pool_->release(std::move(vm_));
+      }
+      pool_ = other.pool_;
+      vm_ = std::move(other.vm_);
+    }
+    return *this;
+  }
+
+  VmPool::Lease::~Lease() {
+    // A moved from lease no longer owns a VM
+    if (vm_ != nullptr) {
+      pool_->release(std::move(vm_));
+    }
+  }
+
+  VmPool::VmPool(std::size_t prepared) {
+    idle_.reserve(prepared);
+    for (std::size_t i = 0; i != prepared; ++i) {
+      idle_.push_back(prepare());
+    }
+  }
+
+  VmPool::Lease VmPool::acquire() {
+    {
+      std::lock_guard lock{mutex_};
+      if (!idle_.empty()) {
+        auto vm = std::move(idle_.back());
+        idle_.pop_back();
+        return Lease{*this, std::move(vm)};
+      }
+    }
+    // Allocate outside the lock so other threads can keep acquiring and releasing meanwhile
+    return Lease{*this, prepare()};
+  }
+
+  std::size_t VmPool::idle() const {
+    std::lock_guard lock{mutex_};
+    return idle_.size();
+  }
+
+  void VmPool::release(std::unique_ptr<VirtualMachine> vm) {
+    std::lock_guard lock{mutex_};
+    idle_.push_back(std::move(vm));
+  }
+}  // namespace fluir
@@ -0,0 +1,57 @@
+#include "vm/profiler.hpp"
+
+#include <algorithm>
+#include <format>  // Use format in VM instead of fmt to reduce dependencies of the runtime
+#include <ostream>
+
+namespace fluir {
+  std::vector<Profiler::Entry> Profiler::histogram() const {
+    std::vector<Entry> entries;
+    for (std::size_t i = 0; i != counters_.size(); ++i) {
+      if (counters_[i].executions != 0) {
+        entries.push_back(Entry{.instruction = static_cast<code::Instruction>(i),
+                                .executions = counters_[i].executions,
+                                .ticks = counters_[i].ticks});
+      }
+    }
+    std::ranges::stable_sort(entries, std::ranges::greater{}, &Entry::ticks);
+    return entries;
+  }
+
+  void Profiler::writeText(std::ostream& out) const {
+    const auto entries = histogram();
+    std::uint64_t total = 0;
+    for (const auto& entry : entries) {
+      total += entry.ticks;
+    }
+    out << std::format(
+      "{:<20} {:>14} {:>16} {:>12} {:>7}\n", "INSTRUCTION", "EXECUTIONS", "TICKS", "TICKS/EXEC", "SHARE");
+    for (const auto& entry : entries) {
+      out << std::format("{:<20} {:>14} {:>16} {:>12.1f} {:>6.1f}%\n",
+                         code::instructionName(entry.instruction),
+                         entry.executions,
+                         entry.ticks,
+                         static_cast<double>(entry.ticks) / static_cast<double>(entry.executions),
+                         total == 0 ? 0.0 : 100.0 * static_cast<double>(entry.ticks) / static_cast<double>(total));
+    }
+    out << std::format("Ticks are counted with {}.\n", CLOCK);
+  }
+
+  void Profiler::writeJson(std::ostream& out) const {
+    const auto entries = histogram();
+    std::uint64_t total = 0;
+    for (const auto& entry : entries) {
+      total += entry.ticks;
+    }
+    out << std::format(R"({{"clock":"{}","ticks":{},"instructions":[)", CLOCK, total);
+    for (std::size_t i = 0; i != entries.size(); ++i) {
+      out << std::format(R"({}{{"name":"{}","opcode":{},"executions":{},"ticks":{}}})",
+                         i == 0 ? "" : ",",
+                         code::instructionName(entries[i].instruction),
+                         static_cast<unsigned>(entries[i].instruction),
+                         entries[i].executions,
+                         entries[i].ticks);
+    }
+    out << "]}\n";
+  }
+}  // namespace fluir
@@ -0,0 +1,82 @@
+#include "vm/program.hpp"
+
+#include <format>
+
+#include "vm/decoder/decode.hpp"
+#include "vm/exceptions.hpp"
+#include "vm/fuser.hpp"
+#include "vm/mapped_file.hpp"
+
+namespace fluir {
+  LoadedProgram LoadedProgram::load(code::ByteCode code) {
+    return LoadedProgram{std::make_shared<const Loaded>(std::move(code))};
+  }
+
+  LazyProgram::Lazy::Lazy(code::ByteCode loaded, std::optional<BinaryDecoder> chunkDecoder) :
+    code(std::move(loaded)),
+    decoder(std::move(chunkDecoder)),
+    loaded(std::make_unique<std::once_flag[]>(code.chunks.size())),
+    entered(std::make_unique<std::atomic<bool>[]>(code.chunks.size())) { }
+
+  LazyProgram::LazyProgram(std::shared_ptr<Lazy> lazy) : lazy_(std::move(lazy)) {
+    // Only the chunks entered so far may be executed
+    lazy_->verified = VerifiedCode{lazy_->code, lazy_->entered.get()};
+  }
+
+  LazyProgram LazyProgram::open(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    if (!file->text().starts_with(code::FILETYPE_BINARY)) {
+      return load(decode(file->text()));
+    }
+    BinaryDecoder decoder;
+    auto directory = decoder.decodeDirectory(file->bytes());
+    // Files without a directory can only be decoded all at once
+    auto code = directory ? std::move(*directory) : decoder.decodeInPlace(file->bytes());
+    code.storage = std::move(file);
+    return LazyProgram{
+      std::make_shared<Lazy>(std::move(code), directory ? std::optional{std::move(decoder)} : std::nullopt)};
+  }
+
+  LazyProgram LazyProgram::load(code::ByteCode code) {
+    return LazyProgram{std::make_shared<Lazy>(std::move(code), std::nullopt)};
+  }
+
+  std::optional<std::size_t> LazyProgram::find(std::string_view name) const {
+    for (std::size_t i = 0; i != lazy_->code.chunks.size(); ++i) {
+      if ((lazy_->decoder ? lazy_->decoder->chunkName(i) : lazy_->code.chunks[i].name) == name) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+
+  bool LazyProgram::entered(std::size_t index) const {
+    return index < lazy_->code.chunks.size() && lazy_->entered[index].load(std::memory_order_acquire);
+  }
+
+  const VerifiedCode& LazyProgram::enter(std::size_t index) const {
+    if (index >= lazy_->code.chunks.size()) {
+      throw VerificationError{std::format(
+        "Invalid bytecode. There is no chunk x{:X} to enter; there are {} chunks.", index, lazy_->code.chunks.size())};
+    }
+    materialize(index);
+    // The scheduler runs each subgraph as a chunk of its own, but never the subgraphs of those chunks
+    for (const auto& subgraph : lazy_->code.chunks[index].subgraphs) {
+      materialize(subgraph.chunk);
+    }
+    return *lazy_->verified;
+  }
+
+  void LazyProgram::materialize(std::size_t index) const {
+    // A chunk which fails to decode or verify is tried again the next time it is entered, and fails the same way
+    std::call_once(lazy_->loaded[index], [&] {
+      auto& code = lazy_->code;
+      if (lazy_->decoder) {
+        code.chunks[index] = lazy_->decoder->decodeChunk(index);
+      }
+      Fuser{}.fuse(code, index);
+      Verifier{}.verify(code, index);
+      lazy_->entered[index].store(true, std::memory_order_release);
+    });
+  }
+}  // namespace fluir
@@ -0,0 +1,150 @@
+#include "vm/sampler.hpp"
+
+#if defined(__unix__)
+#define FLUIR_VM_SAMPLER_TIMER 1
+#include <signal.h>
+#include <sys/time.h>
+#else
+#define FLUIR_VM_SAMPLER_TIMER 0
+#endif
+
+#include <algorithm>
+#include <format>  // Use format in VM instead of fmt to reduce dependencies of the runtime
+#include <ostream>
+
+namespace fluir {
+  namespace {
+    std::string describe(const code::DebugEntry& node) {
+      if (node.node == 0) {
+        return "<no debug info>";
+      }
+      return std::format("node {} ({},{})", node.node, node.x, node.y);
+    }
+
+#if FLUIR_VM_SAMPLER_TIMER
+    /** The handler SIGPROF had before the sampler started, restored once it stops */
+    struct sigaction previousHandler {};
+
+    extern "C" void onSample(int) { SamplingProfiler::request(); }
+#endif
+  }  // namespace
+
+  std::atomic<bool> SamplingProfiler::pending_{false};
+
+  SamplingProfiler::SamplingProfiler(std::chrono::microseconds interval) : interval_(interval) { }
+
+  SamplingProfiler::~SamplingProfiler() { stop(); }
+
+  bool SamplingProfiler::available() { return FLUIR_VM_SAMPLER_TIMER != 0; }
+
+  bool SamplingProfiler::start() {
+    if (started_) {
+      return true;
+    }
+#if FLUIR_VM_SAMPLER_TIMER
+    struct sigaction action {};
+    action.sa_handler = onSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &previousHandler) != 0) {
+      return false;
+    }
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval_);
+    itimerval timer{};
+    timer.it_interval.tv_sec = static_cast<time_t>(seconds.count());
+    timer.it_interval.tv_usec = static_cast<suseconds_t>((interval_ - seconds).count());
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+      sigaction(SIGPROF, &previousHandler, nullptr);
+      return false;
+    }
+    started_ = true;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void SamplingProfiler::stop() {
+    if (!started_) {
+      return;
+    }
+#if FLUIR_VM_SAMPLER_TIMER
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previousHandler, nullptr);
+#endif
+    pending_.store(false, std::memory_order_relaxed);
+    started_ = false;
+  }
+
+  void SamplingProfiler::sample(const code::Chunk& chunk, std::size_t offset, std::uint8_t instruction) {
+    // The entry the offset belongs to is the last one starting at or before it
+    const auto after = std::ranges::upper_bound(chunk.debug, offset, std::ranges::less{}, &code::DebugEntry::offset);
+    const auto node = after == chunk.debug.begin() ? code::DebugEntry{} : *std::prev(after);
+
+    std::scoped_lock lock{mutex_};
+    auto& counter = samples_[Key{chunk.name, node.node, instruction}];
+    counter.node = node;
+    ++counter.samples;
+  }
+
+  std::vector<SamplingProfiler::Hotspot> SamplingProfiler::hotspots() const {
+    std::vector<Hotspot> hotspots;
+    {
+      std::scoped_lock lock{mutex_};
+      // Samples are ordered by chunk and node, so those of the same node are next to each other
+      for (const auto& [key, counter] : samples_) {
+        const auto& chunk = std::get<0>(key);
+        if (hotspots.empty() || hotspots.back().chunk != chunk || hotspots.back().node.node != counter.node.node) {
+          hotspots.push_back(Hotspot{.chunk = chunk, .node = counter.node, .samples = 0});
+        }
+        hotspots.back().samples += counter.samples;
+      }
+    }
+    std::ranges::stable_sort(hotspots, std::ranges::greater{}, &Hotspot::samples);
+    return hotspots;
+  }
+
+  std::uint64_t SamplingProfiler::total() const {
+    std::scoped_lock lock{mutex_};
+    std::uint64_t total = 0;
+    for (const auto& [key, counter] : samples_) {
+      total += counter.samples;
+    }
+    return total;
+  }
+
+  void SamplingProfiler::clear() {
+    std::scoped_lock lock{mutex_};
+    samples_.clear();
+  }
+
+  void SamplingProfiler::writeText(std::ostream& out) const {
+    const auto entries = hotspots();
+    const auto all = total();
+    out << std::format("{:<24} {:<20} {:>20} {:>10} {:>7}\n", "NODE", "CHUNK", "LOCATION", "SAMPLES", "SHARE");
+    for (const auto& entry : entries) {
+      const auto& node = entry.node;
+      out << std::format("{:<24} {:<20} {:>20} {:>10} {:>6.1f}%\n",
+                         node.node == 0 ? std::string{"<no debug info>"} : std::format("node {}", node.node),
+                         entry.chunk,
+                         std::format("{},{},{} {}x{}", node.x, node.y, node.z, node.width, node.height),
+                         entry.samples,
+                         all == 0 ? 0.0 : 100.0 * static_cast<double>(entry.samples) / static_cast<double>(all));
+    }
+    out << std::format("{} samples every {}us of CPU time.\n", all, interval_.count());
+  }
+
+  void SamplingProfiler::writeFolded(std::ostream& out) const {
+    std::scoped_lock lock{mutex_};
+    for (const auto& [key, counter] : samples_) {
+      out << std::format("{};{};{} {}\n",
+                         std::get<0>(key),
+                         describe(counter.node),
+                         code::instructionName(std::get<2>(key)),
+                         counter.samples);
+    }
+  }
+}  // namespace fluir
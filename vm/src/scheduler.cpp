@@ -0,0 +1,107 @@
+#include "vm/scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <vector>
+
+namespace fluir {
+  namespace {
+    /** Keeps what a subgraph writes until every subgraph before it has written its own */
+    class Recording final : public OutputSink {
+     public:
+      void write(const code::Value& value) override { values_.push_back(value); }
+      void replay(OutputSink& output) const {
+        for (const auto& value : values_) {
+          output.write(value);
+        }
+      }
+
+     private:
+      std::vector<code::Value> values_;
+    };
+
+    struct SubgraphRun {
+      Recording output;
+      ExecResult result{ExecResult::SUCCESS};
+      std::optional<FaultReport> fault;
+      /** The number of dependencies which have not finished yet */
+      std::atomic<std::size_t> waiting{0};
+      /** Whether the subgraph failed or was skipped, in which case its dependents are skipped too */
+      std::atomic<bool> failed{false};
+    };
+  }  // namespace
+
+  ExecResult Scheduler::execute(const code::ByteCode& code, ExecOptions options) {
+    fault_.reset();
+    const auto entry = entryChunk(code, options);
+    if (entry >= code.chunks.size() || code.chunks[entry].subgraphs.empty()) {
+      auto vm = vms_.acquire();
+      const auto result = vm->execute(code, options);
+      fault_ = vm->viewFault();
+      return result;
+    }
+
+    const auto& subgraphs = code.chunks[entry].subgraphs;
+    std::vector<SubgraphRun> runs(subgraphs.size());
+    std::vector<std::vector<std::size_t>> dependents(subgraphs.size());
+    for (std::size_t i = 0; i != subgraphs.size(); ++i) {
+      runs[i].waiting = subgraphs[i].dependencies.size();
+      for (auto dependency : subgraphs[i].dependencies) {
+        // The table has not been verified. Like the Verifier, require dependencies to come first, which also rules out
+        // cycles that would never finish.
+        if (dependency >= i) {
+          return ExecResult::ERROR;
+        }
+        dependents[dependency].push_back(i);
+      }
+    }
+    std::latch done{static_cast<std::ptrdiff_t>(subgraphs.size())};
+
+    // Runs a subgraph, then starts every dependent which is no longer waiting on anything. Dependents are submitted
+    // from the worker, so they usually run on the same thread as the subgraph which freed them.
+    std::function<void(std::size_t)> run = [&](std::size_t i) {
+      auto& current = runs[i];
+      const bool skip = std::ranges::any_of(subgraphs[i].dependencies,
+                                            [&runs](std::size_t dependency) { return runs[dependency].failed.load(); });
+      if (skip) {
+        current.failed = true;
+      } else {
+        auto vm = vms_.acquire();
+        current.result = vm->execute(code, {.entry = subgraphs[i].chunk, .output = &current.output});
+        if (current.result != ExecResult::SUCCESS) {
+          current.fault = vm->viewFault();
+          current.failed = true;
+        }
+      }
+      for (auto dependent : dependents[i]) {
+        if (runs[dependent].waiting.fetch_sub(1) == 1) {
+          threads_.submit([&run, dependent] { run(dependent); });
+        }
+      }
+      done.count_down();
+    };
+    for (std::size_t i = 0; i != subgraphs.size(); ++i) {
+      if (subgraphs[i].dependencies.empty()) {
+        threads_.submit([&run, i] { run(i); });
+      }
+    }
+    done.wait();
+
+    TextSink console{&std::cout};
+    auto& output = options.output != nullptr ? *options.output : console;
+    // Running the chunk as a whole stops at the first failure, so nothing after it in the table is written
+    for (const auto& finished : runs) {
+      finished.output.replay(output);
+      if (finished.result != ExecResult::SUCCESS) {
+        output.flush();
+        fault_ = finished.fault;
+        return finished.result;
+      }
+    }
+    output.flush();
+    return ExecResult::SUCCESS;
+  }
+}  // namespace fluir
@@ -0,0 +1,128 @@
+#include "vm/thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <latch>
+
+namespace fluir {
+  namespace {
+    /** The pool the current thread works for and its queue, if the thread is a worker */
+    thread_local ThreadPool const* currentPool = nullptr;
+    thread_local std::size_t currentQueue = 0;
+  }  // namespace
+
+  ThreadPool::ThreadPool(std::size_t threads) {
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i != threads; ++i) {
+      queues_.push_back(std::make_unique<Queue>());
+    }
+    // Only start the workers once every queue exists, since they steal from each other
+    for (std::size_t i = 0; i != threads; ++i) {
+      threads_.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard lock{sleep_};
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void ThreadPool::submit(Task task) { enqueue(std::move(task), true); }
+
+  void ThreadPool::defer(Task task) { enqueue(std::move(task), false); }
+
+  void ThreadPool::forEach(std::size_t count, const std::function<void(std::size_t)>& body) {
+    // A few batches per worker lets the workers even out batches which take longer than others by stealing
+    const auto batches = std::min(count, queues_.size() * 4);
+    if (batches == 0) {
+      return;
+    }
+    std::vector<std::exception_ptr> failures(batches);
+    std::latch done{static_cast<std::ptrdiff_t>(batches)};
+    for (std::size_t batch = 0; batch != batches; ++batch) {
+      submit([&, batch] {
+        try {
+          for (auto i = batch * count / batches; i != (batch + 1) * count / batches; ++i) {
+            body(i);
+          }
+        } catch (...) {
+          failures[batch] = std::current_exception();
+        }
+        done.count_down();
+      });
+    }
+    done.wait();
+    // Batches hold increasing indices, so the first batch which failed holds the lowest index which threw
+    for (const auto& failure : failures) {
+      if (failure) {
+        std::rethrow_exception(failure);
+      }
+    }
+  }
+
+  void ThreadPool::enqueue(Task task, bool back) {
+    const std::size_t index =
+      currentPool == this ? currentQueue : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      auto& queue = *queues_[index];
+      std::lock_guard lock{queue.mutex};
+      if (back) {
+        queue.tasks.push_back(std::move(task));
+      } else {
+        queue.tasks.push_front(std::move(task));
+      }
+    }
+    {
+      std::lock_guard lock{sleep_};
+      ++queued_;
+    }
+    wake_.notify_one();
+  }
+
+  void ThreadPool::work(std::size_t index) {
+    currentPool = this;
+    currentQueue = index;
+    for (;;) {
+      if (auto task = take(index)) {
+        (*task)();
+        continue;
+      }
+      std::unique_lock lock{sleep_};
+      wake_.wait(lock, [this] { return stopping_ || queued_ != 0; });
+      if (stopping_ && queued_ == 0) {
+        return;
+      }
+    }
+  }
+
+  std::optional<ThreadPool::Task> ThreadPool::take(std::size_t index) {
+    std::optional<Task> task;
+    {
+      auto& own = *queues_[index];
+      std::lock_guard lock{own.mutex};
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+      }
+    }
+    for (std::size_t i = 1; !task && i != queues_.size(); ++i) {
+      auto& victim = *queues_[(index + i) % queues_.size()];
+      std::lock_guard lock{victim.mutex};
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+      }
+    }
+    if (task) {
+      std::lock_guard lock{sleep_};
+      --queued_;
+    }
+    return task;
+  }
+}  // namespace fluir
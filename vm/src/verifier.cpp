@@ -0,0 +1,452 @@
+#include "vm/verifier.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include "vm/exceptions.hpp"
+#include "vm/utility/narrow_widen.hpp"
+#include "vm/vm.hpp"
+
+namespace fluir {
+  namespace {
+    bool isAny(code::PrimitiveType) { return true; }
+    template <code::PrimitiveType Type>
+    bool is(code::PrimitiveType type) {
+      return type == Type;
+    }
+
+    std::string_view typeName(code::PrimitiveType type) {
+      switch (type) {
+#define FLUIR_TYPE_NAME(Type, Concrete) \
+  case code::PrimitiveType::Type:       \
+    return #Type;
+
+        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_TYPE_NAME)
+#undef FLUIR_TYPE_NAME
+      }
+      return "<UNKNOWN>";
+    }
+  }  // namespace
+
+  VerifiedCode verify(const code::ByteCode& code) { return Verifier{}.verify(code); }
+
+  VerifiedCode Verifier::verify(const code::ByteCode& code) {
+    usesRegisters_ = code::usesRegisters(code.header);
+    if (code.chunks.empty()) {
+      throw VerificationError{"Invalid bytecode. There are no chunks to execute."};
+    }
+    verifyEntry(code);
+    for (const auto& chunk : code.chunks) {
+      verifyChunk(chunk);
+      verifyDebug(chunk);
+    }
+    for (std::size_t index = 0; index != code.chunks.size(); ++index) {
+      verifySubgraphs(code, index);
+    }
+    return VerifiedCode{code};
+  }
+
+  void Verifier::verify(const code::ByteCode& code, std::size_t index) {
+    usesRegisters_ = code::usesRegisters(code.header);
+    verifyEntry(code);
+    const auto& chunk = code.chunks.at(index);
+    verifyChunk(chunk);
+    verifyDebug(chunk);
+    verifySubgraphs(code, index);
+  }
+
+  void Verifier::verifyEntry(const code::ByteCode& code) {
+    if (code.header.entryOffset >= code.chunks.size()) {
+      throw VerificationError{std::format("Invalid bytecode. The entry chunk x{:X} is not one of the {} chunks.",
+                                          code.header.entryOffset,
+                                          code.chunks.size())};
+    }
+  }
+
+  void Verifier::verifySubgraphs(const code::ByteCode& code, std::size_t index) {
+    const auto& chunk = code.chunks[index];
+    for (std::size_t i = 0; i != chunk.subgraphs.size(); ++i) {
+      const auto& subgraph = chunk.subgraphs[i];
+      if (subgraph.chunk >= code.chunks.size() || subgraph.chunk == index) {
+        throw VerificationError{std::format(
+          "Invalid bytecode in chunk '{}': Subgraph {} refers to chunk x{:X}, which is not another chunk.",
+          chunk.name,
+          i,
+          subgraph.chunk)};
+      }
+      for (auto dependency : subgraph.dependencies) {
+        // Requiring dependencies to come first also rules out cycles
+        if (dependency >= i) {
+          throw VerificationError{std::format(
+            "Invalid bytecode in chunk '{}': Subgraph {} depends on subgraph {}, which does not come before it.",
+            chunk.name,
+            i,
+            dependency)};
+        }
+      }
+    }
+  }
+
+  void Verifier::verifyDebug(const code::Chunk& chunk) {
+    for (std::size_t i = 0; i != chunk.debug.size(); ++i) {
+      const auto offset = chunk.debug[i].offset;
+      if (offset >= chunk.instructions().size() || (i != 0 && offset <= chunk.debug[i - 1].offset)) {
+        throw VerificationError{std::format(
+          "Invalid bytecode in chunk '{}': Debug entry {} is at offset x{:X}, which is not in the code after the entry "
+          "before it.",
+          chunk.name,
+          i,
+          offset)};
+      }
+    }
+  }
+
+  void Verifier::verifyChunk(const code::Chunk& chunk) {
+    chunk_ = &chunk;
+    code_ = chunk.instructions();
+    offset_ = 0;
+    stack_.clear();
+
+    if (usesRegisters_) {
+      registers_.fill(std::nullopt);
+      for (std::size_t i = 0; i != std::min(chunk.constantCount(), registers_.size()); ++i) {
+        registers_[i] = chunk.constantType(i);
+      }
+      while (verifyRegisterInstruction()) {
+      }
+      return;
+    }
+
+    while (verifyInstruction()) {
+    }
+  }
+
+  bool Verifier::verifyInstruction() {
+    using enum code::Instruction;
+
+    if (offset_ >= code_.size()) {
+      fail("Code ends without an EXIT instruction.");
+    }
+    auto instruction = code_[offset_];
+    if (instruction >= code::INSTRUCTION_COUNT) {
+      fail(std::format("Unknown instruction x{:02X}.", instruction));
+    }
+    const auto operands = code::operandBytes(static_cast<code::Instruction>(instruction));
+    if (offset_ + operands >= code_.size()) {
+      fail("Missing operand.");
+    }
+
+    switch (instruction) {
+      case EXIT:
+        return false;
+      case PUSH:
+        push(constant(1));
+        break;
+      case PUSH2:
+        push(constant(1));
+        push(constant(2));
+        break;
+      case PUSH_POP:
+        constant(1);
+        break;
+      case PUSH_WIDE:
+        push(constantType(code::readOperand<std::uint16_t>(&code_[offset_ + 1])));
+        break;
+      case PUSH_F64_IMM:
+        push(code::PrimitiveType::F64);
+        break;
+      case PUSH_I64_IMM:
+      case PUSH_SMALL_INT:
+        push(code::PrimitiveType::I64);
+        break;
+      case POP:
+        pop("a value", isAny);
+        break;
+      case PUSH_PUSH_F64_ADD:
+      case PUSH_PUSH_F64_SUB:
+      case PUSH_PUSH_F64_MUL:
+      case PUSH_PUSH_F64_DIV:
+        push(constant(1));
+        push(constant(2));
+        [[fallthrough]];
+      case F64_ADD:
+      case F64_SUB:
+      case F64_MUL:
+      case F64_DIV:
+        pop("F64", utility::isFloat);
+        pop("F64", utility::isFloat);
+        push(code::PrimitiveType::F64);
+        break;
+      case F64_MUL_ADD:
+        pop("F64", utility::isFloat);
+        pop("F64", utility::isFloat);
+        pop("F64", utility::isFloat);
+        push(code::PrimitiveType::F64);
+        break;
+      case F64_NEG:
+      case F64_AFF:
+        push(pop("F64", utility::isFloat));
+        break;
+      case I64_ADD:
+      case I64_SUB:
+      case I64_MUL:
+      case I64_DIV:
+        {
+          auto rhs = pop("an int", utility::isInt);
+          auto lhs = pop("an int", utility::isInt);
+          push(std::max(lhs, rhs));
+          break;
+        }
+      case I64_NEG:
+      case I64_AFF:
+        push(pop("an int", utility::isInt));
+        break;
+      case U64_ADD:
+      case U64_SUB:
+      case U64_MUL:
+      case U64_DIV:
+        {
+          auto rhs = pop("a uint", utility::isUint);
+          auto lhs = pop("a uint", utility::isUint);
+          push(std::max(lhs, rhs));
+          break;
+        }
+      case U64_AFF:
+        push(pop("a uint", utility::isUint));
+        break;
+#define FLUIR_SIZED_UINT_CASES(Type, Concrete)       \
+  case Type##_ADD:                                   \
+  case Type##_SUB:                                   \
+  case Type##_MUL:                                   \
+  case Type##_DIV:                                   \
+    pop(#Type, is<code::PrimitiveType::Type>);       \
+    push(pop(#Type, is<code::PrimitiveType::Type>)); \
+    break;
+#define FLUIR_SIZED_INT_CASES(Type, Concrete)        \
+  FLUIR_SIZED_UINT_CASES(Type, Concrete)             \
+  case Type##_NEG:                                   \
+    push(pop(#Type, is<code::PrimitiveType::Type>)); \
+    break;
+
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_INT_CASES)
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_UINT_CASES)
+#undef FLUIR_SIZED_INT_CASES
+#undef FLUIR_SIZED_UINT_CASES
+      case CAST_IU:
+        pop("an int", utility::isInt);
+        push(static_cast<code::PrimitiveType>(code::UNSIGNED | width()));
+        break;
+      case CAST_UI:
+        pop("a uint", utility::isUint);
+        push(static_cast<code::PrimitiveType>(code::SIGNED | width()));
+        break;
+      case CAST_IF:
+        pop("an int", utility::isInt);
+        push(code::PrimitiveType::F64);
+        break;
+      case CAST_UF:
+        pop("a uint", utility::isUint);
+        push(code::PrimitiveType::F64);
+        break;
+      case CAST_FI:
+        pop("F64", utility::isFloat);
+        push(static_cast<code::PrimitiveType>(code::SIGNED | width()));
+        break;
+      case CAST_FU:
+        pop("F64", utility::isFloat);
+        push(static_cast<code::PrimitiveType>(code::UNSIGNED | width()));
+        break;
+      case CAST_WIDTH:
+        fail("CAST_WIDTH is not executable yet.");
+      default:
+        fail("Instruction is not supported by the VM.");
+    }
+
+    offset_ += 1 + operands;
+    return true;
+  }
+
+  bool Verifier::verifyRegisterInstruction() {
+    using enum code::Instruction;
+
+    if (offset_ >= code_.size()) {
+      fail("Code ends without an EXIT instruction.");
+    }
+    auto instruction = code_[offset_];
+    if (instruction >= code::INSTRUCTION_COUNT) {
+      fail(std::format("Unknown instruction x{:02X}.", instruction));
+    }
+    const auto operands = code::registerOperandBytes(static_cast<code::Instruction>(instruction));
+    if (operands < 0) {
+      fail("Instruction is not part of the register instruction set.");
+    }
+    if (offset_ + static_cast<std::size_t>(operands) >= code_.size()) {
+      fail("Missing operand.");
+    }
+
+    switch (instruction) {
+      case EXIT:
+        return false;
+      case POP:
+        read(1, "a value", isAny);
+        break;
+      case F64_ADD:
+      case F64_SUB:
+      case F64_MUL:
+      case F64_DIV:
+        read(2, "F64", utility::isFloat);
+        read(3, "F64", utility::isFloat);
+        write(1, code::PrimitiveType::F64);
+        break;
+      case F64_NEG:
+      case F64_AFF:
+        write(1, read(2, "F64", utility::isFloat));
+        break;
+      case I64_ADD:
+      case I64_SUB:
+      case I64_MUL:
+      case I64_DIV:
+        {
+          auto lhs = read(2, "an int", utility::isInt);
+          auto rhs = read(3, "an int", utility::isInt);
+          write(1, std::max(lhs, rhs));
+          break;
+        }
+      case I64_NEG:
+      case I64_AFF:
+        write(1, read(2, "an int", utility::isInt));
+        break;
+      case U64_ADD:
+      case U64_SUB:
+      case U64_MUL:
+      case U64_DIV:
+        {
+          auto lhs = read(2, "a uint", utility::isUint);
+          auto rhs = read(3, "a uint", utility::isUint);
+          write(1, std::max(lhs, rhs));
+          break;
+        }
+      case U64_AFF:
+        write(1, read(2, "a uint", utility::isUint));
+        break;
+#define FLUIR_SIZED_UINT_CASES(Type, Concrete)     \
+  case Type##_ADD:                                 \
+  case Type##_SUB:                                 \
+  case Type##_MUL:                                 \
+  case Type##_DIV:                                 \
+    read(2, #Type, is<code::PrimitiveType::Type>); \
+    read(3, #Type, is<code::PrimitiveType::Type>); \
+    write(1, code::PrimitiveType::Type);           \
+    break;
+#define FLUIR_SIZED_INT_CASES(Type, Concrete)      \
+  FLUIR_SIZED_UINT_CASES(Type, Concrete)           \
+  case Type##_NEG:                                 \
+    read(2, #Type, is<code::PrimitiveType::Type>); \
+    write(1, code::PrimitiveType::Type);           \
+    break;
+
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_INT_CASES)
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_UINT_CASES)
+#undef FLUIR_SIZED_INT_CASES
+#undef FLUIR_SIZED_UINT_CASES
+      case CAST_IU:
+        read(2, "an int", utility::isInt);
+        write(1, static_cast<code::PrimitiveType>(code::UNSIGNED | width(3)));
+        break;
+      case CAST_UI:
+        read(2, "a uint", utility::isUint);
+        write(1, static_cast<code::PrimitiveType>(code::SIGNED | width(3)));
+        break;
+      case CAST_IF:
+        read(2, "an int", utility::isInt);
+        write(1, code::PrimitiveType::F64);
+        break;
+      case CAST_UF:
+        read(2, "a uint", utility::isUint);
+        write(1, code::PrimitiveType::F64);
+        break;
+      case CAST_FI:
+        read(2, "F64", utility::isFloat);
+        write(1, static_cast<code::PrimitiveType>(code::SIGNED | width(3)));
+        break;
+      case CAST_FU:
+        read(2, "F64", utility::isFloat);
+        write(1, static_cast<code::PrimitiveType>(code::UNSIGNED | width(3)));
+        break;
+      default:
+        fail("Instruction is not supported by the VM.");
+    }
+
+    offset_ += 1 + static_cast<std::size_t>(operands);
+    return true;
+  }
+
+  void Verifier::push(code::PrimitiveType type) {
+    if (stack_.size() >= VirtualMachine::STACK_CAPACITY) {
+      fail(std::format("Stack overflow. The stack can hold at most {} values.", VirtualMachine::STACK_CAPACITY));
+    }
+    stack_.push_back(type);
+  }
+
+  code::PrimitiveType Verifier::pop(std::string_view expected, bool (*accepts)(code::PrimitiveType)) {
+    if (stack_.empty()) {
+      fail(std::format("Stack underflow. Expected {} on the stack.", expected));
+    }
+    auto type = stack_.back();
+    if (!accepts(type)) {
+      fail(std::format("Expected {} on the stack, found {}.", expected, typeName(type)));
+    }
+    stack_.pop_back();
+    return type;
+  }
+
+  code::PrimitiveType Verifier::read(std::size_t operand,
+                                     std::string_view expected,
+                                     bool (*accepts)(code::PrimitiveType)) {
+    auto index = code_[offset_ + operand];
+    if (!registers_[index]) {
+      fail(std::format("Register r{} is read before it is written.", index));
+    }
+    auto type = *registers_[index];
+    if (!accepts(type)) {
+      fail(std::format("Expected {} in register r{}, found {}.", expected, index, typeName(type)));
+    }
+    return type;
+  }
+
+  void Verifier::write(std::size_t operand, code::PrimitiveType type) { registers_[code_[offset_ + operand]] = type; }
+
+  code::PrimitiveType Verifier::constant(std::size_t operand) {
+    return constantType(code_[offset_ + operand]);
+  }
+
+  code::PrimitiveType Verifier::constantType(std::size_t index) {
+    if (index >= chunk_->constantCount()) {
+      fail(std::format(
+        "Constant index x{:X} is out of range. The chunk only has x{:X} constants.", index, chunk_->constantCount()));
+    }
+    return chunk_->constantType(index);
+  }
+
+  code::NumericWidth Verifier::width(std::size_t operand) {
+    auto width = code_[offset_ + operand];
+    switch (width) {
+      case code::WIDTH_8:
+      case code::WIDTH_16:
+      case code::WIDTH_32:
+      case code::WIDTH_64:
+        return static_cast<code::NumericWidth>(width);
+      default:
+        fail(std::format("Invalid width operand x{:X}.", width));
+    }
+  }
+
+  void Verifier::fail(std::string_view message) {
+    std::string_view instruction = "<END>";
+    if (offset_ < code_.size()) {
+      instruction = code::instructionName(code_[offset_]);
+    }
+    throw VerificationError{std::format(
+      "Invalid bytecode in chunk '{}' at offset x{:X} ({}): {}", chunk_->name, offset_, instruction, message)};
+  }
+}  // namespace fluir
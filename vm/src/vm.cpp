@@ -1,245 +1,1053 @@
 #include "vm/vm.hpp"
 
 #include <algorithm>
+#include <array>
 #include <format>  // Use format in VM instead of fmt to reduce dependencies of the runtime
 #include <functional>
+#include <iterator>
 #include <iostream>
+#include <limits>
+#include <string_view>
+#include <type_traits>
 
-#include "vm/exceptions.hpp"
+#include "vm/jit.hpp"
 #include "vm/utility/narrow_widen.hpp"
+#include "vm/verifier.hpp"
 
 namespace fluir {
   namespace {
-    // TODO: Remove this later
-    // This code is just for debugging purposes until the rest of the
-    // language is implemented
-    std::ostream& operator<<(std::ostream& os, const code::Value& value) {
-      switch (value.type()) {
-#define FLUIR_PRINT_VALUE(Type, Concrete)          \
-  case code::PrimitiveType::Type:                  \
-    os << '(' << #Type << ')' << value.as##Type(); \
-    break;
+    /** Accepts a value of any type, for instructions which only move values around */
+    constexpr bool anyType(code::PrimitiveType) { return true; }
 
-        FLUIR_CODE_PRIMITIVE_TYPES(FLUIR_PRINT_VALUE)
-#undef FLUIR_PRINT_VALUE
+    /** In checked mode, whether a cast's operand is a width it can narrow to */
+    template <bool Checked>
+    [[gnu::always_inline]] inline Fault checkWidth(std::uint8_t width) {
+      if constexpr (Checked) {
+        if (!utility::isWidth(width)) {
+          return Fault::INVALID_OPERAND;
+        }
       }
+      return Fault::NONE;
+    }
+
+    /** Applies a binary Op, which may report a fault through an out parameter like utility::checkedDivide does */
+    template <typename Op, typename T>
+    Fault apply(T lhs, T rhs, T& result) {
+      if constexpr (std::is_invocable_v<Op, T, T, T&>) {
+        if (!Op{}(lhs, rhs, result)) [[unlikely]] {
+          return Fault::DIVIDE_BY_ZERO;
+        }
+      } else {
+        result = Op{}(lhs, rhs);
+      }
+      return Fault::NONE;
+    }
+
+    std::string_view nameOf(Fault fault) {
+      switch (fault) {
+        case Fault::NONE:
+          return "NO FAULT";
+        case Fault::TYPE_MISMATCH:
+          return "TYPE MISMATCH";
+        case Fault::DIVIDE_BY_ZERO:
+          return "DIVISION BY ZERO";
+        case Fault::STACK_OVERFLOW:
+          return "STACK OVERFLOW";
+        case Fault::STACK_UNDERFLOW:
+          return "STACK UNDERFLOW";
+        case Fault::INVALID_OPERAND:
+          return "INVALID OPERAND";
+        case Fault::INVALID_INSTRUCTION:
+          return "INVALID INSTRUCTION";
+      }
+      return "UNKNOWN FAULT";
+    }
+
+    /** The most text an execution without a sink of its own buffers before writing it to standard output */
+    constexpr std::size_t CONSOLE_BUFFER = 4 * 1024;
+
+    /** How many instructions a budget with a time limit runs between reading the clock */
+    constexpr std::size_t CLOCK_INTERVAL = 256;
+
+    /** Whether code has the entry chunk in options, reporting it if not */
+    bool hasEntry(const code::ByteCode& code, const ExecOptions& options) {
+      const auto entry = entryChunk(code, options);
+      if (entry < code.chunks.size()) {
+        return true;
+      }
+      std::cerr << std::format("NO ENTRY CHUNK {}. THE CODE HAS {} CHUNKS", entry, code.chunks.size()) << std::endl;
+      return false;
+    }
 
-      return os;
+    /** Whether the entry chunk in options has been verified, reporting it if not */
+    bool hasEntry(const VerifiedCode& code, const ExecOptions& options) {
+      if (!hasEntry(code.code(), options)) {
+        return false;
+      }
+      const auto entry = entryChunk(code.code(), options);
+      if (code.verified(entry)) {
+        return true;
+      }
+      std::cerr << std::format("ENTRY CHUNK {} HAS NOT BEEN VERIFIED", entry) << std::endl;
+      return false;
     }
   }  // namespace
 
-  template <typename Op>
-  void VirtualMachine::floatBinary() {
-    double rhs = stack_.back().asF64();
-    stack_.pop_back();
-    double lhs = stack_.back().asF64();
-    stack_.pop_back();
-    stack_.emplace_back(code::Value{Op{}(lhs, rhs)});
+// Every helper reports a fault by returning it, so the handlers stay free of exception edges and the happy path costs
+// a single, well predicted branch. Unchecked code only ever fails on division by zero.
+#define FLUIR_TRY(expr)                                   \
+  if (const Fault fault = (expr); fault != Fault::NONE) { \
+    return raise(fault);                                  \
   }
-  template <typename Op>
-  void VirtualMachine::floatUnary() {
-    double operand = stack_.back().asF64();
+
+  std::string describe(const FaultReport& report) {
+    return std::format("{} in chunk '{}' at offset x{:X}", nameOf(report.fault), report.chunk, report.offset);
+  }
+
+  std::size_t entryChunk(const code::ByteCode& code, const ExecOptions& options) {
+    return options.entry.value_or(code.header.entryOffset);
+  }
+
+  // The checks and helpers below only exist to share code between handlers, so they are always inlined into them. Left
+  // to itself, GCC calls the checked helpers out of line, which costs more than the work they do.
+  template <bool Checked>
+  [[gnu::always_inline]] inline Fault VirtualMachine::checkOperands(std::size_t count,
+                                                                   bool (*accepts)(code::PrimitiveType)) const {
+    if constexpr (Checked) {
+      if (stack_.size() < count) {
+        return Fault::STACK_UNDERFLOW;
+      }
+      for (auto operand = stack_.end() - static_cast<std::ptrdiff_t>(count); operand != stack_.end(); ++operand) {
+        if (!accepts(operand->type())) {
+          return Fault::TYPE_MISMATCH;
+        }
+      }
+    }
+    return Fault::NONE;
+  }
+  template <bool Checked>
+  [[gnu::always_inline]] inline Fault VirtualMachine::checkCapacity(std::size_t count) const {
+    if constexpr (Checked) {
+      if (stack_.size() + count > STACK_CAPACITY) {
+        return Fault::STACK_OVERFLOW;
+      }
+    }
+    return Fault::NONE;
+  }
+  template <bool Checked>
+  [[gnu::always_inline]] inline Fault VirtualMachine::checkConstant(std::size_t index,
+                                                                   bool (*accepts)(code::PrimitiveType)) const {
+    if constexpr (Checked) {
+      if (index >= current_->constantCount()) {
+        return Fault::INVALID_OPERAND;
+      }
+      if (!accepts(current_->constantType(index))) {
+        return Fault::TYPE_MISMATCH;
+      }
+    }
+    return Fault::NONE;
+  }
+  [[gnu::always_inline]] inline void VirtualMachine::pushConstant(std::size_t index) {
+    // Decoding a constant from its bits inline makes the dispatch loop large enough to slow down every other handler,
+    // so only the copy out of an ordinary table is inlined
+    if (current_->constantView.empty()) [[likely]] {
+      stack_.emplace_back(current_->constants[index]);
+    } else {
+      pushViewConstant(index);
+    }
+  }
+  [[gnu::noinline]] void VirtualMachine::pushViewConstant(std::size_t index) {
+    stack_.emplace_back(current_->constantView[index]);
+  }
+  template <bool Checked>
+  [[gnu::always_inline]] inline Fault VirtualMachine::checkOperandBytes(std::size_t count) const {
+    if constexpr (Checked) {
+      const auto code = current_->instructions();
+      if (static_cast<std::size_t>(code.data() + code.size() - ip_) < count) {
+        return Fault::INVALID_OPERAND;
+      }
+    }
+    return Fault::NONE;
+  }
+  template <bool Checked>
+  [[gnu::always_inline]] inline Fault VirtualMachine::checkRegisters(std::initializer_list<std::uint8_t> indices,
+                                                                    bool (*accepts)(code::PrimitiveType)) const {
+    if constexpr (Checked) {
+      // Every register operand is in range, since there are as many registers as a byte can name
+      for (auto index : indices) {
+        if (!accepts(registers_[index].type())) {
+          return Fault::TYPE_MISMATCH;
+        }
+      }
+    }
+    return Fault::NONE;
+  }
+
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::floatBinary() {
+    if (auto fault = checkOperands<Checked>(2, utility::isFloat); fault != Fault::NONE) {
+      return fault;
+    }
+    double rhs = stack_.back().uncheckedAsF64();
     stack_.pop_back();
-    stack_.emplace_back(Op{}(operand));
+    double& lhs = stack_.back().uncheckedAsF64();
+    lhs = Op{}(lhs, rhs);
+    return Fault::NONE;
   }
-  template <typename Op>
-  void VirtualMachine::intBinary() {
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::floatUnary() {
+    if (auto fault = checkOperands<Checked>(1, utility::isFloat); fault != Fault::NONE) {
+      return fault;
+    }
+    double& operand = stack_.back().uncheckedAsF64();
+    operand = Op{}(operand);
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::floatConstantBinary() {
+    const std::uint8_t lhsIndex = *ip_++;
+    const std::uint8_t rhsIndex = *ip_++;
+    if constexpr (Checked) {
+      for (auto fault : {checkCapacity<Checked>(1), checkConstant<Checked>(lhsIndex, utility::isFloat),
+                         checkConstant<Checked>(rhsIndex, utility::isFloat)}) {
+        if (fault != Fault::NONE) {
+          return fault;
+        }
+      }
+    }
+    stack_.emplace_back(Op{}(current_->f64Constant(lhsIndex), current_->f64Constant(rhsIndex)));
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::intBinary() {
+    if (auto fault = checkOperands<Checked>(2, utility::isInt); fault != Fault::NONE) {
+      return fault;
+    }
     code::PrimitiveType typeR, typeL;
     code::I64 rhs = utility::widenI(stack_.back(), typeR);
+    code::I64 lhs = utility::widenI(stack_.end()[-2], typeL);
+    code::I64 result;
+    if (auto fault = apply<Op>(lhs, rhs, result); fault != Fault::NONE) {
+      return fault;
+    }
     stack_.pop_back();
-    code::I64 lhs = utility::widenI(stack_.back(), typeL);
-    stack_.pop_back();
-    stack_.emplace_back(utility::narrowI(Op{}(lhs, rhs), std::max(typeR, typeL)));
+    stack_.back() = utility::narrowI(result, std::max(typeR, typeL));
+    return Fault::NONE;
   }
-  template <typename Op>
-  void VirtualMachine::intUnary() {
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::intUnary() {
+    if (auto fault = checkOperands<Checked>(1, utility::isInt); fault != Fault::NONE) {
+      return fault;
+    }
     code::PrimitiveType type;
     code::I64 operand = utility::widenI(stack_.back(), type);
-    stack_.pop_back();
-    stack_.emplace_back(utility::narrowI(Op{}(operand), type));
+    stack_.back() = utility::narrowI(Op{}(operand), type);
+    return Fault::NONE;
   }
-  template <typename Op>
-  void VirtualMachine::uintBinary() {
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::uintBinary() {
+    if (auto fault = checkOperands<Checked>(2, utility::isUint); fault != Fault::NONE) {
+      return fault;
+    }
     code::PrimitiveType typeR, typeL;
     code::U64 rhs = utility::widenU(stack_.back(), typeR);
+    code::U64 lhs = utility::widenU(stack_.end()[-2], typeL);
+    code::U64 result;
+    if (auto fault = apply<Op>(lhs, rhs, result); fault != Fault::NONE) {
+      return fault;
+    }
     stack_.pop_back();
-    code::U64 lhs = utility::widenU(stack_.back(), typeL);
-    stack_.pop_back();
-    stack_.emplace_back(utility::narrowU(Op{}(lhs, rhs), std::max(typeR, typeL)));
+    stack_.back() = utility::narrowU(result, std::max(typeR, typeL));
+    return Fault::NONE;
   }
-  template <typename Op>
-  void VirtualMachine::uintUnary() {
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::uintUnary() {
+    if (auto fault = checkOperands<Checked>(1, utility::isUint); fault != Fault::NONE) {
+      return fault;
+    }
     code::PrimitiveType type;
     code::U64 operand = utility::widenU(stack_.back(), type);
+    stack_.back() = utility::narrowU(Op{}(operand), type);
+    return Fault::NONE;
+  }
+
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::floatBinaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(3); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1], ip_[2]}, utility::isFloat); fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = code::Value{Op{}(registers_[ip_[1]].uncheckedAsF64(), registers_[ip_[2]].uncheckedAsF64())};
+    ip_ += 3;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::floatUnaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(2); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1]}, utility::isFloat); fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = code::Value{Op{}(registers_[ip_[1]].uncheckedAsF64())};
+    ip_ += 2;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::intBinaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(3); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1], ip_[2]}, utility::isInt); fault != Fault::NONE) {
+      return fault;
+    }
+    code::PrimitiveType typeR, typeL;
+    code::I64 lhs = utility::widenI(registers_[ip_[1]], typeL);
+    code::I64 rhs = utility::widenI(registers_[ip_[2]], typeR);
+    code::I64 result;
+    if (auto fault = apply<Op>(lhs, rhs, result); fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = utility::narrowI(result, std::max(typeR, typeL));
+    ip_ += 3;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::intUnaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(2); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1]}, utility::isInt); fault != Fault::NONE) {
+      return fault;
+    }
+    code::PrimitiveType type;
+    code::I64 operand = utility::widenI(registers_[ip_[1]], type);
+    registers_[ip_[0]] = utility::narrowI(Op{}(operand), type);
+    ip_ += 2;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::uintBinaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(3); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1], ip_[2]}, utility::isUint); fault != Fault::NONE) {
+      return fault;
+    }
+    code::PrimitiveType typeR, typeL;
+    code::U64 lhs = utility::widenU(registers_[ip_[1]], typeL);
+    code::U64 rhs = utility::widenU(registers_[ip_[2]], typeR);
+    code::U64 result;
+    if (auto fault = apply<Op>(lhs, rhs, result); fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = utility::narrowU(result, std::max(typeR, typeL));
+    ip_ += 3;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::uintUnaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(2); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1]}, utility::isUint); fault != Fault::NONE) {
+      return fault;
+    }
+    code::PrimitiveType type;
+    code::U64 operand = utility::widenU(registers_[ip_[1]], type);
+    registers_[ip_[0]] = utility::narrowU(Op{}(operand), type);
+    ip_ += 2;
+    return Fault::NONE;
+  }
+
+  template <bool Checked, typename T, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::sizedBinary() {
+    if (auto fault = checkOperands<Checked>(2, utility::isType<T>); fault != Fault::NONE) {
+      return fault;
+    }
+    T rhs = utility::uncheckedAs<T>(stack_.back());
     stack_.pop_back();
-    stack_.emplace_back(utility::narrowU(Op{}(operand), type));
+    T& lhs = utility::uncheckedAs<T>(stack_.back());
+    return apply<Op>(lhs, rhs, lhs);
+  }
+  template <bool Checked, typename T, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::sizedUnary() {
+    if (auto fault = checkOperands<Checked>(1, utility::isType<T>); fault != Fault::NONE) {
+      return fault;
+    }
+    T& operand = utility::uncheckedAs<T>(stack_.back());
+    operand = Op{}(operand);
+    return Fault::NONE;
+  }
+  template <bool Checked, typename T, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::sizedBinaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(3); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1], ip_[2]}, utility::isType<T>); fault != Fault::NONE) {
+      return fault;
+    }
+    T result;
+    if (auto fault = apply<Op>(utility::uncheckedAs<T>(registers_[ip_[1]]), utility::uncheckedAs<T>(registers_[ip_[2]]),
+                               result);
+        fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = code::Value{result};
+    ip_ += 3;
+    return Fault::NONE;
+  }
+  template <bool Checked, typename T, typename Op>
+  [[gnu::always_inline]] inline Fault VirtualMachine::sizedUnaryRegisters() {
+    if (auto fault = checkOperandBytes<Checked>(2); fault != Fault::NONE) {
+      return fault;
+    }
+    if (auto fault = checkRegisters<Checked>({ip_[1]}, utility::isType<T>); fault != Fault::NONE) {
+      return fault;
+    }
+    registers_[ip_[0]] = code::Value{Op{}(utility::uncheckedAs<T>(registers_[ip_[1]]))};
+    ip_ += 2;
+    return Fault::NONE;
   }
 
-  ExecResult VirtualMachine::execute(code::ByteCode const* code) {
-    // Reset the internal state
-    stack_.clear();
-    stack_.reserve(256);
+  void VirtualMachine::reserve() {
+    stack_.reserve(STACK_CAPACITY);
+    registers_.reserve(REGISTER_COUNT);
+  }
 
-    code_ = code;
-    current_ = &code_->chunks.at(0);
-    ip_ = current_->code.data();  // TODO: Be smarter about loading the entry point
-
-    try {
-      return run();
-    } catch (const DivideByZeroError& e) {
-      std::cerr << e.what() << std::endl;
-      return ExecResult::ERROR_DIVIDE_BY_ZERO;
-    } catch (const VirtualMachineError& e) {
-      std::cerr << e.what() << std::endl;
+  VirtualMachine::VirtualMachine() : console_(&std::cout, CONSOLE_BUFFER) { }
+
+  ExecResult VirtualMachine::execute(code::ByteCode const* code) { return execute(*code, {}); }
+
+  ExecResult VirtualMachine::execute(const code::ByteCode& code, ExecOptions options) {
+    if (!hasEntry(code, options)) {
       return ExecResult::ERROR;
-    } catch (const std::exception& e) {
-      std::cerr << "An unexpected error occurred: \n" << e.what() << std::endl;
+    }
+    return start<true>(&code, options);
+  }
+
+  ExecResult VirtualMachine::execute(const VerifiedCode& code) { return execute(code, {}); }
+
+  ExecResult VirtualMachine::execute(const VerifiedCode& code, ExecOptions options) {
+    if (!hasEntry(code, options)) {
       return ExecResult::ERROR;
-    } catch (...) {
-      std::cerr << "VM PANIC" << std::endl;
+    }
+    return start<false>(&code.code(), options);
+  }
+
+  ExecResult VirtualMachine::execute(const JitCode& code) { return execute(code, {}); }
+
+  ExecResult VirtualMachine::execute(const JitCode& code, ExecOptions options) {
+    const auto& verified = code.verified();
+    if (!hasEntry(verified, options)) {
       return ExecResult::ERROR;
     }
+    // Native code can neither suspend nor be instrumented, so executions which need either are interpreted
+    const bool budgeted =
+      options.budget.instructions != 0 || options.budget.time != std::chrono::nanoseconds::zero();
+    const bool instrumented = options.profiler != nullptr || options.sampler != nullptr;
+    const auto entry = entryChunk(verified.code(), options);
+    if (auto native = code.chunk(entry); native != nullptr && !budgeted && !instrumented) {
+      return runNative(verified.code(), entry, *native, options);
+    }
+    return start<false>(&verified.code(), options);
   }
 
-  ExecResult VirtualMachine::run() {
+  ExecResult VirtualMachine::resume() {
+    if (!suspended_) {
+      std::cerr << "NO SUSPENDED EXECUTION TO RESUME" << std::endl;
+      return ExecResult::ERROR;
+    }
+    renewBudget();
+    return checked_ ? dispatch<true>() : dispatch<false>();
+  }
+
+  void VirtualMachine::renewBudget() {
+    remaining_ = budget_.instructions != 0 ? budget_.instructions : std::numeric_limits<std::size_t>::max();
+    if (budget_.time != std::chrono::nanoseconds::zero()) {
+      deadline_ = std::chrono::steady_clock::now() + budget_.time;
+    }
+    slice_ = budget_.time != std::chrono::nanoseconds::zero() ? std::min(remaining_, CLOCK_INTERVAL) : remaining_;
+    countdown_ = slice_;
+  }
+
+  bool VirtualMachine::exhausted() {
+    remaining_ -= slice_;
+    if (remaining_ == 0) {
+      return true;
+    }
+    if (budget_.time != std::chrono::nanoseconds::zero()) {
+      if (std::chrono::steady_clock::now() >= deadline_) {
+        return true;
+      }
+      slice_ = std::min(remaining_, CLOCK_INTERVAL);
+    } else {
+      slice_ = remaining_;
+    }
+    countdown_ = slice_;
+    return false;
+  }
+
+  ExecResult VirtualMachine::runNative(const code::ByteCode& code, std::size_t entry, const NativeChunk& chunk,
+                                       ExecOptions options) {
+    // Reset the same state as start(), so nothing of an earlier execution, such as its fault, shows through
+    stack_.clear();
+    stack_.reserve(STACK_CAPACITY);
+
+    code_ = &code;
+    current_ = &code_->chunks[entry];
+    output_ = options.output;
+    ip_ = current_->instructions().data();
+
+    fault_.reset();
+    checked_ = false;
+    suspended_ = false;
+    budget_ = {};
+    profiler_ = nullptr;
+    sampler_ = nullptr;
+
+    // The native code keeps raw F64s rather than Values, so copy whatever is left over back onto the stack
+    std::array<code::F64, STACK_CAPACITY> values;
+    code::F64* top = chunk.entry()(values.data(), &output());
+    for (auto value = values.data(); value != top; ++value) {
+      stack_.emplace_back(*value);
+    }
+    output().flush();
+    return ExecResult::SUCCESS;
+  }
+
+  template <bool Checked>
+  ExecResult VirtualMachine::start(code::ByteCode const* code, ExecOptions options) {
+    // Reset the internal state. Clearing keeps the storage of earlier executions, so this only allocates once.
+    stack_.clear();
+    stack_.reserve(STACK_CAPACITY);
+
+    code_ = code;
+    current_ = &code_->chunks.at(entryChunk(*code_, options));
+    output_ = options.output;
+    ip_ = current_->instructions().data();
+
+    const bool registers = code::usesRegisters(code_->header);
+    if (registers) {
+      // Checked code may read a register before writing it, so every register starts out as an F64 which the type
+      // checks can see. The verifier rejects such reads, so verified code only needs the constants loaded, and the
+      // registers keep their size between executions.
+      if constexpr (Checked) {
+        registers_.assign(REGISTER_COUNT, code::Value{0.0});
+      } else {
+        registers_.resize(REGISTER_COUNT, code::Value{0.0});
+      }
+      for (std::size_t i = 0; i != std::min(current_->constantCount(), REGISTER_COUNT); ++i) {
+        registers_[i] = current_->constant(i);
+      }
+    }
+
+    fault_.reset();
+    checked_ = Checked;
+    budget_ = options.budget;
+    profiler_ = options.profiler;
+    sampler_ = options.sampler;
+    renewBudget();
+    return dispatch<Checked>();
+  }
+
+  template <bool Checked>
+  ExecResult VirtualMachine::dispatch() {
+    ExecResult result;
+    if (profiler_ != nullptr) {
+      ProfilingInstrumentation instrument{*profiler_};
+      result = interpret<Checked>(instrument);
+      instrument.stop();
+    } else if (sampler_ != nullptr) {
+      SamplingInstrumentation instrument{*sampler_, current_, ip_};
+      result = interpret<Checked>(instrument);
+    } else {
+      NoInstrumentation instrument;
+      result = interpret<Checked>(instrument);
+    }
+    suspended_ = result == ExecResult::SUSPENDED;
+    output().flush();
+    return result;
+  }
+
+  template <bool Checked, typename Instrument>
+  ExecResult VirtualMachine::interpret(Instrument& instrument) {
+    // Only executions with a budget count their instructions, so the others run exactly as fast as before
+    const bool registers = code::usesRegisters(code_->header);
+    if (budget_.instructions != 0 || budget_.time != std::chrono::nanoseconds::zero()) {
+      return registers ? runRegisters<Checked, true>(instrument) : run<Checked, true>(instrument);
+    }
+    return registers ? runRegisters<Checked, false>(instrument) : run<Checked, false>(instrument);
+  }
+
+  ExecResult VirtualMachine::raise(Fault fault) {
+    // Decode the chunk up to ip_, which is somewhere past the opcode of the failing instruction but never past its
+    // last operand
+    const bool registers = code::usesRegisters(code_->header);
+    const auto code = current_->instructions();
+    const auto failedAt = static_cast<std::size_t>(ip_ - code.data());
+    std::size_t offset = 0;
+    for (;;) {
+      const auto instruction = static_cast<code::Instruction>(code[offset]);
+      const int operands = registers ? code::registerOperandBytes(instruction) : code::operandBytes(instruction);
+      const std::size_t next = offset + 1 + static_cast<std::size_t>(std::max(operands, 0));
+      if (next >= failedAt) {
+        break;
+      }
+      offset = next;
+    }
+
+    fault_ = FaultReport{.fault = fault, .chunk = current_->name, .offset = offset};
+    std::cerr << describe(*fault_) << std::endl;
+    return fault == Fault::DIVIDE_BY_ZERO ? ExecResult::ERROR_DIVIDE_BY_ZERO : ExecResult::ERROR;
+  }
+
+#if FLUIR_VM_COMPUTED_GOTO
+  // Labels-as-values are a GNU extension; they are only used when the build selects the threaded dispatch engine
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma clang diagnostic ignored "-Wgnu-label-as-value"
+#endif
+#endif
+
 #define FLUIR_READ_BYTE() *ip_++
 
+#if FLUIR_VM_COMPUTED_GOTO
+  // Every handler ends by jumping straight to the next handler through a
+  // table, so each one gets its own indirect branch to predict rather than
+  // sharing the single branch at the top of a switch. Each interpreter loop
+  // declares its own dispatchTable with FLUIR_DISPATCH_TABLE.
+#define FLUIR_LABEL_ADDRESS(inst) &&handle##inst,
+#define FLUIR_DISPATCH_TABLE() \
+  static void* const dispatchTable[] = {FLUIR_CODE_INSTRUCTIONS(FLUIR_LABEL_ADDRESS)}
+
+#define FLUIR_DISPATCH()                                                         \
+  {                                                                              \
+    const std::uint8_t nextInstruction = instrument.dispatch(FLUIR_READ_BYTE()); \
+    if (nextInstruction >= std::size(dispatchTable)) {                           \
+      goto handleInvalid;                                                        \
+    }                                                                            \
+    goto* dispatchTable[nextInstruction];                                        \
+  }
+#define FLUIR_HANDLER(inst) handle##inst:
+#define FLUIR_INVALID_HANDLER() handleInvalid:
+#define FLUIR_NEXT()  \
+  {                   \
+    FLUIR_BUDGET();   \
+    FLUIR_DISPATCH(); \
+  }
+#else
+#define FLUIR_DISPATCH_TABLE() static_assert(true)
+#define FLUIR_DISPATCH() switch (instrument.dispatch(FLUIR_READ_BYTE()))
+#define FLUIR_HANDLER(inst) case inst:
+#define FLUIR_INVALID_HANDLER() default:
+#define FLUIR_NEXT() \
+  {                  \
+    FLUIR_BUDGET();  \
+    continue;        \
+  }
+#endif
+
+  // Counts down the budget of Budgeted loops after each instruction. Once it runs out, ip_ is left on the next
+  // instruction, which is where resume() carries on.
+#define FLUIR_BUDGET()                                  \
+  if constexpr (Budgeted) {                             \
+    if (--countdown_ == 0 && exhausted()) {             \
+      return ExecResult::SUSPENDED;                     \
+    }                                                   \
+  }                                                     \
+  static_assert(true)
+
+  // The width specialized instructions of one type, applied with the Binary and Unary helpers of the interpreter
+#define FLUIR_SIZED_INT_HANDLERS(Type, Concrete, Binary, Unary)                              \
+  FLUIR_SIZED_UINT_HANDLERS(Type, Concrete, Binary, Unary)                                   \
+  FLUIR_HANDLER(Type##_NEG)                                                                  \
+  FLUIR_TRY((Unary<Checked, Concrete, utility::wrapping<Concrete, std::negate>>()));         \
+  FLUIR_NEXT();
+#define FLUIR_SIZED_UINT_HANDLERS(Type, Concrete, Binary, Unary)                             \
+  FLUIR_HANDLER(Type##_ADD)                                                                  \
+  FLUIR_TRY((Binary<Checked, Concrete, utility::wrapping<Concrete, std::plus>>()));          \
+  FLUIR_NEXT();                                                                              \
+  FLUIR_HANDLER(Type##_SUB)                                                                  \
+  FLUIR_TRY((Binary<Checked, Concrete, utility::wrapping<Concrete, std::minus>>()));         \
+  FLUIR_NEXT();                                                                              \
+  FLUIR_HANDLER(Type##_MUL)                                                                  \
+  FLUIR_TRY((Binary<Checked, Concrete, utility::wrapping<Concrete, std::multiplies>>()));    \
+  FLUIR_NEXT();                                                                              \
+  FLUIR_HANDLER(Type##_DIV)                                                                  \
+  FLUIR_TRY((Binary<Checked, Concrete, utility::sizedDivide<Concrete>>()));                  \
+  FLUIR_NEXT();
+#define FLUIR_SIZED_INT_STACK_HANDLERS(Type, Concrete) \
+  FLUIR_SIZED_INT_HANDLERS(Type, Concrete, sizedBinary, sizedUnary)
+#define FLUIR_SIZED_UINT_STACK_HANDLERS(Type, Concrete) \
+  FLUIR_SIZED_UINT_HANDLERS(Type, Concrete, sizedBinary, sizedUnary)
+
+  template <bool Checked, bool Budgeted, typename Instrument>
+  ExecResult VirtualMachine::run(Instrument& instrument) {
+    FLUIR_DISPATCH_TABLE();
+
     using enum code::Instruction;
     for (;;) {
-      std::uint8_t instruction = EXIT;
-      switch (instruction = FLUIR_READ_BYTE()) {
-        case PUSH:
-          {
-            uint8_t index = FLUIR_READ_BYTE();
-            const code::Value& val = current_->constants[index];
-            if (!(stack_.size() < 256)) {
-              return ExecResult::ERROR;
-            }
-            stack_.emplace_back(val);
-            break;
-          }
-        case F64_ADD:
-          floatBinary<std::plus<code::F64>>();
-          break;
-        case F64_SUB:
-          floatBinary<std::minus<code::F64>>();
-          break;
-        case F64_MUL:
-          floatBinary<std::multiplies<code::F64>>();
-          break;
-        case F64_DIV:
-          floatBinary<std::divides<code::F64>>();
-          break;
-        case F64_NEG:
-          floatUnary<std::negate<code::F64>>();
-          break;
-        case I64_ADD:
-          intBinary<std::plus<code::I64>>();
-          break;
-        case I64_SUB:
-          intBinary<std::minus<code::I64>>();
-          break;
-        case I64_MUL:
-          intBinary<std::multiplies<code::I64>>();
-          break;
-        case I64_DIV:
-          intBinary<utility::checkedDivide<code::I64>>();
-          break;
-        case I64_NEG:
-          intUnary<std::negate<code::I64>>();
-          break;
-        case U64_ADD:
-          uintBinary<std::plus<code::U64>>();
-          break;
-        case U64_SUB:
-          uintBinary<std::minus<code::U64>>();
-          break;
-        case U64_MUL:
-          uintBinary<std::multiplies<code::U64>>();
-          break;
-        case U64_DIV:
-          uintBinary<utility::checkedDivide<code::U64>>();
-          break;
-        case F64_AFF:
-        case I64_AFF:
-        case U64_AFF:
-          break;  // This is a No-Op
-        case CAST_IU:
-          {
-            auto width = static_cast<code::NumericWidth>(FLUIR_READ_BYTE());
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            code::PrimitiveType _;
-            auto widened = utility::widenI(toCast, _);
-            auto casted = static_cast<code::U64>(widened);
-
-            stack_.push_back(utility::narrowU(casted, static_cast<code::PrimitiveType>(code::UNSIGNED | width)));
-          }
-          break;
-        case CAST_UI:
-          {
-            auto width = static_cast<code::NumericWidth>(FLUIR_READ_BYTE());
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            code::PrimitiveType _;
-            auto widened = utility::widenU(toCast, _);
-            auto casted = static_cast<code::I64>(widened);
-            stack_.push_back(utility::narrowI(casted, static_cast<code::PrimitiveType>(code::SIGNED | width)));
-          }
-          break;
-        case CAST_IF:
-          {
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            code::PrimitiveType _;
-            auto widened = utility::widenI(toCast, _);
-            auto casted = static_cast<code::F64>(widened);
-            stack_.emplace_back(casted);
-          }
-          break;
-        case CAST_FI:
-          {
-            auto width = static_cast<code::NumericWidth>(FLUIR_READ_BYTE());
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            auto casted = static_cast<code::I64>(toCast.asF64());
-            stack_.push_back(utility::narrowI(casted, static_cast<code::PrimitiveType>(code::SIGNED | width)));
-          }
-          break;
-        case CAST_UF:
-          {
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            code::PrimitiveType _;
-            auto widened = utility::widenU(toCast, _);
-            auto casted = static_cast<code::F64>(widened);
-            stack_.emplace_back(casted);
-          }
-          break;
-        case CAST_FU:
-          {
-            auto width = static_cast<code::NumericWidth>(FLUIR_READ_BYTE());
-            auto toCast = stack_.back();
-            stack_.pop_back();
-            auto casted = static_cast<code::U64>(toCast.asF64());
-            stack_.push_back(utility::narrowU(casted, static_cast<code::PrimitiveType>(code::UNSIGNED | width)));
-          }
-          break;
-        case POP:
-          // TODO: Remove this later
-          // This code is just for debugging purposes until the rest of the
-          // language is implemented
-          std::cout << stack_.back() << '\n';
+      FLUIR_DISPATCH() {
+        FLUIR_HANDLER(PUSH) {
+          uint8_t index = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkCapacity<Checked>(1));
+          FLUIR_TRY(checkConstant<Checked>(index, anyType));
+          pushConstant(index);
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(F64_ADD)
+        FLUIR_TRY((floatBinary<Checked, std::plus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_SUB)
+        FLUIR_TRY((floatBinary<Checked, std::minus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_MUL)
+        FLUIR_TRY((floatBinary<Checked, std::multiplies<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_DIV)
+        FLUIR_TRY((floatBinary<Checked, std::divides<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_NEG)
+        FLUIR_TRY((floatUnary<Checked, std::negate<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_ADD)
+        FLUIR_TRY((intBinary<Checked, utility::wrapping<code::I64, std::plus>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_SUB)
+        FLUIR_TRY((intBinary<Checked, utility::wrapping<code::I64, std::minus>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_MUL)
+        FLUIR_TRY((intBinary<Checked, utility::wrapping<code::I64, std::multiplies>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_DIV)
+        FLUIR_TRY((intBinary<Checked, utility::checkedDivide<code::I64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_NEG)
+        FLUIR_TRY((intUnary<Checked, utility::wrapping<code::I64, std::negate>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_ADD)
+        FLUIR_TRY((uintBinary<Checked, std::plus<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_SUB)
+        FLUIR_TRY((uintBinary<Checked, std::minus<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_MUL)
+        FLUIR_TRY((uintBinary<Checked, std::multiplies<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_DIV)
+        FLUIR_TRY((uintBinary<Checked, utility::checkedDivide<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_AFF)
+        FLUIR_HANDLER(I64_AFF)
+        FLUIR_HANDLER(U64_AFF)
+        FLUIR_NEXT();  // This is a No-Op
+        FLUIR_HANDLER(CAST_IU) {
+          const std::uint8_t width = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isInt));
+          FLUIR_TRY(checkWidth<Checked>(width));
+          code::PrimitiveType _;
+          auto casted = static_cast<code::U64>(utility::widenI(stack_.back(), _));
+          stack_.back() = utility::narrowU(casted, static_cast<code::PrimitiveType>(code::UNSIGNED | width));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_UI) {
+          const std::uint8_t width = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isUint));
+          FLUIR_TRY(checkWidth<Checked>(width));
+          code::PrimitiveType _;
+          auto casted = static_cast<code::I64>(utility::widenU(stack_.back(), _));
+          stack_.back() = utility::narrowI(casted, static_cast<code::PrimitiveType>(code::SIGNED | width));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_IF) {
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isInt));
+          code::PrimitiveType _;
+          stack_.back() = code::Value{static_cast<code::F64>(utility::widenI(stack_.back(), _))};
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_FI) {
+          const std::uint8_t width = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isFloat));
+          FLUIR_TRY(checkWidth<Checked>(width));
+          auto casted = static_cast<code::I64>(stack_.back().uncheckedAsF64());
+          stack_.back() = utility::narrowI(casted, static_cast<code::PrimitiveType>(code::SIGNED | width));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_UF) {
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isUint));
+          code::PrimitiveType _;
+          stack_.back() = code::Value{static_cast<code::F64>(utility::widenU(stack_.back(), _))};
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_FU) {
+          const std::uint8_t width = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkOperands<Checked>(1, utility::isFloat));
+          FLUIR_TRY(checkWidth<Checked>(width));
+          auto casted = static_cast<code::U64>(stack_.back().uncheckedAsF64());
+          stack_.back() = utility::narrowU(casted, static_cast<code::PrimitiveType>(code::UNSIGNED | width));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH2) {
+          const std::uint8_t first = FLUIR_READ_BYTE();
+          const std::uint8_t second = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkCapacity<Checked>(2));
+          FLUIR_TRY(checkConstant<Checked>(first, anyType));
+          FLUIR_TRY(checkConstant<Checked>(second, anyType));
+          pushConstant(first);
+          pushConstant(second);
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_PUSH_F64_ADD)
+        FLUIR_TRY((floatConstantBinary<Checked, std::plus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(PUSH_PUSH_F64_SUB)
+        FLUIR_TRY((floatConstantBinary<Checked, std::minus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(PUSH_PUSH_F64_MUL)
+        FLUIR_TRY((floatConstantBinary<Checked, std::multiplies<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(PUSH_PUSH_F64_DIV)
+        FLUIR_TRY((floatConstantBinary<Checked, std::divides<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_MUL_ADD) {
+          FLUIR_TRY(checkOperands<Checked>(3, utility::isFloat));
+          double rhs = stack_.back().uncheckedAsF64();
           stack_.pop_back();
-          break;
-        case EXIT:
-          // TODO: Clean up this testing code later...
-          goto afterLoop;
-        default:
-          return ExecResult::ERROR;
+          double mid = stack_.back().uncheckedAsF64();
+          stack_.pop_back();
+          double& lhs = stack_.back().uncheckedAsF64();
+          // Kept as two separately rounded operations so the result matches F64_MUL followed by F64_ADD. vm.cpp is built
+          // with -ffp-contract=off, so the compiler does not contract them into an FMA either.
+          const double product = mid * rhs;
+          lhs += product;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_F64_IMM) {
+          FLUIR_TRY(checkOperandBytes<Checked>(8));
+          FLUIR_TRY(checkCapacity<Checked>(1));
+          stack_.emplace_back(code::readOperand<code::F64>(ip_));
+          ip_ += 8;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_I64_IMM) {
+          FLUIR_TRY(checkOperandBytes<Checked>(8));
+          FLUIR_TRY(checkCapacity<Checked>(1));
+          stack_.emplace_back(code::readOperand<code::I64>(ip_));
+          ip_ += 8;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_SMALL_INT) {
+          const auto value = static_cast<std::int8_t>(FLUIR_READ_BYTE());
+          FLUIR_TRY(checkCapacity<Checked>(1));
+          stack_.emplace_back(static_cast<code::I64>(value));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_WIDE) {
+          FLUIR_TRY(checkOperandBytes<Checked>(2));
+          const auto index = code::readOperand<std::uint16_t>(ip_);
+          ip_ += 2;
+          FLUIR_TRY(checkCapacity<Checked>(1));
+          FLUIR_TRY(checkConstant<Checked>(index, anyType));
+          pushConstant(index);
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(PUSH_POP) {
+          const std::uint8_t index = FLUIR_READ_BYTE();
+          FLUIR_TRY(checkConstant<Checked>(index, anyType));
+          // Writes the constant like PUSH then POP would, without touching the stack
+          output().write(current_->constant(index));
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(POP)
+        FLUIR_TRY(checkOperands<Checked>(1, anyType));
+        // TODO: Remove this later
+        // This code is just for debugging purposes until the rest of the
+        // language is implemented
+        output().write(stack_.back());
+        stack_.pop_back();
+        FLUIR_NEXT();
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_INT_STACK_HANDLERS)
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_UINT_STACK_HANDLERS)
+        FLUIR_HANDLER(EXIT)
+        return ExecResult::SUCCESS;
+        // CAST_WIDTH is not executable yet, so it is as invalid as any unknown byte
+        FLUIR_HANDLER(CAST_WIDTH)
+        FLUIR_INVALID_HANDLER()
+        return raise(Fault::INVALID_INSTRUCTION);
       }
     }
-  afterLoop:
-    return ExecResult::SUCCESS;
   }
+
+#define FLUIR_SIZED_INT_REGISTER_HANDLERS(Type, Concrete) \
+  FLUIR_SIZED_INT_HANDLERS(Type, Concrete, sizedBinaryRegisters, sizedUnaryRegisters)
+#define FLUIR_SIZED_UINT_REGISTER_HANDLERS(Type, Concrete) \
+  FLUIR_SIZED_UINT_HANDLERS(Type, Concrete, sizedBinaryRegisters, sizedUnaryRegisters)
+
+  template <bool Checked, bool Budgeted, typename Instrument>
+  ExecResult VirtualMachine::runRegisters(Instrument& instrument) {
+    FLUIR_DISPATCH_TABLE();
+
+    using enum code::Instruction;
+    for (;;) {
+      FLUIR_DISPATCH() {
+        FLUIR_HANDLER(F64_ADD)
+        FLUIR_TRY((floatBinaryRegisters<Checked, std::plus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_SUB)
+        FLUIR_TRY((floatBinaryRegisters<Checked, std::minus<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_MUL)
+        FLUIR_TRY((floatBinaryRegisters<Checked, std::multiplies<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_DIV)
+        FLUIR_TRY((floatBinaryRegisters<Checked, std::divides<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_NEG)
+        FLUIR_TRY((floatUnaryRegisters<Checked, std::negate<code::F64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(F64_AFF)
+        FLUIR_TRY((floatUnaryRegisters<Checked, std::identity>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_ADD)
+        FLUIR_TRY((intBinaryRegisters<Checked, utility::wrapping<code::I64, std::plus>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_SUB)
+        FLUIR_TRY((intBinaryRegisters<Checked, utility::wrapping<code::I64, std::minus>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_MUL)
+        FLUIR_TRY((intBinaryRegisters<Checked, utility::wrapping<code::I64, std::multiplies>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_DIV)
+        FLUIR_TRY((intBinaryRegisters<Checked, utility::checkedDivide<code::I64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_NEG)
+        FLUIR_TRY((intUnaryRegisters<Checked, utility::wrapping<code::I64, std::negate>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(I64_AFF)
+        FLUIR_TRY((intUnaryRegisters<Checked, std::identity>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_ADD)
+        FLUIR_TRY((uintBinaryRegisters<Checked, std::plus<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_SUB)
+        FLUIR_TRY((uintBinaryRegisters<Checked, std::minus<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_MUL)
+        FLUIR_TRY((uintBinaryRegisters<Checked, std::multiplies<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_DIV)
+        FLUIR_TRY((uintBinaryRegisters<Checked, utility::checkedDivide<code::U64>>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(U64_AFF)
+        FLUIR_TRY((uintUnaryRegisters<Checked, std::identity>()));
+        FLUIR_NEXT();
+        FLUIR_HANDLER(CAST_IU) {
+          FLUIR_TRY(checkOperandBytes<Checked>(3));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isInt));
+          FLUIR_TRY(checkWidth<Checked>(ip_[2]));
+          code::PrimitiveType _;
+          auto widened = utility::widenI(registers_[ip_[1]], _);
+          auto type = static_cast<code::PrimitiveType>(code::UNSIGNED | ip_[2]);
+          registers_[ip_[0]] = utility::narrowU(static_cast<code::U64>(widened), type);
+          ip_ += 3;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_UI) {
+          FLUIR_TRY(checkOperandBytes<Checked>(3));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isUint));
+          FLUIR_TRY(checkWidth<Checked>(ip_[2]));
+          code::PrimitiveType _;
+          auto widened = utility::widenU(registers_[ip_[1]], _);
+          auto type = static_cast<code::PrimitiveType>(code::SIGNED | ip_[2]);
+          registers_[ip_[0]] = utility::narrowI(static_cast<code::I64>(widened), type);
+          ip_ += 3;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_IF) {
+          FLUIR_TRY(checkOperandBytes<Checked>(2));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isInt));
+          code::PrimitiveType _;
+          auto widened = utility::widenI(registers_[ip_[1]], _);
+          registers_[ip_[0]] = code::Value{static_cast<code::F64>(widened)};
+          ip_ += 2;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_UF) {
+          FLUIR_TRY(checkOperandBytes<Checked>(2));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isUint));
+          code::PrimitiveType _;
+          auto widened = utility::widenU(registers_[ip_[1]], _);
+          registers_[ip_[0]] = code::Value{static_cast<code::F64>(widened)};
+          ip_ += 2;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_FI) {
+          FLUIR_TRY(checkOperandBytes<Checked>(3));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isFloat));
+          FLUIR_TRY(checkWidth<Checked>(ip_[2]));
+          auto casted = static_cast<code::I64>(registers_[ip_[1]].uncheckedAsF64());
+          registers_[ip_[0]] = utility::narrowI(casted, static_cast<code::PrimitiveType>(code::SIGNED | ip_[2]));
+          ip_ += 3;
+          FLUIR_NEXT();
+        }
+        FLUIR_HANDLER(CAST_FU) {
+          FLUIR_TRY(checkOperandBytes<Checked>(3));
+          FLUIR_TRY(checkRegisters<Checked>({ip_[1]}, utility::isFloat));
+          FLUIR_TRY(checkWidth<Checked>(ip_[2]));
+          auto casted = static_cast<code::U64>(registers_[ip_[1]].uncheckedAsF64());
+          registers_[ip_[0]] = utility::narrowU(casted, static_cast<code::PrimitiveType>(code::UNSIGNED | ip_[2]));
+          ip_ += 3;
+          FLUIR_NEXT();
+        }
+        FLUIR_CODE_SIZED_INT_TYPES(FLUIR_SIZED_INT_REGISTER_HANDLERS)
+        FLUIR_CODE_SIZED_UINT_TYPES(FLUIR_SIZED_UINT_REGISTER_HANDLERS)
+        FLUIR_HANDLER(POP)
+        FLUIR_TRY(checkOperandBytes<Checked>(1));
+        output().write(registers_[FLUIR_READ_BYTE()]);
+        FLUIR_NEXT();
+        FLUIR_HANDLER(EXIT)
+        return ExecResult::SUCCESS;
+        // These are only part of the stack instruction set
+        FLUIR_HANDLER(PUSH)
+        FLUIR_HANDLER(CAST_WIDTH)
+        FLUIR_HANDLER(PUSH2)
+        FLUIR_HANDLER(PUSH_PUSH_F64_ADD)
+        FLUIR_HANDLER(PUSH_PUSH_F64_SUB)
+        FLUIR_HANDLER(PUSH_PUSH_F64_MUL)
+        FLUIR_HANDLER(PUSH_PUSH_F64_DIV)
+        FLUIR_HANDLER(PUSH_POP)
+        FLUIR_HANDLER(F64_MUL_ADD)
+        FLUIR_HANDLER(PUSH_F64_IMM)
+        FLUIR_HANDLER(PUSH_I64_IMM)
+        FLUIR_HANDLER(PUSH_SMALL_INT)
+        FLUIR_HANDLER(PUSH_WIDE)
+        FLUIR_INVALID_HANDLER()
+        return raise(Fault::INVALID_INSTRUCTION);
+      }
+    }
+  }
+
+#undef FLUIR_SIZED_UINT_REGISTER_HANDLERS
+#undef FLUIR_SIZED_INT_REGISTER_HANDLERS
+#undef FLUIR_SIZED_UINT_STACK_HANDLERS
+#undef FLUIR_SIZED_INT_STACK_HANDLERS
+#undef FLUIR_SIZED_UINT_HANDLERS
+#undef FLUIR_SIZED_INT_HANDLERS
+#undef FLUIR_BUDGET
+#undef FLUIR_NEXT
+#undef FLUIR_INVALID_HANDLER
+#undef FLUIR_HANDLER
+#undef FLUIR_DISPATCH
+#undef FLUIR_DISPATCH_TABLE
+#undef FLUIR_LABEL_ADDRESS
+#undef FLUIR_READ_BYTE
+#undef FLUIR_TRY
+
+#if FLUIR_VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
 }  // namespace fluir
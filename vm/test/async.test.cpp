@@ -0,0 +1,211 @@
+#include "vm/async.hpp"
+
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vm/program.hpp"
+#include "vm/thread_pool.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+using namespace std::chrono_literals;
+
+namespace {
+  /* Sums 1.5 additions + 1 times */
+  fc::ByteCode sum(std::size_t additions) {
+    fc::Chunk main{.name = "main", .code = {PUSH, 0}, .constants = {1.5_f64}};
+    for (std::size_t i = 0; i != additions; ++i) {
+      main.code.insert(main.code.end(), {PUSH, 0, F64_ADD});
+    }
+    main.code.push_back(EXIT);
+    return fc::ByteCode{.header = {}, .chunks = {std::move(main)}};
+  }
+
+  /* Awaits an execution, then records which one finished */
+  fluir::AsyncExecution record(fluir::AsyncExecution execution, std::mutex& mutex, std::vector<int>& order, int id) {
+    auto result = co_await std::move(execution);
+    std::lock_guard lock{mutex};
+    order.push_back(id);
+    co_return result;
+  }
+}  // namespace
+
+TEST(TestBudget, SuspendsAfterInstructionBudget) {
+  auto code = sum(2);
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(code, {.budget = {.instructions = 2}}));
+  EXPECT_EQ(2, vm.viewStack().size());
+
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.resume());
+  ASSERT_EQ(2, vm.viewStack().size());
+  EXPECT_EQ(3.0_f64, vm.viewStack().front());
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.resume());
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(4.5_f64, vm.viewStack().back());
+}
+
+TEST(TestBudget, SuspendsRegisterCode) {
+  auto code = fc::ByteCode{.header = {.filetype = fc::FILETYPE_REGISTERS},
+                           .chunks = {fc::Chunk{.name = "main",
+                                                .code = {F64_MUL, 2, 0, 1, F64_ADD, 2, 2, 0, EXIT},
+                                                .constants = {1.5_f64, 2.0_f64}}}};
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(code, {.budget = {.instructions = 1}}));
+  EXPECT_EQ(3.0_f64, vm.viewRegisters().at(2));
+
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.resume());
+  EXPECT_EQ(4.5_f64, vm.viewRegisters().at(2));
+
+  // Every resume gets a fresh budget, and EXIT does not take any of it
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.resume());
+}
+
+TEST(TestBudget, RunsWithoutLimitByDefault) {
+  auto code = sum(1'000);
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {}));
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(1501.5_f64, vm.viewStack().back());
+}
+
+TEST(TestBudget, SuspendsAfterTimeBudget) {
+  auto code = sum(1'000);
+  fluir::VirtualMachine vm;
+
+  auto result = vm.execute(code, {.budget = {.time = 1ns}});
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, result);
+  int resumed = 0;
+  while (result == fluir::ExecResult::SUSPENDED) {
+    result = vm.resume();
+    ++resumed;
+  }
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, result);
+  // The clock is only read every few hundred instructions, so the 2001 instructions take a handful of slices
+  EXPECT_LE(resumed, 2001 / 2);
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(1501.5_f64, vm.viewStack().back());
+}
+
+TEST(TestBudget, ResumesOnAnotherThread) {
+  auto code = sum(10);
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(code, {.budget = {.instructions = 5}}));
+
+  std::thread{[&vm, moved = std::move(vm)]() mutable {
+    while (moved.resume() == fluir::ExecResult::SUSPENDED) {
+    }
+    vm = std::move(moved);
+  }}.join();
+
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(16.5_f64, vm.viewStack().back());
+}
+
+TEST(TestBudget, RejectsResumeWithoutSuspension) {
+  auto code = sum(1);
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.resume());
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.budget = {.instructions = 10}}));
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.resume());
+}
+
+TEST(TestAsyncExecution, WaitsForTheResult) {
+  auto code = sum(100);
+  fluir::ThreadPool threads{2};
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.executeAsync(threads, code, {.budget = {.instructions = 7}}).wait());
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(151.5_f64, vm.viewStack().back());
+}
+
+TEST(TestAsyncExecution, ReportsFaults) {
+  auto code = fc::ByteCode{
+    .header = {}, .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, F64_ADD, EXIT}, .constants = {1.5_f64}}}};
+  fluir::ThreadPool threads{1};
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.executeAsync(threads, code, {.budget = {.instructions = 1}}).wait());
+  ASSERT_TRUE(vm.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::STACK_UNDERFLOW, vm.viewFault()->fault);
+}
+
+TEST(TestAsyncExecution, MultiplexesManyExecutions) {
+  const auto program = fluir::LoadedProgram::load(sum(100));
+  fluir::ThreadPool threads{2};
+  std::vector<fluir::ExecutionContext> contexts;
+  for (int i = 0; i != 1'000; ++i) {
+    contexts.emplace_back(program);
+  }
+
+  std::vector<fluir::AsyncExecution> executions;
+  for (auto& context : contexts) {
+    executions.push_back(context.executeAsync(threads, {.budget = {.instructions = 16}}));
+    executions.back().start();
+  }
+
+  for (std::size_t i = 0; i != executions.size(); ++i) {
+    EXPECT_EQ(fluir::ExecResult::SUCCESS, executions[i].wait()) << "execution " << i;
+    EXPECT_EQ(151.5_f64, contexts[i].viewStack().back()) << "execution " << i;
+  }
+}
+
+TEST(TestAsyncExecution, ShortExecutionsOvertakeLongOnes) {
+  auto longCode = sum(100'000);
+  auto shortCode = sum(10);
+  fluir::ThreadPool threads{1};
+  fluir::VirtualMachine longVm;
+  fluir::VirtualMachine shortVm;
+  std::mutex mutex;
+  std::vector<int> order;
+
+  // Hold up the only worker until both executions are queued
+  std::latch queued{1};
+  threads.submit([&queued] { queued.wait(); });
+  auto longExecution =
+    record(longVm.executeAsync(threads, longCode, {.budget = {.instructions = 100}}), mutex, order, 0);
+  auto shortExecution =
+    record(shortVm.executeAsync(threads, shortCode, {.budget = {.instructions = 100}}), mutex, order, 1);
+  longExecution.start();
+  shortExecution.start();
+  queued.count_down();
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, longExecution.wait());
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, shortExecution.wait());
+  EXPECT_EQ((std::vector<int>{1, 0}), order);
+}
+
+TEST(TestAsyncExecution, CanBeAwaited) {
+  auto code = sum(10);
+  fluir::ThreadPool threads{1};
+  fluir::VirtualMachine first;
+  fluir::VirtualMachine second;
+  std::mutex mutex;
+  std::vector<int> order;
+
+  auto both = [&]() -> fluir::AsyncExecution {
+    auto result = co_await record(first.executeAsync(threads, code, {.budget = {.instructions = 3}}), mutex, order, 0);
+    if (result != fluir::ExecResult::SUCCESS) {
+      co_return result;
+    }
+    co_return co_await record(second.executeAsync(threads, code, {}), mutex, order, 1);
+  };
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, both().wait());
+  EXPECT_EQ((std::vector<int>{0, 1}), order);
+  EXPECT_EQ(16.5_f64, second.viewStack().back());
+}
@@ -0,0 +1,232 @@
+#include <bit>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/fuser.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
+using namespace fluir::code::value_literals;
+
+namespace {
+  constexpr std::size_t ROWS = 37;  // Not a multiple of the vector width, so the scalar tails run too
+
+  /* A column of random values with the type of value */
+  fluir::Column randomColumn(const fc::Value& value, std::mt19937_64& random) {
+    std::vector<std::uint64_t> bits;
+    for (std::size_t row = 0; row != ROWS; ++row) {
+      bits.push_back(random());
+    }
+    switch (value.type()) {
+      case fc::PrimitiveType::F64: {
+        std::vector<fc::F64> values;
+        std::uniform_real_distribution<fc::F64> distribution(-1000.0, 1000.0);
+        for (std::size_t row = 0; row != ROWS; ++row) {
+          values.push_back(row % 9 == 0 ? 0.0 : distribution(random));
+        }
+        return fluir::Column::from(std::span<const fc::F64>{values});
+      }
+#define FLUIR_RANDOM_INT_COLUMN(Type, Concrete)                                  \
+  case fc::PrimitiveType::Type: {                                                \
+    std::vector<Concrete> values;                                                \
+    for (auto lane : bits) {                                                     \
+      /* Keep divisors away from zero */                                         \
+      values.push_back(static_cast<Concrete>(lane == 0 ? 1 : lane));             \
+    }                                                                            \
+    return fluir::Column::from(std::span<const Concrete>{values});               \
+  }
+        FLUIR_RANDOM_INT_COLUMN(I8, fc::I8)
+        FLUIR_RANDOM_INT_COLUMN(I16, fc::I16)
+        FLUIR_RANDOM_INT_COLUMN(I32, fc::I32)
+        FLUIR_RANDOM_INT_COLUMN(I64, fc::I64)
+        FLUIR_RANDOM_INT_COLUMN(U8, fc::U8)
+        FLUIR_RANDOM_INT_COLUMN(U16, fc::U16)
+        FLUIR_RANDOM_INT_COLUMN(U32, fc::U32)
+        FLUIR_RANDOM_INT_COLUMN(U64, fc::U64)
+#undef FLUIR_RANDOM_INT_COLUMN
+    }
+    return {};
+  }
+
+  /* Values are compared by their bits so F64 NaNs and signed zeros must match exactly too */
+  void expectSame(const fc::Value& expected, const fc::Value& actual) {
+    ASSERT_EQ(expected.type(), actual.type());
+    if (expected.type() == fc::PrimitiveType::F64) {
+      EXPECT_EQ(std::bit_cast<std::uint64_t>(expected.asF64()), std::bit_cast<std::uint64_t>(actual.asF64()));
+    } else {
+      EXPECT_EQ(expected, actual);
+    }
+  }
+
+  /* Runs the chunk as a batch over random inputs for every constant, then runs every row through the interpreter with
+   * that row's inputs as its constants and compares what is left on the stack. */
+  void expectSameAsInterpreter(const fc::Chunk& chunk) {
+    std::mt19937_64 random{42};
+    std::vector<fluir::Column> inputs;
+    for (const auto& constant : chunk.constants) {
+      inputs.push_back(randomColumn(constant, random));
+    }
+
+    auto code = withChunk(chunk);
+    fluir::VirtualMachine batch;
+    ASSERT_EQ(fluir::ExecResult::SUCCESS, batch.executeBatch(fluir::verify(code), inputs));
+    const auto& columns = batch.viewColumns();
+
+    for (std::size_t row = 0; row != ROWS; ++row) {
+      SCOPED_TRACE(row);
+      auto rowCode = withChunk(chunk);
+      for (std::size_t i = 0; i != inputs.size(); ++i) {
+        rowCode.chunks[0].constants[i] = inputs[i].at(row);
+      }
+      fluir::VirtualMachine vm;
+      ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(&rowCode));
+      ASSERT_EQ(vm.viewStack().size(), columns.size());
+      for (std::size_t slot = 0; slot != columns.size(); ++slot) {
+        expectSame(vm.viewStack()[slot], columns[slot].at(row));
+      }
+    }
+  }
+}  // namespace
+
+TEST(TestBatch, BroadcastsConstantsWithoutInputs) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, POP, PUSH, 1, EXIT},
+                                  .constants = {1.5_f64, 2.0_f64}});
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.executeBatch(fluir::verify(code), {}));
+
+  ASSERT_EQ(1, vm.viewOutputs().size());
+  ASSERT_EQ(1, vm.viewOutputs()[0].size());
+  EXPECT_EQ(3.5_f64, vm.viewOutputs()[0].at(0));
+  ASSERT_EQ(1, vm.viewColumns().size());
+  EXPECT_EQ(2.0_f64, vm.viewColumns()[0].at(0));
+}
+
+TEST(TestBatch, StartsFromTheHeadersEntryChunk) {
+  fc::ByteCode code{.header = {.entryOffset = 1},
+                    .chunks = {fc::Chunk{.code = {EXIT}}, fc::Chunk{.code = {PUSH, 0, EXIT}, .constants = {1.5_f64}}}};
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.executeBatch(fluir::verify(code), {}));
+
+  ASSERT_EQ(1, vm.viewColumns().size());
+  EXPECT_EQ(1.5_f64, vm.viewColumns()[0].at(0));
+}
+
+TEST(TestBatch, ReplacesConstantsWithInputs) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_MUL, POP, EXIT}, .constants = {1_i64, 3_i64}});
+  std::vector<fc::I64> values{1, 2, 3, 4, 5, 6};
+  std::vector<fluir::Column> inputs{fluir::Column::from(std::span<const fc::I64>{values})};
+
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.executeBatch(fluir::verify(code), inputs));
+  ASSERT_EQ(1, vm.viewOutputs().size());
+  const auto& output = vm.viewOutputs()[0];
+  ASSERT_EQ(values.size(), output.size());
+  for (std::size_t row = 0; row != values.size(); ++row) {
+    EXPECT_EQ(fc::Value{values[row] * 3}, output.at(row));
+  }
+}
+
+TEST(TestBatch, RejectsMismatchedInputs) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.0_f64, 2.0_f64}});
+  auto verified = fluir::verify(code);
+  std::vector<fc::F64> floats{1.0, 2.0};
+  std::vector<fc::F64> shorter{1.0};
+  std::vector<fc::I64> ints{1, 2};
+
+  fluir::VirtualMachine vm;
+  std::vector<fluir::Column> wrongType{fluir::Column::from(std::span<const fc::I64>{ints})};
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.executeBatch(verified, wrongType));
+  std::vector<fluir::Column> wrongLength{fluir::Column::from(std::span<const fc::F64>{floats}),
+                                         fluir::Column::from(std::span<const fc::F64>{shorter})};
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.executeBatch(verified, wrongLength));
+  std::vector<fluir::Column> tooMany(3, fluir::Column::from(std::span<const fc::F64>{floats}));
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.executeBatch(verified, tooMany));
+}
+
+TEST(TestBatch, ReportsDivisionByZero) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, U64_DIV, EXIT}, .constants = {1_u64, 1_u64}});
+  std::vector<fc::U64> divisors{3, 2, 1, 0, 5};
+  std::vector<fluir::Column> inputs{fluir::Column::from(std::span<const fc::U64>{divisors}),
+                                    fluir::Column::from(std::span<const fc::U64>{divisors})};
+
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, vm.executeBatch(fluir::verify(code), inputs));
+  ASSERT_TRUE(vm.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::DIVIDE_BY_ZERO, vm.viewFault()->fault);
+  EXPECT_EQ(4, vm.viewFault()->offset);
+}
+
+TEST(TestBatch, WrapsTheQuotientOfTheSmallestIntAndMinusOne) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_DIV, EXIT}, .constants = {1_i64, 1_i64}});
+  constexpr auto MIN = std::numeric_limits<fc::I64>::min();
+  std::vector<fc::I64> dividends{MIN, MIN, 6};
+  std::vector<fc::I64> divisors{-1, 2, -1};
+  std::vector<fluir::Column> inputs{fluir::Column::from(std::span<const fc::I64>{dividends}),
+                                    fluir::Column::from(std::span<const fc::I64>{divisors})};
+
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.executeBatch(fluir::verify(code), inputs));
+  ASSERT_EQ(1, vm.viewColumns().size());
+  const auto& quotients = vm.viewColumns()[0];
+  EXPECT_EQ(fc::Value{MIN}, quotients.at(0));
+  EXPECT_EQ(fc::Value{MIN / 2}, quotients.at(1));
+  EXPECT_EQ(fc::Value{static_cast<fc::I64>(-6)}, quotients.at(2));
+}
+
+TEST(TestBatch, MatchesInterpreterOnF64) {
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, PUSH, 2, F64_MUL, PUSH, 1, F64_SUB, PUSH, 0,
+                                             F64_DIV, F64_NEG, F64_AFF, PUSH, 2, PUSH, 0, F64_DIV, EXIT},
+                                    .constants = {1.5_f64, 0.25_f64, 3.0_f64}});
+}
+
+TEST(TestBatch, MatchesInterpreterOnSuperinstructions) {
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, PUSH, 2, F64_MUL, F64_ADD, PUSH, 0, PUSH, 1, F64_SUB,
+                                           PUSH, 1, PUSH, 2, PUSH, 2, F64_DIV, PUSH, 0, PUSH, 0, EXIT},
+                                  .constants = {1.5_f64, 0.25_f64, 3.0_f64}});
+  fluir::fuse(code);
+  expectSameAsInterpreter(code.chunks[0]);
+}
+
+TEST(TestBatch, MatchesInterpreterOnIntegers) {
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_ADD, PUSH, 2, I64_MUL, PUSH, 3, I64_SUB, PUSH, 1,
+                                             I64_DIV, I64_NEG, I64_AFF, EXIT},
+                                    .constants = {1_i8, 2_i16, 3_i32, 4_i64}});
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_ADD, PUSH, 0, I64_MUL, PUSH, 1, I64_DIV, EXIT},
+                                    .constants = {1_i8, 2_i8}});
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 1, U64_ADD, PUSH, 2, U64_MUL, PUSH, 3, U64_SUB, PUSH, 1,
+                                             U64_DIV, U64_AFF, EXIT},
+                                    .constants = {1_u8, 2_u16, 3_u32, 4_u64}});
+}
+
+TEST(TestBatch, MatchesInterpreterOnCasts) {
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, CAST_IU, WIDTH_16, PUSH, 0, CAST_IF, PUSH, 1, CAST_UI, WIDTH_8,
+                                             PUSH, 1, CAST_UF, PUSH, 2, CAST_FI, WIDTH_32, PUSH, 2, CAST_FU, WIDTH_8,
+                                             PUSH, 2, CAST_FI, WIDTH_64, CAST_IF, EXIT},
+                                    .constants = {1_i32, 2_u64, 3.0_f64}});
+}
+
+TEST(TestBatch, MatchesInterpreterOnSizedIntegers) {
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 0, I8_MUL, PUSH, 0, I8_SUB, I8_NEG, PUSH, 1, PUSH, 1,
+                                             I16_DIV, PUSH, 2, PUSH, 2, I32_ADD, PUSH, 2, I32_DIV, EXIT},
+                                    .constants = {1_i8, 2_i16, 3_i32}});
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH, 0, PUSH, 0, U8_MUL, PUSH, 0, U8_SUB, PUSH, 1, PUSH, 1, U16_DIV,
+                                             PUSH, 2, PUSH, 2, U32_ADD, PUSH, 2, U32_DIV, EXIT},
+                                    .constants = {1_u8, 2_u16, 3_u32}});
+}
+
+TEST(TestBatch, MatchesInterpreterOnImmediatesAndWideConstants) {
+  // Enough constants for PUSH_WIDE to name one PUSH cannot. Every one of them is replaced by an input.
+  std::vector<fc::Value> constants(257, 1.0_f64);
+  // 2.0 is x4000000000000000, stored little endian
+  expectSameAsInterpreter(fc::Chunk{.code = {PUSH_WIDE, 0x00, 0x01, PUSH_F64_IMM, 0, 0, 0, 0, 0, 0, 0, 0x40, F64_MUL,
+                                             PUSH_I64_IMM, 5, 0, 0, 0, 0, 0, 0, 0, PUSH_SMALL_INT, 0xFD, I64_MUL,
+                                             CAST_IF, F64_ADD, PUSH, 0, F64_SUB, EXIT},
+                                    .constants = constants});
+}
@@ -4,6 +4,7 @@
 
 #include <gtest/gtest.h>
 
+#include "vm/verifier.hpp"
 #include "vm/vm.hpp"
 
 using std::tuple;
@@ -32,6 +33,23 @@ TEST_P(TestCasting, Test) {
   }
 }
 
+TEST_P(TestCasting, TestVerified) {
+  auto [expected, chunk] = GetParam();
+  // Add postamble to bytecode to make it execute correctly without requiring too much boilerplate in tests
+  chunk.code.push_back(EXIT);
+  fc::ByteCode code{.header = {}, .chunks = {std::move(chunk)}};
+
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(fluir::verify(code)));
+  auto actual = vm.viewStack().back();
+  if (actual.type() == fc::PrimitiveType::F64) {
+    // stupid double epsilon issues
+    EXPECT_DOUBLE_EQ(expected.asF64(), actual.asF64());
+  } else {
+    EXPECT_EQ(expected, actual);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
   I8toU,
   TestCasting,
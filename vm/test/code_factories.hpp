@@ -0,0 +1,37 @@
+#ifndef FLUIR_VM_TEST_CODE_FACTORIES_HPP
+#define FLUIR_VM_TEST_CODE_FACTORIES_HPP
+
+#include <string>
+#include <utility>
+
+#include "bytecode/byte_code.hpp"
+#include "vm/exceptions.hpp"
+#include "vm/verifier.hpp"
+
+/** ByteCode with a default header whose only chunk is chunk */
+inline fluir::code::ByteCode withChunk(fluir::code::Chunk chunk) {
+  return fluir::code::ByteCode{.header = {}, .chunks = {std::move(chunk)}};
+}
+
+/** ByteCode with two chunks: "first" pushes 1.0 and "second" pushes 2.0 twice and adds them */
+inline fluir::code::ByteCode twoChunks() {
+  namespace fc = fluir::code;
+  using enum fc::Instruction;
+  using namespace fc::value_literals;
+  return fc::ByteCode{
+    .header = {},
+    .chunks = {fc::Chunk{.name = "first", .code = {PUSH, 0, EXIT}, .constants = {1.0_f64}},
+               fc::Chunk{.name = "second", .code = {PUSH, 0, PUSH, 0, F64_ADD, EXIT}, .constants = {2.0_f64}}}};
+}
+
+/** The message of the VerificationError verifying code throws, or an empty string if code verifies */
+inline std::string verificationMessage(const fluir::code::ByteCode& code) {
+  try {
+    fluir::verify(code);
+  } catch (const fluir::VerificationError& e) {
+    return e.what();
+  }
+  return "";
+}
+
+#endif
@@ -0,0 +1,337 @@
+#include "vm/decoder/binary.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bytecode/binary_format.hpp"
+#include "bytecode_assertions.hpp"
+#include "vm/decoder/decode.hpp"
+#include "vm/thread_pool.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  std::string encoded(const fc::ByteCode& code) {
+    const auto bytes = fc::binary::encode(code);
+    return std::string{bytes.begin(), bytes.end()};
+  }
+
+  fc::ByteCode simple() {
+    return fc::ByteCode{
+      .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+      .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, POP, EXIT}, .constants = {1.5_f64}}}};
+  }
+
+  /** The u64 at offset of file */
+  std::uint64_t read(const std::string& file, std::size_t offset) {
+    return fc::readOperand<std::uint64_t>(reinterpret_cast<const std::uint8_t*>(file.data() + offset));
+  }
+
+  /** Overwrites the u64 at offset of file */
+  void patch(std::string& file, std::size_t offset, std::uint64_t value) {
+    fc::writeOperand(value, reinterpret_cast<std::uint8_t*>(file.data() + offset));
+  }
+
+  /** The offset of the entry for section in the section table */
+  constexpr std::size_t entry(std::size_t section) {
+    return fc::binary::HEADER_SIZE + section * fc::binary::SECTION_ENTRY_SIZE;
+  }
+}  // namespace
+
+TEST(TestBinaryDecoder, DecodesWhatWasEncoded) {
+  fc::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 7},
+    .chunks = {fc::Chunk{.name = "main",
+                         .code = {PUSH, 0, PUSH, 1, F64_ADD, POP, EXIT},
+                         .constants = {1.5_f64, fc::Value{-0.0}},
+                         .subgraphs = {{.chunk = 1, .dependencies = {}}, {.chunk = 2, .dependencies = {0}}},
+                         .debug = {{.offset = 0, .node = 26, .x = -5, .y = 6, .z = 0, .width = 7, .height = 8}}},
+               fc::Chunk{.name = "main_sink0",
+                         .code = {PUSH, 0, POP, EXIT},
+                         .constants = {fc::Value{std::int8_t{-3}},
+                                       fc::Value{std::int16_t{-300}},
+                                       fc::Value{std::int32_t{-70000}},
+                                       fc::Value{std::int64_t{-1}},
+                                       255_u8,
+                                       65535_u16,
+                                       4000000000_u32,
+                                       18446744073709551615_u64}},
+               fc::Chunk{.name = "", .code = {EXIT}, .constants = {}}}};
+
+  auto actual = fluir::BinaryDecoder{}.decode(encoded(expected));
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  ASSERT_EQ(expected.chunks.size(), actual.chunks.size());
+  for (std::size_t i = 0; i != expected.chunks.size(); ++i) {
+    EXPECT_CHUNK_EQ(expected.chunks[i], actual.chunks[i]);
+  }
+  EXPECT_TRUE(std::signbit(actual.chunks[0].constants[1].asF64()));
+  ASSERT_EQ(2, actual.chunks[0].subgraphs.size());
+  EXPECT_EQ(2, actual.chunks[0].subgraphs[1].chunk);
+  EXPECT_EQ(std::vector<std::size_t>{0}, actual.chunks[0].subgraphs[1].dependencies);
+  EXPECT_EQ(expected.chunks[0].debug, actual.chunks[0].debug);
+  EXPECT_TRUE(actual.chunks[1].debug.empty());
+}
+
+TEST(TestBinaryDecoder, KeepsTheRegisterInstructionSet) {
+  auto code = simple();
+  code.header.filetype = fc::FILETYPE_REGISTERS;
+
+  EXPECT_TRUE(fc::usesRegisters(fluir::BinaryDecoder{}.decode(encoded(code)).header));
+}
+
+TEST(TestBinaryDecoder, ExpandsSharedConstants) {
+  auto code = simple();
+  code.constants = std::move(code.chunks[0].constants);
+  code.chunks[0].constants.clear();
+
+  auto actual = fluir::BinaryDecoder{}.decode(encoded(code));
+
+  EXPECT_EQ((std::vector{1.5_f64}), actual.chunks[0].constants);
+  EXPECT_TRUE(actual.constants.empty());
+}
+
+TEST(TestBinaryDecoder, SkipsUnknownSections) {
+  auto file = encoded(simple());
+  // Turn the CONSTANTS section into a kind from the future
+  fc::writeOperand(std::uint32_t{99}, reinterpret_cast<std::uint8_t*>(file.data() + entry(2)));
+
+  auto actual = fluir::BinaryDecoder{}.decode(file);
+
+  ASSERT_EQ(1, actual.chunks.size());
+  EXPECT_TRUE(actual.chunks[0].constants.empty());
+  EXPECT_EQ((fc::Bytes{PUSH, 0, POP, EXIT}), actual.chunks[0].code);
+}
+
+TEST(TestBinaryDecoder, RejectsMalformedFiles) {
+  const auto file = encoded(simple());
+  const auto throwsOn = [](const std::string& file) {
+    EXPECT_THROW(fluir::BinaryDecoder{}.decode(file), std::runtime_error);
+    const std::span bytes{reinterpret_cast<const std::uint8_t*>(file.data()), file.size()};
+    EXPECT_THROW(fluir::BinaryDecoder{}.decodeInPlace(bytes), std::runtime_error);
+  };
+
+  throwsOn(file.substr(0, fc::binary::HEADER_SIZE - 1));
+  // The section table runs past the end of the file
+  throwsOn(file.substr(0, entry(3)));
+  // The CODE section runs past the end of the file
+  throwsOn(file.substr(0, read(file, entry(3) + 8) + read(file, entry(3) + 16) - 1));
+
+  auto instructionSet = file;
+  instructionSet[4] = 'X';
+  throwsOn(instructionSet);
+
+  auto misaligned = file;
+  patch(misaligned, entry(3) + 8, read(file, entry(3) + 8) + 1);
+  throwsOn(misaligned);
+
+  auto beforeName = file;
+  // Move the CONSTANTS section to a chunk which has not started
+  fc::writeOperand(std::uint32_t{1}, reinterpret_cast<std::uint8_t*>(beforeName.data() + entry(2) + 4));
+  throwsOn(beforeName);
+
+  auto constantType = file;
+  // The type of the only constant comes right after the count
+  const auto constants = read(file, entry(2) + 8);
+  constantType[constants + 8] = 0x7F;
+  throwsOn(constantType);
+
+  auto hugeCount = file;
+  patch(hugeCount, constants, 1ull << 40);
+  throwsOn(hugeCount);
+}
+
+TEST(TestBinaryDecoder, DecodesChunksFromTheDirectory) {
+  fc::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 1},
+    .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, POP, EXIT}, .constants = {}},
+               fc::Chunk{.name = "helper",
+                         .code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT},
+                         .constants = {1.5_f64, 2.5_f64},
+                         .subgraphs = {{.chunk = 0, .dependencies = {}}},
+                         .debug = {{.offset = 4, .node = 3, .x = 1, .y = 2, .z = 0, .width = 3, .height = 4}}}},
+    .constants = {0.5_f64}};
+  const auto file = fc::binary::encode(expected);
+  fluir::BinaryDecoder uut;
+
+  auto actual = uut.decodeDirectory(file);
+
+  ASSERT_TRUE(actual.has_value());
+  EXPECT_BC_HEADER_EQ(expected.header, actual->header);
+  // Every chunk is left empty until it is decoded
+  ASSERT_EQ(2, actual->chunks.size());
+  EXPECT_TRUE(actual->chunks[0].name.empty());
+  EXPECT_TRUE(actual->chunks[1].instructions().empty());
+  EXPECT_EQ("helper", uut.chunkName(1));
+
+  const auto helper = uut.decodeChunk(1);
+  EXPECT_EQ("helper", helper.name);
+  EXPECT_EQ(expected.chunks[1].code, fc::Bytes(helper.instructions().begin(), helper.instructions().end()));
+  ASSERT_EQ(2, helper.constantCount());
+  EXPECT_EQ(2.5_f64, helper.constant(1));
+  ASSERT_EQ(1, helper.subgraphs.size());
+  EXPECT_EQ(0, helper.subgraphs[0].chunk);
+  EXPECT_EQ(expected.chunks[1].debug, helper.debug);
+  // Chunks without constants of their own read the shared table
+  const auto main = uut.decodeChunk(0);
+  ASSERT_EQ(1, main.constantCount());
+  EXPECT_EQ(0.5_f64, main.constant(0));
+}
+
+TEST(TestBinaryDecoder, DecodesFilesWithoutADirectoryAllAtOnce) {
+  auto file = fc::binary::encode(simple());
+  // Turn the directory into a kind from the future
+  fc::writeOperand(std::uint32_t{99}, file.data() + entry(0));
+
+  EXPECT_FALSE(fluir::BinaryDecoder{}.decodeDirectory(file).has_value());
+  EXPECT_EQ("main", fluir::BinaryDecoder{}.decodeInPlace(file).chunks.at(0).name);
+}
+
+TEST(TestBinaryDecoder, RejectsMalformedDirectories) {
+  const auto file = encoded(simple());
+  const auto bytes = [](const std::string& file) {
+    return std::span{reinterpret_cast<const std::uint8_t*>(file.data()), file.size()};
+  };
+  // The directory's count comes first, then the offset, size, first section and number of sections of the chunk
+  const auto directory = read(file, entry(0) + 8);
+
+  auto missingSections = file;
+  patch(missingSections, directory + 24, 0x0000'0009'0000'0001);
+  EXPECT_THROW(fluir::BinaryDecoder{}.decodeDirectory(bytes(missingSections)), std::runtime_error);
+
+  auto overlapping = file;
+  patch(overlapping, directory + 24, 0x0000'0003'0000'0000);
+  EXPECT_THROW(fluir::BinaryDecoder{}.decodeDirectory(bytes(overlapping)), std::runtime_error);
+
+  auto outside = file;
+  // The chunk claims to end before its CODE section
+  patch(outside, directory + 16, read(file, entry(3) + 8) - read(file, directory + 8));
+  fluir::BinaryDecoder uut;
+  ASSERT_TRUE(uut.decodeDirectory(bytes(outside)).has_value());
+  EXPECT_THROW(static_cast<void>(uut.decodeChunk(0)), std::runtime_error);
+  EXPECT_THROW(static_cast<void>(uut.decodeChunk(1)), std::out_of_range);
+}
+
+TEST(TestBinaryDecoder, DecodesChunksOnThreads) {
+  fc::ByteCode code{.header = {.filetype = 'I', .major = 1, .minor = 0, .patch = 0, .entryOffset = 3},
+                    .constants = {0.5_f64}};
+  for (std::size_t i = 0; i != 40; ++i) {
+    // Every third chunk uses the shared constants
+    auto constants = i % 3 == 0 ? std::vector<fc::Value>{} : std::vector{fc::Value{1.0 * i}};
+    code.chunks.push_back(fc::Chunk{.name = "chunk" + std::to_string(i),
+                                    .code = {PUSH, 0, POP, EXIT},
+                                    .constants = std::move(constants),
+                                    .subgraphs = {{.chunk = i, .dependencies = {}}}});
+  }
+  const auto file = fc::binary::encode(code);
+  fluir::ThreadPool pool{4};
+
+  const auto expected = fluir::BinaryDecoder{}.decode(encoded(code));
+  const auto copied = fluir::BinaryDecoder{}.decode(encoded(code), pool);
+  const auto inPlace = fluir::BinaryDecoder{}.decodeInPlace(file, pool);
+
+  EXPECT_BC_HEADER_EQ(expected.header, copied.header);
+  EXPECT_BC_HEADER_EQ(expected.header, inPlace.header);
+  ASSERT_EQ(expected.chunks.size(), copied.chunks.size());
+  ASSERT_EQ(expected.chunks.size(), inPlace.chunks.size());
+  for (std::size_t i = 0; i != expected.chunks.size(); ++i) {
+    EXPECT_CHUNK_EQ(expected.chunks[i], copied.chunks[i]);
+    ASSERT_EQ(1, copied.chunks[i].subgraphs.size());
+    EXPECT_EQ(i, copied.chunks[i].subgraphs[0].chunk);
+    EXPECT_EQ(expected.chunks[i].name, inPlace.chunks[i].name);
+    EXPECT_EQ(expected.chunks[i].instructions().size(), inPlace.chunks[i].instructions().size());
+    ASSERT_EQ(expected.chunks[i].constantCount(), inPlace.chunks[i].constantCount());
+    EXPECT_EQ(expected.chunks[i].constant(0), inPlace.chunks[i].constant(0));
+  }
+  EXPECT_TRUE(copied.constants.empty());
+}
+
+TEST(TestBinaryDecoder, DecodesFilesWithoutADirectoryOnTheCallingThread) {
+  auto file = encoded(simple());
+  fc::writeOperand(std::uint32_t{99}, reinterpret_cast<std::uint8_t*>(file.data() + entry(0)));
+  fluir::ThreadPool pool{2};
+
+  auto actual = fluir::BinaryDecoder{}.decode(file, pool);
+
+  ASSERT_EQ(1, actual.chunks.size());
+  EXPECT_CHUNK_EQ(simple().chunks[0], actual.chunks[0]);
+}
+
+TEST(TestBinaryDecoder, IsSelectedByDecode) {
+  const auto expected = simple();
+
+  auto actual = fluir::decode(encoded(expected));
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  EXPECT_CHUNK_EQ(expected.chunks[0], actual.chunks[0]);
+}
+
+TEST(TestBinaryDecoder, DecodesInPlace) {
+  auto expected = simple();
+  expected.chunks[0].constants.push_back(fc::Value{-0.0});
+  const auto file = fc::binary::encode(expected);
+
+  auto actual = fluir::BinaryDecoder{}.decodeInPlace(file);
+
+  ASSERT_EQ(1, actual.chunks.size());
+  const auto& chunk = actual.chunks[0];
+  EXPECT_EQ("main", chunk.name);
+  EXPECT_TRUE(chunk.code.empty());
+  EXPECT_TRUE(chunk.constants.empty());
+  // The code is read straight out of the file
+  const auto code = chunk.instructions();
+  EXPECT_GE(code.data(), file.data());
+  EXPECT_LE(code.data() + code.size(), file.data() + file.size());
+  EXPECT_EQ(expected.chunks[0].code, fc::Bytes(code.begin(), code.end()));
+  ASSERT_EQ(2, chunk.constantCount());
+  EXPECT_EQ(1.5_f64, chunk.constant(0));
+  EXPECT_EQ(fc::PrimitiveType::F64, chunk.constantType(1));
+  EXPECT_TRUE(std::signbit(chunk.f64Constant(1)));
+}
+
+TEST(TestBinaryDecoder, SharesSharedConstantsInPlace) {
+  auto code = simple();
+  code.constants = std::move(code.chunks[0].constants);
+  code.chunks[0].constants.clear();
+  const auto file = fc::binary::encode(code);
+
+  auto actual = fluir::BinaryDecoder{}.decodeInPlace(file);
+
+  ASSERT_EQ(1, actual.chunks[0].constantCount());
+  EXPECT_EQ(1.5_f64, actual.chunks[0].constant(0));
+  EXPECT_TRUE(actual.chunks[0].constants.empty());
+}
+
+TEST(TestBinaryDecoder, LoadsFilesInPlace) {
+  const fc::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.5_f64, 0.25_f64}}}};
+  const auto path = std::filesystem::temp_directory_path() / "in_place.flb";
+  {
+    std::ofstream fout{path, std::ios::binary};
+    fout << encoded(expected);
+  }
+
+  auto actual = fluir::load(path.string());
+  // The mapping outlives the file's name
+  std::filesystem::remove(path);
+
+  EXPECT_NE(nullptr, actual.storage);
+  EXPECT_TRUE(actual.chunks.at(0).code.empty());
+  fluir::VirtualMachine checked;
+  fluir::VirtualMachine verified;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, checked.execute(&actual));
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, verified.execute(fluir::verify(actual)));
+  EXPECT_EQ(std::vector{1.75_f64}, checked.viewStack());
+  EXPECT_EQ(std::vector{1.75_f64}, verified.viewStack());
+}
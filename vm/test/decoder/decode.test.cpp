@@ -1,6 +1,10 @@
 #include "vm/decoder/decode.hpp"
 
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -74,3 +78,46 @@ IPOP IEXIT
 
   EXPECT_THROW(fluir::decode(source), std::runtime_error);
 }
+
+TEST(TestDecoder, SelectsInspectForRegisterCode) {
+  std::string source = R"(R0120030000000000000000
+CHUNK main
+CONSTANTS x02
+VF64 1.0 VF64 2.0
+CODE x07
+IF64_ADD x2 x0 x1
+IPOP x2
+IEXIT
+)";
+  fluir::code::ByteCode expected{
+    .header = {.filetype = 'R', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{
+      .name = "main", .code = {F64_ADD, 0x02, 0x00, 0x01, POP, 0x02, EXIT}, .constants = {1.0_f64, 2.0_f64}}}};
+
+  auto actual = fluir::decode(source);
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.chunks.at(0));
+}
+
+TEST(TestDecoder, LoadsTextFilesByDecodingThem) {
+  const auto path = std::filesystem::temp_directory_path() / "load.flc";
+  {
+    std::ofstream fout{path};
+    fout << "I0120030000000000000000\nCHUNK main\nCONSTANTS x01\nVF64 1.5\nCODE x04\nIPUSH x00 IPOP IEXIT\n";
+  }
+
+  auto actual = fluir::load(path.string());
+  std::filesystem::remove(path);
+
+  // Nothing points into the file, so there is nothing to keep alive
+  EXPECT_EQ(nullptr, actual.storage);
+  ASSERT_EQ(1, actual.chunks.size());
+  EXPECT_EQ("main", actual.chunks[0].name);
+  EXPECT_EQ((fluir::code::Bytes{PUSH, 0, POP, EXIT}), actual.chunks[0].code);
+  EXPECT_EQ(std::vector{1.5_f64}, actual.chunks[0].constants);
+}
+
+TEST(TestDecoder, LoadThrowsOnMissingFiles) {
+  EXPECT_THROW(fluir::load((std::filesystem::temp_directory_path() / "missing.flc").string()), std::runtime_error);
+}
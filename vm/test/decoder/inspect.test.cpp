@@ -1,11 +1,15 @@
 #include "vm/decoder/inspect.hpp"
 
+#include <format>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "bytecode/byte_code.hpp"
 #include "bytecode_assertions.hpp"
+#include "vm/thread_pool.hpp"
 
 using enum fluir::code::Instruction;
 using enum fluir::code::NumericWidth;
@@ -347,3 +351,278 @@ CHUNK foo
     EXPECT_CHUNK_EQ(expected.chunks.at(i), actual.chunks.at(i));
   }
 }
+
+TEST(TestInspectDecoder, ParsesSuperinstructions) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x02
+VF64 1.5
+VF64 2.0
+CODE x16
+IPUSH x0
+IPUSH2 x0 x1
+IPUSH_POP x1
+IPUSH_PUSH_F64_ADD x0 x1
+IPUSH_PUSH_F64_SUB x0 x1
+IPUSH_PUSH_F64_MUL x0 x1
+IPUSH_PUSH_F64_DIV x0 x1
+IF64_MUL
+IF64_MUL_ADD
+IEXIT
+)";
+  fluir::code::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{.name = "main",
+                                  .code = {PUSH,     0, PUSH2,    0, 1, PUSH_POP, 1, PUSH_PUSH_F64_ADD, 0, 1,
+                                           PUSH_PUSH_F64_SUB, 0, 1, PUSH_PUSH_F64_MUL, 0, 1, PUSH_PUSH_F64_DIV,
+                                           0,        1, F64_MUL,  F64_MUL_ADD, EXIT},
+                                  .constants = {1.5_f64, 2.0_f64}}}};
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.chunks.at(0));
+}
+
+TEST(TestInspectDecoder, ParsesSizedInstructions) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x00
+CODE x0C
+II8_ADD
+II8_NEG
+II16_SUB
+II32_MUL
+II32_DIV
+II32_NEG
+IU8_ADD
+IU8_DIV
+IU16_SUB
+IU32_MUL
+IU32_DIV
+IEXIT
+)";
+  fluir::code::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{
+      .name = "main",
+      .code = {I8_ADD, I8_NEG, I16_SUB, I32_MUL, I32_DIV, I32_NEG, U8_ADD, U8_DIV, U16_SUB, U32_MUL, U32_DIV, EXIT},
+      .constants = {}}}};
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.chunks.at(0));
+}
+
+TEST(TestInspectDecoder, RejectsSizedUintNegation) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x00
+CODE x02
+IU8_NEG
+IEXIT
+)";
+
+  EXPECT_THROW(fluir::InspectDecoder{}.decode(source), std::runtime_error);
+}
+
+TEST(TestInspectDecoder, ParsesSubgraphs) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x00
+CODE x01
+IEXIT
+SUBGRAPHS x02
+x1 x0
+x2 x1 x0
+CHUNK main_sink0
+CONSTANTS x00
+CODE x01
+IEXIT
+)";
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  ASSERT_EQ(2, actual.chunks.size());
+  const auto& subgraphs = actual.chunks[0].subgraphs;
+  ASSERT_EQ(2, subgraphs.size());
+  EXPECT_EQ(1, subgraphs[0].chunk);
+  EXPECT_TRUE(subgraphs[0].dependencies.empty());
+  EXPECT_EQ(2, subgraphs[1].chunk);
+  EXPECT_EQ(std::vector<std::size_t>{0}, subgraphs[1].dependencies);
+  EXPECT_EQ("main_sink0", actual.chunks[1].name);
+  EXPECT_TRUE(actual.chunks[1].subgraphs.empty());
+}
+
+TEST(TestInspectDecoder, ParsesDebugEntries) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x00
+CODE x01
+IEXIT
+SUBGRAPHS x01
+x1 x0
+DEBUG x01
+x0 x1A xFFFFFFFB x6 x0 x7 x8
+CHUNK main_sink0
+CONSTANTS x00
+CODE x01
+IEXIT
+DEBUG x01
+x0 x4 x1 x2 x3 x4 x5
+)";
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  ASSERT_EQ(2, actual.chunks.size());
+  EXPECT_EQ(1, actual.chunks[0].subgraphs.size());
+  EXPECT_EQ((std::vector<fluir::code::DebugEntry>{
+              {.offset = 0, .node = 26, .x = -5, .y = 6, .z = 0, .width = 7, .height = 8}}),
+            actual.chunks[0].debug);
+  // Debug info does not need subgraphs before it
+  EXPECT_TRUE(actual.chunks[1].subgraphs.empty());
+  EXPECT_EQ((std::vector<fluir::code::DebugEntry>{
+              {.offset = 0, .node = 4, .x = 1, .y = 2, .z = 3, .width = 4, .height = 5}}),
+            actual.chunks[1].debug);
+}
+
+TEST(TestInspectDecoder, ParsesImmediateAndWidePushes) {
+  std::string source = R"(I0120030000000000000000
+CHUNK main
+CONSTANTS x01
+VF64 1.5
+CODE x18
+IPUSH_F64_IMM x0 x0 x0 x0 x0 x0 xF8 x3F
+IPUSH_I64_IMM xFE xFF xFF xFF xFF xFF xFF xFF
+IPUSH_SMALL_INT xF9
+IPUSH_WIDE x0 x0
+IEXIT
+)";
+  fluir::code::ByteCode expected{
+    .header = {.filetype = 'I', .major = 1, .minor = 32, .patch = 3, .entryOffset = 0},
+    .chunks = {fluir::code::Chunk{.name = "main",
+                                  .code = {PUSH_F64_IMM, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x3F,
+                                           PUSH_I64_IMM, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                           PUSH_SMALL_INT, 0xF9, PUSH_WIDE, 0x00, 0x00, EXIT},
+                                  .constants = {1.5_f64}}}};
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  EXPECT_CHUNK_EQ(expected.chunks.at(0), actual.chunks.at(0));
+}
+
+TEST(TestInspectDecoder, ExpandsSharedConstantsIntoEveryChunk) {
+  std::string source = R"(I0120030000000000000000
+CONSTANTS x02
+VF64 1.5
+VF64 2.5
+CHUNK main
+CONSTANTS x00
+CODE x06
+IPUSH x1
+IPOP
+IPUSH x0
+IEXIT
+CHUNK foo
+CONSTANTS x01
+VF64 4.0
+CODE x04
+IPUSH x0
+IPOP
+IEXIT
+)";
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  ASSERT_EQ(2, actual.chunks.size());
+  EXPECT_EQ((std::vector{1.5_f64, 2.5_f64}), actual.chunks[0].constants);
+  // A chunk with a table of its own keeps it
+  EXPECT_EQ((std::vector{4.0_f64}), actual.chunks[1].constants);
+  EXPECT_TRUE(actual.constants.empty());
+}
+
+TEST(TestInspectDecoder, RecognizesEveryInstruction) {
+  // Each instruction on its own, without operands, which is enough to look up every keyword
+  std::string source = "I0120030000000000000000\nCHUNK main\nCONSTANTS x00\nCODE x{}\n";
+  std::vector<std::uint8_t> expected;
+#define FLUIR_INSTRUCTION_LINE(Inst) \
+  source += "I" #Inst "\n";          \
+  expected.push_back(Inst);
+
+  FLUIR_CODE_INSTRUCTIONS(FLUIR_INSTRUCTION_LINE)
+#undef FLUIR_INSTRUCTION_LINE
+  source.replace(source.find("{}"), 2, std::format("{:X}", expected.size()));
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  EXPECT_EQ(expected, actual.chunks.at(0).code);
+}
+
+TEST(TestInspectDecoder, RejectsWordsWhichAreAlmostInstructions) {
+  for (const auto* word : {"IPUSHX", "IPUS", "IF64_ADDS", "I", "IEXIT_", "CHUNK"}) {
+    const auto source = std::format("I0120030000000000000000\nCHUNK main\nCONSTANTS x00\nCODE x01\n{}\n", word);
+
+    EXPECT_THROW(fluir::InspectDecoder{}.decode(source), std::runtime_error) << word;
+  }
+}
+
+TEST(TestInspectDecoder, SkipsLongRunsOfWhitespace) {
+  const std::string blank(40, ' ');
+  const auto source = "I0120030000000000000000\r\n" + blank + "CHUNK\t\tmain\r\n\r\n\r\n" + blank +
+                      "CONSTANTS x01\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n" + blank + "VF64 1.5" + blank +
+                      "\nCODE x03 IPUSH x00\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t IEXIT" + blank;
+
+  auto actual = fluir::InspectDecoder{}.decode(source);
+
+  ASSERT_EQ(1, actual.chunks.size());
+  EXPECT_EQ("main", actual.chunks[0].name);
+  EXPECT_EQ((std::vector{1.5_f64}), actual.chunks[0].constants);
+  EXPECT_EQ((std::vector<std::uint8_t>{PUSH, 0x00, EXIT}), actual.chunks[0].code);
+}
+
+TEST(TestInspectDecoder, DecodesChunksOnThreads) {
+  // Names and debug info which contain CHUNK must not be taken for the start of a chunk
+  std::string source = "I0120030000000000000002\nCONSTANTS x01 VF64 2.5\n";
+  for (int i = 0; i != 50; ++i) {
+    const auto name = i == 7 ? std::string{"CHUNK"} : std::format("CHUNK_{}", i);
+    source += std::format("CHUNK {}\nCONSTANTS x0{}\n{}CODE x04\nIPUSH x00 IPOP IEXIT\n",
+                          name,
+                          i % 2,
+                          i % 2 == 0 ? "" : std::format("VF64 {}.0\n", i));
+    if (i % 5 == 0) {
+      source += std::format("SUBGRAPHS x01 x{:X} x00\n", i + 1);
+    }
+  }
+  fluir::ThreadPool pool{4};
+
+  auto expected = fluir::InspectDecoder{}.decode(source);
+  auto actual = fluir::InspectDecoder{}.decode(source, pool);
+
+  EXPECT_BC_HEADER_EQ(expected.header, actual.header);
+  ASSERT_EQ(50, actual.chunks.size());
+  for (std::size_t i = 0; i != expected.chunks.size(); ++i) {
+    EXPECT_CHUNK_EQ(expected.chunks[i], actual.chunks[i]);
+    ASSERT_EQ(expected.chunks[i].subgraphs.size(), actual.chunks[i].subgraphs.size());
+    for (std::size_t j = 0; j != expected.chunks[i].subgraphs.size(); ++j) {
+      EXPECT_EQ(expected.chunks[i].subgraphs[j].chunk, actual.chunks[i].subgraphs[j].chunk);
+    }
+  }
+  EXPECT_EQ("CHUNK", actual.chunks[7].name);
+  EXPECT_EQ(1, actual.chunks[5].subgraphs.size());
+  EXPECT_EQ((std::vector{2.5_f64}), actual.chunks[0].constants);
+  EXPECT_TRUE(actual.constants.empty());
+}
+
+TEST(TestInspectDecoder, RejectsMalformedChunksOnThreads) {
+  const std::string header = "I0120030000000000000000\n";
+  const std::string chunk = "CHUNK main\nCONSTANTS x00\nCODE x01\nIEXIT\n";
+  fluir::ThreadPool pool{2};
+
+  EXPECT_EQ(0, fluir::InspectDecoder{}.decode(header, pool).chunks.size());
+  for (const auto& source : {header + "IEXIT\n" + chunk, header + chunk + "IEXIT\n" + chunk, header + chunk + "IPUS"}) {
+    EXPECT_THROW(fluir::InspectDecoder{}.decode(source), std::runtime_error) << source;
+    EXPECT_THROW(fluir::InspectDecoder{}.decode(source, pool), std::runtime_error) << source;
+  }
+}
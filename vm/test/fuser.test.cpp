@@ -0,0 +1,156 @@
+#include "vm/fuser.hpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
+using namespace fluir::code::value_literals;
+
+namespace {
+  fc::Bytes fused(fc::Chunk chunk) {
+    auto code = withChunk(std::move(chunk));
+    fluir::fuse(code);
+    return code.chunks.at(0).code;
+  }
+}  // namespace
+
+TEST(TestFuser, FusesPushPushF64Operations) {
+  EXPECT_EQ((fc::Bytes{PUSH_PUSH_F64_ADD, 0, 1, POP, PUSH_PUSH_F64_SUB, 1, 0, POP, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, POP, PUSH, 1, PUSH, 0, F64_SUB, POP, EXIT},
+                            .constants = {1.0_f64, 2.0_f64}}));
+  EXPECT_EQ((fc::Bytes{PUSH_PUSH_F64_MUL, 0, 0, PUSH_PUSH_F64_DIV, 1, 1, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 0, F64_MUL, PUSH, 1, PUSH, 1, F64_DIV, EXIT},
+                            .constants = {1.0_f64, 2.0_f64}}));
+}
+
+TEST(TestFuser, OnlyFusesF64OperationsOnF64Constants) {
+  EXPECT_EQ((fc::Bytes{PUSH2, 0, 1, F64_ADD, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.0_f64, 2_i64}}));
+}
+
+TEST(TestFuser, FusesPushPop) {
+  EXPECT_EQ((fc::Bytes{PUSH_POP, 0, EXIT}), fused(fc::Chunk{.code = {PUSH, 0, POP, EXIT}, .constants = {1.0_f64}}));
+}
+
+TEST(TestFuser, PrefersPushPushF64OverPush2) {
+  EXPECT_EQ((fc::Bytes{PUSH, 0, PUSH_PUSH_F64_MUL, 1, 2, F64_ADD, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 1, PUSH, 2, F64_MUL, F64_ADD, EXIT},
+                            .constants = {1.0_f64, 2.0_f64, 3.0_f64}}));
+}
+
+TEST(TestFuser, FusesMultiplyAdd) {
+  EXPECT_EQ((fc::Bytes{PUSH2, 0, 1, PUSH, 2, CAST_IF, F64_MUL_ADD, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 1, PUSH, 2, CAST_IF, F64_MUL, F64_ADD, EXIT},
+                            .constants = {1.0_f64, 2.0_f64, 3_i64}}));
+}
+
+TEST(TestFuser, DoesNotFuseOperands) {
+  // The width operand of CAST_FI has the same value as PUSH and must not be mistaken for one
+  static_assert(static_cast<int>(WIDTH_8) == static_cast<int>(PUSH));
+  EXPECT_EQ((fc::Bytes{PUSH, 0, CAST_FI, WIDTH_8, CAST_IF, POP, EXIT}),
+            fused(fc::Chunk{.code = {PUSH, 0, CAST_FI, WIDTH_8, CAST_IF, POP, EXIT}, .constants = {1.0_f64}}));
+}
+
+TEST(TestFuser, LeavesMalformedCodeAlone) {
+  EXPECT_EQ((fc::Bytes{PUSH2, 0, 0, 0xFE, PUSH, 0, PUSH}),
+            fused(fc::Chunk{.code = {PUSH, 0, PUSH, 0, 0xFE, PUSH, 0, PUSH}, .constants = {1_i64}}));
+  EXPECT_EQ((fc::Bytes{PUSH, 0, PUSH}), fused(fc::Chunk{.code = {PUSH, 0, PUSH}, .constants = {1.0_f64}}));
+}
+
+TEST(TestFuser, FusedCodeComputesTheSameResult) {
+  fc::Chunk chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, PUSH, 2, PUSH, 1, PUSH, 0, F64_MUL, F64_ADD, PUSH, 0, PUSH,
+                           1, F64_DIV, PUSH, 2, PUSH, 0, F64_SUB, F64_MUL, F64_ADD, EXIT},
+                  .constants = {1.5_f64, 0.25_f64, 3.0_f64}};
+  auto plain = withChunk(chunk);
+  auto fusedCode = withChunk(chunk);
+  fluir::fuse(fusedCode);
+  ASSERT_LT(fusedCode.chunks.at(0).code.size(), plain.chunks.at(0).code.size());
+
+  fluir::VirtualMachine expected;
+  fluir::VirtualMachine checked;
+  fluir::VirtualMachine verified;
+
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, expected.execute(&plain));
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, checked.execute(&fusedCode));
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, verified.execute(fluir::verify(fusedCode)));
+  EXPECT_EQ(expected.viewStack(), checked.viewStack());
+  EXPECT_EQ(expected.viewStack(), verified.viewStack());
+}
+
+TEST(TestFuser, FusedMultiplyAddRoundsTheProduct) {
+  // (1 + 2^-27)^2 = 1 + 2^-26 + 2^-54, whose last term only survives when the product is not rounded before the add,
+  // as in a single FMA. Rounded like F64_MUL followed by F64_ADD, the sum is exactly zero.
+  const auto factor = fc::Value{1.0 + 0x1p-27};
+  // F64_AFF keeps the multiply from fusing into PUSH_PUSH_F64_MUL instead
+  auto fusedCode = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, PUSH, 1, F64_AFF, F64_MUL, F64_ADD, EXIT},
+                                       .constants = {fc::Value{-(1.0 + 0x1p-26)}, factor}});
+  fluir::fuse(fusedCode);
+  ASSERT_EQ((fc::Bytes{PUSH2, 0, 1, PUSH, 1, F64_AFF, F64_MUL_ADD, EXIT}), fusedCode.chunks.at(0).code);
+
+  fluir::VirtualMachine checked;
+  fluir::VirtualMachine verified;
+
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, checked.execute(&fusedCode));
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, verified.execute(fluir::verify(fusedCode)));
+  EXPECT_EQ(std::vector{0.0_f64}, checked.viewStack());
+  EXPECT_EQ(std::vector{0.0_f64}, verified.viewStack());
+}
+
+TEST(TestFuser, MovesDebugEntriesToTheirFusedInstructions) {
+  // PUSH a (node 1), PUSH b (node 2), F64_ADD (node 3), POP (node 3), then PUSH c (node 4) which is left alone
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, POP, PUSH, 0, CAST_FI, WIDTH_8, EXIT},
+                                  .constants = {1.0_f64, 2.0_f64},
+                                  .debug = {{.offset = 0, .node = 1},
+                                            {.offset = 2, .node = 2},
+                                            {.offset = 4, .node = 3},
+                                            {.offset = 6, .node = 4},
+                                            {.offset = 8, .node = 5}}});
+  fluir::fuse(code);
+
+  const auto& chunk = code.chunks.at(0);
+  EXPECT_EQ((fc::Bytes{PUSH_PUSH_F64_ADD, 0, 1, POP, PUSH, 0, CAST_FI, WIDTH_8, EXIT}), chunk.code);
+  // The superinstruction runs for the node which consumes the constants
+  EXPECT_EQ((std::vector<fc::DebugEntry>{
+              {.offset = 0, .node = 3}, {.offset = 4, .node = 4}, {.offset = 6, .node = 5}}),
+            chunk.debug);
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestFuser, KeepsDebugEntriesInMalformedCode) {
+  auto code = withChunk(
+    fc::Chunk{.code = {PUSH, 0, PUSH, 0, 0xFE, PUSH, 0},
+              .constants = {1_i64},
+              .debug = {{.offset = 0, .node = 1}, {.offset = 4, .node = 2}, {.offset = 5, .node = 3}}});
+  fluir::fuse(code);
+
+  EXPECT_EQ((fc::Bytes{PUSH2, 0, 0, 0xFE, PUSH, 0}), code.chunks.at(0).code);
+  EXPECT_EQ((std::vector<fc::DebugEntry>{{.offset = 0, .node = 1}, {.offset = 3, .node = 2}, {.offset = 4, .node = 3}}),
+            code.chunks.at(0).debug);
+}
+
+TEST(TestFuser, OnlyCopiesChunksLoadedInPlaceWhenItFusesThem) {
+  const fc::Bytes file{PUSH, 0, PUSH, 1, F64_ADD, EXIT, PUSH, 0, F64_NEG, EXIT};
+  const fc::Bytes types(2, static_cast<std::uint8_t>(fc::PrimitiveType::F64));
+  fc::Bytes bits(2 * sizeof(std::uint64_t));
+  fc::writeOperand(fc::toBits(2.0), fc::writeOperand(fc::toBits(1.0), bits.data()));
+  const fc::ConstantView constants{types, bits};
+  fc::ByteCode code{
+    .header = {},
+    .chunks = {fc::Chunk{.name = "fused", .codeView = std::span{file}.first(6), .constantView = constants},
+               fc::Chunk{.name = "kept", .codeView = std::span{file}.subspan(6), .constantView = constants}}};
+
+  fluir::fuse(code);
+
+  EXPECT_EQ((fc::Bytes{PUSH_PUSH_F64_ADD, 0, 1, EXIT}), code.chunks[0].code);
+  EXPECT_EQ((fc::Bytes{PUSH_PUSH_F64_ADD, 0, 1, EXIT}),
+            fc::Bytes(code.chunks[0].instructions().begin(), code.chunks[0].instructions().end()));
+  EXPECT_TRUE(code.chunks[1].code.empty());
+  EXPECT_EQ(file.data() + 6, code.chunks[1].instructions().data());
+}
@@ -0,0 +1,217 @@
+#include "vm/jit.hpp"
+
+#include <bit>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/fuser.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  struct Run {
+    fluir::ExecResult result;
+    std::vector<std::uint64_t> stack;
+    std::string output;
+  };
+
+  /* Runs the code and records everything observable. F64s are compared by their bits so NaNs and signed zeros must
+   * match exactly too. */
+  template <typename Code>
+  Run run(const Code& code) {
+    fluir::VirtualMachine vm;
+    testing::internal::CaptureStdout();
+    auto result = vm.execute(code);
+    Run record{.result = result, .stack = {}, .output = testing::internal::GetCapturedStdout()};
+    for (const auto& value : vm.viewStack()) {
+      record.stack.push_back(std::bit_cast<std::uint64_t>(value.asF64()));
+    }
+    return record;
+  }
+
+  void expectSameAsInterpreter(const fc::ByteCode& code) {
+    auto verified = fluir::verify(code);
+    auto jit = fluir::compile(verified);
+    ASSERT_NE(nullptr, jit.chunk(0));
+
+    auto expected = run(verified);
+    auto actual = run(jit);
+    EXPECT_EQ(expected.result, actual.result);
+    EXPECT_EQ(expected.stack, actual.stack);
+    EXPECT_EQ(expected.output, actual.output);
+  }
+
+  /* A random straight-line F64 program which never underflows the stack and leaves some values on it */
+  fc::Chunk randomProgram(std::mt19937& random) {
+    fc::Chunk chunk{
+      .name = "main", .code = {}, .constants = {1.5_f64, fc::Value{-0.25}, 3.0_f64, 0.0_f64, fc::Value{-0.0}}};
+    std::uniform_int_distribution<int> choice(0, 9);
+    std::uniform_int_distribution<int> constant(0, static_cast<int>(chunk.constants.size()) - 1);
+    std::size_t depth = 0;
+    for (int i = 0; i != 60; ++i) {
+      int pick = choice(random);
+      if (depth < 2 || pick < 4) {
+        if (depth == fluir::VirtualMachine::STACK_CAPACITY) {
+          break;
+        }
+        chunk.code.push_back(PUSH);
+        chunk.code.push_back(static_cast<std::uint8_t>(constant(random)));
+        ++depth;
+      } else if (pick < 8) {
+        const fc::Instruction binary[] = {F64_ADD, F64_SUB, F64_MUL, F64_DIV};
+        chunk.code.push_back(binary[pick - 4]);
+        --depth;
+      } else if (pick == 8) {
+        chunk.code.push_back(random() % 2 == 0 ? F64_NEG : F64_AFF);
+      } else {
+        chunk.code.push_back(POP);
+        --depth;
+      }
+    }
+    chunk.code.push_back(EXIT);
+    return chunk;
+  }
+}  // namespace
+
+TEST(TestJit, TranslatesF64Code) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.0_f64, 2.0_f64}});
+  auto jit = fluir::compile(fluir::verify(code));
+
+  ASSERT_NE(nullptr, jit.chunk(0));
+  EXPECT_GT(jit.chunk(0)->size(), 0u);
+}
+
+TEST(TestJit, FallsBackToTheInterpreter) {
+  auto integers = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_ADD, EXIT}, .constants = {1_i64, 2_i64}});
+  auto verified = fluir::verify(integers);
+  auto jit = fluir::compile(verified);
+  EXPECT_EQ(nullptr, jit.chunk(0));
+
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(jit));
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(3_i64, vm.viewStack().back());
+
+  // An I64 constant is unsupported even if no instruction ever treats it as one
+  auto mixed = withChunk(fc::Chunk{.code = {PUSH, 0, POP, EXIT}, .constants = {1_i64}});
+  EXPECT_EQ(nullptr, fluir::compile(fluir::verify(mixed)).chunk(0));
+  // So is pushing an I64 without going through the constants
+  auto immediate = withChunk(fc::Chunk{.code = {PUSH_SMALL_INT, 1, POP, EXIT}});
+  EXPECT_EQ(nullptr, fluir::compile(fluir::verify(immediate)).chunk(0));
+
+  auto registers = withChunk(fc::Chunk{.code = {F64_ADD, 2, 0, 1, EXIT}, .constants = {1.0_f64, 2.0_f64}});
+  registers.header.filetype = fc::FILETYPE_REGISTERS;
+  EXPECT_EQ(nullptr, fluir::compile(fluir::verify(registers)).chunk(0));
+}
+
+TEST(TestJit, MatchesInterpreterOnEveryInstruction) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  expectSameAsInterpreter(withChunk(
+      fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, PUSH, 1, F64_SUB, PUSH, 2, F64_MUL, PUSH, 0, F64_DIV, F64_NEG,
+                         F64_AFF, POP, EXIT},
+                .constants = {1.5_f64, 0.25_f64, 3.0_f64}}));
+  expectSameAsInterpreter(withChunk(fc::Chunk{.code = {PUSH2, 0, 1, PUSH_PUSH_F64_ADD, 0, 1, PUSH_PUSH_F64_SUB, 0, 1,
+                                                       PUSH_PUSH_F64_MUL, 1, 2, PUSH_PUSH_F64_DIV, 2, 1, F64_MUL_ADD,
+                                                       PUSH_POP, 2, EXIT},
+                                              .constants = {1.5_f64, 0.25_f64, 3.0_f64}}));
+  // -2.5 is xC004000000000000, stored little endian
+  expectSameAsInterpreter(withChunk(fc::Chunk{
+    .code = {PUSH_WIDE, 2, 0, PUSH_F64_IMM, 0, 0, 0, 0, 0, 0, 0x04, 0xC0, F64_MUL, PUSH_WIDE, 0, 0, F64_ADD, EXIT},
+    .constants = {1.5_f64, 0.25_f64, 3.0_f64}}));
+}
+
+TEST(TestJit, MatchesInterpreterOnSpecialValues) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  // 0 / 0 is NaN, 1 / 0 is infinity and negating zero gives a signed zero
+  expectSameAsInterpreter(
+      withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 0, F64_DIV, PUSH, 1, PUSH, 0, F64_DIV, PUSH, 0, F64_NEG, POP, EXIT},
+                          .constants = {0.0_f64, 1.0_f64}}));
+}
+
+TEST(TestJit, MatchesInterpreterOnRandomPrograms) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  std::mt19937 random{1234};
+  for (int i = 0; i != 200; ++i) {
+    SCOPED_TRACE(i);
+    auto code = withChunk(randomProgram(random));
+    expectSameAsInterpreter(code);
+    fluir::fuse(code);
+    expectSameAsInterpreter(code);
+  }
+}
+
+TEST(TestJit, ClearsTheFaultOfTheLastExecution) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  auto failing = withChunk(fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_DIV, EXIT}, .constants = {1_i64, 0_i64}});
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, EXIT}, .constants = {1.0_f64}});
+  auto jit = fluir::compile(fluir::verify(code));
+  ASSERT_NE(nullptr, jit.chunk(0));
+
+  fluir::VirtualMachine vm;
+  ASSERT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, vm.execute(&failing));
+  ASSERT_TRUE(vm.viewFault().has_value());
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(jit));
+  EXPECT_FALSE(vm.viewFault().has_value());
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(1.0_f64, vm.viewStack().back());
+}
+
+TEST(TestJit, ObservesExecOptions) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, EXIT}, .constants = {1.0_f64}},
+                               fc::Chunk{.name = "other", .code = {PUSH, 0, PUSH, 0, F64_ADD, EXIT},
+                                         .constants = {2.0_f64}}}};
+  auto jit = fluir::compile(fluir::verify(code));
+  fluir::VirtualMachine vm;
+
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(jit, {.entry = 1}));
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(4.0_f64, vm.viewStack().back());
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.execute(jit, {.entry = 2}));
+
+  // Native code cannot suspend, so a budget runs the chunk on the interpreter
+  ASSERT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(jit, {.entry = 1, .budget = {.instructions = 2}}));
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.resume());
+  EXPECT_EQ(4.0_f64, vm.viewStack().back());
+}
+
+TEST(TestJit, WritesToTheOutputSink) {
+  if (!fluir::Jit::available()) {
+    GTEST_SKIP() << "The JIT does not support this platform";
+  }
+  auto code = withChunk(fc::Chunk{.code = {PUSH, 0, POP, PUSH_POP, 1, EXIT}, .constants = {1.5_f64, fc::Value{-2.0}}});
+  auto jit = fluir::compile(fluir::verify(code));
+  ASSERT_NE(nullptr, jit.chunk(0));
+  fluir::RingBufferSink sink{4};
+  fluir::VirtualMachine vm;
+
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(jit, {.output = &sink}));
+  EXPECT_EQ("", testing::internal::GetCapturedStdout());
+  ASSERT_EQ(2, sink.size());
+  EXPECT_EQ(1.5_f64, sink[0]);
+  EXPECT_EQ(fc::Value{-2.0}, sink[1]);
+}
@@ -0,0 +1,163 @@
+#include "vm/output.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  std::string formatted(const fc::Value& value) {
+    char text[fluir::TextSink::MAX_VALUE_LENGTH];
+    return std::string{text, fluir::format(value, text)};
+  }
+
+  /* Counts how often an execution flushes it */
+  class CountingSink final : public fluir::OutputSink {
+   public:
+    std::vector<fc::Value> values;
+    int flushes{0};
+
+    void write(const fc::Value& value) override { values.push_back(value); }
+    void flush() override { ++flushes; }
+  };
+}  // namespace
+
+TEST(TestTextSink, FormatsEveryType) {
+  EXPECT_EQ("(F64)1.5\n", formatted(1.5_f64));
+  EXPECT_EQ("(F64)0.333333\n", formatted(fc::Value{1.0 / 3.0}));
+  EXPECT_EQ("(F64)-1.79769e+308\n", formatted(fc::Value{std::numeric_limits<double>::lowest()}));
+  EXPECT_EQ("(I64)-9223372036854775808\n", formatted(fc::Value{std::numeric_limits<std::int64_t>::min()}));
+  EXPECT_EQ("(I32)42\n", formatted(42_i32));
+  EXPECT_EQ("(I8)-5\n", formatted(fc::Value{std::int8_t{-5}}));
+  EXPECT_EQ("(U64)18446744073709551615\n", formatted(fc::Value{std::numeric_limits<std::uint64_t>::max()}));
+  EXPECT_EQ("(U8)255\n", formatted(255_u8));
+}
+
+TEST(TestTextSink, KeepsTextWithoutTarget) {
+  fluir::TextSink sink{nullptr, 40};
+  std::string expected;
+  for (int i = 0; i != 100; ++i) {
+    sink.write(fc::Value{std::int64_t{i}});
+    expected += "(I64)" + std::to_string(i) + "\n";
+  }
+  sink.flush();
+
+  EXPECT_EQ(expected, sink.view());
+  sink.clear();
+  EXPECT_EQ("", sink.view());
+}
+
+TEST(TestTextSink, WritesToTargetWhenFullAndWhenFlushed) {
+  std::ostringstream target;
+  fluir::TextSink sink{&target, 40};
+
+  sink.write(1.5_f64);
+  EXPECT_EQ("", target.str());
+  sink.write(2.5_f64);
+  sink.write(3.5_f64);
+  EXPECT_EQ("(F64)1.5\n(F64)2.5\n", target.str());
+  EXPECT_EQ("(F64)3.5\n", sink.view());
+
+  sink.flush();
+  EXPECT_EQ("(F64)1.5\n(F64)2.5\n(F64)3.5\n", target.str());
+  EXPECT_EQ("", sink.view());
+}
+
+TEST(TestRingBufferSink, KeepsTheLastValues) {
+  fluir::RingBufferSink sink{3};
+  for (int i = 0; i != 5; ++i) {
+    sink.write(fc::Value{std::int64_t{i}});
+  }
+
+  ASSERT_EQ(3, sink.size());
+  EXPECT_EQ(3, sink.capacity());
+  EXPECT_EQ(2, sink.overwritten());
+  EXPECT_EQ(2_i64, sink[0]);
+  EXPECT_EQ(3_i64, sink[1]);
+  EXPECT_EQ(4_i64, sink[2]);
+
+  sink.clear();
+  EXPECT_EQ(0, sink.size());
+  EXPECT_EQ(0, sink.overwritten());
+}
+
+TEST(TestCallbackSink, PassesConcreteTypes) {
+  std::vector<std::string> seen;
+  fluir::CallbackSink sink{[&seen](auto value) {
+    if constexpr (std::is_same_v<decltype(value), double>) {
+      seen.push_back("F64 " + std::to_string(value));
+    } else if constexpr (std::is_same_v<decltype(value), std::int32_t>) {
+      seen.push_back("I32 " + std::to_string(value));
+    } else {
+      seen.push_back("other");
+    }
+  }};
+
+  sink.write(1.5_f64);
+  sink.write(7_i32);
+  sink.write(7_u16);
+
+  EXPECT_EQ((std::vector<std::string>{"F64 1.500000", "I32 7", "other"}), seen);
+}
+
+TEST(TestOutputSink, ReceivesStackOutput) {
+  auto code = fc::ByteCode{.header = {},
+                           .chunks = {fc::Chunk{.name = "main",
+                                                .code = {PUSH, 0, POP, PUSH_POP, 1, EXIT},
+                                                .constants = {1.5_f64, 3_i32}}}};
+  CountingSink sink;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.output = &sink}));
+  EXPECT_EQ((std::vector<fc::Value>{1.5_f64, 3_i32}), sink.values);
+  EXPECT_EQ(1, sink.flushes);
+}
+
+TEST(TestOutputSink, ReceivesRegisterOutput) {
+  auto code = fc::ByteCode{.header = {.filetype = fc::FILETYPE_REGISTERS},
+                           .chunks = {fc::Chunk{.name = "main",
+                                                .code = {F64_MUL, 2, 0, 1, POP, 2, EXIT},
+                                                .constants = {1.5_f64, 2.0_f64}}}};
+  CountingSink sink;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.output = &sink}));
+  EXPECT_EQ((std::vector<fc::Value>{3.0_f64}), sink.values);
+}
+
+TEST(TestOutputSink, FlushesWhenSuspending) {
+  auto code = fc::ByteCode{.header = {},
+                           .chunks = {fc::Chunk{.name = "main",
+                                                .code = {PUSH, 0, POP, PUSH, 0, POP, EXIT},
+                                                .constants = {1.5_f64}}}};
+  CountingSink sink;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(code, {.output = &sink, .budget = {.instructions = 3}}));
+  EXPECT_EQ(1, sink.values.size());
+  EXPECT_EQ(1, sink.flushes);
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.resume());
+  EXPECT_EQ(2, sink.values.size());
+  EXPECT_EQ(2, sink.flushes);
+}
+
+TEST(TestOutputSink, DefaultsToStandardOutput) {
+  auto code = fc::ByteCode{
+    .header = {}, .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, POP, EXIT}, .constants = {1.5_f64}}}};
+  fluir::VirtualMachine vm;
+
+  testing::internal::CaptureStdout();
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {}));
+  EXPECT_EQ("(F64)1.5\n", testing::internal::GetCapturedStdout());
+}
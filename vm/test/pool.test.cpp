@@ -0,0 +1,125 @@
+#include "vm/pool.hpp"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+TEST(TestVmReuse, ExecutesFromEntryChunk) {
+  auto code = twoChunks();
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.entry = 1}));
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(4.0_f64, vm.viewStack().back());
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {}));
+  ASSERT_EQ(1, vm.viewStack().size());
+  EXPECT_EQ(1.0_f64, vm.viewStack().back());
+}
+
+TEST(TestVmReuse, RejectsMissingEntryChunk) {
+  auto code = twoChunks();
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.execute(code, {.entry = 2}));
+}
+
+TEST(TestVmReuse, KeepsStorageBetweenExecutions) {
+  auto code = twoChunks();
+  fluir::VirtualMachine vm;
+  vm.reserve();
+  const auto* storage = vm.viewStack().data();
+
+  for (int i = 0; i != 3; ++i) {
+    EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.entry = 1}));
+    EXPECT_EQ(storage, vm.viewStack().data());
+  }
+}
+
+TEST(TestVmReuse, ExecutesAfterMoving) {
+  auto code = twoChunks();
+  fluir::VirtualMachine first;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, first.execute(code, {}));
+
+  fluir::VirtualMachine second{std::move(first)};
+  EXPECT_EQ(1.0_f64, second.viewStack().back());
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, second.execute(code, {.entry = 1}));
+  EXPECT_EQ(4.0_f64, second.viewStack().back());
+
+  first = std::move(second);
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, first.execute(code, {}));
+  EXPECT_EQ(1.0_f64, first.viewStack().back());
+}
+
+TEST(TestVmPool, StartsWithPreparedVms) {
+  fluir::VmPool pool{3};
+  EXPECT_EQ(3, pool.idle());
+}
+
+TEST(TestVmPool, ReusesReleasedVms) {
+  auto code = twoChunks();
+  fluir::VmPool pool;
+  const fc::Value* storage = nullptr;
+  {
+    auto vm = pool.acquire();
+    EXPECT_EQ(0, pool.idle());
+    EXPECT_EQ(fluir::ExecResult::SUCCESS, vm->execute(code, {}));
+    storage = vm->viewStack().data();
+  }
+  EXPECT_EQ(1, pool.idle());
+
+  auto vm = pool.acquire();
+  EXPECT_EQ(0, pool.idle());
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, (*vm).execute(code, {.entry = 1}));
+  EXPECT_EQ(storage, vm->viewStack().data());
+}
+
+TEST(TestVmPool, ReleasesEachVmOnce) {
+  fluir::VmPool pool;
+  {
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    auto moved = std::move(first);
+    second = std::move(moved);
+    EXPECT_EQ(1, pool.idle());
+  }
+  EXPECT_EQ(2, pool.idle());
+}
+
+TEST(TestVmPool, SharesVmsBetweenThreads) {
+  constexpr int THREADS = 4;
+  constexpr int EXECUTIONS = 200;
+  auto code = twoChunks();
+  fluir::VmPool pool{2};
+
+  std::vector<std::thread> threads;
+  std::vector<int> failures(THREADS, 0);
+  for (int t = 0; t != THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i != EXECUTIONS; ++i) {
+        auto vm = pool.acquire();
+        if (vm->execute(code, {.entry = 1}) != fluir::ExecResult::SUCCESS || vm->viewStack().back() != 4.0_f64) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t != THREADS; ++t) {
+    EXPECT_EQ(0, failures[t]);
+  }
+  EXPECT_LE(2, pool.idle());
+  EXPECT_GE(THREADS, pool.idle());
+}
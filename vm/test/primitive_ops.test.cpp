@@ -1,8 +1,10 @@
 #include <cmath>
 #include <tuple>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "vm/verifier.hpp"
 #include "vm/vm.hpp"
 
 using std::tuple;
@@ -30,6 +32,23 @@ TEST_P(TestPrimitiveOps, Test) {
   }
 }
 
+TEST_P(TestPrimitiveOps, TestVerified) {
+  auto [expected, chunk] = GetParam();
+  // Add postamble to bytecode to make it execute correctly without requiring too much boilerplate in tests
+  chunk.code.push_back(EXIT);
+  fc::ByteCode code{.header = {}, .chunks = {std::move(chunk)}};
+
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(fluir::verify(code)));
+  auto actual = vm.viewStack().back();
+  if (actual.type() == fc::PrimitiveType::F64) {
+    // stupid double epsilon issues
+    EXPECT_DOUBLE_EQ(expected.asF64(), actual.asF64());
+  } else {
+    EXPECT_EQ(expected, actual);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
   Float,
   TestPrimitiveOps,
@@ -185,7 +204,11 @@ INSTANTIATE_TEST_SUITE_P(
           fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_SUB},
                     .constants = {fc::Value{static_cast<int64_t>(-9223372036854775807LL - 1)}, 1_i64}}},
     tuple{fc::Value{static_cast<int64_t>(-2)},
-          fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_MUL}, .constants = {9223372036854775807_i64, 2_i64}}}));
+          fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_MUL}, .constants = {9223372036854775807_i64, 2_i64}}},
+    tuple{fc::Value{static_cast<int64_t>(-9223372036854775807LL - 1)},
+          fc::Chunk{.code = {PUSH, 0, PUSH, 1, I64_DIV},
+                    .constants = {fc::Value{static_cast<int64_t>(-9223372036854775807LL - 1)},
+                                  fc::Value{static_cast<int64_t>(-1)}}}}));
 
 INSTANTIATE_TEST_SUITE_P(
   U8,
@@ -285,6 +308,36 @@ INSTANTIATE_TEST_SUITE_P(
     tuple{fc::Value{static_cast<uint64_t>(18446744073709551605ULL)},
           fc::Chunk{.code = {PUSH, 0, PUSH, 1, U64_SUB}, .constants = {0_u64, 11_u64}}}));
 
+namespace {
+  /** A chunk with more constants than PUSH can name, where constant i is the F64 i */
+  std::vector<fc::Value> wideConstants() {
+    std::vector<fc::Value> constants;
+    for (int i = 0; i != 300; ++i) {
+      constants.emplace_back(static_cast<double>(i));
+    }
+    return constants;
+  }
+}  // namespace
+
+INSTANTIATE_TEST_SUITE_P(
+  Push,
+  TestPrimitiveOps,
+  ::testing::Values(
+    // Immediates are stored little endian, so 1.5 is x3FF8000000000000 backwards
+    tuple{1.5_f64, fc::Chunk{.code = {PUSH_F64_IMM, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x3F}}},
+    tuple{3.5_f64,
+          fc::Chunk{.code = {PUSH_F64_IMM, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x3F, PUSH, 0, F64_ADD},
+                    .constants = {2.0_f64}}},
+    tuple{fc::Value{fc::I64{-2}}, fc::Chunk{.code = {PUSH_I64_IMM, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}}},
+    tuple{fc::Value{fc::I64{0x0102030405060708}},
+          fc::Chunk{.code = {PUSH_I64_IMM, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01}}},
+    tuple{fc::Value{fc::I64{-7}}, fc::Chunk{.code = {PUSH_SMALL_INT, 0xF9}}},
+    tuple{3_i64, fc::Chunk{.code = {PUSH_SMALL_INT, 5, PUSH_SMALL_INT, 0xFE, I64_ADD}}},
+    tuple{257.0_f64, fc::Chunk{.code = {PUSH_WIDE, 0x01, 0x01}, .constants = wideConstants()}},
+    tuple{299.0_f64,
+          fc::Chunk{.code = {PUSH_WIDE, 0x2B, 0x01, PUSH, 0xFF, PUSH_WIDE, 0xFF, 0x00, F64_SUB, F64_ADD},
+                    .constants = wideConstants()}}));
+
 // Test this separately since NAN isn't equal to NAN
 class TestPrimitiveOpsProducingNans : public ::testing::TestWithParam<fc::Chunk> { };
 TEST_P(TestPrimitiveOpsProducingNans, Test0Div) {
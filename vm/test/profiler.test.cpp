@@ -0,0 +1,142 @@
+#include "vm/profiler.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  struct Count {
+    fc::Instruction instruction;
+    std::uint64_t executions;
+
+    bool operator==(const Count&) const = default;
+  };
+
+  /* The executions of each instruction in the histogram, most executed first so that tests do not depend on timing */
+  std::vector<Count> counts(const fluir::Profiler& profiler) {
+    std::vector<Count> result;
+    for (const auto& entry : profiler.histogram()) {
+      result.push_back(Count{entry.instruction, entry.executions});
+    }
+    std::ranges::stable_sort(result, [](const Count& lhs, const Count& rhs) {
+      return lhs.executions != rhs.executions ? lhs.executions > rhs.executions : lhs.instruction < rhs.instruction;
+    });
+    return result;
+  }
+
+  fc::ByteCode stackCode() {
+    return fc::ByteCode{.header = {},
+                        .chunks = {fc::Chunk{.name = "main",
+                                             .code = {PUSH, 0, PUSH, 1, F64_ADD, PUSH, 1, F64_ADD, EXIT},
+                                             .constants = {1.5_f64, 2.0_f64}}}};
+  }
+}  // namespace
+
+TEST(TestProfiler, CountsStackInstructions) {
+  auto code = stackCode();
+  fluir::Profiler profiler;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.profiler = &profiler}));
+  EXPECT_EQ((std::vector<Count>{{PUSH, 3}, {F64_ADD, 2}, {EXIT, 1}}), counts(profiler));
+}
+
+TEST(TestProfiler, CountsRegisterInstructions) {
+  auto code = fc::ByteCode{.header = {.filetype = fc::FILETYPE_REGISTERS},
+                           .chunks = {fc::Chunk{.name = "main",
+                                                .code = {F64_MUL, 2, 0, 1, F64_ADD, 2, 2, 0, F64_ADD, 2, 2, 0, EXIT},
+                                                .constants = {1.5_f64, 2.0_f64}}}};
+  fluir::Profiler profiler;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.profiler = &profiler}));
+  EXPECT_EQ((std::vector<Count>{{F64_ADD, 2}, {EXIT, 1}, {F64_MUL, 1}}), counts(profiler));
+}
+
+TEST(TestProfiler, AccumulatesAcrossExecutionsAndResumes) {
+  auto code = stackCode();
+  auto verified = fluir::verify(code);
+  fluir::Profiler profiler;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified, {.profiler = &profiler}));
+  EXPECT_EQ(fluir::ExecResult::SUSPENDED, vm.execute(code, {.budget = {.instructions = 3}, .profiler = &profiler}));
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.resume());
+  EXPECT_EQ((std::vector<Count>{{PUSH, 6}, {F64_ADD, 4}, {EXIT, 2}}), counts(profiler));
+
+  profiler.clear();
+  EXPECT_TRUE(profiler.histogram().empty());
+}
+
+TEST(TestProfiler, CountsNothingWithoutBeingPassed) {
+  auto code = stackCode();
+  fluir::Profiler profiler;
+  fluir::VirtualMachine vm;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.profiler = &profiler}));
+  profiler.clear();
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {}));
+  EXPECT_TRUE(profiler.histogram().empty());
+}
+
+TEST(TestProfiler, SortsByTicks) {
+  fluir::Profiler profiler;
+  profiler.record(F64_ADD, 10);
+  profiler.record(F64_ADD, 10);
+  profiler.record(PUSH, 50);
+  profiler.record(EXIT, 1);
+
+  const auto histogram = profiler.histogram();
+  ASSERT_EQ(3, histogram.size());
+  EXPECT_EQ(PUSH, histogram[0].instruction);
+  EXPECT_EQ(F64_ADD, histogram[1].instruction);
+  EXPECT_EQ(2, histogram[1].executions);
+  EXPECT_EQ(20, histogram[1].ticks);
+  EXPECT_EQ(EXIT, histogram[2].instruction);
+}
+
+TEST(TestProfiler, WritesJson) {
+  fluir::Profiler profiler;
+  profiler.record(F64_ADD, 10);
+  profiler.record(PUSH, 50);
+
+  std::ostringstream json;
+  profiler.writeJson(json);
+
+  EXPECT_EQ(std::string{R"({"clock":")"} + std::string{fluir::Profiler::CLOCK} +
+              R"(","ticks":60,"instructions":[)"
+              R"({"name":"PUSH","opcode":1,"executions":1,"ticks":50},)"
+              R"({"name":"F64_ADD","opcode":3,"executions":1,"ticks":10}]})"
+              "\n",
+            json.str());
+}
+
+TEST(TestProfiler, WritesText) {
+  fluir::Profiler profiler;
+  profiler.record(PUSH, 30);
+  profiler.record(F64_ADD, 10);
+
+  std::ostringstream text;
+  profiler.writeText(text);
+
+  std::istringstream lines{text.str()};
+  std::string line;
+  std::getline(lines, line);
+  EXPECT_TRUE(line.starts_with("INSTRUCTION"));
+  std::getline(lines, line);
+  EXPECT_TRUE(line.starts_with("PUSH "));
+  EXPECT_TRUE(line.ends_with("75.0%"));
+  std::getline(lines, line);
+  EXPECT_TRUE(line.starts_with("F64_ADD "));
+  EXPECT_TRUE(line.ends_with("25.0%"));
+}
@@ -0,0 +1,211 @@
+#include "vm/program.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bytecode/binary_format.hpp"
+#include "code_factories.hpp"
+#include "vm/exceptions.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  /** A module whose entry chunk is the second, with a third chunk which only the entry's subgraph runs and a fourth
+   * which is never run and would not verify */
+  fc::ByteCode module() {
+    return fc::ByteCode{
+      .header = {.entryOffset = 1},
+      .chunks = {fc::Chunk{.name = "unused", .code = {PUSH, 0, EXIT}, .constants = {1.0_f64}},
+                 fc::Chunk{.name = "main",
+                           .code = {PUSH, 0, PUSH, 0, F64_ADD, EXIT},
+                           .constants = {2.0_f64},
+                           .subgraphs = {{.chunk = 2, .dependencies = {}}}},
+                 fc::Chunk{.name = "main_sink0", .code = {EXIT}, .constants = {}},
+                 fc::Chunk{.name = "broken", .code = {F64_ADD, EXIT}, .constants = {}}}};
+  }
+
+  /** Writes code to a binary file, which is removed again when the test ends */
+  class BinaryFile {
+   public:
+    explicit BinaryFile(const fc::ByteCode& code) {
+      const auto bytes = fc::binary::encode(code);
+      std::ofstream fout{path_, std::ios::binary};
+      fout.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    BinaryFile(const BinaryFile&) = delete;
+    BinaryFile& operator=(const BinaryFile&) = delete;
+    ~BinaryFile() { std::filesystem::remove(path_); }
+
+    [[nodiscard]] std::string path() const { return path_.string(); }
+
+   private:
+    std::filesystem::path path_{std::filesystem::temp_directory_path() / "lazy_program.flb"};
+  };
+}  // namespace
+
+TEST(TestLoadedProgram, RejectsUnverifiableCode) {
+  auto code = fc::ByteCode{
+    .header = {}, .chunks = {fc::Chunk{.name = "main", .code = {F64_ADD, EXIT}, .constants = {}}}};
+
+  EXPECT_THROW(fluir::LoadedProgram::load(std::move(code)), fluir::VerificationError);
+}
+
+TEST(TestLoadedProgram, CopiesShareTheCode) {
+  const auto program = fluir::LoadedProgram::load(twoChunks());
+  const auto copy = program;
+
+  EXPECT_EQ(&program.code(), &copy.code());
+  EXPECT_EQ(&program.code(), &program.verified().code());
+}
+
+TEST(TestExecutionContext, ExecutesFromEntryChunk) {
+  fluir::ExecutionContext context{fluir::LoadedProgram::load(twoChunks())};
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, context.execute({.entry = 1}));
+  ASSERT_EQ(1, context.viewStack().size());
+  EXPECT_EQ(4.0_f64, context.viewStack().back());
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, context.execute({.entry = 2}));
+}
+
+TEST(TestExecutionContext, KeepsTheProgramAlive) {
+  std::optional<fluir::ExecutionContext> context;
+  {
+    auto program = fluir::LoadedProgram::load(twoChunks());
+    context.emplace(program);
+  }
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, context->execute());
+  ASSERT_EQ(1, context->viewStack().size());
+  EXPECT_EQ(1.0_f64, context->viewStack().back());
+}
+
+TEST(TestExecutionContext, ThreadsShareAProgram) {
+  const auto program = fluir::LoadedProgram::load(twoChunks());
+  constexpr int THREADS = 8;
+  constexpr int EXECUTIONS = 1'000;
+  std::vector<int> correct(THREADS, 0);
+  {
+    std::vector<std::jthread> threads;
+    for (int t = 0; t != THREADS; ++t) {
+      threads.emplace_back([&program, &correct, t] {
+        fluir::ExecutionContext context{program};
+        for (int i = 0; i != EXECUTIONS; ++i) {
+          const std::size_t entry = (t + i) % 2;
+          if (context.execute({.entry = entry}) == fluir::ExecResult::SUCCESS && context.viewStack().size() == 1 &&
+              context.viewStack().back() == (entry == 0 ? 1.0_f64 : 4.0_f64)) {
+            ++correct[t];
+          }
+        }
+      });
+    }
+  }
+
+  for (int t = 0; t != THREADS; ++t) {
+    EXPECT_EQ(EXECUTIONS, correct[t]) << "thread " << t;
+  }
+}
+
+TEST(TestLazyProgram, OnlyDecodesTheChunksItEnters) {
+  const BinaryFile file{module()};
+  const auto program = fluir::LazyProgram::open(file.path());
+
+  ASSERT_EQ(4, program.code().chunks.size());
+  EXPECT_EQ(1, program.entry());
+  for (std::size_t i = 0; i != 4; ++i) {
+    EXPECT_FALSE(program.entered(i));
+    EXPECT_TRUE(program.code().chunks[i].instructions().empty());
+  }
+
+  const auto& verified = program.enter(program.entry());
+
+  // The entry chunk and its subgraph are decoded, but nothing else is
+  EXPECT_TRUE(program.entered(1));
+  EXPECT_TRUE(program.entered(2));
+  EXPECT_FALSE(program.entered(0));
+  EXPECT_FALSE(program.entered(3));
+  EXPECT_TRUE(program.code().chunks[0].name.empty());
+  EXPECT_EQ("main", program.code().chunks[1].name);
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified));
+  EXPECT_EQ(std::vector{4.0_f64}, vm.viewStack());
+}
+
+TEST(TestLazyProgram, VerifiesChunksWhenTheyAreEntered) {
+  const BinaryFile file{module()};
+  const auto program = fluir::LazyProgram::open(file.path());
+
+  EXPECT_NO_THROW(program.enter(0));
+  EXPECT_THROW(program.enter(3), fluir::VerificationError);
+  EXPECT_FALSE(program.entered(3));
+  EXPECT_THROW(program.enter(4), fluir::VerificationError);
+}
+
+TEST(TestLazyProgram, OnlyExecutesChunksItHasEntered) {
+  const BinaryFile file{module()};
+  const auto program = fluir::LazyProgram::open(file.path());
+
+  const auto& verified = program.enter(program.entry());
+
+  EXPECT_TRUE(verified.verified(1));
+  EXPECT_FALSE(verified.verified(0));
+  EXPECT_FALSE(verified.verified(4));
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.execute(verified, {.entry = 0}));
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.execute(verified, {.entry = 3}));
+  program.enter(0);
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified, {.entry = 0}));
+}
+
+TEST(TestLazyProgram, FindsChunksWithoutDecodingThem) {
+  const BinaryFile file{module()};
+  const auto program = fluir::LazyProgram::open(file.path());
+
+  EXPECT_EQ(2, program.find("main_sink0"));
+  EXPECT_EQ(std::nullopt, program.find("missing"));
+  EXPECT_FALSE(program.entered(2));
+}
+
+TEST(TestLazyProgram, EntersDecodedCodeTheSameWay) {
+  const auto program = fluir::LazyProgram::load(module());
+
+  EXPECT_EQ(0, program.find("unused"));
+  const auto& verified = program.enter(program.entry());
+  EXPECT_FALSE(program.entered(0));
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified));
+  EXPECT_EQ(std::vector{4.0_f64}, vm.viewStack());
+  EXPECT_THROW(program.enter(3), fluir::VerificationError);
+}
+
+TEST(TestLazyProgram, ThreadsEnterChunksTogether) {
+  const BinaryFile file{module()};
+  const auto program = fluir::LazyProgram::open(file.path());
+  constexpr int THREADS = 8;
+  std::vector<int> correct(THREADS, 0);
+  {
+    std::vector<std::jthread> threads;
+    for (int t = 0; t != THREADS; ++t) {
+      threads.emplace_back([&program, &correct, t] {
+        const std::size_t entry = t % 2;
+        fluir::VirtualMachine vm;
+        if (vm.execute(program.enter(entry), {.entry = entry}) == fluir::ExecResult::SUCCESS &&
+            vm.viewStack() == std::vector{entry == 0 ? 1.0_f64 : 4.0_f64}) {
+          ++correct[t];
+        }
+      });
+    }
+  }
+
+  for (int t = 0; t != THREADS; ++t) {
+    EXPECT_EQ(1, correct[t]) << "thread " << t;
+  }
+}
@@ -0,0 +1,163 @@
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/exceptions.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
+using namespace fluir::code::value_literals;
+
+namespace {
+  fc::ByteCode registerCode(fc::Chunk chunk) {
+    return fc::ByteCode{.header = {.filetype = fc::FILETYPE_REGISTERS}, .chunks = {std::move(chunk)}};
+  }
+}  // namespace
+
+TEST(TestRegisterVM, PreloadsConstants) {
+  auto code = registerCode(fc::Chunk{.code = {EXIT}, .constants = {1.5_f64, 3_i32}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  ASSERT_EQ(fluir::VirtualMachine::REGISTER_COUNT, uut.viewRegisters().size());
+  EXPECT_EQ(1.5_f64, uut.viewRegisters()[0]);
+  EXPECT_EQ(3_i32, uut.viewRegisters()[1]);
+  EXPECT_TRUE(uut.viewStack().empty());
+}
+
+TEST(TestRegisterVM, ExecutesThreeAddressArithmetic) {
+  // r3 = r0 + r1; r4 = r3 * r2; r4 = -r4
+  auto code = registerCode(fc::Chunk{.code = {F64_ADD, 3, 0, 1, F64_MUL, 4, 3, 2, F64_NEG, 4, 4, EXIT},
+                                     .constants = {1.5_f64, 2.5_f64, 2.0_f64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  EXPECT_DOUBLE_EQ(4.0, uut.viewRegisters()[3].asF64());
+  EXPECT_DOUBLE_EQ(-8.0, uut.viewRegisters()[4].asF64());
+}
+
+TEST(TestRegisterVM, ExecutesIntegerArithmeticAndCasts) {
+  auto code = registerCode(
+    fc::Chunk{.code = {I64_SUB, 2, 0, 1, CAST_IU, 3, 2, WIDTH_8, U64_MUL, 3, 3, 3, CAST_UF, 4, 3, CAST_FI, 5, 4,
+                       WIDTH_16, EXIT},
+              .constants = {3_i8, 15_i32}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  EXPECT_EQ(fc::Value{static_cast<fc::I32>(-12)}, uut.viewRegisters()[2]);
+  EXPECT_EQ(fc::Value{static_cast<fc::U8>(144)}, uut.viewRegisters()[3]);
+  EXPECT_EQ(144.0_f64, uut.viewRegisters()[4]);
+  EXPECT_EQ(144_i16, uut.viewRegisters()[5]);
+}
+
+TEST(TestRegisterVM, ReportsDivideByZero) {
+  auto code = registerCode(fc::Chunk{.code = {U64_DIV, 2, 0, 1, EXIT}, .constants = {3_u64, 0_u64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(&code));
+}
+
+TEST(TestRegisterVM, WrapsTheQuotientOfTheSmallestIntAndMinusOne) {
+  constexpr auto MIN = std::numeric_limits<fc::I64>::min();
+  auto code = registerCode(
+    fc::Chunk{.code = {I64_DIV, 2, 0, 1, EXIT}, .constants = {fc::Value{MIN}, fc::Value{static_cast<fc::I64>(-1)}}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  EXPECT_EQ(fc::Value{MIN}, uut.viewRegisters()[2]);
+}
+
+TEST(TestRegisterVM, LocatesFaults) {
+  auto code = registerCode(fc::Chunk{.name = "main",
+                                     .code = {U64_ADD, 2, 0, 0, CAST_UF, 3, 2, U64_DIV, 4, 0, 1, EXIT},
+                                     .constants = {3_u64, 0_u64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(&code));
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::DIVIDE_BY_ZERO, uut.viewFault()->fault);
+  EXPECT_EQ(7, uut.viewFault()->offset);
+
+  code.chunks[0].code[7] = F64_ADD;
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&code));
+  EXPECT_EQ(fluir::Fault::TYPE_MISMATCH, uut.viewFault()->fault);
+  EXPECT_EQ(7, uut.viewFault()->offset);
+}
+
+TEST(TestRegisterVM, ReportsTruncatedOperands) {
+  for (auto truncated : {std::vector<std::uint8_t>{F64_ADD, 2, 0}, std::vector<std::uint8_t>{CAST_FI, 2, 0},
+                         std::vector<std::uint8_t>{I32_NEG, 2}, std::vector<std::uint8_t>{POP}}) {
+    auto code = registerCode(fc::Chunk{.code = truncated, .constants = {1.5_f64}});
+
+    fluir::VirtualMachine uut;
+
+    EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&code));
+    ASSERT_TRUE(uut.viewFault().has_value());
+    EXPECT_EQ(fluir::Fault::INVALID_OPERAND, uut.viewFault()->fault);
+  }
+}
+
+TEST(TestRegisterVM, RejectsStackInstructions) {
+  auto code = registerCode(fc::Chunk{.code = {PUSH, 0, EXIT}, .constants = {1.0_f64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&code));
+}
+
+TEST(TestRegisterVM, ExecutesVerifiedCode) {
+  auto code = registerCode(fc::Chunk{.code = {F64_DIV, 2, 0, 1, POP, 2, F64_SUB, 2, 2, 0, EXIT},
+                                     .constants = {1.0_f64, 4.0_f64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(fluir::verify(code)));
+  EXPECT_DOUBLE_EQ(-0.75, uut.viewRegisters()[2].asF64());
+}
+
+TEST(TestRegisterVerifier, RejectsReadingUnwrittenRegisters) {
+  auto code = registerCode(fc::Chunk{.name = "main", .code = {F64_ADD, 2, 0, 1, EXIT}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (F64_ADD): Register r1 is read before it is written.",
+            verificationMessage(code));
+}
+
+TEST(TestRegisterVerifier, RejectsMismatchedRegisterTypes) {
+  auto code = registerCode(fc::Chunk{.name = "main", .code = {F64_ADD, 2, 0, 1, EXIT}, .constants = {1.0_f64, 1_u8}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (F64_ADD): Expected F64 in register r1, found U8.",
+            verificationMessage(code));
+}
+
+TEST(TestRegisterVerifier, TracksTypesThroughWrites) {
+  auto code = registerCode(fc::Chunk{.name = "main",
+                                     .code = {CAST_FI, 0, 0, WIDTH_32, F64_NEG, 1, 0, EXIT},
+                                     .constants = {1.0_f64, 2.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x4 (F64_NEG): Expected F64 in register r0, found I32.",
+            verificationMessage(code));
+}
+
+TEST(TestRegisterVerifier, RejectsStackInstructions) {
+  auto code = registerCode(fc::Chunk{.name = "main", .code = {PUSH, 0, EXIT}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (PUSH): Instruction is not part of the register "
+            "instruction set.",
+            verificationMessage(code));
+}
+
+TEST(TestRegisterVerifier, RejectsMissingOperands) {
+  auto code = registerCode(fc::Chunk{.name = "main", .code = {F64_ADD, 2, 0}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (F64_ADD): Missing operand.", verificationMessage(code));
+}
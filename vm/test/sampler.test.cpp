@@ -0,0 +1,117 @@
+#include "vm/sampler.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/output.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  /** Asks for a sample every time a value is written, so the next instruction dispatched is sampled */
+  class SamplingSink : public fluir::OutputSink {
+   public:
+    void write(const fc::Value&) override { fluir::SamplingProfiler::request(); }
+  };
+}  // namespace
+
+TEST(TestSamplingProfiler, AttributesSamplesToNodes) {
+  auto code = withChunk(fc::Chunk{
+    .name = "main",
+    .code = {PUSH, 0, POP, PUSH, 1, F64_NEG, POP, EXIT},
+    .constants = {1.0_f64, 2.0_f64},
+    .debug = {{.offset = 0, .node = 1, .x = 1, .y = 2}, {.offset = 3, .node = 2, .x = 5, .y = -6, .width = 7}}});
+  auto verified = fluir::verify(code);
+  fluir::VirtualMachine vm;
+  fluir::SamplingProfiler sampler;
+  SamplingSink sink;
+
+  fluir::SamplingProfiler::request();
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified, {.output = &sink, .sampler = &sampler}));
+
+  // The first PUSH, then the instructions after each POP
+  EXPECT_EQ(3, sampler.total());
+  const auto hotspots = sampler.hotspots();
+  ASSERT_EQ(2, hotspots.size());
+  EXPECT_EQ("main", hotspots[0].chunk);
+  EXPECT_EQ(2, hotspots[0].node.node);
+  EXPECT_EQ(7, hotspots[0].node.width);
+  EXPECT_EQ(2, hotspots[0].samples);
+  EXPECT_EQ(1, hotspots[1].node.node);
+  EXPECT_EQ(1, hotspots[1].samples);
+
+  std::stringstream folded;
+  sampler.writeFolded(folded);
+  EXPECT_EQ("main;node 1 (1,2);PUSH 1\nmain;node 2 (5,-6);EXIT 1\nmain;node 2 (5,-6);PUSH 1\n", folded.str());
+
+  sampler.clear();
+  EXPECT_EQ(0, sampler.total());
+  EXPECT_TRUE(sampler.hotspots().empty());
+}
+
+TEST(TestSamplingProfiler, SamplesCodeWithoutDebugInfo) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, POP, EXIT}, .constants = {1.0_f64}});
+  fluir::VirtualMachine vm;
+  fluir::SamplingProfiler sampler;
+  SamplingSink sink;
+
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.output = &sink, .sampler = &sampler}));
+
+  std::stringstream folded;
+  sampler.writeFolded(folded);
+  EXPECT_EQ("main;<no debug info>;EXIT 1\n", folded.str());
+}
+
+TEST(TestSamplingProfiler, DoesNotSampleWithoutSampler) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, POP, EXIT}, .constants = {1.0_f64}});
+  fluir::VirtualMachine vm;
+  fluir::SamplingProfiler sampler;
+
+  fluir::SamplingProfiler::request();
+  ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.output = nullptr}));
+
+  // The request is still pending, since nothing took the sample
+  EXPECT_TRUE(fluir::SamplingProfiler::pending());
+  EXPECT_EQ(0, sampler.total());
+}
+
+TEST(TestSamplingProfiler, TimerTakesSamples) {
+  auto code = withChunk(fc::Chunk{.name = "main",
+                                  .code = {PUSH, 0, PUSH, 1, F64_MUL, PUSH, 0, F64_ADD, POP, EXIT},
+                                  .constants = {1.5_f64, 2.5_f64},
+                                  .debug = {{.offset = 0, .node = 1}, {.offset = 4, .node = 2}}});
+  auto verified = fluir::verify(code);
+  fluir::VirtualMachine vm;
+  fluir::RingBufferSink sink{1};
+  fluir::SamplingProfiler sampler{std::chrono::microseconds{100}};
+
+  if (!fluir::SamplingProfiler::available()) {
+    GTEST_SKIP() << "The sampling timer does not support this platform";
+  }
+  ASSERT_TRUE(sampler.start());
+  // The timer counts CPU time, so keep executing until it has fired or we give up
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while (sampler.total() == 0 && std::chrono::steady_clock::now() < deadline) {
+    for (int i = 0; i != 1000; ++i) {
+      ASSERT_EQ(fluir::ExecResult::SUCCESS, vm.execute(verified, {.output = &sink, .sampler = &sampler}));
+    }
+  }
+  sampler.stop();
+
+  EXPECT_GT(sampler.total(), 0);
+  for (const auto& hotspot : sampler.hotspots()) {
+    EXPECT_EQ("main", hotspot.chunk);
+    EXPECT_TRUE(hotspot.node.node == 1 || hotspot.node.node == 2) << hotspot.node.node;
+  }
+  std::stringstream text;
+  sampler.writeText(text);
+  EXPECT_NE(std::string::npos, text.str().find("samples every 100us of CPU time."));
+}
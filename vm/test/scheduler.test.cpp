@@ -0,0 +1,177 @@
+#include "vm/scheduler.hpp"
+
+#include <atomic>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vm/pool.hpp"
+#include "vm/thread_pool.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  /* A chunk whose subgraphs each print one of its constants, along with a chunk per subgraph */
+  fc::ByteCode printing(std::size_t sinks) {
+    fc::ByteCode code{.header = {}, .chunks = {fc::Chunk{.name = "main"}}};
+    for (std::size_t i = 0; i != sinks; ++i) {
+      auto value = fc::Value{static_cast<fc::F64>(i)};
+      auto& main = code.chunks[0];
+      main.constants.push_back(value);
+      main.code.insert(main.code.end(), {PUSH, static_cast<std::uint8_t>(i), POP});
+      main.subgraphs.push_back(fc::Subgraph{.chunk = i + 1, .dependencies = {}});
+      code.chunks.push_back(fc::Chunk{.name = "main_sink" + std::to_string(i),
+                                      .code = {PUSH, 0, POP, EXIT},
+                                      .constants = {value}});
+    }
+    code.chunks[0].code.push_back(EXIT);
+    return code;
+  }
+
+  std::string runWhole(const fc::ByteCode& code) {
+    fluir::TextSink output;
+    fluir::VirtualMachine vm;
+    EXPECT_EQ(fluir::ExecResult::SUCCESS, vm.execute(code, {.entry = 0, .output = &output}));
+    return std::string{output.view()};
+  }
+}  // namespace
+
+TEST(TestThreadPool, RunsEveryTask) {
+  constexpr int TASKS = 1000;
+  std::atomic<int> ran{0};
+  {
+    fluir::ThreadPool pool{4};
+    EXPECT_EQ(4, pool.size());
+    for (int i = 0; i != TASKS; ++i) {
+      pool.submit([&ran] { ++ran; });
+    }
+  }
+  EXPECT_EQ(TASKS, ran);
+}
+
+TEST(TestThreadPool, RunsTasksSubmittedByWorkers) {
+  constexpr int CHILDREN = 100;
+  fluir::ThreadPool pool{3};
+  std::atomic<int> ran{0};
+  std::latch done{CHILDREN};
+  pool.submit([&] {
+    for (int i = 0; i != CHILDREN; ++i) {
+      pool.submit([&] {
+        ++ran;
+        done.count_down();
+      });
+    }
+  });
+  done.wait();
+  EXPECT_EQ(CHILDREN, ran);
+}
+
+TEST(TestThreadPool, VisitsEveryIndexOnce) {
+  constexpr std::size_t COUNT = 1001;
+  fluir::ThreadPool pool{3};
+  std::vector<int> visits(COUNT);
+  pool.forEach(COUNT, [&](std::size_t i) { ++visits[i]; });
+  EXPECT_EQ(std::vector<int>(COUNT, 1), visits);
+
+  pool.forEach(0, [](std::size_t) { FAIL(); });
+}
+
+TEST(TestThreadPool, RethrowsTheLowestIndexWhichThrew) {
+  fluir::ThreadPool pool{4};
+  try {
+    pool.forEach(100, [](std::size_t i) {
+      if (i % 30 == 29) {
+        throw std::runtime_error(std::to_string(i));
+      }
+    });
+    FAIL() << "Expected an exception";
+  } catch (const std::runtime_error& e) {
+    EXPECT_STREQ("29", e.what());
+  }
+}
+
+TEST(TestThreadPool, AlwaysHasAWorker) {
+  fluir::ThreadPool pool{0};
+  EXPECT_EQ(1, pool.size());
+}
+
+TEST(TestScheduler, WritesOutputInSinkOrder) {
+  auto code = printing(32);
+  fluir::ThreadPool threads{4};
+  fluir::VmPool vms;
+  fluir::Scheduler uut{threads, vms};
+
+  for (int attempt = 0; attempt != 10; ++attempt) {
+    fluir::TextSink output;
+    EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(code, {.entry = 0, .output = &output}));
+    EXPECT_EQ(runWhole(code), output.view());
+  }
+  EXPECT_FALSE(uut.viewFault().has_value());
+}
+
+TEST(TestScheduler, RunsChunksWithoutSubgraphsWhole) {
+  auto code = printing(2);
+  code.chunks[0].subgraphs.clear();
+  fluir::ThreadPool threads{2};
+  fluir::VmPool vms;
+  fluir::Scheduler uut{threads, vms};
+
+  fluir::TextSink output;
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(code, {.entry = 0, .output = &output}));
+  EXPECT_EQ(runWhole(code), output.view());
+}
+
+TEST(TestScheduler, SkipsDependentsOfFailedSubgraphs) {
+  // Subgraph 1 divides by zero, subgraph 2 depends on it and subgraph 3 depends only on subgraph 0
+  auto code = printing(4);
+  code.chunks[2].code = {PUSH, 0, PUSH, 0, U64_DIV, EXIT};
+  code.chunks[2].constants = {0_u64};
+  code.chunks[0].subgraphs[2].dependencies = {1};
+  code.chunks[0].subgraphs[3].dependencies = {0};
+  fluir::ThreadPool threads{2};
+  fluir::VmPool vms;
+  fluir::Scheduler uut{threads, vms};
+
+  fluir::TextSink output;
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(code, {.entry = 0, .output = &output}));
+  EXPECT_EQ("(F64)0\n", output.view());
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::DIVIDE_BY_ZERO, uut.viewFault()->fault);
+  EXPECT_EQ("main_sink1", uut.viewFault()->chunk);
+}
+
+TEST(TestScheduler, StopsWritingAtTheFirstFailedSubgraph) {
+  // Subgraph 1 divides by zero after printing, while subgraph 2 is independent and still runs
+  auto code = printing(3);
+  code.chunks[2].code = {PUSH, 0, POP, PUSH, 1, PUSH, 1, U64_DIV, EXIT};
+  code.chunks[2].constants = {1.0_f64, 0_u64};
+  fluir::ThreadPool threads{2};
+  fluir::VmPool vms;
+  fluir::Scheduler uut{threads, vms};
+
+  fluir::TextSink output;
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(code, {.entry = 0, .output = &output}));
+  EXPECT_EQ("(F64)0\n(F64)1\n", output.view());
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ("main_sink1", uut.viewFault()->chunk);
+}
+
+TEST(TestScheduler, RejectsDependenciesWhichDoNotComeFirst) {
+  auto code = printing(2);
+  fluir::ThreadPool threads{2};
+  fluir::VmPool vms;
+  fluir::Scheduler uut{threads, vms};
+
+  code.chunks[0].subgraphs[1].dependencies = {5};
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(code, {.entry = 0}));
+
+  code.chunks[0].subgraphs[0].dependencies = {1};
+  code.chunks[0].subgraphs[1].dependencies = {0};
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(code, {.entry = 0}));
+}
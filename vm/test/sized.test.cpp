@@ -0,0 +1,124 @@
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vm/exceptions.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using namespace fluir::code::value_literals;
+
+namespace {
+  enum class Mode { CHECKED, VERIFIED, REGISTERS };
+
+  struct Outcome {
+    fluir::ExecResult result;
+    std::optional<fc::Value> value;
+  };
+
+  /* The values where wrapping, sign extension and division are most likely to go wrong */
+  template <typename T>
+  std::vector<fc::Value> edgeValues() {
+    return {fc::Value{std::numeric_limits<T>::min()},
+            fc::Value{std::numeric_limits<T>::max()},
+            fc::Value{static_cast<T>(-1)},
+            fc::Value{static_cast<T>(0)},
+            fc::Value{static_cast<T>(1)},
+            fc::Value{static_cast<T>(7)}};
+  }
+
+  bool isUnary(fc::Instruction instruction) {
+    return fc::registerOperandBytes(instruction) == 2;
+  }
+
+  /* Applies instruction to constants 0 and 1, or just 0 if it is unary, and returns the value it produced */
+  Outcome run(fc::Instruction instruction, const fc::Value& lhs, const fc::Value& rhs, Mode mode) {
+    fc::Chunk chunk{.constants = {lhs, rhs}};
+    if (mode == Mode::REGISTERS) {
+      chunk.code = isUnary(instruction) ? std::vector<std::uint8_t>{instruction, 2, 0, EXIT}
+                                        : std::vector<std::uint8_t>{instruction, 2, 0, 1, EXIT};
+    } else {
+      chunk.code = isUnary(instruction) ? std::vector<std::uint8_t>{PUSH, 0, instruction, EXIT}
+                                        : std::vector<std::uint8_t>{PUSH, 0, PUSH, 1, instruction, EXIT};
+    }
+    fc::ByteCode code{.header = {.filetype = mode == Mode::REGISTERS ? fc::FILETYPE_REGISTERS : fc::Header{}.filetype},
+                      .chunks = {std::move(chunk)}};
+
+    fluir::VirtualMachine vm;
+    Outcome outcome{.result = mode == Mode::VERIFIED ? vm.execute(fluir::verify(code)) : vm.execute(&code),
+                    .value = std::nullopt};
+    if (outcome.result == fluir::ExecResult::SUCCESS) {
+      outcome.value = mode == Mode::REGISTERS ? vm.viewRegisters()[2] : vm.viewStack().back();
+    }
+    return outcome;
+  }
+
+  /* Runs every width specialized instruction of type against the generic instruction it specializes, over every pair
+   * of edge values, and expects the same result from both */
+  void expectSameAsGeneric(fc::PrimitiveType type,
+                           fc::Instruction first,
+                           fc::Instruction last,
+                           const std::vector<fc::Value>& values) {
+    for (auto generic = first; generic <= last; generic = static_cast<fc::Instruction>(generic + 1)) {
+      const auto sized = fc::sized(generic, type);
+      ASSERT_NE(generic, sized);
+      for (auto mode : {Mode::CHECKED, Mode::VERIFIED, Mode::REGISTERS}) {
+        for (std::size_t lhs = 0; lhs != values.size(); ++lhs) {
+          for (std::size_t rhs = 0; rhs != values.size(); ++rhs) {
+            SCOPED_TRACE(testing::Message() << "instruction " << +sized << ", mode " << static_cast<int>(mode)
+                                            << ", values " << lhs << " and " << rhs);
+            auto expected = run(generic, values[lhs], values[rhs], mode);
+            auto actual = run(sized, values[lhs], values[rhs], mode);
+            EXPECT_EQ(expected.result, actual.result);
+            EXPECT_EQ(expected.value, actual.value);
+          }
+        }
+      }
+    }
+  }
+}  // namespace
+
+TEST(TestSizedInstructions, SpecializesIntArithmetic) {
+  EXPECT_EQ(I8_ADD, fc::sized(I64_ADD, fc::PrimitiveType::I8));
+  EXPECT_EQ(I16_NEG, fc::sized(I64_NEG, fc::PrimitiveType::I16));
+  EXPECT_EQ(I32_DIV, fc::sized(I64_DIV, fc::PrimitiveType::I32));
+  EXPECT_EQ(U8_SUB, fc::sized(U64_SUB, fc::PrimitiveType::U8));
+  EXPECT_EQ(U32_MUL, fc::sized(U64_MUL, fc::PrimitiveType::U32));
+}
+
+TEST(TestSizedInstructions, KeepsGenericInstructionsWithoutSpecialization) {
+  EXPECT_EQ(I64_ADD, fc::sized(I64_ADD, fc::PrimitiveType::I64));
+  EXPECT_EQ(U64_DIV, fc::sized(U64_DIV, fc::PrimitiveType::U64));
+  EXPECT_EQ(I64_AFF, fc::sized(I64_AFF, fc::PrimitiveType::I8));
+  EXPECT_EQ(U64_ADD, fc::sized(U64_ADD, fc::PrimitiveType::I8));
+  EXPECT_EQ(I64_ADD, fc::sized(I64_ADD, fc::PrimitiveType::U8));
+  EXPECT_EQ(F64_ADD, fc::sized(F64_ADD, fc::PrimitiveType::F64));
+}
+
+TEST(TestSizedInstructions, MatchGenericIntInstructions) {
+  expectSameAsGeneric(fc::PrimitiveType::I8, I64_ADD, I64_NEG, edgeValues<fc::I8>());
+  expectSameAsGeneric(fc::PrimitiveType::I16, I64_ADD, I64_NEG, edgeValues<fc::I16>());
+  expectSameAsGeneric(fc::PrimitiveType::I32, I64_ADD, I64_NEG, edgeValues<fc::I32>());
+}
+
+TEST(TestSizedInstructions, MatchGenericUintInstructions) {
+  expectSameAsGeneric(fc::PrimitiveType::U8, U64_ADD, U64_DIV, edgeValues<fc::U8>());
+  expectSameAsGeneric(fc::PrimitiveType::U16, U64_ADD, U64_DIV, edgeValues<fc::U16>());
+  expectSameAsGeneric(fc::PrimitiveType::U32, U64_ADD, U64_DIV, edgeValues<fc::U32>());
+}
+
+TEST(TestSizedInstructions, RejectOtherWidths) {
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.code = {PUSH, 0, PUSH, 1, I8_ADD, EXIT}, .constants = {1_i8, 2_i16}}}};
+
+  fluir::VirtualMachine vm;
+  EXPECT_EQ(fluir::ExecResult::ERROR, vm.execute(&code));
+  ASSERT_TRUE(vm.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::TYPE_MISMATCH, vm.viewFault()->fault);
+  EXPECT_EQ(4, vm.viewFault()->offset);
+  EXPECT_THROW(fluir::verify(code), fluir::VerificationError);
+}
@@ -0,0 +1,231 @@
+#include "vm/verifier.hpp"
+
+#include <gtest/gtest.h>
+
+#include "code_factories.hpp"
+#include "vm/exceptions.hpp"
+#include "vm/vm.hpp"
+
+namespace fc = fluir::code;
+using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
+using namespace fluir::code::value_literals;
+
+TEST(TestVerifier, AcceptsEmptyFunction) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {EXIT}});
+
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestVerifier, AcceptsMixedArithmetic) {
+  auto code = withChunk(fc::Chunk{
+    .name = "main",
+    .code = {PUSH, 0, PUSH, 1, I64_ADD, CAST_IF, PUSH, 2, F64_MUL, CAST_FU, WIDTH_16, PUSH, 3, U64_DIV, POP, EXIT},
+    .constants = {1_i8, 2_i32, 1.5_f64, 3_u64}});
+
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestVerifier, AcceptsCodeAfterExit) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {EXIT, F64_ADD}});
+
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestVerifier, RejectsNoChunks) {
+  fc::ByteCode code{};
+
+  EXPECT_THROW(fluir::verify(code), fluir::VerificationError);
+}
+
+TEST(TestVerifier, RejectsMissingEntryChunk) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {EXIT}});
+  code.header.entryOffset = 1;
+
+  EXPECT_EQ("Invalid bytecode. The entry chunk x1 is not one of the 1 chunks.", verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsMissingExit) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, POP}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x3 (<END>): Code ends without an EXIT instruction.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsUnknownInstruction) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {0xFE, EXIT}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (<UNKNOWN>): Unknown instruction xFE.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsMissingOperand) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (PUSH): Missing operand.", verificationMessage(code));
+}
+
+TEST(TestVerifier, AcceptsImmediatesAndWideConstants) {
+  auto code = withChunk(fc::Chunk{.name = "main",
+                                  .code = {PUSH_F64_IMM, 0, 0, 0, 0, 0, 0, 0xF8, 0x3F, PUSH_WIDE, 1, 0, F64_ADD,
+                                           PUSH_I64_IMM, 1, 0, 0, 0, 0, 0, 0, 0, PUSH_SMALL_INT, 0xFF, I64_ADD,
+                                           CAST_IF, F64_ADD, POP, EXIT},
+                                  .constants = {1_i64, 2.0_f64}});
+
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestVerifier, RejectsTruncatedImmediate) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH_I64_IMM, 0, 0, 0, 0, 0, 0, 0}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x0 (PUSH_I64_IMM): Missing operand.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsWideConstantOutOfRange) {
+  auto code = withChunk(fc::Chunk{.name = "foo", .code = {PUSH_WIDE, 0x00, 0x01, EXIT}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'foo' at offset x0 (PUSH_WIDE): Constant index x100 is out of range. The chunk "
+            "only has x1 constants.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsConstantOutOfRange) {
+  auto code = withChunk(fc::Chunk{.name = "foo", .code = {PUSH, 0, PUSH, 2, EXIT}, .constants = {1.0_f64, 2.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'foo' at offset x2 (PUSH): Constant index x2 is out of range. The chunk only "
+            "has x2 constants.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsStackUnderflow) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, F64_ADD, EXIT}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x2 (F64_ADD): Stack underflow. Expected F64 on the stack.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsStackOverflow) {
+  fc::Chunk chunk{.name = "main", .code = {}, .constants = {1.0_f64}};
+  for (size_t i = 0; i <= fluir::VirtualMachine::STACK_CAPACITY; ++i) {
+    chunk.code.push_back(PUSH);
+    chunk.code.push_back(0);
+  }
+  chunk.code.push_back(EXIT);
+  auto code = withChunk(std::move(chunk));
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x200 (PUSH): Stack overflow. The stack can hold at most 256 "
+            "values.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsMismatchedOperandTypes) {
+  auto code =
+    withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.0_f64, 2_i64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x4 (F64_ADD): Expected F64 on the stack, found I64.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsSignMismatch) {
+  auto code =
+    withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, PUSH, 1, U64_MUL, EXIT}, .constants = {1_u8, 2_i8}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x4 (U64_MUL): Expected a uint on the stack, found I8.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsInvalidWidth) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, CAST_FI, 3, EXIT}, .constants = {1.0_f64}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x2 (CAST_FI): Invalid width operand x3.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsCastWidth) {
+  auto code = withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, CAST_WIDTH, WIDTH_16, EXIT}, .constants = {1_i8}});
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main' at offset x2 (CAST_WIDTH): CAST_WIDTH is not executable yet.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsErrorsInLaterChunks) {
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.name = "main", .code = {EXIT}},
+                               fc::Chunk{.name = "bar", .code = {POP, EXIT}}}};
+
+  EXPECT_EQ("Invalid bytecode in chunk 'bar' at offset x0 (POP): Stack underflow. Expected a value on the stack.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, AcceptsSubgraphs) {
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.name = "main",
+                                         .code = {EXIT},
+                                         .subgraphs = {{.chunk = 1, .dependencies = {}},
+                                                       {.chunk = 1, .dependencies = {0}}}},
+                               fc::Chunk{.name = "main_sink0", .code = {EXIT}}}};
+
+  EXPECT_NO_THROW(fluir::verify(code));
+}
+
+TEST(TestVerifier, RejectsSubgraphsOfMissingChunks) {
+  fc::ByteCode code{
+    .header = {},
+    .chunks = {fc::Chunk{.name = "main", .code = {EXIT}, .subgraphs = {{.chunk = 1, .dependencies = {}}}}}};
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main': Subgraph 0 refers to chunk x1, which is not another chunk.",
+            verificationMessage(code));
+  code.chunks[0].subgraphs[0].chunk = 0;
+  EXPECT_EQ("Invalid bytecode in chunk 'main': Subgraph 0 refers to chunk x0, which is not another chunk.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, RejectsSubgraphsDependingOnLaterSubgraphs) {
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.name = "main",
+                                         .code = {EXIT},
+                                         .subgraphs = {{.chunk = 1, .dependencies = {1}},
+                                                       {.chunk = 1, .dependencies = {}}}},
+                               fc::Chunk{.name = "main_sink0", .code = {EXIT}}}};
+
+  EXPECT_EQ("Invalid bytecode in chunk 'main': Subgraph 0 depends on subgraph 1, which does not come before it.",
+            verificationMessage(code));
+}
+
+TEST(TestVerifier, VerifiedCodeExecutes) {
+  auto code = withChunk(fc::Chunk{.name = "main",
+                                  .code = {PUSH, 0, PUSH, 1, I64_MUL, CAST_IU, WIDTH_8, CAST_UF, EXIT},
+                                  .constants = {fc::Value{static_cast<fc::I16>(-3)}, 100_i16}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(fluir::verify(code)));
+  EXPECT_DOUBLE_EQ(212.0, uut.viewStack().back().asF64());
+}
+
+TEST(TestVerifier, VerifiedCodeReportsDivideByZero) {
+  auto code =
+    withChunk(fc::Chunk{.name = "main", .code = {PUSH, 0, PUSH, 1, U64_DIV, EXIT}, .constants = {1_u64, 0_u64}});
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(fluir::verify(code)));
+}
+
+TEST(TestVerifier, RejectsDebugEntriesOutsideCodeOrOutOfOrder) {
+  auto code = withChunk(fc::Chunk{.name = "main",
+                                  .code = {PUSH, 0, POP, EXIT},
+                                  .constants = {1.0_f64},
+                                  .debug = {{.offset = 0, .node = 1}, {.offset = 2, .node = 2}}});
+  EXPECT_NO_THROW(fluir::verify(code));
+
+  code.chunks[0].debug[1].offset = 4;
+  EXPECT_EQ("Invalid bytecode in chunk 'main': Debug entry 1 is at offset x4, which is not in the code after the entry "
+            "before it.",
+            verificationMessage(code));
+  code.chunks[0].debug[1].offset = 0;
+  EXPECT_EQ("Invalid bytecode in chunk 'main': Debug entry 1 is at offset x0, which is not in the code after the entry "
+            "before it.",
+            verificationMessage(code));
+}
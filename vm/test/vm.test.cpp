@@ -1,11 +1,13 @@
 #include "vm/vm.hpp"
 
 #include <array>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 namespace fc = fluir::code;
 using enum fluir::code::Instruction;
+using enum fluir::code::NumericWidth;
 using namespace fluir::code::value_literals;
 
 TEST(TestVM, ExecEmptyFunction) {
@@ -16,6 +18,29 @@ TEST(TestVM, ExecEmptyFunction) {
   EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
 }
 
+TEST(TestVM, StartsFromTheHeadersEntryChunk) {
+  fluir::code::ByteCode code{
+    .header = {.entryOffset = 1},
+    .chunks = {fc::Chunk{.code = {EXIT}}, fc::Chunk{.code = {PUSH, 0, EXIT}, .constants = {1.5_f64}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  EXPECT_EQ(std::vector{1.5_f64}, uut.viewStack());
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(code, {.entry = 0}));
+  EXPECT_TRUE(uut.viewStack().empty());
+}
+
+TEST(TestVM, RejectsCodeWithoutItsEntryChunk) {
+  fluir::code::ByteCode empty{.header = {}, .chunks = {}};
+  fluir::code::ByteCode outside{.header = {.entryOffset = 1}, .chunks = {fc::Chunk{.code = {EXIT}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&empty));
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&outside));
+}
+
 TEST(TestVM, ExecuteSimpleAddition) {
   fluir::code::ByteCode code{
     .header = {}, .chunks = {fc::Chunk{.code = {PUSH, 0, PUSH, 1, F64_ADD, EXIT}, .constants = {1.2_f64, 2.5_f64}}}};
@@ -575,4 +600,94 @@ TEST(TestVM, AffirmU8) {
   EXPECT_EQ(expected, uut.viewStack().back().asU8());
 }
 
-// TODO: Tests for error cases
+TEST(TestVM, SucceedsWithoutFault) {
+  fc::ByteCode code{.header = {}, .chunks = {fc::Chunk{.code = {PUSH, 0, EXIT}, .constants = {5_u8}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::SUCCESS, uut.execute(&code));
+  EXPECT_FALSE(uut.viewFault().has_value());
+}
+
+TEST(TestVM, LocatesDivisionByZero) {
+  fc::ByteCode code{
+    .header = {},
+    .chunks = {fc::Chunk{.name = "main", .code = {PUSH, 0, PUSH, 1, I64_DIV, EXIT}, .constants = {12_i32, 0_i32}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR_DIVIDE_BY_ZERO, uut.execute(&code));
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::DIVIDE_BY_ZERO, uut.viewFault()->fault);
+  EXPECT_EQ("main", uut.viewFault()->chunk);
+  EXPECT_EQ(4, uut.viewFault()->offset);
+  EXPECT_EQ("DIVISION BY ZERO in chunk 'main' at offset x4", fluir::describe(*uut.viewFault()));
+}
+
+TEST(TestVM, LocatesTypeMismatch) {
+  fc::ByteCode code{.header = {},
+                    .chunks = {fc::Chunk{.name = "mixed",
+                                         .code = {PUSH, 0, PUSH, 1, CAST_IU, WIDTH_8, PUSH, 0, U64_ADD, EXIT},
+                                         .constants = {1.5_f64, 3_i16}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&code));
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::TYPE_MISMATCH, uut.viewFault()->fault);
+  EXPECT_EQ("mixed", uut.viewFault()->chunk);
+  EXPECT_EQ(8, uut.viewFault()->offset);
+}
+
+TEST(TestVM, ReportsStackFaults) {
+  fc::ByteCode underflow{.header = {}, .chunks = {fc::Chunk{.code = {PUSH, 0, F64_ADD, EXIT}, .constants = {1.5_f64}}}};
+  fc::ByteCode overflow{.header = {}, .chunks = {fc::Chunk{.code = {}, .constants = {1.5_f64}}}};
+  for (std::size_t i = 0; i <= fluir::VirtualMachine::STACK_CAPACITY; ++i) {
+    overflow.chunks[0].code.insert(overflow.chunks[0].code.end(), {PUSH, 0});
+  }
+  overflow.chunks[0].code.push_back(EXIT);
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&underflow));
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::STACK_UNDERFLOW, uut.viewFault()->fault);
+  EXPECT_EQ(2, uut.viewFault()->offset);
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&overflow));
+  ASSERT_TRUE(uut.viewFault().has_value());
+  EXPECT_EQ(fluir::Fault::STACK_OVERFLOW, uut.viewFault()->fault);
+  EXPECT_EQ(2 * fluir::VirtualMachine::STACK_CAPACITY, uut.viewFault()->offset);
+}
+
+TEST(TestVM, ReportsInvalidOperandsAndInstructions) {
+  fc::ByteCode constant{.header = {}, .chunks = {fc::Chunk{.code = {PUSH, 3, EXIT}, .constants = {1.5_f64}}}};
+  fc::ByteCode width{.header = {}, .chunks = {fc::Chunk{.code = {PUSH, 0, CAST_FI, 3, EXIT}, .constants = {1.5_f64}}}};
+  fc::ByteCode instruction{.header = {}, .chunks = {fc::Chunk{.code = {PUSH, 0, 0xFF, EXIT}, .constants = {1.5_f64}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&constant));
+  EXPECT_EQ(fluir::Fault::INVALID_OPERAND, uut.viewFault()->fault);
+  EXPECT_EQ(0, uut.viewFault()->offset);
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&width));
+  EXPECT_EQ(fluir::Fault::INVALID_OPERAND, uut.viewFault()->fault);
+  EXPECT_EQ(2, uut.viewFault()->offset);
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&instruction));
+  EXPECT_EQ(fluir::Fault::INVALID_INSTRUCTION, uut.viewFault()->fault);
+  EXPECT_EQ(2, uut.viewFault()->offset);
+}
+
+TEST(TestVM, ReportsTruncatedImmediatesAndWideConstantsOutOfRange) {
+  fc::ByteCode truncated{.header = {}, .chunks = {fc::Chunk{.code = {PUSH_SMALL_INT, 1, PUSH_F64_IMM, 0, 0, 0}}}};
+  fc::ByteCode wide{.header = {}, .chunks = {fc::Chunk{.code = {PUSH_WIDE, 0x01, 0x01, EXIT}, .constants = {1.5_f64}}}};
+
+  fluir::VirtualMachine uut;
+
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&truncated));
+  EXPECT_EQ(fluir::Fault::INVALID_OPERAND, uut.viewFault()->fault);
+  EXPECT_EQ(2, uut.viewFault()->offset);
+  EXPECT_EQ(fluir::ExecResult::ERROR, uut.execute(&wide));
+  EXPECT_EQ(fluir::Fault::INVALID_OPERAND, uut.viewFault()->fault);
+  EXPECT_EQ(0, uut.viewFault()->offset);
+}
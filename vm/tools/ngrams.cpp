@@ -0,0 +1,128 @@
+// Counts the most frequent opcode n-grams in a corpus of compiled programs. Used to choose which sequences are worth
+// turning into superinstructions.
+//
+// Usage: fluir.vm.ngrams [--max-length N] [--top K] <file.flc>...
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vm/decoder/decode.hpp"
+
+namespace fc = fluir::code;
+
+namespace {
+  // A string rather than a vector of opcodes, whose ordering GCC 12 wrongly warns overreads in optimized builds
+  using NGram = std::string;
+
+  struct Options {
+    std::size_t maxLength{3};
+    std::size_t top{20};
+    std::vector<std::string> files;
+  };
+
+  bool parseCount(std::string_view argument, std::size_t& count) {
+    auto result = std::from_chars(argument.data(), argument.data() + argument.size(), count);
+    return result.ec == std::errc{} && result.ptr == argument.data() + argument.size() && count > 0;
+  }
+
+  /** The opcodes of a chunk, with their operands skipped. Stops at the first byte which is not an instruction. */
+  std::vector<std::uint8_t> opcodes(const fc::Chunk& chunk, bool registers) {
+    std::vector<std::uint8_t> result;
+    const auto code = chunk.instructions();
+    for (std::size_t offset = 0; offset < code.size();) {
+      auto instruction = code[offset];
+      if (instruction >= fc::INSTRUCTION_COUNT) {
+        break;
+      }
+      auto operands = registers ? fc::registerOperandBytes(static_cast<fc::Instruction>(instruction))
+                                : fc::operandBytes(static_cast<fc::Instruction>(instruction));
+      if (operands < 0) {
+        break;
+      }
+      result.push_back(instruction);
+      offset += 1 + static_cast<std::size_t>(operands);
+    }
+    return result;
+  }
+
+  void count(const std::vector<std::uint8_t>& sequence, std::size_t maxLength, std::map<NGram, std::size_t>& counts) {
+    for (std::size_t length = 2; length <= maxLength; ++length) {
+      for (std::size_t start = 0; start + length <= sequence.size(); ++start) {
+        ++counts[NGram(sequence.begin() + start, sequence.begin() + start + length)];
+      }
+    }
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument{argv[i]};
+    if (argument == "--max-length" && i + 1 < argc) {
+      if (!parseCount(argv[++i], options.maxLength)) {
+        std::cerr << "--max-length must be a positive number.\n";
+        return -1;
+      }
+    } else if (argument == "--top" && i + 1 < argc) {
+      if (!parseCount(argv[++i], options.top)) {
+        std::cerr << "--top must be a positive number.\n";
+        return -1;
+      }
+    } else {
+      options.files.emplace_back(argument);
+    }
+  }
+  if (options.files.empty()) {
+    std::cerr << "Usage: fluir.vm.ngrams [--max-length N] [--top K] <file.flc>...\n";
+    return -1;
+  }
+
+  std::map<NGram, std::size_t> counts;
+  std::size_t instructions = 0;
+  for (const auto& file : options.files) {
+    std::ifstream fin(file);
+    if (!fin) {
+      std::cerr << "Could not open '" << file << "'.\n";
+      return -1;
+    }
+    std::stringstream contents;
+    contents << fin.rdbuf();
+
+    try {
+      auto code = fluir::decode(contents.str());
+      for (const auto& chunk : code.chunks) {
+        auto sequence = opcodes(chunk, fc::usesRegisters(code.header));
+        instructions += sequence.size();
+        count(sequence, options.maxLength, counts);
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "Could not decode '" << file << "': " << e.what() << '\n';
+      return -1;
+    }
+  }
+
+  // Rank by the number of dispatches a superinstruction for the n-gram would save
+  std::vector<std::pair<NGram, std::size_t>> ranked(counts.begin(), counts.end());
+  auto saved = [](const auto& entry) { return entry.second * (entry.first.size() - 1); };
+  std::ranges::stable_sort(ranked, [&](const auto& lhs, const auto& rhs) { return saved(lhs) > saved(rhs); });
+
+  std::cout << "Instructions: " << instructions << '\n';
+  std::cout << "Count\tSaved\tSequence\n";
+  for (std::size_t i = 0; i != std::min(options.top, ranked.size()); ++i) {
+    const auto& [ngram, occurrences] = ranked[i];
+    std::cout << occurrences << '\t' << saved(ranked[i]) << '\t';
+    for (std::size_t j = 0; j != ngram.size(); ++j) {
+      std::cout << (j == 0 ? "" : " ") << fc::instructionName(static_cast<std::uint8_t>(ngram[j]));
+    }
+    std::cout << '\n';
+  }
+  return 0;
+}